@@ -0,0 +1,196 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * metrics.cpp
+ *
+ * Registry of per tick counters, gauges and histograms.
+ */
+#include "frame.h"
+#include "metrics.h"
+
+#include <physfs.h>
+#include <QtCore/QFile>
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+static std::vector<Metric *> &metricList()
+{
+	static std::vector<Metric *> list;  // Not a plain static, since metrics register themselves during static initialisation.
+	return list;
+}
+
+static bool metricsSorted = false;
+static unsigned tickCount = 0;
+static unsigned csvInterval = 0;
+static QFile *csvFile = NULL;
+
+static bool metricNameLess(Metric const *a, Metric const *b)
+{
+	return strcmp(a->name, b->name) < 0;
+}
+
+// Sort by name, so the CSV columns don't depend on the order of static initialisation.
+static std::vector<Metric *> &sortedMetrics()
+{
+	std::vector<Metric *> &list = metricList();
+	if (!metricsSorted)
+	{
+		std::sort(list.begin(), list.end(), metricNameLess);
+		metricsSorted = true;
+	}
+	return list;
+}
+
+Metric::Metric(char const *name, METRIC_TYPE type)
+	: name(name)
+	, type(type)
+	, value(0)
+{
+	memset(buckets, 0, sizeof(buckets));
+	metricList().push_back(this);
+	metricsSorted = false;
+}
+
+Metric::~Metric()
+{
+	std::vector<Metric *> &list = metricList();
+	list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+static double metricAverage(MetricStats const &stats)
+{
+	return stats.count != 0 ? (double)stats.sum / stats.count : 0;
+}
+
+static void metricsWriteCsv()
+{
+	std::vector<Metric *> &list = sortedMetrics();
+	QString line;
+
+	if (csvFile == NULL)
+	{
+		csvFile = new QFile(QString(PHYSFS_getWriteDir()) + "metrics.csv");
+		if (!csvFile->open(QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			debug(LOG_ERROR, "Could not open %s", csvFile->fileName().toUtf8().constData());
+			delete csvFile;
+			csvFile = NULL;
+			csvInterval = 0;
+			return;
+		}
+		line = "tick";
+		for (unsigned i = 0; i < list.size(); ++i)
+		{
+			switch (list[i]->type)
+			{
+				case METRIC_COUNTER:   line += QString(", %1, %1.max").arg(list[i]->name); break;
+				case METRIC_GAUGE:     line += QString(", %1").arg(list[i]->name); break;
+				case METRIC_HISTOGRAM: line += QString(", %1.count, %1.mean, %1.max").arg(list[i]->name); break;
+			}
+		}
+		csvFile->write(line.toUtf8() + "\n");
+	}
+
+	// Counters are written as the average per tick since the last row.
+	line = QString::number(tickCount);
+	for (unsigned i = 0; i < list.size(); ++i)
+	{
+		Metric *m = list[i];
+		switch (m->type)
+		{
+			case METRIC_COUNTER:   line += QString(", %1, %2").arg(metricAverage(m->csvStats)).arg((qlonglong)m->csvStats.max); break;
+			case METRIC_GAUGE:     line += QString(", %1").arg((qlonglong)m->value); break;
+			case METRIC_HISTOGRAM: line += QString(", %1, %2, %3").arg((qlonglong)m->csvStats.count).arg(metricAverage(m->csvStats)).arg((qlonglong)m->csvStats.max); break;
+		}
+		m->csvStats = MetricStats();
+	}
+	csvFile->write(line.toUtf8() + "\n");
+	csvFile->flush();
+}
+
+void metricsTick()
+{
+	std::vector<Metric *> &list = metricList();
+
+	++tickCount;
+	for (unsigned i = 0; i < list.size(); ++i)
+	{
+		if (list[i]->type == METRIC_COUNTER)
+		{
+			list[i]->dumpStats.add(list[i]->value);
+			list[i]->csvStats.add(list[i]->value);
+			list[i]->value = 0;
+		}
+	}
+
+	if (csvInterval != 0 && tickCount % csvInterval == 0)
+	{
+		metricsWriteCsv();
+	}
+}
+
+void metricsDump()
+{
+	std::vector<Metric *> &list = sortedMetrics();
+
+	debug(LOG_INFO, "Metrics at tick %u:", tickCount);
+	for (unsigned i = 0; i < list.size(); ++i)
+	{
+		Metric *m = list[i];
+		switch (m->type)
+		{
+			case METRIC_COUNTER:
+				debug(LOG_INFO, "  %-28s %.1f per tick, max %lld, over %lld ticks", m->name, metricAverage(m->dumpStats), (long long)m->dumpStats.max, (long long)m->dumpStats.count);
+				break;
+			case METRIC_GAUGE:
+				debug(LOG_INFO, "  %-28s %lld", m->name, (long long)m->value);
+				break;
+			case METRIC_HISTOGRAM:
+			{
+				char text[METRIC_BUCKETS*12] = "";
+				for (unsigned b = 0; b < METRIC_BUCKETS; ++b)
+				{
+					char number[12];
+					ssprintf(number, " %u", m->buckets[b]);
+					sstrcat(text, number);
+				}
+				debug(LOG_INFO, "  %-28s %lld samples, mean %.1f, max %lld, by bit length:%s", m->name, (long long)m->dumpStats.count, metricAverage(m->dumpStats), (long long)m->dumpStats.max, text);
+				memset(m->buckets, 0, sizeof(m->buckets));
+				break;
+			}
+		}
+		m->dumpStats = MetricStats();
+	}
+}
+
+void metricsSetCsvInterval(unsigned ticks)
+{
+	csvInterval = ticks;
+	if (ticks == 0)
+	{
+		metricsShutdown();
+	}
+}
+
+void metricsShutdown()
+{
+	delete csvFile;  // Closes the file.
+	csvFile = NULL;
+}
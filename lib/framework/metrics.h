@@ -0,0 +1,91 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*! \file metrics.h
+ *  \brief Counters, gauges and histograms of what happens in each game tick.
+ *
+ * Metrics are declared as static objects in the module they measure, and
+ * register themselves by name. metricsTick() closes a tick, after which the
+ * numbers can be written to the log with metricsDump(), or to metrics.csv
+ * every few ticks with metricsSetCsvInterval().
+ * Only use metrics from the main thread.
+ */
+#ifndef __INCLUDED_LIB_FRAMEWORK_METRICS_H__
+#define __INCLUDED_LIB_FRAMEWORK_METRICS_H__
+
+#include <stdint.h>
+
+enum METRIC_TYPE
+{
+	METRIC_COUNTER,         ///< Number of events in a tick, starts from 0 every tick.
+	METRIC_GAUGE,           ///< A level, such as the number of live objects, which is kept between ticks.
+	METRIC_HISTOGRAM,       ///< Distribution of sampled values, in power of two buckets.
+};
+
+#define METRIC_BUCKETS 16
+
+/// Count, sum and maximum of the values seen since the statistics were last reset.
+struct MetricStats
+{
+	MetricStats() : count(0), sum(0), max(0) {}
+	void add(int64_t n) { ++count; sum += n; max = n > max ? n : max; }
+
+	int64_t count, sum, max;
+};
+
+class Metric
+{
+public:
+	Metric(char const *name, METRIC_TYPE type);
+	~Metric();
+
+	void add(int64_t n = 1) { value += n; }     ///< Counts events, for counters and gauges.
+	void set(int64_t n) { value = n; }          ///< Sets the level of a gauge.
+	void sample(uint32_t n)                     ///< Adds a value to a histogram.
+	{
+		unsigned bucket = 0;
+		for (uint32_t v = n; v != 0 && bucket < METRIC_BUCKETS - 1; v >>= 1)
+		{
+			++bucket;
+		}
+		++buckets[bucket];
+		dumpStats.add(n);
+		csvStats.add(n);
+	}
+
+	char const *name;
+	METRIC_TYPE type;
+	int64_t value;                      ///< Counter value this tick, or gauge value.
+	MetricStats dumpStats;              ///< Counter values per tick, or histogram samples, since the last dump.
+	MetricStats csvStats;               ///< The same, since the last CSV row.
+	uint32_t buckets[METRIC_BUCKETS];   ///< Histogram samples of bit length 0, 1, 2..., since the last dump.
+};
+
+/// Ends a game tick, resetting the counters.
+void metricsTick();
+
+/// Writes all metrics to the log, with averages and maximums since the last dump.
+void metricsDump();
+
+/// Writes the metrics to metrics.csv in the write directory every ticks ticks, or stops if 0.
+void metricsSetCsvInterval(unsigned ticks);
+
+/// Closes metrics.csv.
+void metricsShutdown();
+
+#endif // __INCLUDED_LIB_FRAMEWORK_METRICS_H__
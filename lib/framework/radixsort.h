@@ -0,0 +1,103 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*! \file radixsort.h
+ *  \brief Stable two pass radix sort for small integer keys.
+ *
+ * Sorts by a key of at most RADIXSORT_KEY_BITS bits, using two counting
+ * passes of RADIXSORT_DIGIT_BITS bits each. Elements with equal keys keep
+ * their relative order, so the result does not depend on the standard
+ * library implementation.
+ */
+#ifndef __INCLUDED_LIB_FRAMEWORK_RADIXSORT_H__
+#define __INCLUDED_LIB_FRAMEWORK_RADIXSORT_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define RADIXSORT_DIGIT_BITS 11
+#define RADIXSORT_KEY_BITS   (2*RADIXSORT_DIGIT_BITS)
+#define RADIXSORT_KEY_MAX    ((1u << RADIXSORT_KEY_BITS) - 1)
+
+/// Clamps a key to the range accepted by radixSort.
+static inline uint32_t radixSortClampKey(uint32_t key)
+{
+	return key < RADIXSORT_KEY_MAX ? key : RADIXSORT_KEY_MAX;
+}
+
+/**
+ * Sorts \a items in ascending order of keyOf(item), keeping equal elements in order.
+ * \param scratch Buffer reused between calls, to avoid allocating every frame.
+ * \param keyOf Functor returning a uint32_t no greater than RADIXSORT_KEY_MAX.
+ */
+template <typename T, typename KeyOf>
+void radixSort(std::vector<T> &items, std::vector<T> &scratch, KeyOf keyOf)
+{
+	enum { DIGITS = 1 << RADIXSORT_DIGIT_BITS, MASK = DIGITS - 1 };
+	uint32_t countLow[DIGITS], countHigh[DIGITS];
+	size_t const n = items.size();
+
+	if (n < 2)
+	{
+		return;
+	}
+	memset(countLow, 0, sizeof(countLow));
+	memset(countHigh, 0, sizeof(countHigh));
+	for (size_t i = 0; i < n; ++i)
+	{
+		uint32_t key = keyOf(items[i]);
+		++countLow[key & MASK];
+		++countHigh[key >> RADIXSORT_DIGIT_BITS & MASK];
+	}
+
+	// Turn the histograms into starting offsets.
+	uint32_t sumLow = 0, sumHigh = 0;
+	bool lowSorted = false, highSorted = false;
+	for (unsigned d = 0; d < DIGITS; ++d)
+	{
+		uint32_t c = countLow[d];
+		lowSorted = lowSorted || c == n;  // All keys share this digit, pass does nothing.
+		countLow[d] = sumLow;
+		sumLow += c;
+		c = countHigh[d];
+		highSorted = highSorted || c == n;
+		countHigh[d] = sumHigh;
+		sumHigh += c;
+	}
+
+	scratch.resize(n);
+	if (!lowSorted)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			scratch[countLow[keyOf(items[i]) & MASK]++] = items[i];
+		}
+		items.swap(scratch);
+	}
+	if (!highSorted)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			scratch[countHigh[keyOf(items[i]) >> RADIXSORT_DIGIT_BITS & MASK]++] = items[i];
+		}
+		items.swap(scratch);
+	}
+}
+
+#endif // __INCLUDED_LIB_FRAMEWORK_RADIXSORT_H__
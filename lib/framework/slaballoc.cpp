@@ -0,0 +1,128 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * slaballoc.cpp
+ *
+ * Fixed size object allocation from slabs.
+ */
+#include "frame.h"
+#include "slaballoc.h"
+
+// Every slot starts with a header, padded so the object stays 16 byte aligned.
+struct SlotHeader
+{
+	uint32_t generation;            // Odd while the slot is in use.
+	uint32_t pool;
+};
+
+#define SLOT_HEADER_SIZE 16
+
+static inline SlotHeader *slotHeader(void const *object)
+{
+	return (SlotHeader *)((char *)object - SLOT_HEADER_SIZE);
+}
+
+static inline char *&slotNextFree(char *slot)
+{
+	return *(char **)(slot + SLOT_HEADER_SIZE);
+}
+
+SlabAllocator::SlabAllocator(size_t objectSize)
+	: slotSize(SLOT_HEADER_SIZE + (objectSize + 15)/16*16)
+	, live(0)
+{}
+
+SlabAllocator::~SlabAllocator()
+{
+	if (live != 0)
+	{
+		return;  // Objects still point into the slabs, probably because we are exiting.
+	}
+	for (unsigned p = 0; p < pools.size(); ++p)
+	{
+		for (unsigned s = 0; s < pools[p].slabs.size(); ++s)
+		{
+			free(pools[p].slabs[s]);
+		}
+	}
+}
+
+void *SlabAllocator::allocate(unsigned pool)
+{
+	if (pool >= pools.size())
+	{
+		pools.resize(pool + 1);
+	}
+	Pool &p = pools[pool];
+
+	if (p.psFree == NULL)
+	{
+		char *slab = (char *)malloc(slotSize * SLAB_SLOTS);
+		p.slabs.push_back(slab);
+		// Chain the new slots so that the first one is used first.
+		for (int i = SLAB_SLOTS - 1; i >= 0; --i)
+		{
+			char *slot = slab + i*slotSize;
+			SlotHeader *header = (SlotHeader *)slot;
+			header->generation = 0;
+			header->pool = pool;
+			slotNextFree(slot) = p.psFree;
+			p.psFree = slot;
+		}
+	}
+
+	char *slot = p.psFree;
+	p.psFree = slotNextFree(slot);
+	++((SlotHeader *)slot)->generation;
+	++live;
+	return slot + SLOT_HEADER_SIZE;
+}
+
+void SlabAllocator::deallocate(void *object)
+{
+	if (object == NULL)
+	{
+		return;
+	}
+	SlotHeader *header = slotHeader(object);
+	ASSERT_OR_RETURN(, (header->generation & 1) != 0 && header->pool < pools.size(), "Freeing %p twice, or it was not allocated here", object);
+
+	Pool &p = pools[header->pool];
+	char *slot = (char *)header;
+	++header->generation;
+	slotNextFree(slot) = p.psFree;
+	p.psFree = slot;
+	--live;
+}
+
+unsigned SlabAllocator::slotCount(unsigned pool) const
+{
+	return pool < pools.size() ? pools[pool].slabs.size()*SLAB_SLOTS : 0;
+}
+
+void *SlabAllocator::object(unsigned pool, unsigned slot) const
+{
+	char *psSlot = pools[pool].slabs[slot / SLAB_SLOTS] + slot % SLAB_SLOTS * slotSize;
+	return (((SlotHeader *)psSlot)->generation & 1) != 0 ? psSlot + SLOT_HEADER_SIZE : NULL;
+}
+
+uint32_t SlabAllocator::generation(void const *object)
+{
+	return slotHeader(object)->generation;
+}
@@ -0,0 +1,110 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*! \file slaballoc.h
+ *  \brief Fixed size object allocation from slabs, with generation checked handles.
+ *
+ * Objects are carved out of slabs of SLAB_SLOTS slots, and each pool (normally
+ * a player) has its own slabs, so objects of a pool are close together in memory.
+ * Slabs are never moved or freed while the allocator exists, so a pointer to a
+ * freed object still points at its slot, and SlabHandle can tell that it is stale.
+ * Slots are handed out in the same order for the same sequence of allocations
+ * and frees, unlike addresses from the general heap.
+ */
+#ifndef __INCLUDED_LIB_FRAMEWORK_SLABALLOC_H__
+#define __INCLUDED_LIB_FRAMEWORK_SLABALLOC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define SLAB_SLOTS 64
+
+class SlabAllocator
+{
+public:
+	SlabAllocator(size_t objectSize);
+	~SlabAllocator();
+
+	/// Returns memory for one object from the given pool.
+	void *allocate(unsigned pool);
+	/// Returns the object's slot to its pool. Handles to the object become stale.
+	void deallocate(void *object);
+
+	/// Number of slots in a pool, used or not. A slot keeps its number while the allocator exists.
+	unsigned slotCount(unsigned pool) const;
+	/// The object in a slot, or NULL if the slot is free.
+	void *object(unsigned pool, unsigned slot) const;
+	/// Number of objects currently allocated, from all pools.
+	unsigned liveCount() const { return live; }
+
+	/// Generation of the slot holding an object. Odd while allocated, and changed by every allocation and free.
+	static uint32_t generation(void const *object);
+
+private:
+	struct Pool
+	{
+		Pool() : psFree(NULL) {}
+
+		std::vector<char *> slabs;
+		char *psFree;           ///< First free slot, free slots are chained through their object memory.
+	};
+
+	SlabAllocator(SlabAllocator const &);             // Not copyable.
+	SlabAllocator &operator =(SlabAllocator const &);  // Not copyable.
+
+	size_t slotSize;
+	unsigned live;
+	std::vector<Pool> pools;
+};
+
+/// Gives T class specific operator new and delete, allocating from one SlabAllocator per type.
+/// T must be the most derived type, and new (player) T(...) puts the object in that player's pool.
+template <typename T>
+struct SlabAllocated
+{
+	static void *operator new(size_t size)                  { return operator new(size, 0); }
+	static void *operator new(size_t size, unsigned pool)   { (void)size; return slabAllocator().allocate(pool); }
+	static void operator delete(void *object)               { slabAllocator().deallocate(object); }
+	static void operator delete(void *object, unsigned)     { slabAllocator().deallocate(object); }
+
+	static SlabAllocator &slabAllocator()
+	{
+		static SlabAllocator allocator(sizeof(T));
+		return allocator;
+	}
+};
+
+/// A pointer to a slab allocated object, which becomes NULL once the object is freed.
+/// T may also be a base class, if it is at the start of the allocated object, such as BASE_OBJECT.
+template <typename T>
+class SlabHandle
+{
+public:
+	SlabHandle() : ptr(NULL), gen(0) {}
+	SlabHandle(T *object) : ptr(object), gen(object != NULL ? SlabAllocator::generation(object) : 0) {}
+
+	/// The object, or NULL if it has been freed since the handle was made.
+	T *get() const { return ptr != NULL && SlabAllocator::generation(ptr) == gen ? ptr : NULL; }
+
+private:
+	T *ptr;
+	uint32_t gen;
+};
+
+#endif // __INCLUDED_LIB_FRAMEWORK_SLABALLOC_H__
@@ -275,6 +275,15 @@ Rational gameTimeGetMod()
 	return modifier;
 }
 
+void gameTimeCatchUpGraphics(void)
+{
+	graphicsTime = gameTime;
+	deltaGraphicsTime = 0;
+	graphicsTimeFraction = 0.f;
+
+	prevRealTime = wzGetTicks();
+}
+
 bool gameTimeIsStopped(void)
 {
 	return stopCount != 0;
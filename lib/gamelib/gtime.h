@@ -98,6 +98,9 @@ void gameTimeSetMod(Rational mod);
 /** Get the current time modifier. */
 Rational gameTimeGetMod();
 
+/** Sets the graphics time to the game time, so the graphics don't trail far behind after fast-forwarding. */
+void gameTimeCatchUpGraphics(void);
+
 /**
  * Returns the game time, modulo the time period, scaled to 0..requiredRange.
  * For instance getModularScaledGameTime(4096,256) will return a number that cycles through the values
@@ -28,6 +28,7 @@
 #include "lib/framework/string_ext.h"
 #include "lib/framework/crc.h"
 #include "lib/framework/file.h"
+#include "lib/framework/metrics.h"
 #include "lib/gamelib/gtime.h"
 #include "src/console.h"
 #include "src/component.h"		// FIXME: we need to handle this better
@@ -39,6 +40,7 @@
 
 #include "netplay.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "netsocket.h"
 
 #include <miniupnpc/miniwget.h>
@@ -61,6 +63,7 @@
 // WARNING !!! This is initialised via configuration.c !!!
 char masterserver_name[255] = {'\0'};
 static unsigned int masterserver_port = 0, gameserver_port = 0;
+static char relay_addresses[255] = {'\0'};  ///< Comma separated addresses of relays, which we never ban.
 
 #define WZ_SERVER_DISCONNECT 0
 #define WZ_SERVER_CONNECT    1
@@ -106,6 +109,8 @@ struct NETSTATS  // data regarding the last one second or so.
 	Statistic       rawBytes;               // Number of actual bytes, in about 1 sec.
 	Statistic       uncompressedBytes;      // Number of bytes sent, before compression, in about 1 sec.
 	Statistic       packets;                // Number of calls to writeAll, in about 1 sec.
+	Statistic       fileBytes;              // Number of bytes of map/mod files, in about 1 sec.
+	Statistic       compressionTime;        // Microseconds spent compressing or decompressing, in about 1 sec.
 };
 
 struct NET_PLAYER_DATA
@@ -157,10 +162,16 @@ static SocketSet* tmp_socket_set = NULL;
 static int32_t          NetGameFlags[4] = { 0, 0, 0, 0 };
 char iptoconnect[PATH_MAX] = "\0"; // holds IP/hostname from command line
 
-static NETSTATS nStats              = {{0, 0}, {0, 0}, {0, 0}};
-static NETSTATS nStatsLastSec       = {{0, 0}, {0, 0}, {0, 0}};
-static NETSTATS nStatsSecondLastSec = {{0, 0}, {0, 0}, {0, 0}};
-static const NETSTATS nZeroStats    = {{0, 0}, {0, 0}, {0, 0}};
+static NETSTATS nStats              = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static NETSTATS nStatsLastSec       = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static NETSTATS nStatsSecondLastSec = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static const NETSTATS nZeroStats    = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static Statistic nStatsCompressionTimeStart = {0, 0};  // socketCompressionTime() when nStats was reset.
+
+static Metric metricBytesSent("net.bytes.sent", METRIC_COUNTER);
+static Metric metricBytesReceived("net.bytes.received", METRIC_COUNTER);
+static Metric metricPacketsSent("net.packets.sent", METRIC_COUNTER);
+static Metric metricPacketsReceived("net.packets.received", METRIC_COUNTER);
 static int nStatsLastUpdateTime = 0;
 
 unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
@@ -173,7 +184,7 @@ unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
 **/
 static char const *versionString = version_getVersionString();
 static int NETCODE_VERSION_MAJOR = 7;
-static int NETCODE_VERSION_MINOR = 0;
+static int NETCODE_VERSION_MINOR = 3;
 
 bool NETisCorrectVersion(uint32_t game_version_major, uint32_t game_version_minor)
 {
@@ -240,6 +251,8 @@ static size_t NET_fillBuffer(Socket **pSocket, SocketSet* socket_set, uint8_t *b
 		nStats.rawBytes.received          += rawBytes;
 		nStats.uncompressedBytes.received += size;
 		nStats.packets.received           += 1;
+		metricBytesReceived.add(rawBytes);
+		metricPacketsReceived.add();
 
 		return size;
 	}
@@ -1155,6 +1168,8 @@ int NETshutdown(void)
 	nStats = nZeroStats;
 	nStatsLastSec = nZeroStats;
 	nStatsSecondLastSec = nZeroStats;
+	nStatsCompressionTimeStart.sent = socketCompressionTime(true);
+	nStatsCompressionTimeStart.received = socketCompressionTime(false);
 
 	return 0;
 }
@@ -1251,9 +1266,20 @@ unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 		case NetStatisticRawBytes:          statsType = &NETSTATS::rawBytes;          break;
 		case NetStatisticUncompressedBytes: statsType = &NETSTATS::uncompressedBytes; break;
 		case NetStatisticPackets:           statsType = &NETSTATS::packets;           break;
+		case NetStatisticFileBytes:         statsType = &NETSTATS::fileBytes;         break;
+		case NetStatisticCompressionTime:   statsType = &NETSTATS::compressionTime;   break;
+		case NetStatisticCompressionRatio:
+		{
+			// Percentage of the uncompressed size actually sent or received.
+			unsigned uncompressed = NETgetStatistic(NetStatisticUncompressedBytes, sent, isTotal);
+			return uncompressed != 0 ? (uint64_t)NETgetStatistic(NetStatisticRawBytes, sent, isTotal)*100/uncompressed : 100;
+		}
 		default: ASSERT(false, " "); return 0;
 	}
 
+	nStats.compressionTime.sent = socketCompressionTime(true) - nStatsCompressionTimeStart.sent;
+	nStats.compressionTime.received = socketCompressionTime(false) - nStatsCompressionTimeStart.received;
+
 	int time = wzGetTicks();
 	if ((unsigned)(time - nStatsLastUpdateTime) >= (unsigned)GAME_TICKS_PER_SEC)
 	{
@@ -1322,6 +1348,8 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 					nStats.rawBytes.sent          += compressedRawLen;
 					nStats.uncompressedBytes.sent += rawLen;
 					nStats.packets.sent           += 1;
+					metricBytesSent.add(compressedRawLen);
+					metricPacketsSent.add();
 				}
 				else if (result == SOCKET_ERROR)
 				{
@@ -1353,6 +1381,8 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 				nStats.rawBytes.sent          += compressedRawLen;
 				nStats.uncompressedBytes.sent += rawLen;
 				nStats.packets.sent           += 1;
+				metricBytesSent.add(compressedRawLen);
+				metricPacketsSent.add();
 			}
 			else if (result == SOCKET_ERROR)
 			{
@@ -1404,6 +1434,7 @@ void NETflush()
 			{
 				socketFlush(connected_bsocket[player], &compressedRawLen);
 				nStats.rawBytes.sent += compressedRawLen;
+				metricBytesSent.add(compressedRawLen);
 			}
 		}
 		for (int player = 0; player < MAX_TMP_SOCKETS; ++player)
@@ -1413,6 +1444,7 @@ void NETflush()
 			{
 				socketFlush(tmp_socket[player], &compressedRawLen);
 				nStats.rawBytes.sent += compressedRawLen;
+				metricBytesSent.add(compressedRawLen);
 			}
 		}
 	}
@@ -1422,6 +1454,7 @@ void NETflush()
 		{
 			socketFlush(bsocket, &compressedRawLen);
 			nStats.rawBytes.sent += compressedRawLen;
+			metricBytesSent.add(compressedRawLen);
 		}
 	}
 }
@@ -1478,6 +1511,7 @@ static bool NETprocessSystemMessage(NETQUEUE playerQueue, uint8_t type)
 					|| message->type == NET_COLOURREQUEST
 					|| message->type == NET_POSITIONREQUEST
 					|| message->type == NET_FILE_CANCELLED
+					|| message->type == NET_FILE_ACK
 					|| message->type == NET_JOIN
 					|| message->type == NET_PLAYER_INFO) && receiver != NET_HOST_ONLY))
 				{
@@ -1874,6 +1908,7 @@ bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 			}
 
 			*type = NETgetMessage(*queue)->type;
+			NETreplaySaveNetMessage(NETgetMessage(*queue), current);
 
 			if (*type == GAME_GAME_TIME)
 			{
@@ -1891,19 +1926,101 @@ bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 
 // ////////////////////////////////////////////////////////////////////////
 // File Transfer programs.
-/** Send file. It returns % of file sent when 100 it's complete. Call until it returns 100. 
-*  @TODO: more error checking (?) different file types (?)
-*          Maybe should close file handle, and seek each time?
-*     
-*  @NOTE: MAX_FILE_TRANSFER_PACKET is set to 2k per packet since 7*2 = 14K which is pretty
-*         much our limit.  Don't screw with that without having a bigger buffer!
-*         NET_BUFFER_SIZE is at 16k.  (also remember text chat, plus all the other cruff)
+/*
+*  The host keeps up to FILE_TRANSFER_WINDOW bytes in flight to each client, and the client acknowledges
+*  what it has written every FILE_TRANSFER_ACK_INTERVAL bytes, so the transfer goes as fast as the
+*  connection allows, instead of one packet per frame. A client which already has the start of the file,
+*  from an aborted download, asks for the rest only. The client checks the hash of the whole file at the end.
 */
 #define MAX_FILE_TRANSFER_PACKET 2048
+#define FILE_TRANSFER_WINDOW (64*1024)
+#define FILE_TRANSFER_ACK_INTERVAL (16*1024)
+
+static Sha256 fileRecvHash;             ///< Hash of the file being downloaded, from its first packet.
+static int32_t fileRecvPos = -1;        ///< Next byte expected, or -1 if we are not downloading.
+static int32_t fileRecvAckedPos = 0;    ///< Last position acknowledged to the host.
+static bool fileRecvRetried = false;    ///< Whether we already downloaded the whole file again, after a wrong hash.
+
+// Where a downloaded map goes.
+static void fileDownloadName(char *fileName, size_t size, char const *name, Sha256 const &fileHash)
+{
+	char mapName[256];
+	sstrcpy(mapName, name);
+	removeWildcards(mapName);
+	if (strlen(mapName) >= 3 && mapName[strlen(mapName) - 3] == '-' && mapName[strlen(mapName) - 2] == 'T' && unsigned(mapName[strlen(mapName) - 1] - '1') < 3)
+	{
+		mapName[strlen(mapName) - 3] = '\0';  // Cut off "-T1", "-T2" or "-T3".
+	}
+	snprintf(fileName, size, "maps/%dc-%s-%s.wz", game.maxPlayers, mapName, fileHash.toString().c_str());  // Wonder whether game.maxPlayers is initialised already?
+}
+
+static int32_t fileLength(char const *fileName)
+{
+	PHYSFS_file *file = PHYSFS_openRead(fileName);
+	if (file == NULL)
+	{
+		return 0;
+	}
+	int32_t length = PHYSFS_fileLength(file);
+	PHYSFS_close(file);
+	return std::max(length, 0);
+}
+
+static void NETrequestFileFrom(int32_t offset)
+{
+	uint32_t player = selectedPlayer;
+
+	fileRecvPos = -1;  // Wait for the first packet of the new transfer.
+	NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_REQUESTED);
+		NETuint32_t(&player);
+		NETint32_t(&offset);
+	NETend();
+}
+
+void NETrequestFile(char const *fileName, Sha256 const &fileHash)
+{
+	if (NetPlay.pMapFileHandle != NULL && fileRecvHash == fileHash)
+	{
+		return;  // Already downloading it, asking again would only make the host start over.
+	}
+
+	char downloadName[256];
+	fileDownloadName(downloadName, sizeof(downloadName), fileName, fileHash);
+	// The name contains the hash, so if it exists, it is the start of the same file.
+	int32_t offset = fileLength(downloadName);
+	if (offset != 0)
+	{
+		debug(LOG_INFO, "Resuming download of %s at byte %d", downloadName, offset);
+	}
+	fileRecvRetried = false;
+	NETrequestFileFrom(offset);
+}
+
+bool NETstartSendFile(PHYSFS_file *pFileHandle, int32_t offset, UDWORD player)
+{
+	WZFile &file = NetPlay.players[player].wzFile;
+
+	if (file.isSending)
+	{
+		PHYSFS_close(file.pFileHandle);  // Asked again, start over from where the client is now.
+	}
+	file.pFileHandle = pFileHandle;
+	file.fileSize_32 = PHYSFS_fileLength(pFileHandle);  // We don't support 64bit int nettypes.
+	file.currPos = clip(offset, 0, file.fileSize_32);
+	file.startPos = file.currPos;
+	file.ackedPos = file.currPos;
+	file.isSending = true;
+	file.isCancelled = false;
+	NetPlay.players[player].needFile = true;
+	return PHYSFS_seek(pFileHandle, file.currPos) != 0;
+}
+
+/** Send file. It returns % of file sent when 100 it's complete. Call until it returns 100.
+*  Sends as much as the window allows, the first packet of a transfer has the file name and hash.
+*/
 int NETsendFile(char *fileName, Sha256 const &fileHash, UDWORD player)
 {
-	uint32_t        bytesToRead = 0;
-	uint8_t		sendto = 0;
+	WZFile &file = NetPlay.players[player].wzFile;
 	uint8_t         inBuff[MAX_FILE_TRANSFER_PACKET];
 
 	// We are not the host, so we don't care. (in fact, this would be a error)
@@ -1913,81 +2030,81 @@ int NETsendFile(char *fileName, Sha256 const &fileHash, UDWORD player)
 		return true;
 	}
 
-	memset(inBuff, 0x0, sizeof(inBuff));
+	while (file.isSending && (file.currPos == file.startPos || file.currPos - file.ackedPos < FILE_TRANSFER_WINDOW))
+	{
+		// read some bytes.
+		uint32_t bytesToRead = PHYSFS_read(file.pFileHandle, inBuff, 1, std::min(file.fileSize_32 - file.currPos, MAX_FILE_TRANSFER_PACKET));
+		ASSERT_OR_RETURN(100, (int32_t)bytesToRead >= 0, "Error reading file.");
 
-	// read some bytes.
-	bytesToRead = PHYSFS_read(NetPlay.players[player].wzFile.pFileHandle, inBuff, 1, MAX_FILE_TRANSFER_PACKET);
-	ASSERT_OR_RETURN(100, (int32_t)bytesToRead >= 0, "Error reading file.");
-	sendto = (uint8_t) player;
+		NETbeginEncode(NETnetQueue(player), NET_FILE_PAYLOAD);
+			NETint32_t(&file.fileSize_32);          // total bytes in this file. (we don't support 64bit yet)
+			NETuint32_t(&bytesToRead);              // bytes in this packet
+			NETint32_t(&file.currPos);              // start byte
+			NETint32_t(&file.startPos);             // start byte of the first packet
+			if (file.currPos == file.startPos)
+			{
+				NETstring(fileName, 256);  //256 = max filename size
+				NETbin(const_cast<uint8_t *>(fileHash.bytes), fileHash.Bytes);  // const_cast ok since we're encoding, not decoding.
+			}
+			NETbin(inBuff, bytesToRead);
+		NETend();
+		nStats.fileBytes.sent += bytesToRead;
 
-	NETbeginEncode(NETnetQueue(sendto), NET_FILE_PAYLOAD);
-		NETint32_t(&NetPlay.players[player].wzFile.fileSize_32);		// total bytes in this file. (we don't support 64bit yet)
-		NETuint32_t(&bytesToRead);                                                // bytes in this packet
-		NETint32_t(&NetPlay.players[player].wzFile.currPos);			// start byte
-		if (NetPlay.players[player].wzFile.currPos == 0)
+		file.currPos += bytesToRead;		// update position!
+		if (file.currPos == file.fileSize_32)
 		{
-			NETstring(fileName, 256);  //256 = max filename size
-			NETbin(const_cast<uint8_t *>(fileHash.bytes), fileHash.Bytes);  // const_cast ok since we're encoding, not decoding.
+			PHYSFS_close(file.pFileHandle);
+			file.pFileHandle = NULL;
+			file.isSending = false;	// we are done sending to this client.
+			NetPlay.players[player].needFile = false;
+		}
+		else if (bytesToRead == 0)
+		{
+			debug(LOG_ERROR, "File ended before its length, at byte %d of %d.", file.currPos, file.fileSize_32);
+			return 100;
 		}
-		NETbin(inBuff, bytesToRead);
-	NETend();
-
-	NetPlay.players[player].wzFile.currPos += bytesToRead;		// update position!
-	if(NetPlay.players[player].wzFile.currPos == NetPlay.players[player].wzFile.fileSize_32)
-	{
-		PHYSFS_close(NetPlay.players[player].wzFile.pFileHandle);
-		NetPlay.players[player].wzFile.isSending = false;	// we are done sending to this client.
-		NetPlay.players[player].needFile = false;
 	}
 
-	return (NetPlay.players[player].wzFile.currPos * 100) / NetPlay.players[player].wzFile.fileSize_32;
+	return file.fileSize_32 != 0 ? (int64_t)file.currPos * 100 / file.fileSize_32 : 100;
 }
 
-/* @TODO more error checking (?) different file types (?) */
-// recv file. it returns % of the file so far recvd.
-UBYTE NETrecvFile(NETQUEUE queue)
+void NETrecvFileAck(NETQUEUE queue)
 {
-	uint32_t        bytesToRead = 0;
-	int32_t		fileSize = 0, currPos = 0;
-	uint8_t         outBuff[MAX_FILE_TRANSFER_PACKET];
-	static bool isLoop = false;
+	int32_t pos = 0;
 
-	memset(outBuff, 0x0, sizeof(outBuff));
-
-	//read incoming bytes.
-	NETbeginDecode(queue, NET_FILE_PAYLOAD);
-	NETint32_t(&fileSize);		// total bytes in this file.
-	NETuint32_t(&bytesToRead);      // bytes in this packet
-	NETint32_t(&currPos);		// start byte
+	NETbeginDecode(queue, NET_FILE_ACK);
+		NETint32_t(&pos);
+	NETend();
 
-	if (currPos == 0)	// first packet!
+	WZFile &file = NetPlay.players[queue.index].wzFile;
+	if (file.isSending && pos >= file.ackedPos && pos <= file.currPos)
 	{
-		char mapName[256];
-		Sha256 fileHash;
-		memset(mapName, 0x0, sizeof(mapName));
-		fileHash.setZero();
-		// Read filename and hash (only valid on 1st packet)
-		NETstring(mapName, 256);
-		NETbin(fileHash.bytes, fileHash.Bytes);
+		file.ackedPos = pos;
+	}
+}
 
-		removeWildcards(mapName);
-		char fileName[256];
-		if (strlen(mapName) >= 3 && mapName[strlen(mapName) - 3] == '-' && mapName[strlen(mapName) - 2] == 'T' && unsigned(mapName[strlen(mapName) - 1] - '1') < 3)
+// Opens the file, which starts at startPos, and returns false if we already have all of it.
+static bool NETopenRecvFile(char const *fileName, int32_t startPos)
+{
+	if (startPos != 0)
+	{
+		// Resuming, check that the file is still as long as when we asked.
+		if (fileLength(fileName) != startPos)
 		{
-			mapName[strlen(mapName) - 3] = '\0';  // Cut off "-T1", "-T2" or "-T3".
+			debug(LOG_NET, "%s changed since we asked to resume it, downloading all of it.", fileName);
+			NETrequestFileFrom(0);
+			return true;
 		}
-		snprintf(fileName, sizeof(fileName), "maps/%dc-%s-%s.wz", game.maxPlayers, mapName, fileHash.toString().c_str());  // Wonder whether game.maxPlayers is initialised already?
-
-		debug(LOG_INFO, "Creating new file %s hash %s", fileName, fileHash.toString().c_str());
-
+		NetPlay.pMapFileHandle = PHYSFS_openAppend(fileName);
+	}
+	else
+	{
 		if (PHYSFS_exists(fileName))
 		{
 			PHYSFS_file *fin;
 			fin = PHYSFS_openRead(fileName);
 			if (!fin)
 			{
-				NETend();
-
 				// the file exists, but we can't open it, and I have no clue how to fix this...
 				debug(LOG_FATAL, "PHYSFS_openRead(\"%s\") failed with error: %s\n", fileName, PHYSFS_getLastError());
 
@@ -2002,56 +2119,134 @@ UBYTE NETrecvFile(NETQUEUE queue)
 
 				abort();
 			}
+			PHYSFS_close(fin);
 			Sha256 ourHash = findHashOfFile(fileName);
-			if (ourHash == fileHash)
+			if (ourHash == fileRecvHash)
 			{
+				static bool isLoop = false;
 				uint32_t reason = ALREADY_HAVE_FILE;
 				debug(LOG_NET, "We already have the file %s! ", fileName);
-				PHYSFS_close(fin);
-				NETend();
 
-				NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_CANCELLED);
-					NETuint32_t(&selectedPlayer);
-					NETuint32_t(&reason);
-				NETend();
 				if (!isLoop)
 				{
 					isLoop = true;
 				}
 				else
 				{
-					uint32_t reason = STUCK_IN_FILE_LOOP;
-	
-					NETend();
 					// we should never get here, it means, that the game can't detect the level, but we have the file.
 					// so we kick this player out.
-					NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_CANCELLED);
-						NETuint32_t(&selectedPlayer);
-						NETuint32_t(&reason);
-					NETend();
-					PHYSFS_close(NetPlay.pMapFileHandle);
-					NetPlay.pMapFileHandle = NULL;
+					reason = STUCK_IN_FILE_LOOP;
 					debug(LOG_FATAL, "Something is really wrong with the file's (%s) data, game can't detect it?", fileName);
 				}
-				return 100;
+				NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_CANCELLED);
+					NETuint32_t(&selectedPlayer);
+					NETuint32_t(&reason);
+				NETend();
+				return false;
 			}
-			PHYSFS_close(fin);
-
-			debug(LOG_NET, "We already have the file %s, but wrong hash, ours %s vs theirs %s.  Redownloading", fileName, ourHash.toString().c_str(), fileHash.toString().c_str());
 
+			debug(LOG_NET, "We already have the file %s, but wrong hash, ours %s vs theirs %s.  Redownloading", fileName, ourHash.toString().c_str(), fileRecvHash.toString().c_str());
 		}
 		NetPlay.pMapFileHandle = PHYSFS_openWrite(fileName);	// create a new file.
-		sstrcpy(NetPlay.mapFileName, fileName);
 	}
 
-	debug(LOG_NET, "New file position is %d", currPos);
-
 	if (!NetPlay.pMapFileHandle) // file can't be opened
 	{
 		debug(LOG_FATAL, "Fatal error while creating file: %s", PHYSFS_getLastError());
 		debug(LOG_FATAL, "Either we do not have write permission, or the host sent us a invalid file!");
 		abort();
 	}
+	sstrcpy(NetPlay.mapFileName, fileName);
+	fileRecvPos = startPos;
+	fileRecvAckedPos = startPos;
+	return true;
+}
+
+// Checks the downloaded file, and downloads it again if it is wrong. Returns true if it is good.
+static bool NETcheckRecvFile(int32_t fileSize)
+{
+	int noError = PHYSFS_close(NetPlay.pMapFileHandle);
+	if (noError == 0)
+	{
+		debug(LOG_ERROR, "Could not close file handle after trying to save map: %s", PHYSFS_getLastError());
+	}
+	NetPlay.pMapFileHandle = NULL;
+	fileRecvPos = -1;
+
+	int32_t actualFileSize = fileLength(NetPlay.mapFileName);
+	Sha256 actualHash = findHashOfFile(NetPlay.mapFileName);
+	if (actualFileSize == fileSize && actualHash == fileRecvHash)
+	{
+		NetPlay.mapFileName[0] = '\0';
+		return true;
+	}
+
+	debug(LOG_ERROR, "Downloaded %s is wrong, got %d bytes hash %s, expected %d bytes hash %s.", NetPlay.mapFileName, actualFileSize, actualHash.toString().c_str(), fileSize, fileRecvHash.toString().c_str());
+	PHYSFS_delete(NetPlay.mapFileName);
+	NetPlay.mapFileName[0] = '\0';
+	if (!fileRecvRetried)
+	{
+		fileRecvRetried = true;
+		NETrequestFileFrom(0);
+	}
+	else
+	{
+		uint32_t reason = STUCK_IN_FILE_LOOP;
+
+		NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_CANCELLED);
+			NETuint32_t(&selectedPlayer);
+			NETuint32_t(&reason);
+		NETend();
+	}
+	return false;
+}
+
+/* @TODO more error checking (?) different file types (?) */
+// recv file. it returns % of the file so far recvd.
+UBYTE NETrecvFile(NETQUEUE queue)
+{
+	uint32_t        bytesToRead = 0;
+	int32_t		fileSize = 0, currPos = 0, startPos = 0;
+	uint8_t         outBuff[MAX_FILE_TRANSFER_PACKET];
+
+	//read incoming bytes.
+	NETbeginDecode(queue, NET_FILE_PAYLOAD);
+	NETint32_t(&fileSize);		// total bytes in this file.
+	NETuint32_t(&bytesToRead);      // bytes in this packet
+	NETint32_t(&currPos);		// start byte
+	NETint32_t(&startPos);		// start byte of the first packet
+
+	if (currPos == startPos)	// first packet!
+	{
+		char mapName[256];
+		memset(mapName, 0x0, sizeof(mapName));
+		fileRecvHash.setZero();
+		// Read filename and hash (only valid on 1st packet)
+		NETstring(mapName, 256);
+		NETbin(fileRecvHash.bytes, fileRecvHash.Bytes);
+
+		char fileName[256];
+		fileDownloadName(fileName, sizeof(fileName), mapName, fileRecvHash);
+		debug(LOG_INFO, "Receiving file %s hash %s from byte %d", fileName, fileRecvHash.toString().c_str(), startPos);
+
+		if (NetPlay.pMapFileHandle != NULL)
+		{
+			PHYSFS_close(NetPlay.pMapFileHandle);  // The host started over.
+			NetPlay.pMapFileHandle = NULL;
+		}
+		if (!NETopenRecvFile(fileName, startPos))
+		{
+			NETend();
+			return 100;
+		}
+	}
+
+	if (currPos != fileRecvPos || NetPlay.pMapFileHandle == NULL)
+	{
+		// Left over from a transfer we restarted, or we are waiting for the host to start again.
+		NETend();
+		return 0;
+	}
 
 	if (bytesToRead > sizeof(outBuff))
 	{
@@ -2062,27 +2257,28 @@ UBYTE NETrecvFile(NETQUEUE queue)
 
 	NETbin(outBuff, bytesToRead);
 	NETend();
+	nStats.fileBytes.received += bytesToRead;
 
 	//write packet to the file.
 	PHYSFS_write(NetPlay.pMapFileHandle, outBuff, bytesToRead, 1);
+	fileRecvPos += bytesToRead;
 
-	if (currPos + bytesToRead == fileSize)	// last packet
+	// Let the host send more.
+	if (fileRecvPos - fileRecvAckedPos >= FILE_TRANSFER_ACK_INTERVAL || fileRecvPos == fileSize)
 	{
-		int noError = PHYSFS_close(NetPlay.pMapFileHandle);
-		if (noError == 0)
-		{
-			debug(LOG_ERROR, "Could not close file handle after trying to save map: %s", PHYSFS_getLastError());
-		}
-		NetPlay.pMapFileHandle = NULL;
-		PHYSFS_File *file = PHYSFS_openRead(NetPlay.mapFileName);
-		int actualFileSize = PHYSFS_fileLength(file);
-		PHYSFS_close(file);
-		NetPlay.mapFileName[0] = '\0';
-		ASSERT(actualFileSize == fileSize, "Downloaded map too small! Got %d, expected %d!", actualFileSize, fileSize);
+		fileRecvAckedPos = fileRecvPos;
+		NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_ACK);
+			NETint32_t(&fileRecvAckedPos);
+		NETend();
+	}
+
+	if (fileRecvPos == fileSize)	// last packet
+	{
+		return NETcheckRecvFile(fileSize) ? 100 : 0;
 	}
 
 	//return the percentage count
-	return ((currPos + bytesToRead) * 100) / fileSize;
+	return (int64_t)fileRecvPos * 100 / fileSize;
 }
 
 static ssize_t readLobbyResponse(Socket* sock, unsigned int timeout)
@@ -3075,6 +3271,32 @@ const char* NETgetMasterserverName()
 	return masterserver_name;
 }
 
+/*!
+ * Set the addresses of the relays that players may join through. The players of a relay all
+ * join from its address, so kicking one of them doesn't ban that address.
+ * \param addresses Comma separated IP addresses, as shown when a player joins
+ */
+void NETsetRelayAddresses(const char *addresses)
+{
+	char *out = relay_addresses;
+	for (const char *in = addresses; *in != '\0' && out < relay_addresses + sizeof(relay_addresses) - 1; ++in)
+	{
+		if (*in != ' ')
+		{
+			*out++ = *in;
+		}
+	}
+	*out = '\0';
+}
+
+/**
+ * @return The addresses of the relays, comma separated.
+ */
+const char *NETgetRelayAddresses()
+{
+	return relay_addresses;
+}
+
 /*!
  * Set the masterserver port
  * \param port The port of the masterserver to connect to
@@ -3650,6 +3872,7 @@ const char *messageTypeToString(unsigned messageType_)
 		case NET_FILE_REQUESTED:            return "NET_FILE_REQUESTED";
 		case NET_FILE_CANCELLED:            return "NET_FILE_CANCELLED";
 		case NET_FILE_PAYLOAD:              return "NET_FILE_PAYLOAD";
+		case NET_FILE_ACK:                  return "NET_FILE_ACK";
 		case NET_DEBUG_SYNC:                return "NET_DEBUG_SYNC";
 		case NET_MAX_TYPE:                  return "NET_MAX_TYPE";
 
@@ -3702,6 +3925,30 @@ static bool onBanList(const char *ip)
 	return false;
 }
 
+/**
+ * Check if ip is the address of a relay.
+ * \param ip IP address converted to text
+ */
+static bool isRelayAddress(const char *ip)
+{
+	size_t length = strlen(ip);
+	const char *address = relay_addresses;
+	while (*address != '\0')
+	{
+		const char *end = strchr(address, ',');
+		if (end == NULL)
+		{
+			end = address + strlen(address);
+		}
+		if ((size_t)(end - address) == length && strncmp(address, ip, length) == 0)
+		{
+			return true;
+		}
+		address = *end == ',' ? end + 1 : end;
+	}
+	return false;
+}
+
 /**
  * Create the banned list.
  * \param ip IP address in text format
@@ -3711,6 +3958,12 @@ static void addToBanList(const char *ip, const char *name)
 {
 	static int numBans = 0;
 
+	if (isRelayAddress(ip))
+	{
+		// Banning the relay would ban everyone joining through it.
+		debug(LOG_INFO, "Not banning %s, who joined through the relay at %s.", name, ip);
+		return;
+	}
 	if (!IPlist)
 	{
 		IPlist = (PLAYER_IP *)malloc(sizeof(PLAYER_IP) * MAX_BANS + 1);
@@ -88,6 +88,7 @@ enum MESSAGE_TYPES
 	NET_FILE_REQUESTED,             ///< Player has requested a file (map/mod/?)
 	NET_FILE_CANCELLED,             ///< Player cancelled a file request
 	NET_FILE_PAYLOAD,               ///< sending file to the player that needs it
+	NET_FILE_ACK,                   ///< Player has written the file up to here, so the host can send more
 	NET_DEBUG_SYNC,                 ///< Synch error messages, so people don't have to use pastebin.
 	NET_MAX_TYPE,                   ///< Maximum+1 valid NET_ type, *MUST* be last.
 
@@ -199,6 +200,8 @@ struct WZFile
 	PHYSFS_file	*pFileHandle;		// handle
 	PHYSFS_sint32 fileSize_32;		// size
 	int32_t		currPos;			// current position
+	int32_t		startPos;			// position of the first packet sent
+	int32_t		ackedPos;			// position the player has received
 	bool	isSending;				// sending to this player
 	bool	isCancelled;			// player cancelled
 	int32_t	filetype;				// future use (1=map 2=mod 3=...)
@@ -294,8 +297,11 @@ extern bool NETrecvNet(NETQUEUE *queue, uint8_t *type);                  ///< re
 extern bool NETrecvGame(NETQUEUE *queue, uint8_t *type);                 ///< recv a message from the game queues which is sceduled to execute by time, if possible.
 void NETflush(void);                                                     ///< Flushes any data stuck in compression buffers.
 
+void NETrequestFile(char const *fileName, Sha256 const &fileHash);      ///< Asks the host for a file, or the rest of it, if we have the start.
+bool NETstartSendFile(PHYSFS_file *pFileHandle, int32_t offset, UDWORD player);  ///< Starts sending a file from offset, after a player asked for it.
 int NETsendFile(char *mapName, Sha256 const &fileHash, UDWORD player);  // send file chunk.
 extern UBYTE   NETrecvFile(NETQUEUE queue);                     // recv file chunk
+void NETrecvFileAck(NETQUEUE queue);                                     ///< Lets the host send more of a file.
 
 extern int NETclose(void);					// close current game
 extern int NETshutdown(void);					// leave the game in play.
@@ -304,7 +310,7 @@ extern void NETaddRedirects(void);
 extern void NETremRedirects(void);
 extern void NETdiscoverUPnPDevices(void);
 
-enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets};
+enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets, NetStatisticFileBytes, NetStatisticCompressionTime, NetStatisticCompressionRatio};
 unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal = false);     // Return some statistic. Call regularly for good results.
 
 extern void NETplayerKicked(UDWORD index);			// Cleanup after player has been kicked
@@ -325,6 +331,8 @@ void            NETfixDuplicatePlayerNames(void);  // Change a player's name aut
 
 extern void NETsetMasterserverName(const char* hostname);
 extern const char* NETgetMasterserverName(void);
+extern void NETsetRelayAddresses(const char *addresses);
+extern const char *NETgetRelayAddresses(void);
 extern void NETsetMasterserverPort(unsigned int port);
 extern unsigned int NETgetMasterserverPort(void);
 extern void NETsetGameserverPort(unsigned int port);
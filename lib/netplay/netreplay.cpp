@@ -0,0 +1,260 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * netreplay.cpp
+ *
+ * A replay file is "WZRP", a version and the length of the settings, all big endian uint32_t,
+ * followed by the settings, and then one record per processed message:
+ *   gameTime - gameTime of the previous record, as an encoded uint32_t
+ *   player, whose game queue the message is from, or REPLAY_END after the last message
+ *   the message, as from NetMessage::rawDataDup()
+ */
+// ////////////////////////////////////////////////////////////////////////
+// Includes
+#include "lib/framework/frame.h"
+#include "lib/gamelib/gtime.h"
+
+#include <physfs.h>
+#include <string.h>
+
+#include "netreplay.h"
+#include "netplay.h"
+#include "netqueue.h"
+
+#define REPLAY_VERSION 2
+#define REPLAY_END 0xFF
+#define REPLAY_FLUSH_SIZE (64*1024)
+
+static PHYSFS_file *replaySaveHandle = NULL;
+static std::vector<uint8_t> replaySaveBuffer;      ///< Records not yet written to the file.
+static uint32_t replaySaveTime = 0;               ///< gameTime of the last record written.
+
+static std::vector<uint8_t> replayLoadData;        ///< The whole replay file.
+static size_t replayLoadPos = 0;                   ///< Start of the next record in replayLoadData.
+static uint32_t replayLoadTime = 0;               ///< gameTime of the last record read.
+static bool replayLoadFinished = false;
+static bool replayLoading = false;
+
+static void replayPutUint32(uint32_t v)
+{
+	unsigned length = encodedlength_uint32_t(v);
+	for (unsigned n = 0; n < length; ++n)
+	{
+		uint8_t b;
+		encode_uint32_t(b, v, n);
+		replaySaveBuffer.push_back(b);
+	}
+}
+
+// Returns false if the replay ends in the middle of the number.
+static bool replayGetUint32(uint32_t *v)
+{
+	*v = 0;
+	for (unsigned n = 0; replayLoadPos < replayLoadData.size(); ++n)
+	{
+		if (!decode_uint32_t(replayLoadData[replayLoadPos++], *v, n))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool replayFlush(void)
+{
+	bool ok = replaySaveBuffer.empty() || PHYSFS_write(replaySaveHandle, &replaySaveBuffer[0], replaySaveBuffer.size(), 1) == 1;
+	replaySaveBuffer.clear();
+	return ok;
+}
+
+bool NETreplaySaveStart(char const *fileName, std::vector<uint8_t> const &settings)
+{
+	ASSERT_OR_RETURN(false, replaySaveHandle == NULL, "Already recording a replay.");
+
+	replaySaveHandle = PHYSFS_openWrite(fileName);
+	if (replaySaveHandle == NULL)
+	{
+		debug(LOG_ERROR, "Could not create replay %s: %s", fileName, PHYSFS_getLastError());
+		return false;
+	}
+	if (PHYSFS_write(replaySaveHandle, "WZRP", 4, 1) != 1
+	    || !PHYSFS_writeUBE32(replaySaveHandle, REPLAY_VERSION)
+	    || !PHYSFS_writeUBE32(replaySaveHandle, settings.size())
+	    || (!settings.empty() && PHYSFS_write(replaySaveHandle, &settings[0], settings.size(), 1) != 1))
+	{
+		debug(LOG_ERROR, "Could not write replay %s: %s", fileName, PHYSFS_getLastError());
+		PHYSFS_close(replaySaveHandle);
+		replaySaveHandle = NULL;
+		return false;
+	}
+	replaySaveBuffer.clear();
+	replaySaveTime = gameTime;
+	debug(LOG_INFO, "Recording replay %s", fileName);
+	return true;
+}
+
+bool NETreplaySaveStop(void)
+{
+	if (replaySaveHandle == NULL)
+	{
+		return false;
+	}
+
+	replayPutUint32(gameTime - replaySaveTime);
+	replaySaveBuffer.push_back(REPLAY_END);
+	bool ok = replayFlush();
+	ok = PHYSFS_close(replaySaveHandle) != 0 && ok;
+	replaySaveHandle = NULL;
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not write replay: %s", PHYSFS_getLastError());
+	}
+	return ok;
+}
+
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player)
+{
+	if (replaySaveHandle == NULL)
+	{
+		return;
+	}
+
+	replayPutUint32(gameTime - replaySaveTime);
+	replaySaveTime = gameTime;
+	replaySaveBuffer.push_back(player);
+	uint8_t *raw = message->rawDataDup();
+	replaySaveBuffer.insert(replaySaveBuffer.end(), raw, raw + message->rawLen());
+	delete[] raw;
+
+	if (replaySaveBuffer.size() >= REPLAY_FLUSH_SIZE && !replayFlush())
+	{
+		debug(LOG_ERROR, "Could not write replay, stopping recording: %s", PHYSFS_getLastError());
+		PHYSFS_close(replaySaveHandle);
+		replaySaveHandle = NULL;
+	}
+}
+
+bool NETreplayLoadStart(char const *fileName, std::vector<uint8_t> *settings)
+{
+	PHYSFS_file *handle = PHYSFS_openRead(fileName);
+	if (handle == NULL)
+	{
+		debug(LOG_ERROR, "Could not open replay %s: %s", fileName, PHYSFS_getLastError());
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0, settingsSize = 0;
+	PHYSFS_sint64 fileSize = PHYSFS_fileLength(handle);
+	bool ok = PHYSFS_read(handle, magic, 4, 1) == 1
+	          && PHYSFS_readUBE32(handle, &version)
+	          && PHYSFS_readUBE32(handle, &settingsSize)
+	          && memcmp(magic, "WZRP", 4) == 0
+	          && version == REPLAY_VERSION
+	          && settingsSize <= fileSize - 12;
+	if (ok)
+	{
+		settings->resize(settingsSize);
+		replayLoadData.resize(fileSize - 12 - settingsSize);
+		ok = (settings->empty() || PHYSFS_read(handle, &(*settings)[0], settings->size(), 1) == 1)
+		     && (replayLoadData.empty() || PHYSFS_read(handle, &replayLoadData[0], replayLoadData.size(), 1) == 1);
+	}
+	PHYSFS_close(handle);
+	if (!ok)
+	{
+		debug(LOG_ERROR, "%s is not a replay of this version.", fileName);
+		replayLoadData.clear();
+		return false;
+	}
+
+	replayLoadPos = 0;
+	replayLoadTime = 0;
+	replayLoadFinished = false;
+	replayLoading = true;
+	debug(LOG_INFO, "Playing replay %s", fileName);
+	return true;
+}
+
+void NETreplayLoadNetMessages(uint32_t untilTime)
+{
+	while (!replayLoadFinished)
+	{
+		size_t recordPos = replayLoadPos;
+		uint32_t deltaTime;
+		if (!replayGetUint32(&deltaTime) || replayLoadPos >= replayLoadData.size())
+		{
+			debug(LOG_ERROR, "Replay ends without an end marker.");
+			replayLoadFinished = true;
+			break;
+		}
+		if (replayLoadTime + deltaTime > untilTime)
+		{
+			replayLoadPos = recordPos;  // Not yet.
+			break;
+		}
+		replayLoadTime += deltaTime;
+
+		uint8_t player = replayLoadData[replayLoadPos++];
+		if (player == REPLAY_END)
+		{
+			replayLoadFinished = true;
+			break;
+		}
+
+		uint32_t size;
+		if (player >= MAX_PLAYERS || replayLoadPos >= replayLoadData.size())
+		{
+			debug(LOG_ERROR, "Broken replay record at byte %u.", (unsigned)recordPos);
+			replayLoadFinished = true;
+			break;
+		}
+		NetMessage message(replayLoadData[replayLoadPos++]);
+		if (!replayGetUint32(&size) || size > replayLoadData.size() - replayLoadPos)
+		{
+			debug(LOG_ERROR, "Broken replay record at byte %u.", (unsigned)recordPos);
+			replayLoadFinished = true;
+			break;
+		}
+		message.data.assign(replayLoadData.begin() + replayLoadPos, replayLoadData.begin() + replayLoadPos + size);
+		replayLoadPos += size;
+
+		NETinsertMessageFromNet(NETgameQueue(player), &message);
+	}
+}
+
+bool NETreplayLoadFinished(void)
+{
+	return replayLoadFinished;
+}
+
+uint32_t NETreplayLoadEndTime(void)
+{
+	return replayLoadTime;
+}
+
+void NETreplayLoadStop(void)
+{
+	replayLoadData.clear();
+	replayLoading = false;
+}
+
+bool NETisReplay(void)
+{
+	return replayLoading;
+}
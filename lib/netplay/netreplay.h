@@ -0,0 +1,47 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file netreplay.h
+ *  Recording and playback of the game queues.
+ *
+ *  Since the game is lockstep, the messages processed from the game queues, including
+ *  GAME_GAME_TIME, are all that is needed to repeat a game, given the settings it started with.
+ *  The settings are opaque here, the game encodes them.
+ */
+#ifndef _netreplay_h
+#define _netreplay_h
+
+#include "lib/framework/frame.h"
+
+#include <vector>
+
+class NetMessage;
+
+bool NETreplaySaveStart(char const *fileName, std::vector<uint8_t> const &settings);  ///< Starts recording the game queues.
+bool NETreplaySaveStop(void);                                                         ///< Finishes the replay file.
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player);              ///< Records a message, when it is processed from a game queue.
+
+bool NETreplayLoadStart(char const *fileName, std::vector<uint8_t> *settings);       ///< Opens a replay, and returns the settings the game started with.
+void NETreplayLoadNetMessages(uint32_t untilTime);                                  ///< Inserts the messages processed up to untilTime into the game queues.
+bool NETreplayLoadFinished(void);                                                   ///< True once all messages have been inserted.
+uint32_t NETreplayLoadEndTime(void);                                                ///< gameTime at the end of the replay, once finished.
+void NETreplayLoadStop(void);
+
+bool NETisReplay(void);                                                             ///< True while playing a replay, when the game queues must only contain recorded messages.
+
+#endif // _netreplay_h
@@ -29,9 +29,14 @@
 
 #include <vector>
 #include <algorithm>
-#include <map>
+#include <set>
 
 #include <zlib.h>
+#include <QtCore/QElapsedTimer>
+
+#if defined(HAVE_SYS_EPOLL_H)
+# include <sys/epoll.h>
+#endif
 
 enum
 {
@@ -41,6 +46,105 @@ enum
 	SOCK_COUNT,
 };
 
+#define SOCKET_COMPRESSION_LEVEL 6              ///< zlib level to start with.
+#define SOCKET_COMPRESSION_ADAPT_INTERVAL 2000  ///< Milliseconds between reconsidering the compression level of a socket.
+#define SOCKET_COMPRESSION_BUDGET 2000          ///< Microseconds per second a socket may spend compressing, before it lowers the level.
+#define SOCKET_COMPRESSION_BACKLOG 8192         ///< Bytes waiting to be sent, above which a socket is limited by bandwidth, and raises the level.
+
+/// Preset zlib dictionary, so that the start of the stream compresses as well as the rest.
+/// It is two game ticks of a 4 player game, as the host sends them: NET_SHARE_GAME_QUEUE messages with
+/// GAME_GAME_TIME, and a GAME_DROIDINFO move order, wrapped in NET_SEND_TO_PLAYER for the other players,
+/// followed by a NET_PING. Both ends must use the same dictionary, so changing it changes the netcode version.
+static const uint8_t socketCompressionDictionary[] =
+{
+	0x3A, 0x21, 0x00, 0x02, 0x70, 0x13, 0x00, 0x01, 0x02, 0xFF, 0xFE, 0x01, 0xFF, 0xDC, 0x00, 0x00,
+	0x04, 0xBD, 0xDC, 0x01, 0x0A, 0xC6, 0x99, 0xB4, 0x00, 0x78, 0x08, 0x02, 0xB5, 0xDC, 0x06, 0x96,
+	0x61, 0x00, 0x00, 0x39, 0x10, 0x01, 0xFF, 0x3A, 0x0C, 0x01, 0x01, 0x78, 0x08, 0x02, 0xB5, 0xDC,
+	0x06, 0xBE, 0x7E, 0x00, 0x00, 0x39, 0x10, 0x02, 0xFF, 0x3A, 0x0C, 0x02, 0x01, 0x78, 0x08, 0x02,
+	0xB5, 0xDC, 0x06, 0x1B, 0x73, 0x00, 0x00, 0x39, 0x10, 0x03, 0xFF, 0x3A, 0x0C, 0x03, 0x01, 0x78,
+	0x08, 0x02, 0xB5, 0xDC, 0x06, 0x22, 0x7A, 0x00, 0x00, 0x22, 0x02, 0x00, 0x01, 0x3A, 0x0C, 0x00,
+	0x01, 0x78, 0x08, 0x02, 0xED, 0xDA, 0x06, 0x62, 0x99, 0x00, 0x00, 0x39, 0x26, 0x01, 0xFF, 0x3A,
+	0x22, 0x01, 0x02, 0x70, 0x14, 0x01, 0x01, 0x02, 0xDB, 0xD4, 0x01, 0xD9, 0xEF, 0x00, 0x00, 0x04,
+	0xD8, 0xD8, 0x01, 0xBD, 0x51, 0xB6, 0x22, 0xD9, 0x03, 0x78, 0x08, 0x02, 0xED, 0xDA, 0x06, 0x38,
+	0xB9, 0x00, 0x00, 0x39, 0x10, 0x02, 0xFF, 0x3A, 0x0C, 0x02, 0x01, 0x78, 0x08, 0x02, 0xED, 0xDA,
+	0x06, 0x0D, 0x59, 0x00, 0x00, 0x39, 0x10, 0x03, 0xFF, 0x3A, 0x0C, 0x03, 0x01, 0x78, 0x08, 0x02,
+	0xED, 0xDA, 0x06, 0xC2, 0x56, 0x00, 0x00, 0x22, 0x02, 0x00, 0x01,
+};
+
+/// Queue of bytes to send, in a ring buffer, so that sending the start of the queue doesn't move the rest.
+class WriteQueue
+{
+public:
+	WriteQueue() : begin(0), used(0) {}
+
+	bool empty() const { return used == 0; }
+	size_t size() const { return used; }
+
+	void push(uint8_t const *data, size_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		if (used + size > buffer.size())
+		{
+			grow(used + size);
+		}
+		size_t end = (begin + used) & (buffer.size() - 1);
+		size_t first = std::min(size, buffer.size() - end);
+		std::copy(data, data + first, &buffer[end]);
+		std::copy(data + first, data + size, &buffer[0]);
+		used += size;
+	}
+
+	/// Returns the start of the queue, and how many bytes are stored there before the buffer wraps around.
+	size_t front(uint8_t const **data) const
+	{
+		*data = used != 0 ? &buffer[begin] : NULL;
+		return std::min(used, buffer.size() - begin);
+	}
+
+	void pop(size_t size)
+	{
+		begin = (begin + size) & (buffer.size() - 1);
+		used -= size;
+		if (used == 0)
+		{
+			begin = 0;
+		}
+	}
+
+	void clear()
+	{
+		begin = 0;
+		used = 0;
+	}
+
+private:
+	void grow(size_t minSize)
+	{
+		size_t newSize = std::max<size_t>(buffer.size(), 4096);
+		while (newSize < minSize)
+		{
+			newSize *= 2;  // Keep the size a power of 2.
+		}
+		std::vector<uint8_t> newBuffer(newSize);
+		uint8_t const *data;
+		size_t first = front(&data);
+		if (used != 0)
+		{
+			std::copy(data, data + first, &newBuffer[0]);
+			std::copy(&buffer[0], &buffer[0] + (used - first), &newBuffer[first]);
+		}
+		buffer.swap(newBuffer);
+		begin = 0;
+	}
+
+	std::vector<uint8_t> buffer;    ///< Size is 0 or a power of 2.
+	size_t begin;
+	size_t used;
+};
+
 struct Socket
 {
 	/* Multiple socket handles only for listening sockets. This allows us
@@ -49,7 +153,7 @@ struct Socket
 	 *
 	 * All non-listening sockets will only use the first socket handle.
 	 */
-	Socket() : ready(false), writeError(false), deleteLater(false), isCompressed(false), readDisconnected(false), zDeflateInSize(0)
+	Socket() : ready(false), writeError(false), deleteLater(false), writable(true), writeRegistered(false), isCompressed(false), readDisconnected(false), zDeflateInSize(0), zDeflateLevel(SOCKET_COMPRESSION_LEVEL), zDeflateAdaptive(true), zAdaptTime(0), zAdaptNsecs(0)
 	{
 		memset(&zDeflate, 0, sizeof(zDeflate));
 		memset(&zInflate, 0, sizeof(zInflate));
@@ -60,6 +164,9 @@ struct Socket
 	bool ready;
 	bool writeError;
 	bool deleteLater;
+	WriteQueue writeQueue;          ///< Data for the socket thread to send. Protected by socketThreadMutex.
+	bool writable;                  ///< False if the last send would have blocked, so wait for the socket to become writable.
+	bool writeRegistered;           ///< True if added to socketThreadEpoll.
 	char textAddress[40];
 
 	bool isCompressed;
@@ -70,11 +177,18 @@ struct Socket
 	bool zInflateNeedInput;
 	std::vector<uint8_t> zDeflateOutBuf;
 	std::vector<uint8_t> zInflateInBuf;
+	int zDeflateLevel;              ///< Current zlib compression level.
+	bool zDeflateAdaptive;          ///< True if socketFlush may change zDeflateLevel.
+	unsigned zAdaptTime;            ///< wzGetTicks() when zDeflateLevel was last considered.
+	uint64_t zAdaptNsecs;           ///< Time spent compressing since zAdaptTime.
 };
 
 struct SocketSet
 {
+	SocketSet() : epollFd(-1) {}
+
 	std::vector<Socket *> fds;
+	int epollFd;                    ///< Sockets of the set, waiting to be readable, or -1 to use select().
 };
 
 
@@ -82,9 +196,21 @@ static WZ_MUTEX *socketThreadMutex;
 static WZ_SEMAPHORE *socketThreadSemaphore;
 static WZ_THREAD *socketThread = NULL;
 static bool socketThreadQuit;
-typedef std::map<Socket *, std::vector<uint8_t> > SocketThreadWriteMap;
-static SocketThreadWriteMap socketThreadWrites;
+typedef std::set<Socket *> SocketThreadWriteSet;
+static SocketThreadWriteSet socketThreadWrites;  ///< Sockets with data in their writeQueue.
+#if defined(HAVE_SYS_EPOLL_H)
+// If epoll works, the socket thread waits on socketThreadEpoll for sockets to become writable, instead of calling select() with
+// every socket every 50 ms. Sockets are added with EPOLLET, so they are only reported once each time they become writable again.
+static int socketThreadEpoll = -1;
+static int socketThreadWakeup[2] = {-1, -1};  ///< Pipe, also in socketThreadEpoll, to wake the socket thread when a writable socket gets data.
+static bool socketThreadSleeping = false;     ///< True while the socket thread is in epoll_wait, and nobody has woken it yet.
+typedef std::set<Socket *> SocketThreadRegisteredSet;
+static SocketThreadRegisteredSet socketThreadRegistered;  ///< Sockets in socketThreadEpoll, to ignore events for sockets closed since.
+#endif
+
 
+static QElapsedTimer compressionTimer;        ///< Measures the time spent in zlib.
+static uint64_t compressionNsecs[2] = {0, 0};  ///< Time spent decompressing and compressing, by all sockets.
 
 static void socketCloseNow(Socket *sock);
 
@@ -317,7 +443,8 @@ const char* strSockError(int error)
  */
 static bool connectionIsOpen(Socket* sock)
 {
-	const SocketSet set = {std::vector<Socket *>(1, sock)};
+	SocketSet set;
+	set.fds.push_back(sock);
 
 	ASSERT_OR_RETURN((setSockErr(EBADF), false),
 		sock && sock->fd[SOCK_CONNECTION] != INVALID_SOCKET, "Invalid socket");
@@ -359,106 +486,170 @@ static bool connectionIsOpen(Socket* sock)
 	return true;
 }
 
-static int socketThreadFunction(void *)
+enum SOCKET_SEND_RESULT
 {
-	wzMutexLock(socketThreadMutex);
-	while (!socketThreadQuit)
+	SEND_DONE,              ///< The write queue is empty.
+	SEND_BLOCKED,           ///< The socket would block, so wait until it is writable.
+	SEND_FAILED,            ///< The socket is broken.
+};
+
+/// Sends as much of the write queue as the socket accepts without blocking. Must hold socketThreadMutex.
+static SOCKET_SEND_RESULT socketThreadSend(Socket *sock)
+{
+	while (!sock->writeQueue.empty())
 	{
+		uint8_t const *data;
+		size_t size = sock->writeQueue.front(&data);
+
+		// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
+		ssize_t ret = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char const *>(data), size, MSG_NOSIGNAL);
+		if (ret != SOCKET_ERROR)
+		{
+			sock->writeQueue.pop(ret);  // Drop as much data as written.
+			continue;
+		}
+
+		switch (getSockErr())
+		{
+			case EAGAIN:
+#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
+			case EWOULDBLOCK:
+#endif
+				sock->writable = false;
+				return SEND_BLOCKED;
+			case EINTR:
+				break;
+#if defined(EPIPE)
+			case EPIPE:
+				debug(LOG_NET, "EPIPE generated");
+				// fall through
+#endif
+			default:
+				return SEND_FAILED;
+		}
+	}
+	return SEND_DONE;
+}
+
+/// Writes to a socket which is ready for writing, and stops writing to it once there is nothing left to write or it is broken.
+static void socketThreadWrite(Socket *sock, bool checkConnection)
+{
+	SOCKET_SEND_RESULT result = socketThreadSend(sock);
+	if (result == SEND_BLOCKED && checkConnection && !connectionIsOpen(sock))
+	{
+		debug(LOG_NET, "Socket error");
+		result = SEND_FAILED;
+	}
+	if (result == SEND_BLOCKED)
+	{
+		return;
+	}
+
+	if (result == SEND_FAILED)
+	{
+		sock->writeError = true;  // Socket broken, don't try writing to it again.
+		sock->writeQueue.clear();
+	}
+	socketThreadWrites.erase(sock);  // Nothing left to write, delete from pending list.
+	if (sock->deleteLater)
+	{
+		socketCloseNow(sock);
+	}
+}
+
+/// Waits up to 50 ms for sockets to become writable, and writes to them.
+static void socketThreadSelect()
+{
 #if   defined(WZ_OS_UNIX)
-		SOCKET maxfd = INT_MIN;
+	SOCKET maxfd = INT_MIN;
 #elif defined(WZ_OS_WIN)
-		SOCKET maxfd = 0;
+	SOCKET maxfd = 0;
 #endif
-		fd_set fds;
-		FD_ZERO(&fds);
-		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
+	fd_set fds;
+	FD_ZERO(&fds);
+	for (SocketThreadWriteSet::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
+	{
+		SOCKET fd = (*i)->fd[SOCK_CONNECTION];
+		maxfd = std::max(maxfd, fd);
+		ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
+		FD_SET(fd, &fds);
+	}
+	struct timeval tv = {0, 50 * 1000};
+
+	// Check if we can write to any sockets.
+	wzMutexUnlock(socketThreadMutex);
+	int ret = select(maxfd + 1, NULL, &fds, NULL, &tv);
+	wzMutexLock(socketThreadMutex);
+
+	// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
+	if (ret > 0)
+	{
+		for (SocketThreadWriteSet::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); )
 		{
-			if (!i->second.empty())
+			Socket *sock = *i;
+			++i;  // socketThreadWrite may erase sock.
+
+			if (FD_ISSET(sock->fd[SOCK_CONNECTION], &fds))
 			{
-				SOCKET fd = i->first->fd[SOCK_CONNECTION];
-				maxfd = std::max(maxfd, fd);
-				ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
-				FD_SET(fd, &fds);
+				socketThreadWrite(sock, true);
 			}
 		}
-		struct timeval tv = {0, 50 * 1000};
+	}
+}
 
-		// Check if we can write to any sockets.
-		wzMutexUnlock(socketThreadMutex);
-		int ret = select(maxfd + 1, NULL, &fds, NULL, &tv);
-		wzMutexLock(socketThreadMutex);
+#if defined(HAVE_SYS_EPOLL_H)
+/// Writes to sockets until they would block, then waits until some become writable, or socketThreadNotify is called.
+static void socketThreadEpollWait()
+{
+	for (SocketThreadWriteSet::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); )
+	{
+		Socket *sock = *i;
+		++i;  // socketThreadWrite may erase sock.
 
-		// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
-		if (ret > 0)
+		if (sock->writable)
 		{
-			for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); )
-			{
-				SocketThreadWriteMap::iterator w = i;
-				++i;
-
-				Socket *sock = w->first;
-				std::vector<uint8_t> &writeQueue = w->second;
-				ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
+			socketThreadWrite(sock, false);
+		}
+	}
 
-				if (!FD_ISSET(sock->fd[SOCK_CONNECTION], &fds))
-				{
-					continue;  // This socket is not ready for writing, or we don't have anything to write.
-				}
+	struct epoll_event events[64];
+	socketThreadSleeping = true;
+	wzMutexUnlock(socketThreadMutex);
+	int ret = epoll_wait(socketThreadEpoll, events, ARRAY_SIZE(events), -1);
+	wzMutexLock(socketThreadMutex);
+	socketThreadSleeping = false;
 
-				// Write data.
-				// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
-				ssize_t ret = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char *>(&writeQueue[0]), writeQueue.size(), MSG_NOSIGNAL);
-				if (ret != SOCKET_ERROR)
-				{
-					// Erase as much data as written.
-					writeQueue.erase(writeQueue.begin(), writeQueue.begin() + ret);
-					if (writeQueue.empty())
-					{
-						socketThreadWrites.erase(w);  // Nothing left to write, delete from pending list.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-					}
-				}
-				else
-				{
-					switch (getSockErr())
-					{
-						case EAGAIN:
-#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
-						case EWOULDBLOCK:
-#endif
-							if (!connectionIsOpen(sock))
-							{
-								debug(LOG_NET, "Socket error");
-								sock->writeError = true;
-								socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-								if (sock->deleteLater)
-								{
-									socketCloseNow(sock);
-								}
-								break;
-							}
-						case EINTR:
-							break;
-#if defined(EPIPE)
-						case EPIPE:
-							debug(LOG_NET, "EPIPE generated");
-							// fall through
+	for (int n = 0; n < ret; ++n)
+	{
+		Socket *sock = static_cast<Socket *>(events[n].data.ptr);
+		if (sock == NULL)
+		{
+			char buf[64];
+			while (read(socketThreadWakeup[0], buf, sizeof(buf)) > 0)
+			{}
+			continue;
+		}
+		if (socketThreadRegistered.count(sock) != 0)  // Else the socket was closed after epoll_wait returned.
+		{
+			sock->writable = true;  // Also on EPOLLERR or EPOLLHUP, so that send finds the error.
+		}
+	}
+}
 #endif
-						default:
-							sock->writeError = true;
-							socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-							if (sock->deleteLater)
-							{
-								socketCloseNow(sock);
-							}
-							break;
-					}
-				}
-			}
+
+static int socketThreadFunction(void *)
+{
+	wzMutexLock(socketThreadMutex);
+	while (!socketThreadQuit)
+	{
+#if defined(HAVE_SYS_EPOLL_H)
+		if (socketThreadEpoll != -1)
+		{
+			socketThreadEpollWait();
+			continue;
 		}
+#endif
+		socketThreadSelect();
 
 		if (socketThreadWrites.empty())
 		{
@@ -473,6 +664,50 @@ static int socketThreadFunction(void *)
 	return 42;  // Return value arbitrary and unused.
 }
 
+/// Tells the socket thread that there is data in the socket's write queue. Must hold socketThreadMutex.
+static void socketThreadNotify(Socket *sock)
+{
+	bool wasIdle = socketThreadWrites.empty();
+	bool added = socketThreadWrites.insert(sock).second;
+
+#if defined(HAVE_SYS_EPOLL_H)
+	if (socketThreadEpoll != -1)
+	{
+		if (!sock->writeRegistered)
+		{
+			struct epoll_event event;
+			memset(&event, 0, sizeof(event));
+			event.events = EPOLLOUT | EPOLLET;
+			event.data.ptr = sock;
+			if (epoll_ctl(socketThreadEpoll, EPOLL_CTL_ADD, sock->fd[SOCK_CONNECTION], &event) == SOCKET_ERROR)
+			{
+				debug(LOG_ERROR, "Failed to add socket %p to epoll: %s", sock, strSockError(getSockErr()));
+			}
+			sock->writeRegistered = true;
+			socketThreadRegistered.insert(sock);
+		}
+		if (added && sock->writable && socketThreadSleeping)
+		{
+			// The socket won't become writable again, since it already is, so wake the thread to write now.
+			socketThreadSleeping = false;
+			char wake = 0;
+			if (write(socketThreadWakeup[1], &wake, 1) == SOCKET_ERROR && getSockErr() != EAGAIN)
+			{
+				debug(LOG_ERROR, "Failed to wake socket thread: %s", strSockError(getSockErr()));
+			}
+		}
+		return;
+	}
+#else
+	(void)added;
+#endif
+
+	if (wasIdle)
+	{
+		wzSemaphorePost(socketThreadSemaphore);
+	}
+}
+
 /**
  * Similar to read(2) with the exception that this function won't be
  * interrupted by signals (EINTR).
@@ -524,7 +759,13 @@ ssize_t readNoInt(Socket* sock, void* buf, size_t max_size, size_t *rawByteCount
 
 		sock->zInflate.next_out = (Bytef *)buf;
 		sock->zInflate.avail_out = max_size;
+		qint64 startNsecs = compressionTimer.nsecsElapsed();
 		int ret = inflate(&sock->zInflate, Z_NO_FLUSH);
+		if (ret == Z_NEED_DICT && inflateSetDictionary(&sock->zInflate, socketCompressionDictionary, sizeof(socketCompressionDictionary)) == Z_OK)
+		{
+			ret = inflate(&sock->zInflate, Z_NO_FLUSH);
+		}
+		compressionNsecs[false] += compressionTimer.nsecsElapsed() - startNsecs;
 		ASSERT(ret != Z_STREAM_ERROR, "zlib inflate not working!");
 		char const *err = NULL;
 		switch (ret)
@@ -599,12 +840,8 @@ ssize_t writeAll(Socket* sock, const void* buf, size_t size, size_t *rawByteCoun
 		if (!sock->isCompressed)
 		{
 			wzMutexLock(socketThreadMutex);
-			if (socketThreadWrites.empty())
-			{
-				wzSemaphorePost(socketThreadSemaphore);
-			}
-			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-			writeQueue.insert(writeQueue.end(), static_cast<char const *>(buf), static_cast<char const *>(buf) + size);
+			sock->writeQueue.push(static_cast<uint8_t const *>(buf), size);
+			socketThreadNotify(sock);
 			wzMutexUnlock(socketThreadMutex);
 			rawBytes = size;
 		}
@@ -613,6 +850,7 @@ ssize_t writeAll(Socket* sock, const void* buf, size_t size, size_t *rawByteCoun
 			sock->zDeflate.next_in = (Bytef *)buf;
 			sock->zDeflate.avail_in = size;
 			sock->zDeflateInSize += sock->zDeflate.avail_in;
+			qint64 startNsecs = compressionTimer.nsecsElapsed();
 			do
 			{
 				size_t alreadyHave = sock->zDeflateOutBuf.size();
@@ -626,6 +864,9 @@ ssize_t writeAll(Socket* sock, const void* buf, size_t size, size_t *rawByteCoun
 				// Remove unused part of buffer.
 				sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
 			} while(sock->zDeflate.avail_out == 0);
+			qint64 nsecs = compressionTimer.nsecsElapsed() - startNsecs;
+			compressionNsecs[true] += nsecs;
+			sock->zAdaptNsecs += nsecs;
 
 			ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
 		}
@@ -634,6 +875,62 @@ ssize_t writeAll(Socket* sock, const void* buf, size_t size, size_t *rawByteCoun
 	return size;
 }
 
+// Changes the level of the compressed stream. Only between flushes, since any output goes to zDeflateOutBuf.
+static void socketSetDeflateLevel(Socket *sock, int level)
+{
+	size_t alreadyHave = sock->zDeflateOutBuf.size();
+	sock->zDeflateOutBuf.resize(alreadyHave + 100);  // Nothing is pending after a flush, so it shouldn't need much.
+	sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
+	sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
+
+	int ret = deflateParams(&sock->zDeflate, level, Z_DEFAULT_STRATEGY);
+
+	sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
+	if (ret == Z_OK)
+	{
+		sock->zDeflateLevel = level;
+	}
+}
+
+// Lowers the compression level if the socket spends too much time compressing, or raises it if there is time to spare,
+// or if the data isn't getting sent fast enough anyway.
+static void socketAdaptCompression(Socket *sock)
+{
+	unsigned time = wzGetTicks();
+	unsigned interval = time - sock->zAdaptTime;
+	if (!sock->zDeflateAdaptive || interval < SOCKET_COMPRESSION_ADAPT_INTERVAL)
+	{
+		return;
+	}
+
+	wzMutexLock(socketThreadMutex);
+	size_t backlog = sock->writeQueue.size();
+	wzMutexUnlock(socketThreadMutex);
+
+	uint64_t usecsPerSecond = sock->zAdaptNsecs / interval;  // Nanoseconds per millisecond.
+	int level = sock->zDeflateLevel;
+	if (backlog > SOCKET_COMPRESSION_BACKLOG && usecsPerSecond < SOCKET_COMPRESSION_BUDGET*4)
+	{
+		level = std::min(level + 1, Z_BEST_COMPRESSION);
+	}
+	else if (usecsPerSecond > SOCKET_COMPRESSION_BUDGET)
+	{
+		level = std::max(level - 1, Z_BEST_SPEED);
+	}
+	else if (usecsPerSecond < SOCKET_COMPRESSION_BUDGET/4)
+	{
+		level = std::min(level + 1, Z_BEST_COMPRESSION);
+	}
+	if (level != sock->zDeflateLevel)
+	{
+		debug(LOG_NET, "Compression level %d -> %d for %s, %u us/s, %u bytes waiting", sock->zDeflateLevel, level, sock->textAddress, (unsigned)usecsPerSecond, (unsigned)backlog);
+		socketSetDeflateLevel(sock, level);
+	}
+
+	sock->zAdaptTime = time;
+	sock->zAdaptNsecs = 0;
+}
+
 void socketFlush(Socket *sock, size_t *rawByteCount)
 {
 	size_t ignored;
@@ -646,6 +943,7 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	}
 
 	// Flush data out of zlib compression state.
+	qint64 startNsecs = compressionTimer.nsecsElapsed();
 	do
 	{
 		sock->zDeflate.next_in = (Bytef *)NULL;
@@ -661,6 +959,9 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 		// Remove unused part of buffer.
 		sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
 	} while(sock->zDeflate.avail_out == 0);
+	qint64 nsecs = compressionTimer.nsecsElapsed() - startNsecs;
+	compressionNsecs[true] += nsecs;
+	sock->zAdaptNsecs += nsecs;
 
 	if (sock->zDeflateOutBuf.empty())
 	{
@@ -668,12 +969,8 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	}
 
 	wzMutexLock(socketThreadMutex);
-	if (socketThreadWrites.empty())
-	{
-		wzSemaphorePost(socketThreadSemaphore);
-	}
-	std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-	writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
+	sock->writeQueue.push(&sock->zDeflateOutBuf[0], sock->zDeflateOutBuf.size());
+	socketThreadNotify(sock);
 	wzMutexUnlock(socketThreadMutex);
 
 	// Primitive network logging, uncomment to use.
@@ -685,6 +982,8 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	rawBytes = sock->zDeflateOutBuf.size();
 	sock->zDeflateInSize = 0;
 	sock->zDeflateOutBuf.clear();
+
+	socketAdaptCompression(sock);
 }
 
 void socketBeginCompression(Socket *sock)
@@ -700,8 +999,12 @@ void socketBeginCompression(Socket *sock)
 	sock->zDeflate.zalloc = Z_NULL;
 	sock->zDeflate.zfree = Z_NULL;
 	sock->zDeflate.opaque = Z_NULL;
-	int ret = deflateInit(&sock->zDeflate, 6);
+	int ret = deflateInit(&sock->zDeflate, sock->zDeflateLevel);
 	ASSERT(ret == Z_OK, "deflateInit failed! Sockets won't work.");
+	ret = deflateSetDictionary(&sock->zDeflate, socketCompressionDictionary, sizeof(socketCompressionDictionary));
+	ASSERT(ret == Z_OK, "deflateSetDictionary failed! Sockets won't work.");
+	sock->zAdaptTime = wzGetTicks();
+	sock->zAdaptNsecs = 0;
 
 	sock->zInflate.zalloc = Z_NULL;
 	sock->zInflate.zfree = Z_NULL;
@@ -709,7 +1012,7 @@ void socketBeginCompression(Socket *sock)
 	sock->zInflate.avail_in = 0;
 	sock->zInflate.next_in = Z_NULL;
 	ret = inflateInit(&sock->zInflate);
-	ASSERT(ret == Z_OK, "deflateInit failed! Sockets won't work.");
+	ASSERT(ret == Z_OK, "inflateInit failed! Sockets won't work.");
 
 	sock->zInflateNeedInput = true;
 
@@ -717,22 +1020,61 @@ void socketBeginCompression(Socket *sock)
 	wzMutexUnlock(socketThreadMutex);
 }
 
+void socketSetCompressionLevel(Socket *sock, int level)
+{
+	sock->zDeflateAdaptive = level < 0;
+	level = level < 0 ? SOCKET_COMPRESSION_LEVEL : std::min(level, Z_BEST_COMPRESSION);
+	if (!sock->isCompressed)
+	{
+		sock->zDeflateLevel = level;
+	}
+	else if (level != sock->zDeflateLevel)
+	{
+		socketSetDeflateLevel(sock, level);
+	}
+}
+
+int socketGetCompressionLevel(Socket const *sock)
+{
+	return sock->zDeflateLevel;
+}
+
+unsigned socketCompressionTime(bool compressing)
+{
+	return compressionNsecs[compressing] / 1000;
+}
+
 Socket::~Socket()
 {
 	if (isCompressed)
 	{
 		deflateEnd(&zDeflate);
-		deflateEnd(&zInflate);
+		inflateEnd(&zInflate);
 	}
 }
 
 SocketSet *allocSocketSet()
 {
-	return new SocketSet;
+	SocketSet *set = new SocketSet;
+#if defined(HAVE_SYS_EPOLL_H)
+	set->epollFd = epoll_create(16);  // Size is only a hint.
+	if (set->epollFd == SOCKET_ERROR)
+	{
+		debug(LOG_NET, "epoll_create failed, using select: %s", strSockError(getSockErr()));
+		set->epollFd = -1;
+	}
+#endif
+	return set;
 }
 
 void deleteSocketSet(SocketSet *set)
 {
+#if defined(HAVE_SYS_EPOLL_H)
+	if (set != NULL && set->epollFd != -1)
+	{
+		close(set->epollFd);
+	}
+#endif
 	delete set;
 }
 
@@ -756,6 +1098,23 @@ void SocketSet_AddSocket(SocketSet* set, Socket* socket)
 		return;
 	}
 
+#if defined(HAVE_SYS_EPOLL_H)
+	if (set->epollFd != -1)
+	{
+		// Level triggered, since readNoInt only reads once each time checkSockets says the socket is ready.
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.ptr = socket;
+		if (epoll_ctl(set->epollFd, EPOLL_CTL_ADD, socket->fd[SOCK_CONNECTION], &event) == SOCKET_ERROR)
+		{
+			debug(LOG_ERROR, "Failed to add socket %p to epoll, using select: %s", socket, strSockError(getSockErr()));
+			close(set->epollFd);
+			set->epollFd = -1;
+		}
+	}
+#endif
+
 	set->fds.push_back(socket);
 	debug(LOG_NET, "Socket added: set->fds[%lu] = %p", (unsigned long)i, socket);
 }
@@ -773,6 +1132,13 @@ void SocketSet_DelSocket(SocketSet* set, Socket* socket)
 	{
 		debug(LOG_NET, "Socket %p erased (set->fds[%lu])", socket, (unsigned long)i);
 		set->fds.erase(set->fds.begin() + i);
+#if defined(HAVE_SYS_EPOLL_H)
+		if (set->epollFd != -1)
+		{
+			struct epoll_event event;  // Ignored, but must not be NULL on old kernels.
+			epoll_ctl(set->epollFd, EPOLL_CTL_DEL, socket->fd[SOCK_CONNECTION], &event);
+		}
+#endif
 	}
 }
 
@@ -824,6 +1190,35 @@ static void socketBlockSIGPIPE(const SOCKET fd, bool block_sigpipe)
 #endif
 }
 
+#if defined(HAVE_SYS_EPOLL_H)
+static int checkSocketsEpoll(const SocketSet *set, unsigned int timeout)
+{
+	std::vector<struct epoll_event> events(set->fds.size());
+	int ret;
+	do
+	{
+		ret = epoll_wait(set->epollFd, &events[0], events.size(), timeout);
+	} while (ret == SOCKET_ERROR && getSockErr() == EINTR);
+
+	if (ret == SOCKET_ERROR)
+	{
+		debug(LOG_ERROR, "epoll_wait failed: %s", strSockError(getSockErr()));
+		return SOCKET_ERROR;
+	}
+
+	for (size_t i = 0; i < set->fds.size(); ++i)
+	{
+		set->fds[i]->ready = false;
+	}
+	for (int i = 0; i < ret; ++i)
+	{
+		static_cast<Socket *>(events[i].data.ptr)->ready = true;  // Also on EPOLLERR or EPOLLHUP, like select.
+	}
+
+	return ret;
+}
+#endif
+
 int checkSockets(const SocketSet* set, unsigned int timeout)
 {
 	if (set->fds.empty())
@@ -864,6 +1259,13 @@ int checkSockets(const SocketSet* set, unsigned int timeout)
 		return ret;
 	}
 
+#if defined(HAVE_SYS_EPOLL_H)
+	if (set->epollFd != -1)
+	{
+		return checkSocketsEpoll(set, timeout);
+	}
+#endif
+
 	int ret;
 	fd_set fds;
 	do
@@ -914,7 +1316,8 @@ ssize_t readAll(Socket* sock, void* buf, size_t size, unsigned int timeout)
 	ASSERT_OR_RETURN( SOCKET_ERROR, sock, "We don't have a valid socket!");
 	ASSERT(!sock->isCompressed, "readAll on compressed sockets not implemented.");
 
-	const SocketSet set = {std::vector<Socket *>(1, sock)};
+	SocketSet set;
+	set.fds.push_back(sock);
 
 	size_t received = 0;
 
@@ -981,6 +1384,14 @@ ssize_t readAll(Socket* sock, void* buf, size_t size, unsigned int timeout)
 
 static void socketCloseNow(Socket *sock)
 {
+#if defined(HAVE_SYS_EPOLL_H)
+	if (sock->writeRegistered)
+	{
+		struct epoll_event event;  // Ignored, but must not be NULL on old kernels.
+		epoll_ctl(socketThreadEpoll, EPOLL_CTL_DEL, sock->fd[SOCK_CONNECTION], &event);
+		socketThreadRegistered.erase(sock);
+	}
+#endif
 	for (unsigned i = 0; i < ARRAY_SIZE(sock->fd); ++i)
 	{
 		if (sock->fd[i] != INVALID_SOCKET)
@@ -1434,6 +1845,46 @@ void deleteSocketAddress(SocketAddress *addr)
 
 // ////////////////////////////////////////////////////////////////////////
 // setup stuff
+#if defined(HAVE_SYS_EPOLL_H)
+static void socketThreadEpollShutdown()
+{
+	if (socketThreadEpoll != -1)
+	{
+		close(socketThreadEpoll);
+		socketThreadEpoll = -1;
+	}
+	for (unsigned i = 0; i < ARRAY_SIZE(socketThreadWakeup); ++i)
+	{
+		if (socketThreadWakeup[i] != -1)
+		{
+			close(socketThreadWakeup[i]);
+			socketThreadWakeup[i] = -1;
+		}
+	}
+	socketThreadRegistered.clear();
+}
+
+/// Sets up socketThreadEpoll, or leaves it at -1, so the socket thread uses select instead.
+static void socketThreadEpollInit()
+{
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;  // Means socketThreadWakeup.
+
+	socketThreadEpoll = epoll_create(16);  // Size is only a hint.
+	if (socketThreadEpoll == SOCKET_ERROR
+	 || pipe(socketThreadWakeup) == SOCKET_ERROR
+	 || !setSocketBlocking(socketThreadWakeup[0], false)
+	 || !setSocketBlocking(socketThreadWakeup[1], false)
+	 || epoll_ctl(socketThreadEpoll, EPOLL_CTL_ADD, socketThreadWakeup[0], &event) == SOCKET_ERROR)
+	{
+		debug(LOG_NET, "Failed to set up epoll, using select: %s", strSockError(getSockErr()));
+		socketThreadEpollShutdown();
+	}
+}
+#endif
+
 void SOCKETinit()
 {
 #if defined(WZ_OS_WIN)
@@ -1462,9 +1913,17 @@ void SOCKETinit()
 	}
 #endif
 
+	if (!compressionTimer.isValid())
+	{
+		compressionTimer.start();
+	}
+
 	if (socketThread == NULL)
 	{
 		socketThreadQuit = false;
+#if defined(HAVE_SYS_EPOLL_H)
+		socketThreadEpollInit();
+#endif
 		socketThreadMutex = wzMutexCreate();
 		socketThreadSemaphore = wzSemaphoreCreate(0);
 		socketThread = wzThreadCreate(socketThreadFunction, NULL);
@@ -1481,10 +1940,23 @@ void SOCKETshutdown()
 		socketThreadWrites.clear();
 		wzMutexUnlock(socketThreadMutex);
 		wzSemaphorePost(socketThreadSemaphore);  // Wake up the thread, so it can quit.
+#if defined(HAVE_SYS_EPOLL_H)
+		if (socketThreadEpoll != -1)
+		{
+			char wake = 0;
+			if (write(socketThreadWakeup[1], &wake, 1) == SOCKET_ERROR)
+			{
+				debug(LOG_ERROR, "Failed to wake socket thread: %s", strSockError(getSockErr()));
+			}
+		}
+#endif
 		wzThreadJoin(socketThread);
 		wzMutexDestroy(socketThreadMutex);
 		wzSemaphoreDestroy(socketThreadSemaphore);
 		socketThread = NULL;
+#if defined(HAVE_SYS_EPOLL_H)
+		socketThreadEpollShutdown();
+#endif
 	}
 
 #if defined(WZ_OS_WIN)
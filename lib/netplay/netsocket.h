@@ -111,6 +111,9 @@ ssize_t writeAll(Socket *sock, const void* buf, size_t size, size_t *rawByteCoun
 void socketBeginCompression(Socket *sock);                              ///< Makes future data sent compressed, and future data received expected to be compressed.
 bool socketReadDisconnected(Socket *sock);                              ///< If readNoInt returned 0, returns true if this is the result of a disconnect, or false if the input compressed data just hasn't produced any output bytes.
 void socketFlush(Socket *sock, size_t *rawByteCount = NULL);            ///< Actually sends the data written with writeAll. Only useful on compressed sockets. Note that flushing too often makes compression less effective. Raw count of bytes (after compression) returned in rawByteCount.
+void socketSetCompressionLevel(Socket *sock, int level);               ///< Fixes the zlib level of data sent, or lets the socket adapt it to the time spent compressing and the data waiting to be sent, if level is -1, which is the default.
+int socketGetCompressionLevel(Socket const *sock);                      ///< Returns the current zlib level of data sent.
+unsigned socketCompressionTime(bool compressing);                       ///< Returns the microseconds all sockets have spent compressing data sent, or decompressing data received. Wraps around.
 
 // Socket sets.
 SocketSet *allocSocketSet(void);                                        ///< Constructs a SocketSet.
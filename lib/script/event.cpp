@@ -27,16 +27,31 @@
 #include "event.h"
 #include "script.h"
 
+#include <algorithm>
+
 // array to store release functions
 static VAL_CREATE_FUNC	*asCreateFuncs = NULL;
 static VAL_RELEASE_FUNC	*asReleaseFuncs = NULL;
 static UDWORD		numFuncs;
 
-/** The list of currently active triggers */
-ACTIVE_TRIGGER		*psTrigList = NULL;
+/** The currently active timed triggers, a binary heap with the next trigger to fire at the front */
+static std::vector<ACTIVE_TRIGGER *> asTimedTriggers;
+
+/** Sequence number given to the next trigger added */
+static UDWORD		triggerSequence = 0;
+
+/** The lists of callback triggers, indexed by type - TR_CALLBACKSTART */
+static std::vector<ACTIVE_TRIGGER *> apsCallbackLists;
 
-/** The list of callback triggers */
-ACTIVE_TRIGGER		*psCallbackList = NULL;
+/** Whether a trigger still in one of the lists has been marked for deletion */
+static bool		triggersDeactivated = false;
+
+/** Number of trigger nodes allocated at once */
+#define TRIGGER_BLOCK	256
+
+/** The allocated blocks of trigger nodes, and the unused nodes in them */
+static std::vector<ACTIVE_TRIGGER *> apsTriggerBlocks;
+static ACTIVE_TRIGGER	*psFreeTriggers = NULL;
 
 /** The new triggers added this loop */
 static ACTIVE_TRIGGER	*psAddedTriggers = NULL;
@@ -97,15 +112,99 @@ static void eventAddTrigger(ACTIVE_TRIGGER *psTrigger);
 // Free up a trigger
 static void eventFreeTrigger(ACTIVE_TRIGGER *psTrigger);
 
+// Get a trigger node from the pool
+static ACTIVE_TRIGGER *eventNewTriggerNode(void)
+{
+	if (psFreeTriggers == NULL)
+	{
+		ACTIVE_TRIGGER *psBlock = (ACTIVE_TRIGGER *)malloc(sizeof(ACTIVE_TRIGGER) * TRIGGER_BLOCK);
+
+		apsTriggerBlocks.push_back(psBlock);
+		for (int i = TRIGGER_BLOCK - 1; i >= 0; i--)
+		{
+			psBlock[i].psNext = psFreeTriggers;
+			psFreeTriggers = psBlock + i;
+		}
+	}
+
+	ACTIVE_TRIGGER *psTrigger = psFreeTriggers;
+	psFreeTriggers = psTrigger->psNext;
+	return psTrigger;
+}
+
+// Return a trigger node to the pool
+static void eventFreeTriggerNode(ACTIVE_TRIGGER *psTrigger)
+{
+	psTrigger->psNext = psFreeTriggers;
+	psFreeTriggers = psTrigger;
+}
+
+// Whether trigger a is checked before trigger b - earliest first, and the most recently added first at equal times
+static bool eventTriggerBefore(ACTIVE_TRIGGER const *psA, ACTIVE_TRIGGER const *psB)
+{
+	if (psA->testTime != psB->testTime)
+	{
+		return psA->testTime < psB->testTime;
+	}
+	return psA->sequence > psB->sequence;
+}
+
+// Heap ordering for asTimedTriggers, puts the trigger to check first at the front
+static bool eventTriggerAfter(ACTIVE_TRIGGER const *psA, ACTIVE_TRIGGER const *psB)
+{
+	return eventTriggerBefore(psB, psA);
+}
+
 // Remove triggers marked for deletion
 static void eventPruneList(ACTIVE_TRIGGER **psList);
 static void eventPruneLists(void)
 {
-	eventPruneList(&psTrigList);
-	eventPruneList(&psCallbackList);
+	if (!triggersDeactivated)
+	{
+		return;
+	}
+	triggersDeactivated = false;
+
+	std::vector<ACTIVE_TRIGGER *>::iterator kept = asTimedTriggers.begin();
+	for (std::vector<ACTIVE_TRIGGER *>::iterator i = asTimedTriggers.begin(); i != asTimedTriggers.end(); ++i)
+	{
+		if ((*i)->deactivated)
+		{
+			eventFreeTriggerNode(*i);
+		}
+		else
+		{
+			*kept++ = *i;
+		}
+	}
+	if (kept != asTimedTriggers.end())
+	{
+		asTimedTriggers.erase(kept, asTimedTriggers.end());
+		std::make_heap(asTimedTriggers.begin(), asTimedTriggers.end(), eventTriggerAfter);
+	}
+	for (unsigned i = 0; i < apsCallbackLists.size(); i++)
+	{
+		eventPruneList(&apsCallbackLists[i]);
+	}
 	eventPruneList(&psAddedTriggers);
 }
 
+// Get the currently active triggers and the callback triggers, in the order they are checked
+void eventGetTriggerLists(std::vector<ACTIVE_TRIGGER *> &timed, std::vector<ACTIVE_TRIGGER *> &callbacks)
+{
+	timed = asTimedTriggers;
+	std::sort(timed.begin(), timed.end(), eventTriggerBefore);
+
+	callbacks.clear();
+	for (unsigned i = 0; i < apsCallbackLists.size(); i++)
+	{
+		for (ACTIVE_TRIGGER *psCurr = apsCallbackLists[i]; psCurr; psCurr = psCurr->psNext)
+		{
+			callbacks.push_back(psCurr);
+		}
+	}
+}
+
 //resets the event timer - updateTime
 void eventTimeReset(UDWORD initTime)
 {
@@ -115,8 +214,10 @@ void eventTimeReset(UDWORD initTime)
 /* Initialise the event system */
 bool eventInitialise()
 {
-	psTrigList = NULL;
-	psCallbackList = NULL;
+	asTimedTriggers.clear();
+	apsCallbackLists.clear();
+	triggerSequence = 0;
+	triggersDeactivated = false;
 	psContList = NULL;
 	eventTraceLevel = 0;
 	asCreateFuncs = NULL;
@@ -132,31 +233,36 @@ void eventReset(void)
 	SDWORD			count=0;
 
 	// Free any active triggers and their context's
-	while (psTrigList)
+	while (!asTimedTriggers.empty())
 	{
-		ACTIVE_TRIGGER	*psCurr = psTrigList;
+		ACTIVE_TRIGGER	*psCurr = asTimedTriggers.front();
 
-		psTrigList = psTrigList->psNext;
+		std::pop_heap(asTimedTriggers.begin(), asTimedTriggers.end(), eventTriggerAfter);
+		asTimedTriggers.pop_back();
 		if (!psCurr->psContext->release)
 		{
 			count += 1;
 		}
 		eventRemoveContext(psCurr->psContext);
-		free(psCurr);
+		eventFreeTriggerNode(psCurr);
 	}
 	// Free any active callback triggers and their context's
-	while (psCallbackList)
+	for (unsigned i = 0; i < apsCallbackLists.size(); i++)
 	{
-		ACTIVE_TRIGGER	*psCurr = psCallbackList;
-
-		psCallbackList = psCallbackList->psNext;
-		if (!psCurr->psContext->release)
+		while (apsCallbackLists[i])
 		{
-			count += 1;
+			ACTIVE_TRIGGER	*psCurr = apsCallbackLists[i];
+
+			apsCallbackLists[i] = psCurr->psNext;
+			if (!psCurr->psContext->release)
+			{
+				count += 1;
+			}
+			eventRemoveContext(psCurr->psContext);
+			eventFreeTriggerNode(psCurr);
 		}
-		eventRemoveContext(psCurr->psContext);
-		free(psCurr);
 	}
+	triggerSequence = 0;
 	// Now free any contexts that are left
 	while (psContList)
 	{
@@ -178,6 +284,13 @@ void eventShutDown(void)
 {
 	eventReset();
 
+	for (unsigned i = 0; i < apsTriggerBlocks.size(); i++)
+	{
+		free(apsTriggerBlocks[i]);
+	}
+	apsTriggerBlocks.clear();
+	psFreeTriggers = NULL;
+
 	if (asCreateFuncs)
 	{
 		free(asCreateFuncs);
@@ -525,51 +638,54 @@ void eventRemoveContext(SCRIPT_CONTEXT *psContext)
 	INTERP_VAL		*psVal;
 
 	// Get rid of all it's triggers
-	while(psTrigList && psTrigList->psContext == psContext)
-	{
-		psNext = psTrigList->psNext;
-		eventFreeTrigger(psTrigList);
-		psTrigList = psNext;
-	}
-
-	for (psPrev = NULL, psCurr = psTrigList; psCurr; psCurr = psNext)
+	std::vector<ACTIVE_TRIGGER *> removed;
+	std::vector<ACTIVE_TRIGGER *>::iterator kept = asTimedTriggers.begin();
+	for (std::vector<ACTIVE_TRIGGER *>::iterator i = asTimedTriggers.begin(); i != asTimedTriggers.end(); ++i)
 	{
-		psNext = psCurr->psNext;
-		if (psCurr->psContext == psContext)
+		if ((*i)->psContext == psContext)
 		{
-			eventFreeTrigger(psCurr);
-			if (psPrev)
-			{
-				psPrev->psNext = psNext;
-			}
+			removed.push_back(*i);
 		}
 		else
 		{
-			psPrev = psCurr;
+			*kept++ = *i;
 		}
 	}
-	// Get rid of all it's callback triggers
-	while(psCallbackList && psCallbackList->psContext == psContext)
+	if (!removed.empty())
 	{
-		psNext = psCallbackList->psNext;
-		eventFreeTrigger(psCallbackList);
-		psCallbackList = psNext;
+		asTimedTriggers.erase(kept, asTimedTriggers.end());
+		std::make_heap(asTimedTriggers.begin(), asTimedTriggers.end(), eventTriggerAfter);
+		for (unsigned i = 0; i < removed.size(); i++)
+		{
+			eventFreeTrigger(removed[i]);
+		}
 	}
 
-	for (psPrev = NULL, psCurr = psCallbackList; psCurr; psCurr = psNext)
+	// Get rid of all it's callback triggers
+	for (unsigned list = 0; list < apsCallbackLists.size(); list++)
 	{
-		psNext = psCurr->psNext;
-		if (psCurr->psContext == psContext)
+		while (apsCallbackLists[list] && apsCallbackLists[list]->psContext == psContext)
 		{
-			eventFreeTrigger(psCurr);
-			if (psPrev)
-			{
-				psPrev->psNext = psNext;
-			}
+			psNext = apsCallbackLists[list]->psNext;
+			eventFreeTrigger(apsCallbackLists[list]);
+			apsCallbackLists[list] = psNext;
 		}
-		else
+
+		for (psPrev = NULL, psCurr = apsCallbackLists[list]; psCurr; psCurr = psNext)
 		{
-			psPrev = psCurr;
+			psNext = psCurr->psNext;
+			if (psCurr->psContext == psContext)
+			{
+				eventFreeTrigger(psCurr);
+				if (psPrev)
+				{
+					psPrev->psNext = psNext;
+				}
+			}
+			else
+			{
+				psPrev = psCurr;
+			}
 		}
 	}
 
@@ -699,53 +815,23 @@ bool eventSetContextVar(SCRIPT_CONTEXT *psContext, UDWORD index, INTERP_VAL *dat
 // Add a trigger to the list in order
 static void eventAddTrigger(ACTIVE_TRIGGER *psTrigger)
 {
-	UDWORD	testTime = psTrigger->testTime;
-
+	psTrigger->sequence = triggerSequence++;
 	if (psTrigger->type >= TR_CALLBACKSTART)
 	{
-		// Add this to the callback trigger list
-		if (psCallbackList == NULL)
+		// Add this to the front of the list for its callback type
+		unsigned index = psTrigger->type - TR_CALLBACKSTART;
+		if (index >= apsCallbackLists.size())
 		{
-			psTrigger->psNext = NULL;
-			psCallbackList = psTrigger;
+			apsCallbackLists.resize(index + 1, NULL);
 		}
-		else if (psTrigger->type <= psCallbackList->type)
-		{
-			psTrigger->psNext = psCallbackList;
-			psCallbackList = psTrigger;
-		}
-		else
-		{
-			ACTIVE_TRIGGER *psCurr, *psPrev = NULL;
-
-			for(psCurr = psCallbackList; psCurr && psCurr->type < psTrigger->type; psCurr = psCurr->psNext)
-			{
-				psPrev = psCurr;
-			}
-			psTrigger->psNext = psPrev->psNext;
-			psPrev->psNext =  psTrigger;
-		}
-	}
-	else if (psTrigList == NULL)
-	{
-		psTrigger->psNext = NULL;
-		psTrigList = psTrigger;
-	}
-	else if (testTime <= psTrigList->testTime)
-	{
-		psTrigger->psNext = psTrigList;
-		psTrigList = psTrigger;
+		psTrigger->psNext = apsCallbackLists[index];
+		apsCallbackLists[index] = psTrigger;
 	}
 	else
 	{
-		ACTIVE_TRIGGER *psCurr, *psPrev = NULL;
-
-		for(psCurr = psTrigList; psCurr && psCurr->testTime < testTime; psCurr = psCurr->psNext)
-		{
-			psPrev = psCurr;
-		}
-		psTrigger->psNext = psPrev->psNext;
-		psPrev->psNext =  psTrigger;
+		psTrigger->psNext = NULL;
+		asTimedTriggers.push_back(psTrigger);
+		std::push_heap(asTimedTriggers.begin(), asTimedTriggers.end(), eventTriggerAfter);
 	}
 }
 
@@ -765,7 +851,7 @@ static bool eventInitTrigger(ACTIVE_TRIGGER **ppsTrigger, SCRIPT_CONTEXT *psCont
 	}
 
 	// Get a trigger object
-	psNewTrig = (ACTIVE_TRIGGER *)malloc(sizeof(ACTIVE_TRIGGER));
+	psNewTrig = eventNewTriggerNode();
 
 	// Initialise the trigger
 	psNewTrig->psContext = psContext;
@@ -794,7 +880,7 @@ bool eventLoadTrigger(UDWORD time, SCRIPT_CONTEXT *psContext,
 	ASSERT(trigger < psContext->psCode->numTriggers, "Trigger out of range");
 
 	// Get a trigger object
-	psNewTrig = (ACTIVE_TRIGGER *)malloc(sizeof(ACTIVE_TRIGGER));
+	psNewTrig = eventNewTriggerNode();
 
 	// Initialise the trigger
 	psNewTrig->psContext = psContext;
@@ -820,7 +906,7 @@ bool eventAddPauseTrigger(SCRIPT_CONTEXT *psContext, UDWORD event, UDWORD offset
 	ASSERT(event < psContext->psCode->numEvents, "Event out of range");
 
 	// Get a trigger object
-	psNewTrig = (ACTIVE_TRIGGER *)malloc(sizeof(ACTIVE_TRIGGER));
+	psNewTrig = eventNewTriggerNode();
 
 	// figure out what type of trigger will go into the system when the pause
 	// finishes
@@ -856,6 +942,7 @@ bool eventAddPauseTrigger(SCRIPT_CONTEXT *psContext, UDWORD event, UDWORD offset
 
 	// mark the trigger for deletion
 	psFiringTrigger->deactivated = true;
+	triggersDeactivated = true;
 
 	return true;
 }
@@ -868,13 +955,14 @@ static void eventFreeTrigger(ACTIVE_TRIGGER *psTrigger)
 		// Free the context as well
 		eventRemoveContext(psTrigger->psContext);
 	}
-	free(psTrigger);
+	eventFreeTriggerNode(psTrigger);
 }
 
 // Activate a callback trigger
 void eventFireCallbackTrigger(TRIGGER_TYPE callback)
 {
 	ACTIVE_TRIGGER	*psPrev = NULL, *psCurr, *psNext;
+	unsigned	index = callback - TR_CALLBACKSTART;
 	TRIGGER_DATA	*psTrigDat;
 	int32_t		fired;		// was BOOL (int) ** see warning about conversion
 
@@ -886,78 +974,72 @@ void eventFireCallbackTrigger(TRIGGER_TYPE callback)
 
 	//this can be called from eventProcessTriggers and so will wipe out all the current added ones
 	//psAddedTriggers = NULL;
-	for (psCurr = psCallbackList; psCurr && psCurr->type <= (int)callback; psCurr = psNext)
+	for (psCurr = index < apsCallbackLists.size() ? apsCallbackLists[index] : NULL; psCurr; psCurr = psNext)
 	{
 		psNext = psCurr->psNext;
-		if (psCurr->type == (int)callback)
+
+		// see if the callback should be fired
+		fired = false;
+		if (psCurr->type != TR_PAUSE)
+		{
+			ASSERT(psCurr->trigger >= 0 && psCurr->trigger < psCurr->psContext->psCode->numTriggers, "Invalid trigger number");
+			psTrigDat = psCurr->psContext->psCode->psTriggerData + psCurr->trigger;
+		}
+		else
+		{
+			psTrigDat = NULL;
+		}
+		if (psTrigDat && psTrigDat->code)
 		{
-			// see if the callback should be fired
-			fired = false;
-			if (psCurr->type != TR_PAUSE)
+			if (!interpRunScript(psCurr->psContext, IRT_TRIGGER, psCurr->trigger, 0))
 			{
-				ASSERT(psCurr->trigger >= 0 && psCurr->trigger < psCurr->psContext->psCode->numTriggers, "Invalid trigger number");
-				psTrigDat = psCurr->psContext->psCode->psTriggerData + psCurr->trigger;
+				ASSERT(false, "Trigger %s: code failed", eventGetTriggerID(psCurr->psContext->psCode, psCurr->trigger));
+				psPrev = psCurr;
+				continue;
 			}
-			else
+			if (!stackPopParams(1, VAL_BOOL, &fired))
 			{
-				psTrigDat = NULL;
+				ASSERT(false, "Trigger %s: code failed", eventGetTriggerID(psCurr->psContext->psCode, psCurr->trigger));
+				psPrev = psCurr;
+				continue;
 			}
-			if (psTrigDat && psTrigDat->code)
+		}
+		else
+		{
+			fired = true;
+		}
+
+		// run the event
+		if (fired)
+		{
+			DB_TRIGINF(psCurr,1);
+			DB_TRACE(" fired",1);
+
+			// remove the trigger from the list
+			if (psPrev == NULL)
 			{
-				if (!interpRunScript(psCurr->psContext, IRT_TRIGGER, psCurr->trigger, 0))
-				{
-					ASSERT(false, "Trigger %s: code failed", eventGetTriggerID(psCurr->psContext->psCode, psCurr->trigger));
-					psPrev = psCurr;
-					continue;
-				}
-				if (!stackPopParams(1, VAL_BOOL, &fired))
-				{
-					ASSERT(false, "Trigger %s: code failed", eventGetTriggerID(psCurr->psContext->psCode, psCurr->trigger));
-					psPrev = psCurr;
-					continue;
-				}
+				apsCallbackLists[index] = psNext;
 			}
 			else
 			{
-				fired = true;
+				psPrev->psNext = psNext;
 			}
 
-			// run the event
-			if (fired)
+			psFiringTrigger = psCurr;
+			if (!interpRunScript(psCurr->psContext, IRT_EVENT, psCurr->event, psCurr->offset)) // this could set psCurr->deactivated
 			{
-				DB_TRIGINF(psCurr,1);
-				DB_TRACE(" fired",1);
-
-				// remove the trigger from the list
-				if (psPrev == NULL)
-				{
-					psCallbackList = psCallbackList->psNext;
-				}
-				else
-				{
-					psPrev->psNext = psNext;
-				}
-
-				psFiringTrigger = psCurr;
-				if (!interpRunScript(psCurr->psContext, IRT_EVENT, psCurr->event, psCurr->offset)) // this could set psCurr->deactivated
-				{
-					ASSERT(false, "Event %s: code failed", eventGetEventID(psCurr->psContext->psCode, psCurr->event));
-				}
-				if (psCurr->deactivated)
-				{
-					// don't need to add the trigger again - just free it
-					eventFreeTrigger(psCurr);
-				}
-				else
-				{
-					// make sure the trigger goes back into the system
-					psCurr->psNext = psAddedTriggers;
-					psAddedTriggers = psCurr;
-				}
+				ASSERT(false, "Event %s: code failed", eventGetEventID(psCurr->psContext->psCode, psCurr->event));
+			}
+			if (psCurr->deactivated)
+			{
+				// don't need to add the trigger again - just free it
+				eventFreeTrigger(psCurr);
 			}
 			else
 			{
-				psPrev = psCurr;
+				// make sure the trigger goes back into the system
+				psCurr->psNext = psAddedTriggers;
+				psAddedTriggers = psCurr;
 			}
 		}
 		else
@@ -1041,10 +1123,11 @@ void eventProcessTriggers(UDWORD currTime)
 	// Process all the current triggers
 	psAddedTriggers = NULL;
 	updateTime = currTime;
-	while(psTrigList && psTrigList->testTime <= currTime)
+	while (!asTimedTriggers.empty() && asTimedTriggers.front()->testTime <= currTime)
 	{
-		psCurr = psTrigList;
-		psTrigList = psTrigList->psNext;
+		psCurr = asTimedTriggers.front();
+		std::pop_heap(asTimedTriggers.begin(), asTimedTriggers.end(), eventTriggerAfter);
+		asTimedTriggers.pop_back();
 
 		// Run the trigger
 		if (eventFireTrigger(psCurr))	// This might mark the trigger for deletion
@@ -1103,7 +1186,7 @@ static void eventPruneList(ACTIVE_TRIGGER **ppsList)
 		if ((*ppsCurr)->deactivated)
 		{
 			psTemp = (*ppsCurr)->psNext;
-			free(*ppsCurr);
+			eventFreeTriggerNode(*ppsCurr);
 			*ppsCurr = psTemp;
 		}
 		else
@@ -1113,33 +1196,54 @@ static void eventPruneList(ACTIVE_TRIGGER **ppsList)
 	}
 }
 
-// Mark a trigger for removal from a list
-static void eventMarkTriggerInList(ACTIVE_TRIGGER **ppsList, SCRIPT_CONTEXT *psContext, SDWORD event, SDWORD *pTrigger)
+// Mark a trigger for removal
+static void eventMarkTrigger(ACTIVE_TRIGGER *psTrigger, SDWORD *pTrigger)
 {
-	ACTIVE_TRIGGER	**ppsCurr;
+	if (psTrigger->type == TR_PAUSE)
+	{
+		// pause trigger, don't remove it,
+		// just note the type for when the pause finishes
+		psTrigger->trigger = (SWORD)*pTrigger;
+		*pTrigger = -1;
+	}
+	else
+	{
+		psTrigger->deactivated = true;
+		triggersDeactivated = true;
+	}
+}
 
-	for (ppsCurr = ppsList;; ppsCurr = &(*ppsCurr)->psNext)
+// Mark a trigger for removal from a list, returns whether one was found
+static bool eventMarkTriggerInList(ACTIVE_TRIGGER *psList, SCRIPT_CONTEXT *psContext, SDWORD event, SDWORD *pTrigger)
+{
+	for (ACTIVE_TRIGGER *psCurr = psList; psCurr; psCurr = psCurr->psNext)
 	{
-		if (!(*ppsCurr))
+		if (psCurr->event == event && psCurr->psContext == psContext)
 		{
-			return;
-		}
-		else if ((*ppsCurr)->event == event &&
-				 (*ppsCurr)->psContext == psContext)
-		{
-			break;
+			eventMarkTrigger(psCurr, pTrigger);
+			return true;
 		}
 	}
-	if ((*ppsCurr)->type == TR_PAUSE)
+	return false;
+}
+
+// Mark the first matching timed trigger, in the order they would fire
+static void eventMarkTimedTrigger(SCRIPT_CONTEXT *psContext, SDWORD event, SDWORD *pTrigger)
+{
+	ACTIVE_TRIGGER *psFirst = NULL;
+
+	for (unsigned i = 0; i < asTimedTriggers.size(); i++)
 	{
-		// pause trigger, don't remove it,
-		// just note the type for when the pause finishes
-		(*ppsCurr)->trigger = (SWORD)*pTrigger;
-		*pTrigger = -1;
+		ACTIVE_TRIGGER *psCurr = asTimedTriggers[i];
+		if (psCurr->event == event && psCurr->psContext == psContext
+		 && (psFirst == NULL || eventTriggerBefore(psCurr, psFirst)))
+		{
+			psFirst = psCurr;
+		}
 	}
-	else
+	if (psFirst != NULL)
 	{
-		(*ppsCurr)->deactivated = true;
+		eventMarkTrigger(psFirst, pTrigger);
 	}
 }
 
@@ -1167,13 +1271,20 @@ bool eventSetTrigger(void)
 	if (psFiringTrigger->event == event)
 	{
 		psFiringTrigger->deactivated = true;
+		triggersDeactivated = true;
 	}
 	else
 	{
 		// Mark the old trigger in the lists
-		eventMarkTriggerInList(&psTrigList, psContext, event, &trigger);
-		eventMarkTriggerInList(&psCallbackList, psContext, event, &trigger);
-		eventMarkTriggerInList(&psAddedTriggers, psContext, event, &trigger);
+		eventMarkTimedTrigger(psContext, event, &trigger);
+		for (unsigned i = 0; i < apsCallbackLists.size(); i++)
+		{
+			if (eventMarkTriggerInList(apsCallbackLists[i], psContext, event, &trigger))
+			{
+				break;
+			}
+		}
+		eventMarkTriggerInList(psAddedTriggers, psContext, event, &trigger);
 	}
 
 	// Create a new trigger if necessary
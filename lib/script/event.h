@@ -28,6 +28,8 @@
 
 #include "interpreter.h"
 
+#include <vector>
+
 /* The number of values in a context value chunk */
 #define CONTEXT_VALS 20
 
@@ -72,6 +74,7 @@ struct ACTIVE_TRIGGER
 	UWORD				event;
 	UWORD				offset;
 	int32_t				deactivated;	// Whether the trigger is marked for deletion
+	UDWORD				sequence;		// When the trigger was added, newer triggers fire first at equal testTime
 	ACTIVE_TRIGGER *        psNext;
 };
 
@@ -114,11 +117,8 @@ enum SCR_USER_TYPES
 	ST_MAXTYPE,									// maximum possible type - should always be last
 };
 
-// The list of currently active triggers
-extern ACTIVE_TRIGGER	*psTrigList;
-
-// The list of callback triggers
-extern ACTIVE_TRIGGER	*psCallbackList;
+// Get the currently active triggers and the callback triggers, in the order they are checked
+extern void eventGetTriggerLists(std::vector<ACTIVE_TRIGGER *> &timed, std::vector<ACTIVE_TRIGGER *> &callbacks);
 
 // The currently allocated contexts
 extern SCRIPT_CONTEXT	*psContList;
@@ -282,12 +282,14 @@ static bool eventFindContext(SDWORD id, SCRIPT_CONTEXT **ppsContext)
 }
 
 // save a list of triggers
-static bool eventSaveTriggerList(ACTIVE_TRIGGER *psList, QString tname, WzConfig &ini)
+static bool eventSaveTriggerList(std::vector<ACTIVE_TRIGGER *> const &list, QString tname, WzConfig &ini)
 {
 	int numTriggers = 0, context = 0;
 
-	for (ACTIVE_TRIGGER *psCurr = psList; psCurr != NULL; psCurr = psCurr->psNext)
+	for (unsigned i = 0; i < list.size(); ++i)
 	{
+		ACTIVE_TRIGGER *psCurr = list[i];
+
 		if (!eventGetContextIndex(psCurr->psContext, &context))
 		{
 			debug(LOG_FATAL, "Could not find context");
@@ -344,7 +346,9 @@ static bool eventLoadTriggerList(WzConfig &ini, QString tname)
 bool eventSaveState(const char *pFilename)
 {
 	WzConfig ini(pFilename);
-	if (!eventSaveContext(ini) || !eventSaveTriggerList(psTrigList, "trig", ini) || !eventSaveTriggerList(psCallbackList, "callback", ini))
+	std::vector<ACTIVE_TRIGGER *> timed, callbacks;
+	eventGetTriggerLists(timed, callbacks);
+	if (!eventSaveContext(ini) || !eventSaveTriggerList(timed, "trig", ini) || !eventSaveTriggerList(callbacks, "callback", ini))
 	{
 		return false;
 	}
@@ -32,6 +32,8 @@
 #include "script.h"
 #include "event.h" //needed for eventGetEventID()
 
+#include <vector>
+
 
 // the maximum number of instructions to execute before assuming
 // an infinite loop
@@ -40,10 +42,39 @@
 
 static INTERP_VAL	*varEnvironment[MAX_FUNC_CALLS];		//environments for local variables of events/functions
 
+/* Pseudo opcodes, only found in decoded code */
+enum
+{
+	OP_ENDCODE = OP_TO_INT + 1,	// End of a trigger or event
+	OP_BADCODE,					// Code which failed to decode, and fails when run
+	OP_NUMDECODED
+};
+
+/* A decoded instruction. Its operands are unpacked, and checked once when decoding rather than each time it runs. */
+struct INTERP_INSTR
+{
+	void			*pHandler;	// The code which runs this instruction, when using threaded dispatch
+	UDWORD			opcode;		// OPCODE, or one of the pseudo opcodes
+	UDWORD			data;		// The data packed in with the opcode
+	INTERP_VAL		*psArg;		// The value following the opcode
+	UDWORD			jump;		// Index of the instruction to jump to, for jumps, OP_EXIT and OP_PAUSE
+	const char		*pError;	// Why an OP_BADCODE could not be decoded
+	UDWORD			offset;		// Position of the instruction in the compiled code
+};
+
+/* A whole decoded program: the code of each trigger, then of each event, each ending with an OP_ENDCODE */
+struct INTERP_DECODED
+{
+	std::vector<INTERP_INSTR>	instr;
+	std::vector<UDWORD>			triggerStart;	// Index of the first instruction of each trigger
+	std::vector<UDWORD>			eventStart;		// Index of the first instruction of each event, and the end of the last one
+	bool						threaded;		// Whether the instruction handlers are filled in
+};
+
 struct ReturnAddressStack_t
 {
 	UDWORD CallerIndex;
-	INTERP_VAL *ReturnAddress;
+	INTERP_INSTR *ReturnAddress;
 };
 
 /**
@@ -72,7 +103,7 @@ static inline bool retStackIsFull(void);
  * \param ReturnAddress Address to return to
  * \return False on failure (stack full)
  */
-static bool retStackPush(UDWORD CallerIndex, INTERP_VAL *ReturnAddress);
+static bool retStackPush(UDWORD CallerIndex, INTERP_INSTR *ReturnAddress);
 
 /**
  * Pop an address/event pair from the return address stack
@@ -81,7 +112,7 @@ static bool retStackPush(UDWORD CallerIndex, INTERP_VAL *ReturnAddress);
  * \param ReturnAddress Address to return to
  * \return False on failure (stack empty)
  */
-static bool retStackPop(UDWORD *CallerIndex, INTERP_VAL **ReturnAddress);
+static bool retStackPop(UDWORD *CallerIndex, INTERP_INSTR **ReturnAddress);
 
 /* Creates a new local var environment for a new function call */
 static inline void createVarEnvironment(SCRIPT_CONTEXT *psContext, UDWORD eventIndex);
@@ -205,19 +236,18 @@ static inline INTERP_VAL *interpGetVarData(VAL_CHUNK *psGlobals, UDWORD index)
 }
 
 // get the array data for an array operation
-static bool interpGetArrayVarData(INTERP_VAL **pip, VAL_CHUNK *psGlobals, SCRIPT_CODE *psProg, INTERP_VAL **ppsVal)
+static bool interpGetArrayVarData(UDWORD data, VAL_CHUNK *psGlobals, SCRIPT_CODE *psProg, INTERP_VAL **ppsVal)
 {
 	SDWORD		i, dimensions, vals[VAR_MAX_DIMENSIONS];
 	UBYTE		*elements;
 	SDWORD		size, val;
-	INTERP_VAL	*InstrPointer = *pip;
 	UDWORD		base, index;
 
 	// get the base index of the array
-	base = InstrPointer->v.ival & ARRAY_BASE_MASK;
+	base = data & ARRAY_BASE_MASK;
 
 	// get the number of dimensions
-	dimensions = (InstrPointer->v.ival & ARRAY_DIMENSION_MASK) >> ARRAY_DIMENSION_SHIFT;
+	dimensions = (data & ARRAY_DIMENSION_MASK) >> ARRAY_DIMENSION_SHIFT;
 
 	ASSERT_OR_RETURN(false, base < psProg->numArrays, "Arrray base index out of range (%d should be less than %d)", base, psProg->numArrays);
 	ASSERT_OR_RETURN(false, dimensions == psProg->psArrayInfo[base].dimensions, "Array dimensions do not match (%d vs %d)", dimensions, psProg->psArrayInfo[base].dimensions);
@@ -263,9 +293,6 @@ static bool interpGetArrayVarData(INTERP_VAL **pip, VAL_CHUNK *psGlobals, SCRIPT
 	// get the variable data
 	*ppsVal = interpGetVarData(psGlobals, psProg->psArrayInfo[base].base + index);
 
-	// update the instruction pointer
-	*pip += 1;
-
 	return true;
 }
 
@@ -278,24 +305,245 @@ bool interpInitialise(void)
 	return true;
 }
 
+/* Decode the code of one trigger or event, appending an OP_ENDCODE.
+ * event is the index of the event, or -1 for trigger code, which has no local variables.
+ */
+static void interpDecodeRange(SCRIPT_CODE *psProg, UDWORD start, UDWORD end, SDWORD event, std::vector<INTERP_INSTR> &instr)
+{
+	UDWORD		first = instr.size(), offset = start, last, i;
+	INTERP_INSTR	sInstr;
+	INTERP_VAL	*psVal;
+	SDWORD		size;
+
+	while (offset < end)
+	{
+		psVal = psProg->pCode + offset;
+		sInstr.pHandler = NULL;
+		sInstr.opcode = (UDWORD)psVal->v.ival >> OPCODE_SHIFT;
+		sInstr.data = psVal->v.ival & OPCODE_DATAMASK;
+		sInstr.psArg = psVal + 1;
+		sInstr.jump = 0;
+		sInstr.pError = NULL;
+		sInstr.offset = offset;
+
+		size = sInstr.opcode <= OP_TO_INT ? aOpSize[sInstr.opcode] : -1;
+		if (size <= 0 || sInstr.opcode == OP_JUMPTRUE || (psVal->type != VAL_OPCODE && psVal->type != VAL_PKOPCODE))
+		{
+			// Can't tell where the next instruction starts, so give up on the rest of the code
+			sInstr.pError = "unknown opcode";
+			sInstr.opcode = OP_BADCODE;
+			instr.push_back(sInstr);
+			break;
+		}
+		if (offset + size > end)
+		{
+			sInstr.pError = "instruction runs past the end of the code";
+			sInstr.opcode = OP_BADCODE;
+			instr.push_back(sInstr);
+			break;
+		}
+
+		switch (sInstr.opcode)
+		{
+		case OP_PUSH:
+			ASSERT(interpCheckEquiv(sInstr.psArg->type, (INTERP_TYPE)sInstr.data),
+				"wrong value type passed for OP_PUSH: %d, expected: %d", sInstr.psArg->type, sInstr.data);
+			break;
+		case OP_PUSHLOCALREF:
+			ASSERT(sInstr.psArg->type == VAL_INT, "wrong value type passed for OP_PUSHLOCALREF: %d", sInstr.psArg->type);
+			if (event < 0 || (UDWORD)sInstr.psArg->v.ival >= psProg->numLocalVars[event])
+			{
+				sInstr.pError = "OP_PUSHLOCALREF: variable index out of range";
+			}
+			break;
+		case OP_PUSHLOCAL:
+		case OP_POPLOCAL:
+			if (event < 0 || sInstr.data >= psProg->numLocalVars[event])
+			{
+				sInstr.pError = "local variable index out of range";
+			}
+			break;
+		case OP_PUSHGLOBAL:
+		case OP_POPGLOBAL:
+			if (sInstr.data >= psProg->numGlobals)
+			{
+				sInstr.pError = "variable index out of range";
+			}
+			break;
+		case OP_FUNC:
+			ASSERT(sInstr.psArg->type == VAL_EVENT, "wrong value type passed for OP_FUNC: %d", sInstr.psArg->type);
+			if ((UDWORD)sInstr.psArg->v.ival >= psProg->numEvents)
+			{
+				sInstr.pError = "trigger index out of range";
+			}
+			break;
+		case OP_VARCALL:
+			ASSERT(sInstr.psArg->type == VAL_OBJ_GETSET,
+				"wrong set/get function pointer type passed for OP_VARCALL: %d", sInstr.psArg->type);
+			break;
+		default:
+			break;
+		}
+		if (sInstr.pError != NULL)
+		{
+			sInstr.opcode = OP_BADCODE;
+		}
+		instr.push_back(sInstr);
+		offset += size;
+	}
+
+	sInstr.pHandler = NULL;
+	sInstr.opcode = OP_ENDCODE;
+	sInstr.data = 0;
+	sInstr.psArg = NULL;
+	sInstr.jump = 0;
+	sInstr.pError = NULL;
+	sInstr.offset = end;
+	instr.push_back(sInstr);
+	last = instr.size() - 1;
+
+	// Resolve the jumps, which may go anywhere in the same code, including its end
+	for (i = first; i < last; i++)
+	{
+		if (instr[i].opcode == OP_EXIT || instr[i].opcode == OP_PAUSE)
+		{
+			instr[i].jump = last;
+		}
+		else if (instr[i].opcode == OP_JUMP || instr[i].opcode == OP_JUMPFALSE)
+		{
+			SDWORD		target = (SDWORD)instr[i].offset + (SWORD)instr[i].data;
+			UDWORD		lo = first, hi = last;
+
+			if (target < (SDWORD)start || target > (SDWORD)end)
+			{
+				instr[i].pError = "jump out of range";
+				instr[i].opcode = OP_BADCODE;
+				continue;
+			}
+			while (lo < hi)
+			{
+				UDWORD mid = (lo + hi) / 2;
+				if (instr[mid].offset < (UDWORD)target)
+				{
+					lo = mid + 1;
+				}
+				else
+				{
+					hi = mid;
+				}
+			}
+			if (instr[lo].offset != (UDWORD)target)
+			{
+				instr[i].pError = "jump into the middle of an instruction";
+				instr[i].opcode = OP_BADCODE;
+				continue;
+			}
+			instr[i].jump = lo;
+		}
+	}
+}
+
+/* Decode a whole program, the first time it runs */
+static INTERP_DECODED *interpDecode(SCRIPT_CODE *psProg)
+{
+	INTERP_DECODED	*psDecoded = new INTERP_DECODED;
+	UDWORD			i;
+
+	psDecoded->threaded = false;
+	for (i = 0; i < psProg->numTriggers; i++)
+	{
+		psDecoded->triggerStart.push_back(psDecoded->instr.size());
+		interpDecodeRange(psProg, psProg->pTriggerTab[i], psProg->pTriggerTab[i + 1], -1, psDecoded->instr);
+	}
+	for (i = 0; i < psProg->numEvents; i++)
+	{
+		psDecoded->eventStart.push_back(psDecoded->instr.size());
+		interpDecodeRange(psProg, psProg->pEventTab[i], psProg->pEventTab[i + 1], i, psDecoded->instr);
+	}
+	psDecoded->eventStart.push_back(psDecoded->instr.size());
+
+	return psDecoded;
+}
+
+/* Free the decoded version of a program */
+void interpFreeDecoded(SCRIPT_CODE *psProg)
+{
+	delete psProg->psDecoded;
+	psProg->psDecoded = NULL;
+}
+
+/* Find the instruction at an offset into an event, to carry on after a pause */
+static UDWORD interpFindResume(SCRIPT_CODE *psProg, INTERP_DECODED *psDecoded, UDWORD event, UDWORD offset)
+{
+	UDWORD		i = psDecoded->eventStart[event];
+
+	offset += psProg->pEventTab[event];
+	while (psDecoded->instr[i].offset < offset && psDecoded->instr[i].opcode != OP_ENDCODE)
+	{
+		i++;
+	}
+	ASSERT(psDecoded->instr[i].offset == offset, "Resuming event %d in the middle of an instruction", event);
+	return i;
+}
+
+/* Remember the name of the running trigger, event or function, for asserts and the call trace */
+static void interpNoteEvent(SCRIPT_CODE *psProg, UDWORD index, bool isEvent)
+{
+	sstrcpy(last_called_script_event, isEvent ? eventGetEventID(psProg, index) : eventGetTriggerID(psProg, index));
+}
+
+/* Use GCC's labels as values to jump straight from each instruction to the code for the next one.
+ * Other compilers get a switch in a loop instead.
+ */
+#if defined(__GNUC__)
+# define INTERP_THREADED
+#endif
+
+#ifdef INTERP_THREADED
+# define INTERP_OP(op)		L_##op:
+# define INTERP_NEXT()		goto *psInstr->pHandler
+#else
+# define INTERP_OP(op)		case op:
+# define INTERP_NEXT()		continue
+#endif
+
 /* Run a compiled script */
 bool interpRunScript(SCRIPT_CONTEXT *psContext, INTERP_RUNTYPE runType, UDWORD index, UDWORD offset)
 {
-	UDWORD			data;
-	OPCODE			opcode;
-	INTERP_VAL		sVal, *psVar,*InstrPointer;
+	INTERP_VAL		sVal, *psVar, *psLocals = NULL;
 	VAL_CHUNK		*psGlobals;
-	UDWORD			numGlobals = 0;
-	INTERP_VAL		*pCodeStart, *pCodeEnd, *pCodeBase;
-	SCRIPT_FUNC		scriptFunc = 0;
-	SCRIPT_VARFUNC	scriptVarFunc = 0;
 	SCRIPT_CODE		*psProg;
+	INTERP_DECODED	*psDecoded;
+	INTERP_INSTR	*psBase, *psInstr;
+	UDWORD			codeBase;			// Offset of the running code, which pause() counts from
 	SDWORD			instructionCount = 0;
+	const char		*pError = NULL;
 
 	UDWORD			CurEvent = 0;
-	bool			bStop = false, bEvent = false;
+	bool			bEvent = false, bScriptDebug;
 	UDWORD			callDepth = 0;
-	bool			bTraceOn=false;		//enable to debug function/event calls
+
+#ifdef INTERP_THREADED
+	static void *const dispatchTable[OP_NUMDECODED] =
+	{
+		&&L_OP_PUSH, &&L_OP_PUSHREF, &&L_OP_POP,
+		&&L_OP_PUSHGLOBAL, &&L_OP_POPGLOBAL,
+		&&L_OP_PUSHARRAYGLOBAL, &&L_OP_POPARRAYGLOBAL,
+		&&L_OP_CALL, &&L_OP_VARCALL,
+		&&L_OP_JUMP, &&L_OP_BADCODE, &&L_OP_JUMPFALSE,		// OP_JUMPTRUE is never generated
+		&&L_OP_BINARYOP, &&L_OP_UNARYOP,
+		&&L_OP_EXIT, &&L_OP_PAUSE,
+		// Secondary opcodes, which only follow OP_BINARYOP and OP_UNARYOP
+		&&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE,
+		&&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE,
+		&&L_OP_BADCODE,
+		&&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE, &&L_OP_BADCODE,
+		&&L_OP_FUNC, &&L_OP_POPLOCAL, &&L_OP_PUSHLOCAL,
+		&&L_OP_PUSHLOCALREF, &&L_OP_TO_FLOAT, &&L_OP_TO_INT,
+		&&L_OP_ENDCODE, &&L_OP_BADCODE,
+	};
+	STATIC_ASSERT(OP_PUSHLOCALREF == 36 && OP_NUMDECODED == 41);
+#endif
 
 	ASSERT(psContext != NULL, "Invalid context pointer");
 
@@ -311,6 +559,24 @@ bool interpRunScript(SCRIPT_CONTEXT *psContext, INTERP_RUNTYPE runType, UDWORD i
 		goto exit_with_error;
 	}
 
+	// Decode the script the first time it runs
+	if (psProg->psDecoded == NULL)
+	{
+		psProg->psDecoded = interpDecode(psProg);
+	}
+	psDecoded = psProg->psDecoded;
+	psBase = psDecoded->instr.empty() ? NULL : &psDecoded->instr[0];
+#ifdef INTERP_THREADED
+	if (!psDecoded->threaded)
+	{
+		for (UDWORD i = 0; i < psDecoded->instr.size(); i++)
+		{
+			psDecoded->instr[i].pHandler = dispatchTable[psDecoded->instr[i].opcode];
+		}
+		psDecoded->threaded = true;
+	}
+#endif
+
 	// note that the interpreter is running to stop recursive script calls
 	bInterpRunning = true;
 
@@ -323,581 +589,446 @@ bool interpRunScript(SCRIPT_CONTEXT *psContext, INTERP_RUNTYPE runType, UDWORD i
 	// Turn off tracing initially
 	interpTrace = false;
 
+	// Only keep track of the names of called functions when they could be shown
+	bScriptDebug = debugPartEnabled(LOG_SCRIPT);
+
 	/* Get the global variables */
-	numGlobals = psProg->numGlobals;
 	psGlobals = psContext->psGlobals;
 
 	bEvent = false;
 
-	// Find the code range
+	// Find the code to run
 	switch (runType)
 	{
 	case IRT_TRIGGER:
-		if (index > psProg->numTriggers)
+		if (index >= psProg->numTriggers)
 		{
 			ASSERT(false, "Trigger index out of range");
+			bInterpRunning = false;
 			return false;
 		}
-		pCodeBase = psProg->pCode + psProg->pTriggerTab[index];
-		pCodeStart = pCodeBase;
-		pCodeEnd  = psProg->pCode + psProg->pTriggerTab[index+1];
+		psInstr = psBase + psDecoded->triggerStart[index];
+		codeBase = psProg->pTriggerTab[index];
 
 		bCurCallerIsEvent = false;
-
-		// find the debug info for the trigger
-		strcpy(last_called_script_event, eventGetTriggerID(psProg, index));
-
-		if(bTraceOn)
-			debug(LOG_SCRIPT,"Trigger: %s", last_called_script_event);
-
 		break;
 	case IRT_EVENT:
-		if (index > psProg->numEvents)
+		if (index >= psProg->numEvents)
 		{
 			ASSERT(false, "Trigger index out of range");
+			bInterpRunning = false;
 			return false;
 		}
-		pCodeBase = psProg->pCode + psProg->pEventTab[index];
-		pCodeStart = pCodeBase + offset;		//offset only used for pause() script function
-		pCodeEnd  = psProg->pCode + psProg->pEventTab[index+1];
+		//offset only used for pause() script function
+		psInstr = psBase + (offset == 0 ? psDecoded->eventStart[index] : interpFindResume(psProg, psDecoded, index, offset));
+		codeBase = psProg->pEventTab[index];
 
 		bEvent = true; //remember it's an event
 		bCurCallerIsEvent = true;
-
-		// remember last called event/function
-		strcpy(last_called_script_event, eventGetEventID(psProg, index));
-
-		if(bTraceOn)
-			debug(LOG_SCRIPT,"Original event name: %s", last_called_script_event);
-
 		break;
 	default:
 		ASSERT(false, "Unknown run type");
+		bInterpRunning = false;
 		return false;
 	}
 
-	// Get the first opcode
-	InstrPointer = pCodeStart;
-
-	/* Make sure we start with an opcode */
-	ASSERT(InstrPointer->type == VAL_PKOPCODE || InstrPointer->type == VAL_OPCODE,
-		"Expected an opcode at the beginning of the interpreting process (type=%d)", InstrPointer->type);
-
-	//opcode = InstrPointer->v.ival >> OPCODE_SHIFT;
+	// remember last called trigger or event
+	interpNoteEvent(psProg, index, bEvent);
 
 	instructionCount = 0;
 
 	CurEvent = index;
-	bStop = false;
 
 	// create new variable environment for this call
 	if (bEvent)
 	{
 		createVarEnvironment(psContext, CurEvent);
+		psLocals = varEnvironment[retStackCallDepth()];
 	}
 
-	while(!bStop)
+#ifdef INTERP_THREADED
+	INTERP_NEXT();
+#else
+	for (;;)
 	{
-		// Run the code
-		if (InstrPointer < pCodeEnd)// && opcode != OP_EXIT)
+		switch (psInstr->opcode)
 		{
-			if (instructionCount > INTERP_MAXINSTRUCTIONS)
-			{
-				debug( LOG_ERROR, "interpRunScript: max instruction count exceeded - infinite loop ?" );
-				goto exit_with_error;
-			}
-			instructionCount++;
-
-			TRCPRINTF( "%-6d  ", (int)(InstrPointer - psProg->pCode) );
-			opcode = (OPCODE)(InstrPointer->v.ival >> OPCODE_SHIFT);			//get opcode
-			data = (SDWORD)(InstrPointer->v.ival & OPCODE_DATAMASK);		//get data - only used with packed opcodes
-			switch (opcode)
-			{
-				/* Custom function call */
-				case OP_FUNC:
-					//debug( LOG_SCRIPT, "-OP_FUNC" );
-					//debug( LOG_SCRIPT, "OP_FUNC: remember event %d, ip=%d", CurEvent, (ip + 2) );
-
-					if(!retStackPush(CurEvent, (InstrPointer + aOpSize[opcode]))) //Remember where to jump back later
-					{
-						debug( LOG_ERROR, "interpRunScript() - retStackPush() failed.");
-						return false;
-					}
-
-					ASSERT(((INTERP_VAL *)(InstrPointer+1))->type == VAL_EVENT, "wrong value type passed for OP_FUNC: %d", ((INTERP_VAL *)(InstrPointer+1))->type);
-
-					// get index of the new event
-					CurEvent = ((INTERP_VAL *)(InstrPointer+1))->v.ival; //Current event = event to jump to
-
-					if (CurEvent > psProg->numEvents)
-					{
-						debug( LOG_ERROR, "interpRunScript: trigger index out of range");
-						goto exit_with_error;
-					}
-
-					// create new variable environment for this call
-					createVarEnvironment(psContext, CurEvent);
-
-					//Set new code execution boundaries
-					//----------------------------------
-					pCodeBase = psProg->pCode + psProg->pEventTab[CurEvent];
-					pCodeStart = pCodeBase;
-					pCodeEnd  = psProg->pCode + psProg->pEventTab[CurEvent+1];
-
-					InstrPointer = pCodeStart;				//Start at the beginning of the new event
-
-					//remember last called event/index
-					strcpy(last_called_script_event, eventGetEventID(psProg, CurEvent));
-
-					if(bTraceOn)
-						debug(LOG_SCRIPT,"Called: '%s'", last_called_script_event);
-
-					//debug( LOG_SCRIPT, "-OP_FUNC: jumped to event %d; ip=%d, numLocalVars: %d", CurEvent, ip, psContext->psCode->numLocalVars[CurEvent] );
-					//debug( LOG_SCRIPT, "-END OP_FUNC" );
-
-					break;
-
-				//handle local variables
-			case OP_PUSHLOCAL:
-
-				//debug( LOG_SCRIPT, "OP_PUSHLOCAL");
-				//debug( LOG_SCRIPT, "OP_PUSHLOCAL, (CurEvent=%d, data =%d) num loc vars: %d; pushing: %d", CurEvent, data, psContext->psCode->numLocalVars[CurEvent], psContext->psCode->ppsLocalVarVal[CurEvent][data].v.ival);
-
-				if (data >= psContext->psCode->numLocalVars[CurEvent])
-				{
-					debug(LOG_ERROR, "interpRunScript: OP_PUSHLOCAL: variable index out of range");
-					goto exit_with_error;
-				}
-
-				//debug(LOG_SCRIPT, "OP_PUSHLOCAL type: %d", psContext->psCode->ppsLocalVarVal[CurEvent][data].type);
-
-				if (!stackPush( &(varEnvironment[retStackCallDepth()][data]) ))
-				{
-					debug(LOG_ERROR, "interpRunScript: OP_PUSHLOCAL: push failed");
-					goto exit_with_error;
-				}
-
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_POPLOCAL:
+#endif
 
-				//debug( LOG_SCRIPT, "OP_POPLOCAL, event index: '%d', data: '%d'", CurEvent, data);
-				//debug( LOG_SCRIPT, "OP_POPLOCAL, numLocalVars: '%d'", psContext->psCode->numLocalVars[CurEvent]);
+	/* Custom function call */
+	INTERP_OP(OP_FUNC)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_FUNC);
+		TRCPRINTF( "\n" );
 
-				if (data >= psContext->psCode->numLocalVars[CurEvent])
-				{
-					debug(LOG_ERROR, "interpRunScript: OP_POPLOCAL: variable index out of range");
-					goto exit_with_error;
-				}
+		if (!retStackPush(CurEvent, psInstr + 1)) //Remember where to jump back later
+		{
+			pError = "retStackPush() failed";
+			goto exit_with_error;
+		}
 
-				//DbgMsg("OP_POPLOCAL type: %d, CurEvent=%d, data=%d", psContext->psCode->ppsLocalVarVal[CurEvent][data].type, CurEvent, data);
+		// Count calls towards the instruction limit, as a loop could call a long function
+		CurEvent = psInstr->psArg->v.ival;
+		instructionCount += psDecoded->eventStart[CurEvent + 1] - psDecoded->eventStart[CurEvent];
+		if (instructionCount > INTERP_MAXINSTRUCTIONS)
+		{
+			pError = "max instruction count exceeded - infinite loop ?";
+			goto exit_with_error;
+		}
 
-				if ( !stackPopType( &(varEnvironment[retStackCallDepth()][data]) ) )
-				{
-					debug(LOG_ERROR, "interpRunScript: OP_POPLOCAL: pop failed");
-					goto exit_with_error;
-				}
+		// create new variable environment for this call
+		createVarEnvironment(psContext, CurEvent);
+		psLocals = varEnvironment[retStackCallDepth()];
 
-				//debug(LOG_SCRIPT, "OP_POPLOCAL: type=%d, val=%d", psContext->psCode->ppsLocalVarVal[CurEvent][data].type, psContext->psCode->ppsLocalVarVal[CurEvent][data].v.ival);
+		//Start at the beginning of the new event
+		psInstr = psBase + psDecoded->eventStart[CurEvent];
+		codeBase = psProg->pEventTab[CurEvent];
 
-				InstrPointer += aOpSize[opcode];
+		if (bScriptDebug || interpTrace)
+		{
+			interpNoteEvent(psProg, CurEvent, true);
+		}
+		INTERP_NEXT();
 
-				break;
+	//handle local variables
+	INTERP_OP(OP_PUSHLOCAL)
+		if (!stackPush(psLocals + psInstr->data))
+		{
+			pError = "OP_PUSHLOCAL: push failed";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-			case OP_PUSHLOCALREF:
+	INTERP_OP(OP_POPLOCAL)
+		if (!stackPopType(psLocals + psInstr->data))
+		{
+			pError = "OP_POPLOCAL: pop failed";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				// The type of the variable is stored in with the opcode
-				sVal.type = (INTERP_TYPE)(InstrPointer->v.ival & OPCODE_DATAMASK);
+	INTERP_OP(OP_PUSHLOCALREF)
+		// The type of the variable is stored in with the opcode
+		sVal.type = (INTERP_TYPE)psInstr->data;
+		sVal.v.oval = psLocals + psInstr->psArg->v.ival;
 
-				ASSERT(  ((INTERP_VAL *)(InstrPointer + 1))->type == VAL_INT,
-					"wrong value type passed for OP_PUSHLOCALREF: %d", ((INTERP_VAL *)(InstrPointer + 1))->type);
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_PUSHLOCALREF);
+		TRCPRINTVAL(sVal);
+		TRCPRINTF( "\n" );
 
-				/* get local var index */
-				data = ((INTERP_VAL *)(InstrPointer + 1))->v.ival;
+		if (!stackPush(&sVal))
+		{
+			pError = "OP_PUSHLOCALREF: push failed";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
+
+	INTERP_OP(OP_PUSH)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_PUSH);
+		TRCPRINTVAL(*psInstr->psArg);
+		TRCPRINTF( "\n" );
+		if (!stackPush(psInstr->psArg))
+		{
+			// Eeerk, out of memory
+			pError = "out of memory!";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				if (data >= psContext->psCode->numLocalVars[CurEvent])
-				{
-					debug(LOG_ERROR, "interpRunScript: OP_PUSHLOCALREF: variable index out of range");
-					goto exit_with_error;
-				}
+	INTERP_OP(OP_PUSHREF)
+		// The type of the variable is stored in with the opcode
+		sVal.type = (INTERP_TYPE)psInstr->data;
 
-				/* get local variable */
-				sVal.v.oval = &(varEnvironment[retStackCallDepth()][data]);
+		// store pointer to INTERP_VAL
+		sVal.v.oval = interpGetVarData(psGlobals, psInstr->psArg->v.ival);
 
-				TRCPRINTOPCODE(opcode);
-				TRCPRINTVAL(sVal);
-				TRCPRINTF( "\n" );
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_PUSHREF);
+		TRCPRINTVAL(sVal);
+		TRCPRINTF( "\n" );
+		if (!stackPush(&sVal))
+		{
+			// Eeerk, out of memory
+			pError = "out of memory!";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				if (!stackPush(&sVal))
-				{
-					debug(LOG_ERROR, "interpRunScript: OP_PUSHLOCALREF: push failed");
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
+	INTERP_OP(OP_POP)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_POP);
+		if (!stackPop(&sVal))
+		{
+			pError = "could not do stack pop";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-			case OP_PUSH:
-				// The type of the value is stored in with the opcode
-				sVal.type = (INTERP_TYPE)(InstrPointer->v.ival & OPCODE_DATAMASK);
+	INTERP_OP(OP_BINARYOP)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(psInstr->data);
+		if (!stackBinaryOp((OPCODE)psInstr->data))
+		{
+			pError = "could not do binary op";
+			goto exit_with_error;
+		}
+		TRCPRINTSTACKTOP();
+		TRCPRINTF( "\n" );
+		++psInstr;
+		INTERP_NEXT();
+
+	INTERP_OP(OP_UNARYOP)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(psInstr->data);
+		if (!stackUnaryOp((OPCODE)psInstr->data))
+		{
+			pError = "could not do unary op";
+			goto exit_with_error;
+		}
+		TRCPRINTSTACKTOP();
+		TRCPRINTF( "\n" );
+		++psInstr;
+		INTERP_NEXT();
+
+	INTERP_OP(OP_PUSHGLOBAL)
+		TRCPRINTF( "%-6d  PUSHGLOBAL  %d\n", psInstr->offset, psInstr->data );
+		if (!stackPush(interpGetVarData(psGlobals, psInstr->data)))
+		{
+			pError = "could not do stack push";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
+
+	INTERP_OP(OP_POPGLOBAL)
+		TRCPRINTF( "%-6d  POPGLOBAL   %d ", psInstr->offset, psInstr->data );
+		TRCPRINTSTACKTOP();
+		TRCPRINTF( "\n" );
+		if (!stackPopType(interpGetVarData(psGlobals, psInstr->data)))
+		{
+			pError = "could not do stack pop";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				//ASSERT( ((INTERP_VAL *)(InstrPointer + 1))->type  == sVal.type,
-				//	"wrong value type passed for OP_PUSH: %d, expected: %d", ((INTERP_VAL *)(InstrPointer + 1))->type, sVal.type );
+	INTERP_OP(OP_PUSHARRAYGLOBAL)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_PUSHARRAYGLOBAL);
+		if (!interpGetArrayVarData(psInstr->data, psGlobals, psProg, &psVar))
+		{
+			pError = "could not get array var data";
+			goto exit_with_error;
+		}
+		TRCPRINTF( "\n" );
+		if (!stackPush(psVar))
+		{
+			pError = "could not do stack push";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				ASSERT(interpCheckEquiv(((INTERP_VAL *)(InstrPointer + 1))->type, sVal.type),
-					"wrong value type passed for OP_PUSH: %d, expected: %d", ((INTERP_VAL *)(InstrPointer + 1))->type, sVal.type);
+	INTERP_OP(OP_POPARRAYGLOBAL)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_POPARRAYGLOBAL);
+		if (!interpGetArrayVarData(psInstr->data, psGlobals, psProg, &psVar))
+		{
+			pError = "could not get array var data";
+			goto exit_with_error;
+		}
+		TRCPRINTSTACKTOP();
+		TRCPRINTF( "\n" );
+		if (!stackPopType(psVar))
+		{
+			pError = "could not do pop stack of type";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				/* copy value */
-				memcpy(&sVal, (INTERP_VAL *)(InstrPointer + 1), sizeof(INTERP_VAL));
+	INTERP_OP(OP_JUMPFALSE)
+		TRCPRINTF( "%-6d  JUMPFALSE   %d (%d)", psInstr->offset, (SWORD)psInstr->data, psBase[psInstr->jump].offset );
 
-				TRCPRINTOPCODE(opcode);
-				TRCPRINTVAL(sVal);
-				TRCPRINTF( "\n" );
-				if (!stackPush(&sVal))
-				{
-					// Eeerk, out of memory
-					debug( LOG_ERROR, "interpRunScript: out of memory!" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_PUSHREF:
-				// The type of the variable is stored in with the opcode
-				sVal.type = (INTERP_TYPE)(InstrPointer->v.ival & OPCODE_DATAMASK);
-
-				// store pointer to INTERP_VAL
-				sVal.v.oval = interpGetVarData(psGlobals, ((INTERP_VAL *)(InstrPointer + 1))->v.ival);
-
-				TRCPRINTOPCODE(opcode);
-				TRCPRINTVAL(sVal);
-				TRCPRINTF( "\n" );
-				if (!stackPush(&sVal))
-				{
-					// Eeerk, out of memory
-					debug( LOG_ERROR, "interpRunScript: out of memory!" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_POP:
-				ASSERT( InstrPointer->type == VAL_OPCODE,
-					"wrong value type passed for OP_POP: %d", InstrPointer->type);
-
-				TRCPRINTOPCODE(opcode);
-				if (!stackPop(&sVal))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do stack pop" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_BINARYOP:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_BINARYOP: %d", InstrPointer->type);
-
-				TRCPRINTOPCODE(data);
-				if (!stackBinaryOp((OPCODE)data))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do binary op" );
-					goto exit_with_error;
-				}
-				TRCPRINTSTACKTOP();
-				TRCPRINTF( "\n" );
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_UNARYOP:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_UNARYOP: %d", InstrPointer->type);
-
-				TRCPRINTOPCODE(data);
-				if (!stackUnaryOp((OPCODE)data))
+		if (!stackPop(&sVal))
+		{
+			pError = "could not do pop of stack";
+			goto exit_with_error;
+		}
+		if (!sVal.v.bval)
+		{
+			// Do the jump
+			TRCPRINTF( " - done -\n" );
+			if ((SWORD)psInstr->data <= 0)
+			{
+				// Only loops can run forever, so only count instructions when jumping back
+				instructionCount += psInstr - (psBase + psInstr->jump) + 1;
+				if (instructionCount > INTERP_MAXINSTRUCTIONS)
 				{
-					debug( LOG_ERROR, "interpRunScript: could not do unary op" );
+					pError = "max instruction count exceeded - infinite loop ?";
 					goto exit_with_error;
 				}
-				TRCPRINTSTACKTOP();
-				TRCPRINTF( "\n" );
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_PUSHGLOBAL:
+			}
+			psInstr = psBase + psInstr->jump;
+		}
+		else
+		{
+			TRCPRINTF( "\n" );
+			++psInstr;
+		}
+		INTERP_NEXT();
 
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_PUSHGLOBAL: %d", InstrPointer->type);
+	INTERP_OP(OP_JUMP)
+		TRCPRINTF( "%-6d  JUMP        %d (%d)\n", psInstr->offset, (SWORD)psInstr->data, psBase[psInstr->jump].offset );
+		if ((SWORD)psInstr->data <= 0)
+		{
+			instructionCount += psInstr - (psBase + psInstr->jump) + 1;
+			if (instructionCount > INTERP_MAXINSTRUCTIONS)
+			{
+				pError = "max instruction count exceeded - infinite loop ?";
+				goto exit_with_error;
+			}
+		}
+		// Do the jump
+		psInstr = psBase + psInstr->jump;
+		INTERP_NEXT();
+
+	INTERP_OP(OP_CALL)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTFUNC( psInstr->psArg->v.pFuncExtern );
+		TRCPRINTF( "\n" );
+		if (!psInstr->psArg->v.pFuncExtern())
+		{
+			pError = "could not do func";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-				TRCPRINTF( "PUSHGLOBAL  %d\n", data );
-				if (data >= numGlobals)
-				{
-					debug( LOG_ERROR, "interpRunScript: variable index out of range" );
-					goto exit_with_error;
-				}
-				if (!stackPush(interpGetVarData(psGlobals, data)))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do stack push" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_POPGLOBAL:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_POPGLOBAL: %d", InstrPointer->type);
-
-				TRCPRINTF( "POPGLOBAL   %d ", data );
-				TRCPRINTSTACKTOP();
-				TRCPRINTF( "\n" );
-				if (data >= numGlobals)
-				{
-					debug( LOG_ERROR, "interpRunScript: variable index out of range" );
-					goto exit_with_error;
-				}
-				if (!stackPopType(interpGetVarData(psGlobals, data)))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do stack pop" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_PUSHARRAYGLOBAL:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_PUSHARRAYGLOBAL: %d", InstrPointer->type);
-
-				TRCPRINTOPCODE(opcode);
-				if (!interpGetArrayVarData(&InstrPointer, psGlobals, psProg, &psVar))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not get array var data, CurEvent=%d", CurEvent );
-					goto exit_with_error;
-				}
-				TRCPRINTF( "\n" );
-				if (!stackPush(psVar))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do stack push" );
-					goto exit_with_error;
-				}
-				break;
-			case OP_POPARRAYGLOBAL:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_POPARRAYGLOBAL: %d", InstrPointer->type);
+	INTERP_OP(OP_VARCALL)
+		TRCPRINTF( "%-6d  ", psInstr->offset );
+		TRCPRINTOPCODE(OP_VARCALL);
+		TRCPRINTVARFUNC( psInstr->psArg->v.pObjGetSet, psInstr->data );
+		TRCPRINTF( "(%d)\n", psInstr->data );
 
-				TRCPRINTOPCODE(opcode);
-				if (!interpGetArrayVarData(&InstrPointer, psGlobals, psProg, &psVar))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not get array var data" );
-					goto exit_with_error;
-				}
-				TRCPRINTSTACKTOP();
-				TRCPRINTF( "\n" );
-				if (!stackPopType(psVar))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do pop stack of type" );
-					goto exit_with_error;
-				}
-				break;
+		if (!psInstr->psArg->v.pObjGetSet(psInstr->data))
+		{
+			pError = "could not do var func";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-			case OP_JUMPFALSE:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_JUMPFALSE: %d", InstrPointer->type);
+	INTERP_OP(OP_EXIT)	/* end of function/event, "exit" or "return" statements */
+		// jump out of the code
+		psInstr = psBase + psInstr->jump;
+		INTERP_NEXT();
 
-				TRCPRINTF( "JUMPFALSE   %d (%d)",
-				           (SWORD)data, (int)(InstrPointer - psProg->pCode + (SWORD)data) );
+	INTERP_OP(OP_PAUSE)
+		TRCPRINTF( "%-6d  PAUSE       %d\n", psInstr->offset, psInstr->data );
+		ASSERT( stackEmpty(),
+			"interpRunScript: OP_PAUSE without empty stack" );
 
-				if (!stackPop(&sVal))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do pop of stack" );
-					goto exit_with_error;
-				}
-				if (!sVal.v.bval)
-				{
-					// Do the jump
-					TRCPRINTF( " - done -\n" );
-					InstrPointer += (SWORD)data;
-					if (InstrPointer < pCodeStart || InstrPointer > pCodeEnd)
-					{
-						debug( LOG_ERROR, "interpRunScript: jump out of range" );
-						goto exit_with_error;
-					}
-				}
-				else
-				{
-					TRCPRINTF( "\n" );
-					InstrPointer += aOpSize[opcode];
-				}
-				break;
-			case OP_JUMP:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_JUMP: %d", InstrPointer->type);
-
-				TRCPRINTF( "JUMP        %d (%d)\n",
-				           (SWORD)data, (int)(InstrPointer - psProg->pCode + (SWORD)data) );
-				// Do the jump
-				InstrPointer += (SWORD)data;
-				if (InstrPointer < pCodeStart || InstrPointer > pCodeEnd)
-				{
-					debug( LOG_ERROR, "interpRunScript: jump out of range" );
-					goto exit_with_error;
-				}
-				break;
-			case OP_CALL:
-				//debug(LOG_SCRIPT, "OP_CALL");
-
-				ASSERT( InstrPointer->type == VAL_OPCODE,
-					"wrong value type passed for OP_CALL: %d", InstrPointer->type);
-
-				scriptFunc = ((INTERP_VAL *)(InstrPointer+1))->v.pFuncExtern;
-				TRCPRINTFUNC( scriptFunc );
-				TRCPRINTF( "\n" );
-				//debug(LOG_SCRIPT, "OP_CALL 1");
-				if (!scriptFunc())
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do func" );
-					goto exit_with_error;
-				}
-				//debug(LOG_SCRIPT, "OP_CALL 2");
-				InstrPointer += aOpSize[opcode];
-				//debug(LOG_SCRIPT, "OP_CALL 3");
-				break;
-			case OP_VARCALL:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_VARCALL: %d", InstrPointer->type);
-
-				TRCPRINTOPCODE(opcode);
-				TRCPRINTVARFUNC(  ((INTERP_VAL *)(InstrPointer+1))->v.pObjGetSet, data );
-				TRCPRINTF( "(%d)\n", data );
-
-				ASSERT( ((INTERP_VAL *)(InstrPointer+1))->type == VAL_OBJ_GETSET,
-					"wrong set/get function pointer type passed for OP_VARCALL: %d", ((INTERP_VAL *)(InstrPointer+1))->type);
-
-				scriptVarFunc =((INTERP_VAL *)(InstrPointer+1))->v.pObjGetSet;
-				if (!scriptVarFunc(data))
-				{
-					debug( LOG_ERROR, "interpRunScript: could not do var func" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_EXIT:	/* end of function/event, "exit" or "return" statements */
-				ASSERT( InstrPointer->type == VAL_OPCODE,
-					"wrong value type passed for OP_EXIT: %d", InstrPointer->type);
-
-				// jump out of the code
-				InstrPointer = pCodeEnd;
-				break;
-			case OP_PAUSE:
-				ASSERT( InstrPointer->type == VAL_PKOPCODE,
-					"wrong value type passed for OP_PAUSE: %d", InstrPointer->type);
-
-				TRCPRINTF( "PAUSE       %d\n", data );
-				ASSERT( stackEmpty(),
-					"interpRunScript: OP_PAUSE without empty stack" );
-
-				InstrPointer += aOpSize[opcode];
-				// tell the event system to reschedule this event
-				if (!eventAddPauseTrigger(psContext, index, (UDWORD)(InstrPointer - pCodeBase), data))	//only original caller can be paused since we pass index and not CurEvent (not sure if that's what we want)
-				{
-					debug( LOG_ERROR, "interpRunScript: could not add pause trigger" );
-					goto exit_with_error;
-				}
-				// now jump out of the event
-				InstrPointer = pCodeEnd;
-				break;
-			case OP_TO_FLOAT:
-				ASSERT( InstrPointer->type == VAL_OPCODE,
-					"wrong value type passed for OP_TO_FLOAT: %d", InstrPointer->type);
-
-				if(!stackCastTop(VAL_FLOAT))
-				{
-					debug( LOG_ERROR, "interpRunScript: OP_TO_FLOAT failed" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			case OP_TO_INT:
-				ASSERT( InstrPointer->type == VAL_OPCODE,
-					"wrong value type passed for OP_TO_INT: %d", InstrPointer->type);
+		// tell the event system to reschedule this event
+		if (!eventAddPauseTrigger(psContext, index, psInstr[1].offset - codeBase, psInstr->data))	//only original caller can be paused since we pass index and not CurEvent (not sure if that's what we want)
+		{
+			pError = "could not add pause trigger";
+			goto exit_with_error;
+		}
+		// now jump out of the event
+		psInstr = psBase + psInstr->jump;
+		INTERP_NEXT();
 
-				if(!stackCastTop(VAL_INT))
-				{
-					debug( LOG_ERROR, "interpRunScript: OP_TO_INT failed" );
-					goto exit_with_error;
-				}
-				InstrPointer += aOpSize[opcode];
-				break;
-			default:
-				debug(LOG_ERROR, "interpRunScript: unknown opcode: %d, type: %d", opcode, InstrPointer->type);
-				goto exit_with_error;
-				break;
-			}
+	INTERP_OP(OP_TO_FLOAT)
+		if(!stackCastTop(VAL_FLOAT))
+		{
+			pError = "OP_TO_FLOAT failed";
+			goto exit_with_error;
 		}
-		else	//End of the event reached, see if we have to jump back to the caller function or just exit
+		++psInstr;
+		INTERP_NEXT();
+
+	INTERP_OP(OP_TO_INT)
+		if(!stackCastTop(VAL_INT))
 		{
-			//debug(LOG_SCRIPT, "End of event reached");
+			pError = "OP_TO_INT failed";
+			goto exit_with_error;
+		}
+		++psInstr;
+		INTERP_NEXT();
 
-			if(!retStackIsEmpty())		//There was a caller function before this one
+	INTERP_OP(OP_ENDCODE)	//End of the event reached, see if we have to jump back to the caller function or just exit
+		if (retStackIsEmpty())
+		{
+			//reset local vars only if original caller was an event, not a trigger
+			if (bEvent)
 			{
 				// destroy current variable environment
 				destroyVarEnvironment(psContext, retStackCallDepth(), CurEvent);
+			}
+			goto finished;		//Stop execution of this event here, no more calling functions stored
+		}
 
-				//pop caller function index and return address
-				if (!retStackPop(&CurEvent, &InstrPointer))
-				{
-					debug( LOG_ERROR, "interpRunScript() - retStackPop() failed.");
-					return false;
-				}
-
-				//remember last called event/index
-				strcpy(last_called_script_event, eventGetEventID(psProg, CurEvent));
+		// destroy current variable environment
+		destroyVarEnvironment(psContext, retStackCallDepth(), CurEvent);
 
-				if(bTraceOn)
-					debug(LOG_SCRIPT,"Returned to: '%s'", last_called_script_event);
+		//pop caller function index and return address
+		if (!retStackPop(&CurEvent, &psInstr))
+		{
+			pError = "retStackPop() failed";
+			goto exit_with_error;
+		}
+		psLocals = varEnvironment[retStackCallDepth()];
 
-				//debug( LOG_SCRIPT, "RETURNED TO CALLER EVENT %d", CurEvent );
+		if (retStackIsEmpty() && !bEvent)
+		{
+			// we jumped back to the original caller, which was a trigger
+			codeBase = psProg->pTriggerTab[CurEvent];
+		}
+		else
+		{
+			codeBase = psProg->pEventTab[CurEvent];
+		}
 
-				//Set new boundaries
-				//--------------------------
-				if(retStackIsEmpty())	//if we jumped back to the original caller
-				{
-					if(!bEvent)		//original caller was a trigger (is it possible at all?)
-					{
-						pCodeBase = psProg->pCode + psProg->pTriggerTab[CurEvent];
-						pCodeStart = pCodeBase;
-						pCodeEnd  = psProg->pCode + psProg->pTriggerTab[CurEvent+1];
-					}
-					else			//original caller was an event
-					{
- 						pCodeBase = psProg->pCode + psProg->pEventTab[CurEvent];
-						pCodeStart = pCodeBase + offset;	//also use the offset passed, since it's an original caller event (offset is used for pause() )
-						pCodeEnd  = psProg->pCode + psProg->pEventTab[CurEvent+1];
-					}
-				}
-				else	//we are still jumping thru functions (this can't be a callback, since it can't/should not be called)
-				{
- 					pCodeBase = psProg->pCode + psProg->pEventTab[CurEvent];
-					pCodeStart = pCodeBase;
-					pCodeEnd  = psProg->pCode + psProg->pEventTab[CurEvent+1];
-				}
-			}
-			else		//we have returned to the original caller event/function
-			{
-				//debug( LOG_SCRIPT, " *** CALL STACK EMPTY ***" );
+		if (bScriptDebug || interpTrace)
+		{
+			interpNoteEvent(psProg, CurEvent, bEvent || !retStackIsEmpty());
+		}
+		INTERP_NEXT();
 
-				//reset local vars only if original caller was an event, not a trigger
-				if(bEvent)
-				{
-					// destroy current variable environment
-					destroyVarEnvironment(psContext, retStackCallDepth(), CurEvent);
-				}
+	INTERP_OP(OP_BADCODE)
+		debug(LOG_ERROR, "interpRunScript: %s at %d", psInstr->pError, psInstr->offset);
+		goto exit_with_error;
 
-				bStop = true;		//Stop execution of this event here, no more calling functions stored
-			}
+#ifndef INTERP_THREADED
+		default:
+			debug(LOG_ERROR, "interpRunScript: unknown opcode: %d", psInstr->opcode);
+			goto exit_with_error;
 		}
-
 	}
+#endif
 
+finished:
 	psCurProg = NULL;
-	TRCPRINTF( "%-6d  EXIT\n", (int)(InstrPointer - psProg->pCode) );
+	TRCPRINTF( "%-6d  EXIT\n", psInstr->offset );
 
 	bInterpRunning = false;
 	return true;
 
 exit_with_error:
 	// Deal with the script crashing or running out of memory
+	if (pError != NULL)
+	{
+		debug(LOG_ERROR, "interpRunScript: %s", pError);
+	}
 	debug(LOG_ERROR,"interpRunScript: *** ERROR EXIT *** (CurEvent=%d)", CurEvent);
 
 	/* Free all memory allocated for variable environments */
@@ -917,6 +1048,10 @@ exit_with_error:
 	debug(LOG_ERROR,"Call depth : %d", callDepth);
 
 	/* Output script call trace */
+	if (bInterpRunning)
+	{
+		interpNoteEvent(psProg, CurEvent, bEvent || !retStackIsEmpty());
+	}
 	scrOutputCallTrace(LOG_ERROR);
 	psCurProg = NULL;
 
@@ -928,6 +1063,9 @@ exit_with_error:
 	return false;
 }
 
+#undef INTERP_OP
+#undef INTERP_NEXT
+
 
 /* Set the type equivalence table */
 void scriptSetTypeEquiv(TYPE_EQUIV *psTypeTab)
@@ -1055,7 +1193,7 @@ static inline bool retStackIsFull(void)
 }
 
 
-static bool retStackPush(UDWORD CallerIndex, INTERP_VAL *ReturnAddress)
+static bool retStackPush(UDWORD CallerIndex, INTERP_INSTR *ReturnAddress)
 {
 	if (retStackIsFull())
 	{
@@ -1073,7 +1211,7 @@ static bool retStackPush(UDWORD CallerIndex, INTERP_VAL *ReturnAddress)
 }
 
 
-static bool retStackPop(UDWORD *CallerIndex, INTERP_VAL **ReturnAddress)
+static bool retStackPop(UDWORD *CallerIndex, INTERP_INSTR **ReturnAddress)
 {
 	if (retStackIsEmpty())
 	{
@@ -1120,7 +1258,7 @@ void scrOutputCallTrace(code_part part)
 				pEvent = eventGetEventID(psCurProg, retStack[i].CallerIndex);
 			}
 
-			debug(part,"%d: %s (return address: %p)", i, pEvent, retStack[i].ReturnAddress);
+			debug(part,"%d: %s (return address: %d)", i, pEvent, retStack[i].ReturnAddress->offset);
 		}
 	}
 	else
@@ -226,6 +226,9 @@ struct TRIGGER_DATA
 	UDWORD			time;		// How often to check the trigger
 };
 
+/* The decoded version of a script, which the interpreter runs */
+struct INTERP_DECODED;
+
 /* A compiled script and its associated data */
 struct SCRIPT_CODE
 {
@@ -258,6 +261,8 @@ struct SCRIPT_CODE
 
 	UWORD			debugEntries;	// Number of entries in psDebug
 	SCRIPT_DEBUG	*psDebug;		// Debugging info for the script
+
+	INTERP_DECODED	*psDecoded;		// The code decoded for the interpreter, NULL until first run
 };
 
 
@@ -281,6 +286,9 @@ extern bool interpInitialise(void);
 // true if the interpreter is currently running
 extern bool interpProcessorActive(void);
 
+// Free the decoded code of a script
+extern void interpFreeDecoded(SCRIPT_CODE *psProg);
+
 /* Output script call stack trace */
 extern void scrOutputCallTrace(code_part part);
 
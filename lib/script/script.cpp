@@ -93,6 +93,7 @@ void scriptFreeCode(SCRIPT_CODE *psCode)
 	free(psCode->ppsLocalVarVal);
 
 	free(psCode->pCode);
+	interpFreeDecoded(psCode);
 
 	free(psCode->pTriggerTab);
 	free(psCode->psTriggerData);
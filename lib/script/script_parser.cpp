@@ -291,6 +291,7 @@ void script_debug(const char *pFormat, ...);
 	(psProg)->numGlobals = (UWORD)(numGlobs); \
 	(psProg)->numTriggers = (UWORD)(numTriggers); \
 	(psProg)->numEvents = (UWORD)(numEvnts); \
+	(psProg)->psDecoded = NULL; \
 	(psProg)->size = (codeSize) * sizeof(INTERP_VAL);
 
 /* Macro to allocate a code block, blockSize - number of INTERP_VALs we need*/
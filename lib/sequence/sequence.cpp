@@ -57,8 +57,10 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
+#include "lib/framework/wzapp.h"
 #include "sequence.h"
 #include "timer.h"
+#include "yuv.h"
 #include "lib/framework/math_ext.h"
 #include "lib/ivis_opengl/piestate.h"
 #include "lib/ivis_opengl/pieblitfunc.h"
@@ -77,6 +79,9 @@
 #include <AL/al.h>
 #endif
 
+#include <deque>
+#include <vector>
+
 // stick this in sequence.h perhaps?
 struct AudioData
 {
@@ -119,28 +124,44 @@ static int vorbis_p = 0;
 
 static bool stateflag = false;
 static bool videoplaying = false;
-static bool videobuf_ready = false;		// single frame video buffer ready for processing
-static bool audiobuf_ready = false;		// single 'frame' audio buffer ready for processing
 
 // file handle
 static PHYSFS_file* fpInfile = NULL;
 
-static uint32_t* RGBAframe = NULL;					// texture buffer
-static ogg_int16_t* audiobuf = NULL;			// audio buffer
+static ogg_int16_t* audiobuf = NULL;			// audio fragment being decoded
+
+#define SEQ_FRAME_QUEUE 4		///< Frames decoded ahead.
+#define SEQ_AUDIO_QUEUE 2		///< Audio fragments, of a second each, decoded ahead.
+
+/// A frame converted to RGBA by the decoder thread, ready for the texture.
+struct SeqFrame
+{
+	uint32_t *rgba;
+	double time;			///< When to show the frame, in seconds since the start.
+};
+
+// The decoder thread fills the queues, the main thread empties them. The counters only ever
+// increase, frames frameQueueRead to frameQueueWrite - 1 (modulo SEQ_FRAME_QUEUE) are ready.
+static SeqFrame frameQueue[SEQ_FRAME_QUEUE];
+static unsigned frameQueueRead = 0;
+static unsigned frameQueueWrite = 0;
+static std::deque<std::vector<ogg_int16_t> > audioQueue;
+
+static WZ_THREAD *seqThread = NULL;
+static WZ_MUTEX *seqMutex = NULL;			///< Guards the queue counters, audioQueue and the flags below.
+static WZ_SEMAPHORE *seqSemaphore = NULL;	///< Posted when the queues have room, or the thread should quit.
+static bool seqThreadQuit = false;
+static bool seqDecodeFinished = false;		///< Everything in the file has been queued.
 
 // For timing
 static double audioTime = 0;
 
-static double videobuf_time = 0;
-static double sampletimeOffset = 0;
+static double videobuf_time = 0;			// time of the frame on screen
 static double basetime = -1;
 static double last_time;
 static double timer_expire;
 static bool timer_started = false;
 
-static ogg_int64_t audiobuf_granulepos = 0;	// time position of last sample
-static ogg_int64_t videobuf_granulepos = -1;	// time position of last video frame
-
 // frame & dropped frame counter
 static int frames = 0;
 static int dropped = 0;
@@ -222,7 +243,6 @@ static void open_audio(void)
 static void audio_close(void)
 {
 	// NOTE: sources & buffers deleted in seq_Shutdown()
-	audiobuf_granulepos = 0;
 //	clear struct
 //	memset(&audiodata,0x0,sizeof(audiodata));
 	audiodata.audiobuf_fill = 0;
@@ -258,7 +278,7 @@ static double getRelativeTime(void)
 const GLfloat texture_width = 1024.0f;
 const GLfloat texture_height = 1024.0f;
 
-/** Allocates memory to hold the decoded video frame
+/** Allocates memory to hold the decoded video frames
  */
 static void Allocate_videoFrame(void)
 {
@@ -266,111 +286,76 @@ static void Allocate_videoFrame(void)
 	if (use_scanlines)
 		size *= 2;
 
-	RGBAframe = (uint32_t *)malloc(size);
-	memset(RGBAframe, 0, size);
+	for (unsigned i = 0; i < SEQ_FRAME_QUEUE; ++i)
+	{
+		frameQueue[i].rgba = (uint32_t *)calloc(1, size);
+	}
 }
 
 static void deallocateVideoFrame(void)
 {
-	if (RGBAframe)
-		free(RGBAframe);
+	for (unsigned i = 0; i < SEQ_FRAME_QUEUE; ++i)
+	{
+		free(frameQueue[i].rgba);
+		frameQueue[i].rgba = NULL;
+	}
 }
 
+// The bytes are always R, G, B, A in memory.
 #ifndef __BIG_ENDIAN__
-const int Rshift = 0;
-const int Gshift = 8;
-const int Bshift = 16;
-const int Ashift = 24;
 // RGBmask is used only after right-shifting, so ignore the leftmost bit of each byte
 const int RGBmask = 0x007f7f7f;
 const int Amask = 0xff000000;
 #else
-const int Rshift = 24;
-const int Gshift = 16;
-const int Bshift = 8;
-const int Ashift = 0;
 const int RGBmask = 0x7f7f7f00;
 const int Amask = 0x000000ff;
 #endif
-#define Vclip( x )	( (x > 0) ? ((x < 255) ? x : 255) : 0 )
-// main routine to display video on screen.
-static void video_write(bool update)
+
+/// Converts the frame just decoded to RGBA, with the scanlines if any. Called by the decoder thread.
+static void video_convert(uint32_t *frame)
 {
-	unsigned int x = 0, y = 0;
-	const int video_width = videodata.ti.frame_width;
-	const int video_height = videodata.ti.frame_height;
-	// when using scanlines we need to double the height
-	const int height_factor = (use_scanlines ? 2 : 1);
+	const unsigned video_width = videodata.ti.frame_width;
+	const unsigned video_height = videodata.ti.frame_height;
 	yuv_buffer yuv;
 
-	if (update)
-	{
-		int rgb_offset = 0;
-		int y_offset = 0;
-		int uv_offset = 0;
-		const int half_width = video_width / 2;
+	theora_decode_YUVout(&videodata.td, &yuv);
 
-		theora_decode_YUVout(&videodata.td, &yuv);
+	uint32_t *row = frame;
+	for (unsigned y = 0; y < video_height; ++y)
+	{
+		const int uv_offset = (y >> 1) * yuv.uv_stride;
+		yuv420ToRgbaRow((uint8_t *)row, yuv.y + y * yuv.y_stride, yuv.u + uv_offset, yuv.v + uv_offset, video_width);
+		row += video_width;
 
-		// fill the RGBA buffer
-		for (y = 0; y < video_height; y++)
+		if (use_scanlines == SCANLINES_50)
 		{
-			y_offset = y * yuv.y_stride;
-			uv_offset = (y >> 1) * yuv.uv_stride;
-
-			for (x = 0; x < half_width; x++)
+			// halve the rgb values for a dimmed scanline
+			for (unsigned x = 0; x < video_width; ++x)
 			{
-				int Y = yuv.y[y_offset++] - 16;
-				const int U = yuv.u[uv_offset] - 128;
-				const int V = yuv.v[uv_offset++] - 128;
-
-				int A = 298 * Y;
-				const int C = 409 * V;
-
-				int R = Vclip((A + C + 128) >> 8);
-				int G = Vclip((A - 100 * U - (C >> 1) + 128) >> 8);
-				int B = Vclip((A + 516 * U + 128) >> 8);
-
-				uint32_t rgba = (R << Rshift) | (G << Gshift) | (B << Bshift) | (0xFF << Ashift);
-
-				RGBAframe[rgb_offset] = rgba;
-				if (use_scanlines == SCANLINES_50)
-				{
-					// halve the rgb values for a dimmed scanline
-					RGBAframe[rgb_offset + video_width] = (rgba >> 1 & RGBmask) | Amask;
-				}
-				else if (use_scanlines == SCANLINES_BLACK)
-				{
-					RGBAframe[rgb_offset + video_width] = Amask;
-				}
-				rgb_offset++;
-
-				// second pixel, U and V (and thus C) are the same as before.
-				Y = yuv.y[y_offset++] - 16;
-				A = 298 * Y;
-
-				R = Vclip((A + C + 128) >> 8);
-				G = Vclip((A - 100 * U - (C >> 1) + 128) >> 8);
-				B = Vclip((A + 516 * U + 128) >> 8);
-
-				rgba = (R << Rshift) | (G << Gshift) | (B << Bshift) | (0xFF << Ashift);
-				RGBAframe[rgb_offset] = rgba;
-				if (use_scanlines == SCANLINES_50)
-				{
-					// halve the rgb values for a dimmed scanline
-					RGBAframe[rgb_offset + video_width] = (rgba >> 1 & RGBmask) | Amask;
-				}
-				else if (use_scanlines == SCANLINES_BLACK)
-				{
-					RGBAframe[rgb_offset + video_width] = Amask;
-				}
-				rgb_offset++;
+				row[x] = (row[x - video_width] >> 1 & RGBmask) | Amask;
+			}
+		}
+		else if (use_scanlines == SCANLINES_BLACK)
+		{
+			for (unsigned x = 0; x < video_width; ++x)
+			{
+				row[x] = Amask;
 			}
-			if (use_scanlines)
-				rgb_offset += video_width;
 		}
+		if (use_scanlines)
+			row += video_width;
+	}
+}
 
-		videoGfx->updateTexture(RGBAframe, video_width, video_height * height_factor);
+// main routine to display video on screen, with the given frame if not NULL.
+static void video_write(uint32_t const *frame)
+{
+	if (frame != NULL)
+	{
+		// when using scanlines we need to double the height
+		const int height_factor = (use_scanlines ? 2 : 1);
+
+		videoGfx->updateTexture(frame, videodata.ti.frame_width, videodata.ti.frame_height * height_factor);
 	}
 
 	glDisable(GL_DEPTH_TEST);
@@ -386,7 +371,7 @@ static void video_write(bool update)
 }
 
 // FIXME: perhaps we should use wz's routine for audio?
-// loads up the audio buffers, and calculates audio sync time.
+// loads up the audio buffers with the fragments decoded, and calculates audio sync time.
 static void audio_write(void)
 {
 	ALint processed = 0;
@@ -394,9 +379,22 @@ static void audio_write(void)
 
 	alGetSourcei(audiodata.source, AL_BUFFERS_PROCESSED, &processed);
 	alGetSourcei(audiodata.source, AL_BUFFERS_QUEUED, &queued);
-	if ((audiodata.totbufstarted < 2 || processed) && audiodata.audiobuf_fill > 0)
+	if (audiodata.totbufstarted < 2 || processed)
 	{
-		// we have audiobuf_fill bytes of data
+		std::vector<ogg_int16_t> fragment;
+		wzMutexLock(seqMutex);
+		if (!audioQueue.empty())
+		{
+			fragment.swap(audioQueue.front());
+			audioQueue.pop_front();
+		}
+		wzMutexUnlock(seqMutex);
+		if (fragment.empty())
+		{
+			return;
+		}
+		wzSemaphorePost(seqSemaphore);  // There is room for another fragment.
+
 		ALuint oldbuffer = 0;
 
 		if (audiodata.totbufstarted == 0)
@@ -410,19 +408,16 @@ static void audio_write(void)
 		else
 		{
 			ALint buffer_size = 0;
-			ogg_int64_t current_sample = 0;
 
 			alSourceUnqueueBuffers(audiodata.source, 1, &oldbuffer);
 			alGetBufferi(oldbuffer, AL_SIZE, &buffer_size);
 			// audio time sync
 			audioTime += (double) buffer_size / (videodata.vi.rate * videodata.vi.channels);
 			debug(LOG_VIDEO, "Audio sync");
-			current_sample = audiobuf_granulepos - audiodata.audiobuf_fill / 2 / videodata.vi.channels;
-			sampletimeOffset -= getTimeNow() - 1000 * current_sample / videodata.vi.rate;
 		}
 
 		alBufferData(oldbuffer, (videodata.vi.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16),
-		        audiobuf, audiodata.audiobuf_fill, videodata.vi.rate);
+		        &fragment[0], fragment.size() * sizeof(ogg_int16_t), videodata.vi.rate);
 
 		alSourceQueueBuffers(audiodata.source, 1, &oldbuffer);
 		audiodata.totbufstarted++;
@@ -436,12 +431,180 @@ static void audio_write(void)
 			debug(LOG_VIDEO, "starting source\n");
 			alSourcePlay(audiodata.source);
 		}
+	}
+}
 
-		audiobuf_ready = 0;
-		audiodata.audiobuf_fill = 0;
+/// Throws away the audio decoded, when audio is disabled, so that decoding goes on.
+static void audio_discard(void)
+{
+	wzMutexLock(seqMutex);
+	bool discarded = !audioQueue.empty();
+	audioQueue.clear();
+	wzMutexUnlock(seqMutex);
+	if (discarded)
+	{
+		wzSemaphorePost(seqSemaphore);
 	}
 }
 
+/// Gets the next packet of a stream, skipping holes in the data. Returns false if more data is needed.
+static bool seq_PacketOut(ogg_stream_state *stream, ogg_packet *op)
+{
+	int ret;
+	while ((ret = ogg_stream_packetout(stream, op)) < 0)
+	{}
+	return ret > 0;
+}
+
+/// Hands the audio fragment decoded so far over to the main thread.
+static void seq_QueueAudio(void)
+{
+	std::vector<ogg_int16_t> fragment(audiobuf, audiobuf + audiodata.audiobuf_fill / 2);
+	audiodata.audiobuf_fill = 0;
+
+	wzMutexLock(seqMutex);
+	audioQueue.push_back(std::vector<ogg_int16_t>());
+	audioQueue.back().swap(fragment);
+	wzMutexUnlock(seqMutex);
+}
+
+/// Decodes audio until a whole fragment is queued. Returns false if nothing could be decoded without more data.
+static bool seq_DecodeAudio(void)
+{
+	ogg_packet op;
+	int ret;
+	float **pcm;
+	bool progress = false;
+
+	while (audiodata.audiobuf_fill < audiodata.audiofd_fragsize)
+	{
+		/* if there's pending, decoded audio, grab it */
+		if ((ret = vorbis_synthesis_pcmout(&videodata.vd, &pcm)) > 0)
+		{
+			// we now have float pcm data in pcm
+			// going to convert that to int pcm in audiobuf
+			int count = audiodata.audiobuf_fill / 2;
+			const int maxsamples = (audiodata.audiofd_fragsize - audiodata.audiobuf_fill) / 2 / videodata.vi.channels;
+			int i;
+
+			for (i = 0; i < ret && i < maxsamples; i++)
+			{
+				for (int j = 0; j < videodata.vi.channels; j++)
+				{
+					int val = nearbyint(pcm[j][i] * 32767.f);
+
+					if (val > 32767)
+					{
+						val = 32767;
+					}
+					else if (val < -32768)
+					{
+						val = -32768;
+					}
+					audiobuf[count++] = val;
+				}
+			}
+
+			vorbis_synthesis_read(&videodata.vd, i);
+			audiodata.audiobuf_fill += i * videodata.vi.channels * 2;
+		}
+		/* no pending audio; is there a pending packet to decode? */
+		else if (seq_PacketOut(&videodata.vo, &op))
+		{
+			if (vorbis_synthesis(&videodata.vb, &op) == 0)
+			{	/* test for success! */
+				vorbis_synthesis_blockin(&videodata.vd, &videodata.vb);
+			}
+		}
+		else
+		{	/* we need more data */
+			return progress;
+		}
+		progress = true;
+	}
+
+	seq_QueueAudio();
+	return true;
+}
+
+/// Decodes the next frame into the given slot of the frame queue. Returns false if more data is needed.
+static bool seq_DecodeVideo(SeqFrame *frame)
+{
+	ogg_packet op;
+
+	/* theora is one in, one out... */
+	if (!seq_PacketOut(&videodata.to, &op))
+	{
+		return false;
+	}
+	theora_decode_packetin(&videodata.td, &op);
+	frame->time = theora_granule_time(&videodata.td, videodata.td.granulepos);
+	video_convert(frame->rgba);
+	return true;
+}
+
+/** Decodes ahead, while the main thread plays what has been decoded. Decodes whichever
+ *  stream has room in its queue, and reads more of the file when that stream needs it.
+ */
+static int seq_DecodeThreadFunc(void *)
+{
+	wzMutexLock(seqMutex);
+	while (!seqThreadQuit)
+	{
+		const bool videoRoom = theora_p && frameQueueWrite - frameQueueRead < SEQ_FRAME_QUEUE;
+		const bool audioRoom = vorbis_p && audioQueue.size() < SEQ_AUDIO_QUEUE;
+		SeqFrame *frame = &frameQueue[frameQueueWrite % SEQ_FRAME_QUEUE];
+		const bool decoding = !seqDecodeFinished;
+		wzMutexUnlock(seqMutex);
+
+		bool progress = false;
+		bool finished = false;
+		if (decoding && videoRoom && seq_DecodeVideo(frame))
+		{
+			wzMutexLock(seqMutex);
+			++frameQueueWrite;
+			wzMutexUnlock(seqMutex);
+			progress = true;
+		}
+		if (decoding && audioRoom && seq_DecodeAudio())
+		{
+			progress = true;
+		}
+		if (decoding && !progress && (videoRoom || audioRoom))
+		{
+			/* no data yet for somebody.  Grab another page */
+			if (buffer_data(fpInfile, &videodata.oy) > 0)
+			{
+				while (ogg_sync_pageout(&videodata.oy, &videodata.og) > 0)
+				{
+					queue_page(&videodata.og);
+				}
+				progress = true;
+			}
+			else if ((!theora_p || videoRoom) && (!vorbis_p || audioRoom))
+			{
+				// Out of data, and no stream has anything left to decode.
+				if (audiodata.audiobuf_fill > 0)
+				{
+					seq_QueueAudio();
+				}
+				finished = true;
+			}
+		}
+
+		wzMutexLock(seqMutex);
+		seqDecodeFinished = seqDecodeFinished || finished;
+		if (!progress && !seqThreadQuit)
+		{
+			wzMutexUnlock(seqMutex);
+			wzSemaphoreWait(seqSemaphore);
+			wzMutexLock(seqMutex);
+		}
+	}
+	wzMutexUnlock(seqMutex);
+	return 0;
+}
+
 static void seq_InitOgg(void)
 {
 	debug(LOG_VIDEO, "seq_InitOgg");
@@ -452,22 +615,19 @@ static void seq_InitOgg(void)
 
 	videoplaying = false;
 
-	/* single frame video buffering */
-	videobuf_ready = false;
-	videobuf_granulepos = -1;
+	/* video and audio decoded ahead by the decoder thread */
+	frameQueueRead = frameQueueWrite = 0;
+	audioQueue.clear();
+	seqThreadQuit = false;
+	seqDecodeFinished = false;
+
 	videobuf_time = 0;
 	frames = 0;
 	dropped = 0;
 
-	/* single audio fragment audio buffering */
 	audiodata.audiobuf_fill = 0;
-	audiobuf_ready = false;
-
-	audiobuf_granulepos = 0;	/* time position of last sample */
 	audioTime = 0;
 
-	sampletimeOffset = 0;
-
 	/* start up Ogg stream synchronization layer */
 	ogg_sync_init(&videodata.oy);
 
@@ -709,7 +869,10 @@ bool seq_Play(const char* filename)
 		we have a start frame for both.  This is not necessarily a valid
 		assumption in Ogg A/V streams! It will always be true of the
 		example_encoder (and most streams) though. */
-	sampletimeOffset = getTimeNow();
+	seqMutex = wzMutexCreate();
+	seqSemaphore = wzSemaphoreCreate(0);
+	seqThread = wzThreadCreate(seq_DecodeThreadFunc, NULL);
+	wzThreadStart(seqThread);
 	videoplaying = true;
 	return true;
 }
@@ -725,173 +888,94 @@ bool seq_Playing()
  */
 bool seq_Update()
 {
-	ogg_packet op;
-	int ret;
-	int i, j;
-	float **  pcm;
-	int count, maxsamples;
-
-	/* we want a video and audio frame ready to go at all times.  If
-		   we have to buffer incoming, buffer the compressed data (ie, let
-		   ogg do the buffering) */
+	/* the decoder thread keeps a few video frames and audio fragments ready to go
+	   at all times.  We only play them here. */
 	if (!videoplaying)
 	{
 		debug(LOG_VIDEO, "no movie playing");
 		return false;
 	}
 
-	while (vorbis_p && !audiobuf_ready)
-	{
-		/* if there's pending, decoded audio, grab it */
-		if ((ret = vorbis_synthesis_pcmout(&videodata.vd, &pcm)) > 0)
-		{
-			// we now have float pcm data in pcm
-			// going to convert that to int pcm in audiobuf
-			count = audiodata.audiobuf_fill / 2;
-			maxsamples = (audiodata.audiofd_fragsize - audiodata.audiobuf_fill) / 2 / videodata.vi.channels;
-
-			for (i = 0; i < ret && i < maxsamples; i++)
-			{
-				for (j = 0; j < videodata.vi.channels; j++)
-				{
-					int val = nearbyint(pcm[j][i] * 32767.f);
-
-					if (val > 32767)
-					{
-						val = 32767;
-					}
-					else if (val < -32768)
-					{
-						val = -32768;
-					}
-					audiobuf[count++] = val;
-				}
-			}
-
-			vorbis_synthesis_read(&videodata.vd, i);
-			audiodata.audiobuf_fill += i * videodata.vi.channels * 2;
-
-			if (audiodata.audiobuf_fill == audiodata.audiofd_fragsize)
-			{
-				audiobuf_ready = true;
-			}
-
-			if (videodata.vd.granulepos >= 0)
-			{
-				audiobuf_granulepos = videodata.vd.granulepos - ret + i;
-			}
-			else
-			{
-				audiobuf_granulepos += i;
-			}
-		}
-		else
-		{
-			/* no pending audio; is there a pending packet to decode? */
-			if (ogg_stream_packetout(&videodata.vo, &op) > 0)
-			{
-				if (vorbis_synthesis(&videodata.vb, &op) == 0)
-				{	/* test for success! */
-					vorbis_synthesis_blockin(&videodata.vd, &videodata.vb);
-				}
-			}
-			else
-			{	/* we need more data; break out to suck in another page */
-				break;
-			}
-		}
-	}
-
-	while (theora_p && !videobuf_ready)
-	{
-		/* theora is one in, one out... */
-		if (ogg_stream_packetout(&videodata.to, &op) > 0)
-		{
-			double now_time = 0;
-			double delay = 0;
-
-			theora_decode_packetin(&videodata.td, &op);
-			videobuf_granulepos = videodata.td.granulepos;
-			videobuf_time = theora_granule_time(&videodata.td, videobuf_granulepos);
-
-			now_time = getRelativeTime();
-			delay = videobuf_time - getRelativeTime();
-
-			if ((delay >= 0.0f) || (now_time - last_time >= 1.0f))
-			{
-				videobuf_ready = true;
-				seq_SetFrameNumber(seq_GetFrameNumber() + 1);
-			}
-			else
-			{
-				// running slow, so we skip this frame
-				dropped++;
-			}
-		}
-		else
-		{
-			break;
-		}
-	}
+	wzMutexLock(seqMutex);
+	const bool finished = seqDecodeFinished;
+	const unsigned framesQueued = frameQueueWrite - frameQueueRead;
+	const bool audioQueued = !audioQueue.empty();
+	wzMutexUnlock(seqMutex);
 
 	alGetSourcei(audiodata.source, AL_SOURCE_STATE, &sourcestate);
 
-	if (PHYSFS_eof(fpInfile)
-		&& !videobuf_ready
-		&& ((!audiobuf_ready && (audiodata.audiobuf_fill == 0)) || audio_Disabled())
+	if (finished
+		&& framesQueued == 0
+		&& (!audioQueued || audio_Disabled())
 		&& sourcestate != AL_PLAYING
 	 )
 	{
-		video_write(false);
+		video_write(NULL);
 		seq_Shutdown();
 		debug(LOG_VIDEO, "video finished");
 		return false;
 	}
 
-	if (!videobuf_ready || !audiobuf_ready)
+	/* if our buffers either don't exist or are ready to go,
+		   we can begin playback, same if we've run out of input */
+	if (!stateflag && (((!theora_p || framesQueued > 0) && (!vorbis_p || audioQueued)) || finished))
 	{
-		/* no data yet for somebody.  Grab another page */
-		ret = buffer_data(fpInfile, &videodata.oy);
-		while (ogg_sync_pageout(&videodata.oy, &videodata.og) > 0)
-		{
-			queue_page(&videodata.og);
-		}
+		debug(LOG_VIDEO, "all buffers ready");
+		stateflag = true;
+	}
+	if (!stateflag)
+	{
+		return true;
 	}
 
-	/* If playback has begun, top audio buffer off immediately. */
-	if (vorbis_p
-	 && stateflag
+	/* top audio buffer off immediately. */
 	// FIXME : it is possible to crash if people are playing with no sound.
-	 && !audio_Disabled())
+	if (vorbis_p && !audio_Disabled())
 	{
 		// play the data in pcm
 		audio_write();
 	}
-
-	/* are we at or past time for this video frame? */
-	if (stateflag && videobuf_ready && (videobuf_time <= getRelativeTime()))
+	else if (vorbis_p)
 	{
-		video_write(true);
-		last_time = getRelativeTime();
-		videobuf_ready = false;
-	}
-	else if (stateflag)
-	{
-		video_write(false);
+		audio_discard();
 	}
 
-	/* if our buffers either don't exist or are ready to go,
-		   we can begin playback */
-	if ((!theora_p || videobuf_ready) && (!vorbis_p || audiobuf_ready) && !stateflag)
+	/* are we at or past time for the next video frame? */
+	SeqFrame const *frame = NULL;
+	unsigned skip = 0;
+	if (framesQueued > 0)
 	{
-		debug(LOG_VIDEO, "all buffers ready");
-		stateflag = true;
+		const double now_time = getRelativeTime();
+
+		// running slow, so we skip the frames already late, unless nothing was shown for a second
+		while (skip + 1 < framesQueued && frameQueue[(frameQueueRead + skip + 1) % SEQ_FRAME_QUEUE].time <= now_time
+		       && now_time - last_time < 1.0f)
+		{
+			++skip;
+		}
+		frame = &frameQueue[(frameQueueRead + skip) % SEQ_FRAME_QUEUE];
+		if (frame->time <= now_time)
+		{
+			dropped += skip;
+			seq_SetFrameNumber(seq_GetFrameNumber() + 1);
+			videobuf_time = frame->time;
+			last_time = now_time;
+		}
+		else
+		{
+			frame = NULL;
+		}
 	}
 
-	/* same if we've run out of input */
-	if (PHYSFS_eof(fpInfile))
+	video_write(frame != NULL ? frame->rgba : NULL);
+
+	if (frame != NULL)
 	{
-		stateflag = true;
+		// The texture has the frame now, the decoder thread can have the slots back.
+		wzMutexLock(seqMutex);
+		frameQueueRead += skip + 1;
+		wzMutexUnlock(seqMutex);
+		wzSemaphorePost(seqSemaphore);
 	}
 
 	return true;
@@ -907,6 +991,20 @@ void seq_Shutdown()
 		debug(LOG_VIDEO, "movie is not playing");
 		return;
 	}
+
+	// stop decoding before the decoder state goes
+	wzMutexLock(seqMutex);
+	seqThreadQuit = true;
+	wzMutexUnlock(seqMutex);
+	wzSemaphorePost(seqSemaphore);
+	wzThreadJoin(seqThread);
+	seqThread = NULL;
+	wzMutexDestroy(seqMutex);
+	seqMutex = NULL;
+	wzSemaphoreDestroy(seqSemaphore);
+	seqSemaphore = NULL;
+	audioQueue.clear();
+
 	delete videoGfx;
 	videoGfx = NULL;
 
@@ -945,7 +1043,7 @@ void seq_Shutdown()
 	Timer_stop();
 
 	audioTime = 0;
-	sampletimeOffset = last_time = timer_expire = timer_started = 0;
+	last_time = timer_expire = timer_started = 0;
 	basetime = -1;
 	pie_SetTexturePage(-1);
 	debug(LOG_VIDEO, " **** frames = %d dropped = %d ****", frames, dropped);
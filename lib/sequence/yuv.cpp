@@ -0,0 +1,199 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * yuv.cpp
+ *
+ * YUV420 to RGBA conversion of video rows. The vector versions do 8 pixels at a time with 32 bit
+ * intermediates, like the scalar version, so the results are identical. The rest of a row is done
+ * by the scalar version.
+ */
+#include "yuv.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define YUV_SSE2
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+# define YUV_NEON
+# include <arm_neon.h>
+#endif
+
+#define Vclip( x )	( (x > 0) ? ((x < 255) ? x : 255) : 0 )
+
+void yuv420ToRgbaRowScalar(uint8_t *rgba, uint8_t const *y, uint8_t const *u, uint8_t const *v, unsigned width)
+{
+	for (unsigned x = 0; x < width / 2; ++x)
+	{
+		const int U = u[x] - 128;
+		const int V = v[x] - 128;
+		const int C = 409 * V;
+
+		// Two pixels, U and V (and thus C) are the same for both.
+		for (unsigned i = 0; i < 2; ++i)
+		{
+			const int A = 298 * (y[2*x + i] - 16);
+
+			const int R = (A + C + 128) >> 8;
+			const int G = (A - 100 * U - (C >> 1) + 128) >> 8;
+			const int B = (A + 516 * U + 128) >> 8;
+
+			*rgba++ = Vclip(R);
+			*rgba++ = Vclip(G);
+			*rgba++ = Vclip(B);
+			*rgba++ = 0xFF;
+		}
+	}
+}
+
+#if defined(YUV_SSE2)
+
+// Four pixels of one colour, from 16 bit pairs of (Y, other) multiplied by (298, mul) and added.
+static inline __m128i yuvMadd(__m128i y, __m128i other, __m128i mul, __m128i add)
+{
+	return _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, other), mul), add);
+}
+
+static inline __m128i yuvMaddHi(__m128i y, __m128i other, __m128i mul, __m128i add)
+{
+	return _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, other), mul), add);
+}
+
+void yuv420ToRgbaRow(uint8_t *rgba, uint8_t const *y, uint8_t const *u, uint8_t const *v, unsigned width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha = _mm_set1_epi8((char)0xFF);
+	const __m128i offsetY = _mm_set1_epi16(16);
+	const __m128i offsetUV = _mm_set1_epi16(128);
+	const __m128i round = _mm_set1_epi32(128);
+	const __m128i mulR = _mm_set_epi16(409, 298, 409, 298, 409, 298, 409, 298);   // (Y, V)
+	const __m128i mulG = _mm_set_epi16(-100, 298, -100, 298, -100, 298, -100, 298);  // (Y, U)
+	const __m128i mulB = _mm_set_epi16(516, 298, 516, 298, 516, 298, 516, 298);   // (Y, U)
+	const __m128i mulC = _mm_set_epi16(0, 409, 0, 409, 0, 409, 0, 409);           // (V, 0)
+
+	unsigned x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		int32_t u4, v4;
+		memcpy(&u4, u + x/2, 4);
+		memcpy(&v4, v + x/2, 4);
+
+		__m128i Y = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const *)(y + x)), zero), offsetY);
+		__m128i U = _mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero);
+		__m128i V = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero);
+		U = _mm_sub_epi16(_mm_unpacklo_epi16(U, U), offsetUV);
+		V = _mm_sub_epi16(_mm_unpacklo_epi16(V, V), offsetUV);
+
+		__m128i halfCLo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(V, zero), mulC), 1);
+		__m128i halfCHi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(V, zero), mulC), 1);
+
+		__m128i RLo = _mm_srai_epi32(yuvMadd(Y, V, mulR, round), 8);
+		__m128i RHi = _mm_srai_epi32(yuvMaddHi(Y, V, mulR, round), 8);
+		__m128i GLo = _mm_srai_epi32(_mm_sub_epi32(yuvMadd(Y, U, mulG, round), halfCLo), 8);
+		__m128i GHi = _mm_srai_epi32(_mm_sub_epi32(yuvMaddHi(Y, U, mulG, round), halfCHi), 8);
+		__m128i BLo = _mm_srai_epi32(yuvMadd(Y, U, mulB, round), 8);
+		__m128i BHi = _mm_srai_epi32(yuvMaddHi(Y, U, mulB, round), 8);
+
+		// Saturating packs do the clipping, the values fit in 16 bits before it.
+		__m128i R = _mm_packus_epi16(_mm_packs_epi32(RLo, RHi), zero);
+		__m128i G = _mm_packus_epi16(_mm_packs_epi32(GLo, GHi), zero);
+		__m128i B = _mm_packus_epi16(_mm_packs_epi32(BLo, BHi), zero);
+
+		__m128i RG = _mm_unpacklo_epi8(R, G);
+		__m128i BA = _mm_unpacklo_epi8(B, alpha);
+		_mm_storeu_si128((__m128i *)(rgba + 4*x), _mm_unpacklo_epi16(RG, BA));
+		_mm_storeu_si128((__m128i *)(rgba + 4*x + 16), _mm_unpackhi_epi16(RG, BA));
+	}
+	yuv420ToRgbaRowScalar(rgba + 4*x, y + x, u + x/2, v + x/2, width - x);
+}
+
+char const *yuv420ToRgbaImplementation()
+{
+	return "sse2";
+}
+
+#elif defined(YUV_NEON)
+
+// Four pixels of one colour, as 32 bit values before clipping.
+static inline int16x4_t yuvNarrow(int32x4_t colour)
+{
+	return vmovn_s32(vshrq_n_s32(colour, 8));
+}
+
+void yuv420ToRgbaRow(uint8_t *rgba, uint8_t const *y, uint8_t const *u, uint8_t const *v, unsigned width)
+{
+	const int32x4_t round = vdupq_n_s32(128);
+
+	unsigned x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		uint32_t u4, v4;
+		memcpy(&u4, u + x/2, 4);
+		memcpy(&v4, v + x/2, 4);
+		uint8x8_t u8 = vreinterpret_u8_u32(vdup_n_u32(u4));
+		uint8x8_t v8 = vreinterpret_u8_u32(vdup_n_u32(v4));
+
+		int16x8_t Y = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))), vdupq_n_s16(16));
+		int16x8_t U = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(u8, u8).val[0])), vdupq_n_s16(128));
+		int16x8_t V = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(v8, v8).val[0])), vdupq_n_s16(128));
+
+		int16x4_t R[2], G[2], B[2];
+		for (int half = 0; half < 2; ++half)
+		{
+			int16x4_t Yh = half ? vget_high_s16(Y) : vget_low_s16(Y);
+			int16x4_t Uh = half ? vget_high_s16(U) : vget_low_s16(U);
+			int16x4_t Vh = half ? vget_high_s16(V) : vget_low_s16(V);
+
+			int32x4_t A = vaddq_s32(vmull_n_s16(Yh, 298), round);
+			int32x4_t C = vmull_n_s16(Vh, 409);
+
+			R[half] = yuvNarrow(vaddq_s32(A, C));
+			G[half] = yuvNarrow(vsubq_s32(vmlal_n_s16(A, Uh, -100), vshrq_n_s32(C, 1)));
+			B[half] = yuvNarrow(vmlal_n_s16(A, Uh, 516));
+		}
+
+		// Saturating narrowing does the clipping.
+		uint8x8x4_t out;
+		out.val[0] = vqmovun_s16(vcombine_s16(R[0], R[1]));
+		out.val[1] = vqmovun_s16(vcombine_s16(G[0], G[1]));
+		out.val[2] = vqmovun_s16(vcombine_s16(B[0], B[1]));
+		out.val[3] = vdup_n_u8(0xFF);
+		vst4_u8(rgba + 4*x, out);
+	}
+	yuv420ToRgbaRowScalar(rgba + 4*x, y + x, u + x/2, v + x/2, width - x);
+}
+
+char const *yuv420ToRgbaImplementation()
+{
+	return "neon";
+}
+
+#else
+
+void yuv420ToRgbaRow(uint8_t *rgba, uint8_t const *y, uint8_t const *u, uint8_t const *v, unsigned width)
+{
+	yuv420ToRgbaRowScalar(rgba, y, u, v, width);
+}
+
+char const *yuv420ToRgbaImplementation()
+{
+	return "scalar";
+}
+
+#endif
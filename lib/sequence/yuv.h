@@ -0,0 +1,41 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*! \file yuv.h
+ *  \brief Conversion of YUV420 video rows to RGBA.
+ *
+ * Uses the integer BT.601 formula the sequence player always used:
+ * R = (298*(Y-16) + 409*(V-128) + 128) >> 8, and so on, clamped to 0..255.
+ * The SSE2 and NEON versions give exactly the same bytes as the scalar one.
+ */
+#ifndef __INCLUDED_LIB_SEQUENCE_YUV_H__
+#define __INCLUDED_LIB_SEQUENCE_YUV_H__
+
+#include <stdint.h>
+
+/// Converts one row of width pixels to R, G, B, A bytes, with A = 255. The u and v rows have one sample per two
+/// pixels. If width is odd, the last pixel is left alone.
+void yuv420ToRgbaRowScalar(uint8_t *rgba, uint8_t const *y, uint8_t const *u, uint8_t const *v, unsigned width);
+
+/// The same as yuv420ToRgbaRowScalar, using SSE2 or NEON if compiled for them.
+void yuv420ToRgbaRow(uint8_t *rgba, uint8_t const *y, uint8_t const *u, uint8_t const *v, unsigned width);
+
+/// Name of the implementation yuv420ToRgbaRow uses, "sse2", "neon" or "scalar".
+char const *yuv420ToRgbaImplementation(void);
+
+#endif // __INCLUDED_LIB_SEQUENCE_YUV_H__
@@ -31,6 +31,7 @@
 // defines
 #define NO_SAMPLE				- 2
 #define MAX_SAME_SAMPLES		2
+#define SAME_CELL_BUCKETS		4096	// buckets counting 3D samples per track and grid cell, collisions only make the limit stricter
 
 // global variables
 static AUDIO_SAMPLE *g_psSampleList = NULL;
@@ -39,6 +40,7 @@ static bool			g_bAudioEnabled = false;
 static bool			g_bAudioPaused = false;
 static AUDIO_SAMPLE g_sPreviousSample;
 static int			g_iPreviousSampleTime = 0;
+static uint8_t		g_aSameCellCount[SAME_CELL_BUCKETS];
 
 /** Counts the number of samples in the SampleQueue
  *  \return the number of samples in the SampleQueue
@@ -154,6 +156,7 @@ bool audio_Shutdown(void)
 	// free sample heap
 	g_psSampleList = NULL;
 	g_psSampleQueue = NULL;
+	memset(g_aSameCellCount, 0, sizeof(g_aSameCellCount));
 
 	return bOK;
 }
@@ -281,6 +284,17 @@ static void audio_RemoveSample(AUDIO_SAMPLE **ppsSampleList, AUDIO_SAMPLE *psSam
 	psSample->psNext = NULL;
 }
 
+/** Stops counting the sample in its grid cell, once it is removed from the list of playing samples.
+ */
+static void audio_LeaveSameCell(AUDIO_SAMPLE *psSample)
+{
+	if (psSample->iSameCell >= 0)
+	{
+		--g_aSameCellCount[psSample->iSameCell];
+		psSample->iSameCell = -1;
+	}
+}
+
 //*
 // =======================================================================================================================
 // =======================================================================================================================
@@ -358,6 +372,7 @@ static AUDIO_SAMPLE *audio_QueueSample(SDWORD iTrack)
 	psSample->y = SAMPLE_COORD_INVALID;
 	psSample->z = SAMPLE_COORD_INVALID;
 	psSample->bFinishedPlaying = false;
+	psSample->iSameCell = -1;
 
 	// add to queue
 	audio_AddSampleToTail(&g_psSampleQueue, psSample);
@@ -575,6 +590,7 @@ void audio_Update()
 		if (psSample->bFinishedPlaying == true)
 		{
 			psSampleTemp = psSample->psNext;
+			audio_LeaveSameCell(psSample);
 			audio_RemoveSample(&g_psSampleList, psSample);
 			free(psSample);
 			psSample = psSampleTemp;
@@ -628,6 +644,17 @@ unsigned int audio_SetTrackVals(const char *fileName, bool loop, unsigned int vo
 	return sound_SetTrackVals(fileName, loop, volume, audibleRadius);
 }
 
+/** Finds the bucket counting the 3D samples of the track in the grid cell containing the given position. The cells
+ *  are as big as the track's audible radius, so the samples counted together are mostly within earshot of each other.
+ */
+static int audio_GetSameCell(SDWORD iTrack, SDWORD iX, SDWORD iY)
+{
+	SDWORD		iRad = MAX(sound_GetTrackAudibleRadius(iTrack), 1);
+	uint32_t	cellX = iX / iRad, cellY = iY / iRad;
+
+	return (iTrack * 73856093u ^ cellX * 19349663u ^ cellY * 83492791u) % SAME_CELL_BUCKETS;
+}
+
 //*
 //
 //
@@ -639,50 +666,15 @@ unsigned int audio_SetTrackVals(const char *fileName, bool loop, unsigned int vo
 // =======================================================================================================================
 // =======================================================================================================================
 //
-static bool audio_CheckSame3DTracksPlaying(SDWORD iTrack, SDWORD iX, SDWORD iY, SDWORD iZ)
+static bool audio_CheckSame3DTracksPlaying(int iSameCell)
 {
-	//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-	SDWORD			iCount, iDx, iDy, iDz, iDistSq, iMaxDistSq, iRad;
-	AUDIO_SAMPLE	*psSample = NULL;
-	bool			bOK = true;
-	//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-
 	// return if audio not enabled
 	if (g_bAudioEnabled == false || g_bAudioPaused == true)
 	{
 		return true;
 	}
 
-	iCount = 0;
-
-	// loop through 3D sounds and check whether too many already in earshot
-	psSample = g_psSampleList;
-	while (psSample != NULL)
-	{
-		if (psSample->iTrack == iTrack)
-		{
-			iDx = iX - psSample->x;
-			iDy = iY - psSample->y;
-			iDz = iZ - psSample->z;
-			iDistSq = (iDx * iDx) + (iDy * iDy) + (iDz * iDz);
-			iRad = sound_GetTrackAudibleRadius(iTrack);
-			iMaxDistSq = iRad * iRad;
-			if (iDistSq < iMaxDistSq)
-			{
-				iCount++;
-			}
-
-			if (iCount > MAX_SAME_SAMPLES)
-			{
-				bOK = false;
-				break;
-			}
-		}
-
-		psSample = psSample->psNext;
-	}
-
-	return bOK;
+	return g_aSameCellCount[iSameCell] <= MAX_SAME_SAMPLES;
 }
 
 //*
@@ -697,6 +689,7 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 	// calculation results
 	float	distance, gain;
 	ALenum err;
+	int		iSameCell;
 
 	// if audio not enabled return true to carry on game without audio
 	if (g_bAudioEnabled == false || g_bAudioPaused == true)
@@ -704,7 +697,8 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 		return false;
 	}
 
-	if (audio_CheckSame3DTracksPlaying(iTrack, iX, iY, iZ) == false)
+	iSameCell = audio_GetSameCell(iTrack, iX, iY);
+	if (audio_CheckSame3DTracksPlaying(iSameCell) == false)
 	{
 		return false;
 	}
@@ -754,6 +748,7 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 	psSample->bFinishedPlaying = false;
 	psSample->psObj = psObj;
 	psSample->pCallback = pUserCallback;
+	psSample->iSameCell = -1;
 
 	// add sample to list if able to play
 	if (!sound_Play3DTrack(psSample))
@@ -763,6 +758,8 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 		return false;
 	}
 
+	psSample->iSameCell = iSameCell;
+	++g_aSameCellCount[iSameCell];
 	audio_AddSampleToHead(&g_psSampleList, psSample);
 	return true;
 }
@@ -963,6 +960,7 @@ void audio_PlayTrack(int iTrack)
 	// Zero callback stuff since we don't need/want it
 	psSample->pCallback = NULL;
 	psSample->psObj = NULL;
+	psSample->iSameCell = -1;
 
 	/* iSample, psPrev, and psNext will be initialized by the
 	 * following functions, and x, y and z will be completely
@@ -1166,6 +1164,7 @@ void audio_RemoveObj(SIMPLE_OBJECT const *psObj)
 			sound_RemoveActiveSample(toRemove);   //remove from global active list.
 
 			// Perform the actual task of destroying this sample
+			audio_LeaveSameCell(toRemove);
 			audio_RemoveSample(&g_psSampleList, toRemove);
 			free(toRemove);
 
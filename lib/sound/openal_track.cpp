@@ -25,6 +25,8 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/math_ext.h"
 #include "lib/framework/frameresource.h"
+#include "lib/framework/metrics.h"
+#include "lib/framework/wzapp.h"
 #include "lib/exceptionhandler/dumpinfo.h"
 
 #ifdef WZ_OS_MAC
@@ -38,6 +40,9 @@
 #include <physfs.h>
 #include <string.h>
 #include <math.h>
+#include <algorithm>
+#include <vector>
+#include <QtCore/QAtomicInt>
 
 #include "tracklib.h"
 #include "audio.h"
@@ -50,6 +55,8 @@ static ALuint current_queue_sample = -1;
 
 static bool openal_initialized = false;
 
+#define STREAM_RING_SIZE 8      ///< Buffers the decoder thread keeps decoded ahead, for each stream.
+
 struct AUDIO_STREAM
 {
 	ALuint                  source;        // OpenAL name of the sound source
@@ -62,11 +69,33 @@ struct AUDIO_STREAM
 	void                    *user_data;
 
 	size_t                  bufferSize;
+	std::vector<ALuint>     buffers;       // OpenAL names of all the buffers
+	std::vector<ALuint>     freeBuffers;   // buffers waiting for decoded data
+	bool                    started;       // whether the source has started playing
+	bool                    stopped;       // stopped by sound_StopStream(), so to be destroyed
+	bool                    paused;        // paused by sound_PauseStream()
+	bool                    finished;      // all decoded data has been queued
+
+	// Ring of decoded data, filled by the decoder thread. A NULL entry marks the end.
+	// Only the decoder thread writes ringWrite, and only the main thread writes ringRead.
+	soundDataBuffer        *ring[STREAM_RING_SIZE];
+	QAtomicInt              ringRead, ringWrite;
+	bool                    decoded;       // decoder thread only, true once the end has been put in the ring
 
 	// Linked list pointer
 	AUDIO_STREAM           *next;
 };
 
+// The decoder thread decodes the streams ahead, so a slow decode doesn't stall a frame.
+static WZ_THREAD *streamThread = NULL;
+static WZ_MUTEX *streamThreadMutex = NULL;              ///< Held by the decoder thread while decoding, and to add or remove streams.
+static WZ_SEMAPHORE *streamThreadSemaphore = NULL;      ///< Posted when a stream has room in its ring.
+static bool streamThreadQuit = false;
+static std::vector<AUDIO_STREAM *> streamThreadStreams; ///< Streams the decoder thread decodes.
+static unsigned streamUnderruns = 0, streamsStarved = 0;
+static Metric metricStreamUnderruns("sound.stream.underruns", METRIC_COUNTER);  ///< OpenAL played a buffer, but nothing was decoded to refill it.
+static Metric metricStreamsStarved("sound.stream.starved", METRIC_COUNTER);     ///< A source ran out of buffers, and had to be restarted.
+
 struct SAMPLE_LIST
 {
 	AUDIO_SAMPLE   *curr;
@@ -83,6 +112,35 @@ static ALfloat		sfx3d_volume = 1.0;
 static ALCdevice *device = NULL;
 static ALCcontext *context = NULL;
 
+#define SOUND_CACHE_SIZE (16*1024*1024)  ///< Bytes of decoded sound effects to keep, before dropping the least recently played.
+
+// Tracks are only registered when the resources load, and decoded when first played.
+static std::vector<TRACK *> decodedTracks;      ///< Tracks with a buffer.
+static size_t decodedBytes = 0;                 ///< Size of the buffers of decodedTracks.
+static UDWORD playCount = 0;                    ///< Number of sounds played, to order tracks by when they were last played.
+static unsigned tracksRegistered = 0, tracksDecoded = 0, tracksDropped = 0;
+static unsigned decodeTime = 0;                 ///< Milliseconds spent decoding tracks.
+static Metric metricSoundCacheBytes("sound.cache.bytes", METRIC_GAUGE);
+static Metric metricSoundDecodes("sound.decodes", METRIC_COUNTER);
+
+#define SOUND_VOICES 64                 ///< OpenAL sources for samples, generated once. Samples beyond these are virtual.
+#define SOUND_STREAM_SOURCES 4          ///< OpenAL sources left for the streams.
+#define SOUND_VOICE_HYSTERESIS 1.5f     ///< How much louder a virtual sample must get than a playing one, to take its voice.
+#define SOUND_2D_PRIORITY 2.0f          ///< fGain of 2D samples, which are never attenuated, so never lose their voice.
+
+/// A source, and the sample playing on it. A sample without a voice is virtual: it is kept, with its position and
+/// gain updated, but silent, until it finishes or gets loud enough to take a voice from a quieter sample.
+struct VOICE
+{
+	ALuint          source;
+	AUDIO_SAMPLE   *psSample;           ///< NULL if free
+};
+
+static std::vector<VOICE> voices;
+static unsigned voicesStolen = 0;
+static Metric metricSoundVirtual("sound.voices.virtual", METRIC_GAUGE);
+static Metric metricSoundStolen("sound.voices.stolen", METRIC_COUNTER);
+
 
 /** Removes the given sample from the "active_samples" linked list
  *  \param previous either NULL (if \c to_remove is the first item in the
@@ -109,6 +167,61 @@ static void sound_RemoveSample(SAMPLE_LIST *previous, SAMPLE_LIST *to_remove)
 	}
 }
 
+/** Decodes the stream until its ring is full, or everything is decoded. Runs on the decoder thread.
+ */
+static void sound_DecodeStreamAhead(AUDIO_STREAM *stream)
+{
+	int write = stream->ringWrite.fetchAndAddAcquire(0);
+
+	while (!stream->decoded && (unsigned)(write - stream->ringRead.fetchAndAddAcquire(0)) < STREAM_RING_SIZE)
+	{
+		soundDataBuffer *soundBuffer = sound_DecodeOggVorbis(stream->decoder, stream->bufferSize);
+
+		// If no data has been decoded we're at the end of our stream.
+		if (soundBuffer == NULL || soundBuffer->size == 0)
+		{
+			free(soundBuffer);
+			soundBuffer = NULL;
+			stream->decoded = true;
+		}
+		stream->ring[(unsigned)write % STREAM_RING_SIZE] = soundBuffer;
+		stream->ringWrite.fetchAndStoreRelease(++write);
+	}
+}
+
+/** Takes the next decoded buffer from the stream's ring. Runs on the main thread.
+ *  \return false if the ring is empty
+ */
+static bool sound_PopStreamRing(AUDIO_STREAM *stream, soundDataBuffer **soundBuffer)
+{
+	int read = stream->ringRead.fetchAndAddAcquire(0);
+
+	if (read == stream->ringWrite.fetchAndAddAcquire(0))
+	{
+		return false;
+	}
+	*soundBuffer = stream->ring[(unsigned)read % STREAM_RING_SIZE];
+	stream->ringRead.fetchAndStoreRelease(read + 1);
+	return true;
+}
+
+static int sound_StreamThreadFunc(void *)
+{
+	wzMutexLock(streamThreadMutex);
+	while (!streamThreadQuit)
+	{
+		for (std::vector<AUDIO_STREAM *>::iterator i = streamThreadStreams.begin(); i != streamThreadStreams.end(); ++i)
+		{
+			sound_DecodeStreamAhead(*i);
+		}
+		wzMutexUnlock(streamThreadMutex);
+		wzSemaphoreWait(streamThreadSemaphore);  // Go to sleep until a stream has room.
+		wzMutexLock(streamThreadMutex);
+	}
+	wzMutexUnlock(streamThreadMutex);
+	return 0;
+}
+
 //*
 // =======================================================================================================================
 // =======================================================================================================================
@@ -210,10 +323,39 @@ bool sound_InitLibrary(void)
 	alDistanceModel(AL_NONE);
 	sound_GetError();
 
+	// Generate as many sources as we can, up to SOUND_VOICES, leaving some for the streams.
+	ALuint sources[SOUND_VOICES + SOUND_STREAM_SOURCES];
+	unsigned numSources = 0;
+	while (numSources < ARRAY_SIZE(sources))
+	{
+		alGenSources(1, &sources[numSources]);
+		if (alGetError() != AL_NO_ERROR)
+		{
+			break;
+		}
+		++numSources;
+	}
+	unsigned numVoices = numSources > SOUND_STREAM_SOURCES ? numSources - SOUND_STREAM_SOURCES : std::min(numSources, 1u);
+	alDeleteSources(numSources - numVoices, sources + numVoices);
+	sound_GetError();
+	for (unsigned i = 0; i < numVoices; ++i)
+	{
+		VOICE voice = {sources[i], NULL};
+		voices.push_back(voice);
+	}
+	debug(LOG_SOUND, "%u voices", numVoices);
+
+	streamThreadQuit = false;
+	streamThreadMutex = wzMutexCreate();
+	streamThreadSemaphore = wzSemaphoreCreate(0);
+	streamThread = wzThreadCreate(sound_StreamThreadFunc, NULL);
+	wzThreadStart(streamThread);
+
 	return true;
 }
 
 static void sound_UpdateStreams(void);
+static bool sound_LoadTrackBuffer(TRACK *psTrack);
 
 void sound_ShutdownLibrary(void)
 {
@@ -225,6 +367,10 @@ void sound_ShutdownLibrary(void)
 		return;
 	}
 	debug(LOG_SOUND, "starting shutdown");
+	debug(LOG_SOUND, "%u of %u tracks decoded when first played, taking %u ms, %u dropped again, %u KiB cached",
+	      tracksDecoded, tracksRegistered, decodeTime, tracksDropped, (unsigned)(decodedBytes / 1024));
+	debug(LOG_SOUND, "%u voices taken by louder samples", voicesStolen);
+	debug(LOG_SOUND, "%u stream underruns, %u streams restarted after running out", streamUnderruns, streamsStarved);
 
 	// Stop all streams, sound_UpdateStreams() will deallocate all stopped streams
 	for (stream = active_streams; stream != NULL; stream = stream->next)
@@ -233,6 +379,25 @@ void sound_ShutdownLibrary(void)
 	}
 	sound_UpdateStreams();
 
+	wzMutexLock(streamThreadMutex);
+	streamThreadQuit = true;
+	wzMutexUnlock(streamThreadMutex);
+	wzSemaphorePost(streamThreadSemaphore);  // Wake up the thread, so it can quit.
+	wzThreadJoin(streamThread);
+	streamThread = NULL;
+	wzMutexDestroy(streamThreadMutex);
+	streamThreadMutex = NULL;
+	wzSemaphoreDestroy(streamThreadSemaphore);
+	streamThreadSemaphore = NULL;
+
+	for (std::vector<VOICE>::iterator i = voices.begin(); i != voices.end(); ++i)
+	{
+		alSourceStop(i->source);
+		alDeleteSources(1, &i->source);
+	}
+	voices.clear();
+	sound_GetError();
+
 	alcGetError(device);	// clear error codes
 
 	/* On Linux since this caused some versions of OpenAL to hang on exit. - Per */
@@ -259,18 +424,117 @@ void sound_ShutdownLibrary(void)
 	active_samples = NULL;
 }
 
+/** Stops the sample, and frees its voice, leaving it virtual.
+ */
+static void sound_ReleaseVoice(AUDIO_SAMPLE *psSample)
+{
+	if (psSample->iSample == (ALuint)AL_INVALID)
+	{
+		return;
+	}
+	alSourceStop(psSample->iSample);
+	alSourcei(psSample->iSample, AL_BUFFER, 0);
+	sound_GetError();
+	if (current_queue_sample == psSample->iSample)
+	{
+		current_queue_sample = AL_INVALID;
+	}
+	for (std::vector<VOICE>::iterator i = voices.begin(); i != voices.end(); ++i)
+	{
+		if (i->psSample == psSample)
+		{
+			i->psSample = NULL;
+		}
+	}
+	psSample->iSample = AL_INVALID;
+}
+
+/** Gives the sample a free voice, or else takes the voice of the quietest sample, if the given sample is louder by
+ *  the factor \c margin. The sample losing its voice becomes virtual.
+ *  \return false if all the voices are playing louder samples
+ */
+static bool sound_GetVoice(AUDIO_SAMPLE *psSample, float margin)
+{
+	VOICE *psVoice = NULL;
+	for (std::vector<VOICE>::iterator i = voices.begin(); i != voices.end(); ++i)
+	{
+		if (i->psSample == NULL)
+		{
+			psVoice = &*i;
+			break;
+		}
+		if (psVoice == NULL || i->psSample->fGain < psVoice->psSample->fGain)
+		{
+			psVoice = &*i;
+		}
+	}
+	if (psVoice == NULL)
+	{
+		return false;
+	}
+	if (psVoice->psSample != NULL)
+	{
+		if (psVoice->psSample->fGain * margin >= psSample->fGain)
+		{
+			return false;
+		}
+		sound_ReleaseVoice(psVoice->psSample);
+		++voicesStolen;
+		metricSoundStolen.add();
+	}
+	psVoice->psSample = psSample;
+	psSample->iSample = psVoice->source;
+	return true;
+}
+
+/** Sets up the sample's voice to play the track, from where the sample would be now, if it has been virtual.
+ */
+static void sound_StartVoice(AUDIO_SAMPLE *psSample, TRACK *psTrack, bool is3D)
+{
+	ALfloat zero[3] = { 0.0, 0.0, 0.0 };
+	ALuint source = psSample->iSample;
+	UDWORD elapsed = wzGetTicks() - psSample->iStartTime;
+
+	// Clear error codes
+	alGetError();
+
+	if (is3D)
+	{
+		// HACK: this is a workaround for a bug in the 64bit implementation of OpenAL on GNU/Linux
+		// The AL_PITCH value really should be 1.0.
+		alSourcef(source, AL_PITCH, 1.001f);
+		alSourcef(source, AL_GAIN, psSample->fGain);
+		alSource3f(source, AL_POSITION, (float)psSample->x, (float)psSample->y, (float)psSample->z);
+		alSourcei(source, AL_SOURCE_RELATIVE, AL_FALSE);
+	}
+	else
+	{
+		alSourcef(source, AL_PITCH, 1.0f);
+		alSourcef(source, AL_GAIN, psSample->fVol * sfx_volume);
+		alSourcefv(source, AL_POSITION, zero);
+		alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+	}
+	alSourcefv(source, AL_VELOCITY, zero);
+	alSourcei(source, AL_BUFFER, psTrack->iBufferName);
+	alSourcei(source, AL_LOOPING, psTrack->bLoop ? AL_TRUE : AL_FALSE);
+	if (elapsed > 0 && psTrack->iTime > 0)
+	{
+		alSourcef(source, AL_SEC_OFFSET, (elapsed % psTrack->iTime) / 1000.f);
+	}
+	sound_GetError();
+
+	alSourcePlay(source);
+	sound_GetError();
+}
+
 /** Deletes the given sample and updates the \c previous and \c current iterators
  *  \param previous iterator to the previous sample in the list
  *  \param sample iterator to the current sample in the list which you want to delete
  */
 static void sound_DestroyIteratedSample(SAMPLE_LIST **previous, SAMPLE_LIST **sample)
 {
-	// If an OpenAL source is associated with this sample, release it
-	if ((*sample)->curr->iSample != (ALuint)AL_INVALID)
-	{
-		alDeleteSources(1, &(*sample)->curr->iSample);
-		sound_GetError();
-	}
+	// If a voice is associated with this sample, release it
+	sound_ReleaseVoice((*sample)->curr);
 
 	// Do the cleanup of this sample
 	sound_FinishedCallback((*sample)->curr);
@@ -300,12 +564,20 @@ unsigned int sound_GetActiveSamplesCount()
 	return num;
 }
 
+/** Sorts louder samples first. */
+static bool sound_LouderSample(AUDIO_SAMPLE const *a, AUDIO_SAMPLE const *b)
+{
+	return a->fGain > b->fGain;
+}
+
 void sound_Update()
 {
 	SAMPLE_LIST *node = active_samples;
 	SAMPLE_LIST *previous = NULL;
 	ALCenum err;
-	ALfloat gain;
+	UDWORD now = wzGetTicks();
+	std::vector<AUDIO_SAMPLE *> audible;    // Virtual samples which could take a voice.
+	unsigned numVirtual = 0;
 
 	if (!openal_initialized)
 	{
@@ -318,20 +590,42 @@ void sound_Update()
 	while (node != NULL)
 	{
 		ALenum state, err;
+		AUDIO_SAMPLE *psSample = node->curr;
 
-		// query what the gain is for this sample
-		alGetSourcef(node->curr->iSample, AL_GAIN, &gain);
-		err = sound_GetError();
+		// if gain is 0, then we can't hear it, so free its voice.
+		if (psSample->fGain == 0.0f)
+		{
+			sound_ReleaseVoice(psSample);
+		}
 
-		// if gain is 0, then we can't hear it, so we kill it.
-		if (gain == 0.0f)
+		if (psSample->iSample == (ALuint)AL_INVALID)
 		{
-			sound_DestroyIteratedSample(&previous, &node);
+			// Virtual, finished when it would have finished playing.
+			if (now >= psSample->iEndTime)
+			{
+				sound_DestroyIteratedSample(&previous, &node);
+				continue;
+			}
+			if (psSample->fGain > 0.0f)
+			{
+				audible.push_back(psSample);
+			}
+			++numVirtual;
+			previous = node;
+			node = node->next;
+			continue;
+		}
+
+		// Can't have finished yet, so don't ask OpenAL.
+		if (now < psSample->iEndTime)
+		{
+			previous = node;
+			node = node->next;
 			continue;
 		}
 
-		//ASSERT(alIsSource(node->curr->iSample), "Not a valid source!");
-		alGetSourcei(node->curr->iSample, AL_SOURCE_STATE, &state);
+		//ASSERT(alIsSource(psSample->iSample), "Not a valid source!");
+		alGetSourcei(psSample->iSample, AL_SOURCE_STATE, &state);
 
 		// Check whether an error occurred while retrieving the state.
 		// If one did, the state returned is useless. So instead of
@@ -340,7 +634,7 @@ void sound_Update()
 		if (err != AL_NO_ERROR)
 		{
 			// Make sure to invoke the "finished" callback
-			sound_FinishedCallback(node->curr);
+			sound_FinishedCallback(psSample);
 
 			// Destroy this object and move to the next object
 			sound_DestroyIteratedSample(&previous, &node);
@@ -354,8 +648,6 @@ void sound_Update()
 			// If we haven't finished playing yet, just
 			// continue with the next item in the list.
 
-			// sound_SetObjectPosition(i->curr->iSample, i->curr->x, i->curr->y, i->curr->z);
-
 			// Move to the next object
 			previous = node;
 			node = node->next;
@@ -370,6 +662,26 @@ void sound_Update()
 		}
 	}
 
+	// Give voices to the loudest virtual samples, while there are free voices or quieter samples playing.
+	std::sort(audible.begin(), audible.end(), sound_LouderSample);
+	for (std::vector<AUDIO_SAMPLE *>::iterator i = audible.begin(); i != audible.end(); ++i)
+	{
+		TRACK *psTrack = sound_GetTrack((*i)->iTrack);
+		if (!sound_GetVoice(*i, SOUND_VOICE_HYSTERESIS))
+		{
+			break;
+		}
+		if (psTrack == NULL || !sound_LoadTrackBuffer(psTrack))
+		{
+			sound_ReleaseVoice(*i);
+			(*i)->iEndTime = 0;  // Can't be played.
+			continue;
+		}
+		sound_StartVoice(*i, psTrack, true);
+		--numVirtual;
+	}
+	metricSoundVirtual.set(numVirtual);
+
 	// Reset the current error state
 	alcGetError(device);
 
@@ -443,26 +755,20 @@ bool sound_QueueSamplePlaying(void)
 /** Decodes an opened OggVorbis file into an OpenAL buffer
  *  \param psTrack pointer to object which will contain the final buffer
  *  \param PHYSFS_fileHandle file handle given by PhysicsFS to the opened file
- *  \return on success the psTrack pointer, otherwise it will be free'd and a NULL pointer is returned instead
+ *  \return true on success
  */
-static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHYSFS_fileHandle)
+static inline bool sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHYSFS_fileHandle)
 {
 	ALenum		format;
 	ALuint		buffer;
 	struct OggVorbisDecoderState *decoder;
 	soundDataBuffer	*soundBuffer;
 
-	if (!openal_initialized)
-	{
-		return NULL;
-	}
-
 	decoder = sound_CreateOggVorbisDecoder(PHYSFS_fileHandle, true);
 	if (decoder == NULL)
 	{
 		debug(LOG_WARNING, "Failed to open audio file for decoding");
-		free(psTrack);
-		return NULL;
+		return false;
 	}
 
 	soundBuffer = sound_DecodeOggVorbis(decoder, 0);
@@ -470,8 +776,7 @@ static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHY
 
 	if (soundBuffer == NULL)
 	{
-		free(psTrack);
-		return NULL;
+		return false;
 	}
 
 	if (soundBuffer->size == 0)
@@ -479,11 +784,10 @@ static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHY
 		debug(LOG_WARNING, "sound_DecodeOggVorbisTrack: OggVorbis track is entirely empty after decoding");
 // NOTE: I'm not entirely sure if a track that's empty after decoding should be
 //       considered an error condition. Therefore I'll only error out on DEBUG
-//       builds. (Returning NULL here __will__ result in a program termination.)
+//       builds.
 #ifdef DEBUG
 		free(soundBuffer);
-		free(psTrack);
-		return NULL;
+		return false;
 #endif
 	}
 
@@ -496,12 +800,101 @@ static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHY
 	alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
 	sound_GetError();
 
-	free(soundBuffer);
-
 	// save buffer name in track
 	psTrack->iBufferName = buffer;
+	psTrack->iBufferSize = soundBuffer->size;
+	psTrack->iTime = soundBuffer->frequency != 0 ? (uint64_t)soundBuffer->size * 1000 / (soundBuffer->channelCount * 2 * soundBuffer->frequency) : 0;
+
+	free(soundBuffer);
+
+	return true;
+}
+
+/** Checks whether any voice uses the given buffer, in which case OpenAL can't delete it.
+ */
+static bool sound_BufferInUse(ALuint buffer)
+{
+	for (std::vector<VOICE>::iterator i = voices.begin(); i != voices.end(); ++i)
+	{
+		ALint sampleBuffer = 0;
+		if (i->psSample == NULL)
+		{
+			continue;
+		}
+		alGetSourcei(i->source, AL_BUFFER, &sampleBuffer);
+		if (sound_GetError() == AL_NO_ERROR && (ALuint)sampleBuffer == buffer)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void sound_DropTrackBuffer(TRACK *psTrack)
+{
+	alDeleteBuffers(1, &psTrack->iBufferName);
+	sound_GetError();
+	decodedBytes -= psTrack->iBufferSize;
+	psTrack->iBufferName = 0;
+	psTrack->iBufferSize = 0;
+	decodedTracks.erase(std::find(decodedTracks.begin(), decodedTracks.end(), psTrack));
+	metricSoundCacheBytes.set(decodedBytes);
+}
+
+/** Makes sure the track has a buffer, decoding it if this is the first time it is played since loading, or since it was
+ *  dropped from the cache. Then drops the least recently played tracks which aren't playing, while over SOUND_CACHE_SIZE.
+ *  \return false if the track can't be decoded
+ */
+static bool sound_LoadTrackBuffer(TRACK *psTrack)
+{
+	psTrack->iLastPlayed = ++playCount;
+	if (psTrack->iBufferName != 0)
+	{
+		return true;
+	}
+	if (psTrack->filePath == NULL)
+	{
+		return false;  // Already failed.
+	}
+
+	unsigned startTime = wzGetTicks();
+	PHYSFS_file *fileHandle = PHYSFS_openRead(psTrack->filePath);
+	bool decoded = fileHandle != NULL && sound_DecodeOggVorbisTrack(psTrack, fileHandle);
+	if (fileHandle != NULL)
+	{
+		PHYSFS_close(fileHandle);
+	}
+	if (!decoded)
+	{
+		debug(LOG_ERROR, "Could not decode %s: %s", psTrack->filePath, fileHandle == NULL ? PHYSFS_getLastError() : "bad data");
+		psTrack->filePath = NULL;
+		return false;
+	}
+	decodeTime += wzGetTicks() - startTime;
+	++tracksDecoded;
+	metricSoundDecodes.add();
 
-	return psTrack;
+	decodedTracks.push_back(psTrack);
+	decodedBytes += psTrack->iBufferSize;
+	while (decodedBytes > SOUND_CACHE_SIZE)
+	{
+		TRACK *psOldest = NULL;
+		for (std::vector<TRACK *>::iterator i = decodedTracks.begin(); i != decodedTracks.end(); ++i)
+		{
+			if (*i != psTrack && (psOldest == NULL || (*i)->iLastPlayed < psOldest->iLastPlayed) && !sound_BufferInUse((*i)->iBufferName))
+			{
+				psOldest = *i;
+			}
+		}
+		if (psOldest == NULL)
+		{
+			break;  // Everything else is playing.
+		}
+		sound_DropTrackBuffer(psOldest);
+		++tracksDropped;
+	}
+	metricSoundCacheBytes.set(decodedBytes);
+	return true;
 }
 
 //*
@@ -511,16 +904,19 @@ static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHY
 TRACK *sound_LoadTrackFromFile(const char *fileName)
 {
 	TRACK *pTrack;
-	PHYSFS_file *fileHandle;
-	size_t filename_size;
+	size_t filename_size, path_size;
 	char *track_name;
 
-	// Use PhysicsFS to open the file
-	fileHandle = PHYSFS_openRead(fileName);
+	if (!openal_initialized)
+	{
+		return NULL;
+	}
+
+	// Only check that the file is there, it is decoded when first played.
 	debug(LOG_NEVER, "Reading...[directory: %s] %s", PHYSFS_getRealDir(fileName), fileName);
-	if (fileHandle == NULL)
+	if (!PHYSFS_exists(fileName))
 	{
-		debug(LOG_ERROR, "sound_LoadTrackFromFile: PHYSFS_openRead(\"%s\") failed with error: %s\n", fileName, PHYSFS_getLastError());
+		debug(LOG_ERROR, "sound_LoadTrackFromFile: \"%s\" not found: %s\n", fileName, PHYSFS_getLastError());
 		return NULL;
 	}
 
@@ -534,10 +930,11 @@ TRACK *sound_LoadTrackFromFile(const char *fileName)
 	{
 		filename_size = strlen(GetLastResourceFilename()) + 1;
 	}
+	path_size = strlen(fileName) + 1;
 
-	// allocate track, plus the memory required to contain the filename
+	// allocate track, plus the memory required to contain the filename and path
 	// one malloc call ensures only one free call is required
-	pTrack = (TRACK *)malloc(sizeof(TRACK) + filename_size);
+	pTrack = (TRACK *)malloc(sizeof(TRACK) + filename_size + path_size);
 	if (pTrack == NULL)
 	{
 		debug(LOG_FATAL, "sound_ConstructTrack: couldn't allocate memory\n");
@@ -559,18 +956,18 @@ TRACK *sound_LoadTrackFromFile(const char *fileName)
 		strcpy(track_name, GetLastResourceFilename());
 	}
 	pTrack->fileName = track_name;
+	pTrack->filePath = strcpy((char *)(pTrack + 1) + filename_size, fileName);
 
-	// Now use sound_ReadTrackFromBuffer to decode the file's contents
-	pTrack = sound_DecodeOggVorbisTrack(pTrack, fileHandle);
-
-	PHYSFS_close(fileHandle);
+	++tracksRegistered;
 	return pTrack;
 }
 
 void sound_FreeTrack(TRACK *psTrack)
 {
-	alDeleteBuffers(1, &psTrack->iBufferName);
-	sound_GetError();
+	if (psTrack->iBufferName != 0)
+	{
+		sound_DropTrackBuffer(psTrack);
+	}
 }
 
 static void sound_AddActiveSample(AUDIO_SAMPLE *psSample)
@@ -625,9 +1022,7 @@ static bool sound_SetupChannel(AUDIO_SAMPLE *psSample)
 //
 bool sound_Play2DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample, bool bQueued)
 {
-	ALfloat zero[3] = { 0.0, 0.0, 0.0 };
 	ALfloat volume;
-	ALint error;
 
 	if (sfx_volume == 0.0)
 	{
@@ -638,33 +1033,21 @@ bool sound_Play2DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample, bool bQueued)
 	volume *= sfx_volume;							// and now take into account the Users sound Prefs.
 
 	// We can't hear it, so don't bother creating it.
-	if (volume == 0.0f)
+	if (volume == 0.0f || !sound_LoadTrackBuffer(psTrack))
 	{
 		return false;
 	}
 
-	// Clear error codes
-	alGetError();
-
-	alGenSources(1, &(psSample->iSample));
-
-	error = sound_GetError();
-	if (error != AL_NO_ERROR)
+	// 2D samples aren't worth keeping virtual, so need a voice now.
+	psSample->iSample = AL_INVALID;
+	psSample->fGain = SOUND_2D_PRIORITY;
+	if (!sound_GetVoice(psSample, 1.0f))
 	{
-		/* FIXME: We run out of OpenAL sources very quickly, so we
-		 * should handle the case where we've ran out of them.
-		 * Currently we don't do this, causing some unpleasant side
-		 * effects, e.g. crashing...
-		 */
+		debug(LOG_SOUND, "No voice for %s", psTrack->fileName);
+		return false;
 	}
-
-	alSourcef(psSample->iSample, AL_PITCH, 1.0f);
-	alSourcef(psSample->iSample, AL_GAIN, volume);
-	alSourcefv(psSample->iSample, AL_POSITION, zero);
-	alSourcefv(psSample->iSample, AL_VELOCITY, zero);
-	alSourcei(psSample->iSample, AL_BUFFER, psTrack->iBufferName);
-	alSourcei(psSample->iSample, AL_SOURCE_RELATIVE, AL_TRUE);
-	alSourcei(psSample->iSample, AL_LOOPING, (sound_SetupChannel(psSample)) ? AL_TRUE : AL_FALSE);
+	psSample->iStartTime = wzGetTicks();
+	psSample->iEndTime = sound_SetupChannel(psSample) ? UDWORD_MAX : psSample->iStartTime + psTrack->iTime;
 
 	// NOTE: this is only useful for debugging.
 #ifdef DEBUG
@@ -673,11 +1056,8 @@ bool sound_Play2DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample, bool bQueued)
 	memcpy(psSample->filename, psTrack->fileName, strlen(psTrack->fileName));
 	psSample->filename[strlen(psTrack->fileName)] = '\0';
 #endif
-	// Clear error codes
-	alGetError();
 
-	alSourcePlay(psSample->iSample);
-	sound_GetError();
+	sound_StartVoice(psSample, psTrack, false);
 
 	if (bQueued)
 	{
@@ -697,9 +1077,7 @@ bool sound_Play2DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample, bool bQueued)
 //
 bool sound_Play3DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample)
 {
-	ALfloat zero[3] = { 0.0, 0.0, 0.0 };
 	ALfloat volume;
-	ALint error;
 
 	if (sfx3d_volume == 0.0)
 	{
@@ -710,33 +1088,18 @@ bool sound_Play3DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample)
 	psSample->fVol = volume;						// store results for later
 
 	// If we can't hear it, then don't bother playing it.
-	if (volume == 0.0f)
+	if (volume == 0.0f || !sound_LoadTrackBuffer(psTrack))
 	{
 		return false;
 	}
-	// Clear error codes
-	alGetError();
-
-	alGenSources(1, &(psSample->iSample));
-
-	error = sound_GetError();
-	if (error != AL_NO_ERROR)
+	psSample->iSample = AL_INVALID;
+	sound_SetObjectPosition(psSample);
+	if (psSample->fGain == 0.0f)
 	{
-		/* FIXME: We run out of OpenAL sources very quickly, so we
-		 * should handle the case where we've ran out of them.
-		 * Currently we don't do this, causing some unpleasant side
-		 * effects, e.g. crashing...
-		 */
+		return false;
 	}
-
-	// HACK: this is a workaround for a bug in the 64bit implementation of OpenAL on GNU/Linux
-	// The AL_PITCH value really should be 1.0.
-	alSourcef(psSample->iSample, AL_PITCH, 1.001f);
-
-	sound_SetObjectPosition(psSample);
-	alSourcefv(psSample->iSample, AL_VELOCITY, zero);
-	alSourcei(psSample->iSample, AL_BUFFER, psTrack->iBufferName);
-	alSourcei(psSample->iSample, AL_LOOPING, (sound_SetupChannel(psSample)) ? AL_TRUE : AL_FALSE);
+	psSample->iStartTime = wzGetTicks();
+	psSample->iEndTime = sound_SetupChannel(psSample) ? UDWORD_MAX : psSample->iStartTime + psTrack->iTime;
 
 	// NOTE: this is only useful for debugging.
 #ifdef DEBUG
@@ -746,11 +1109,11 @@ bool sound_Play3DSample(TRACK *psTrack, AUDIO_SAMPLE *psSample)
 	psSample->filename[strlen(psTrack->fileName)] = '\0';
 #endif
 
-	// Clear error codes
-	alGetError();
-
-	alSourcePlay(psSample->iSample);
-	sound_GetError();
+	// Without a voice, the sample is virtual until one is free, or it is louder than another.
+	if (sound_GetVoice(psSample, 1.0f))
+	{
+		sound_StartVoice(psSample, psTrack, true);
+	}
 
 	return true;
 }
@@ -790,9 +1153,7 @@ AUDIO_STREAM *sound_PlayStream(PHYSFS_file *fileHandle, float volume, void (*onF
 AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, void (*onFinished)(void *), void *user_data, size_t streamBufferSize, unsigned int buffer_count)
 {
 	AUDIO_STREAM *stream;
-	ALuint       *buffers = (ALuint *)alloca(sizeof(ALuint) * buffer_count);
 	ALint error;
-	unsigned int i;
 
 	if (!openal_initialized)
 	{
@@ -800,13 +1161,7 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 		return NULL;
 	}
 
-	stream = (AUDIO_STREAM *)malloc(sizeof(AUDIO_STREAM));
-	if (stream == NULL)
-	{
-		debug(LOG_FATAL, "sound_PlayStream: Out of memory");
-		abort();
-		return NULL;
-	}
+	stream = new AUDIO_STREAM;
 
 	// Clear error codes
 	alGetError();
@@ -819,7 +1174,7 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 	{
 		// Failed to create OpenAL sound source, so bail out...
 		debug(LOG_SOUND, "alGenSources failed, most likely out of sound sources");
-		free(stream);
+		delete stream;
 		return NULL;
 	}
 
@@ -829,12 +1184,18 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 	if (stream->decoder == NULL)
 	{
 		debug(LOG_ERROR, "sound_PlayStream: Failed to open audio file for decoding");
-		free(stream);
+		alDeleteSources(1, &stream->source);
+		delete stream;
 		return NULL;
 	}
 
 	stream->volume = volume;
 	stream->bufferSize = streamBufferSize;
+	stream->started = false;
+	stream->stopped = false;
+	stream->paused = false;
+	stream->finished = false;
+	stream->decoded = false;
 
 	alSourcef(stream->source, AL_GAIN, stream->volume);
 
@@ -843,70 +1204,10 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 	alSourcef(stream->source, AL_PITCH, 1.001f);
 
 	// Create some OpenAL buffers to store the decoded data in
-	alGenBuffers(buffer_count, buffers);
-	sound_GetError();
-
-	// Fill some buffers with audio data
-	for (i = 0; i < buffer_count; ++i)
-	{
-		// Decode some audio data
-		soundDataBuffer *soundBuffer = sound_DecodeOggVorbis(stream->decoder, stream->bufferSize);
-
-		// If we actually decoded some data
-		if (soundBuffer && soundBuffer->size > 0)
-		{
-			// Determine PCM data format
-			ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-
-			// Copy the audio data into one of OpenAL's own buffers
-			alBufferData(buffers[i], format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
-			sound_GetError();
-
-			// Clean up our memory
-			free(soundBuffer);
-		}
-		else
-		{
-			// If no data has been decoded we're probably at the end of our
-			// stream. So cleanup the excess stuff here.
-
-			// First remove the data buffer itself
-			free(soundBuffer);
-
-			// Then remove OpenAL's buffers
-			alDeleteBuffers(buffer_count - i, &buffers[i]);
-			sound_GetError();
-
-			break;
-		}
-	}
-
-	// Bail out if we didn't fill any buffers
-	if (i == 0)
-	{
-		debug(LOG_ERROR, "Failed to fill buffers with decoded audio data!");
-
-		// Destroy the decoder
-		sound_DestroyOggVorbisDecoder(stream->decoder);
-
-		// Destroy the OpenAL source
-		alDeleteSources(1, &stream->source);
-
-		// Free allocated memory
-		free(stream);
-
-		return NULL;
-	}
-
-	// Attach the OpenAL buffers to our OpenAL source
-	// (i = the amount of buffers we worked on in the above for-loop)
-	alSourceQueueBuffers(stream->source, i, buffers);
-	sound_GetError();
-
-	// Start playing the source
-	alSourcePlay(stream->source);
-
+	stream->buffers.resize(buffer_count);
+	alGenBuffers(buffer_count, &stream->buffers[0]);
 	sound_GetError();
+	stream->freeBuffers = stream->buffers;
 
 	// Set callback info
 	stream->onFinished = onFinished;
@@ -916,12 +1217,18 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 	stream->next = active_streams;
 	active_streams = stream;
 
+	// The decoder thread fills the ring, and sound_UpdateStream() starts playing once there is some data.
+	wzMutexLock(streamThreadMutex);
+	streamThreadStreams.push_back(stream);
+	wzMutexUnlock(streamThreadMutex);
+	wzSemaphorePost(streamThreadSemaphore);
+
 	return stream;
 }
 
 /** Checks if the stream is playing.
  *  \param stream the stream to check
- *  \post true if playing, false otherwise.
+ *  \post true if playing, or about to start playing, false otherwise.
  *
  */
 bool sound_isStreamPlaying(AUDIO_STREAM *stream)
@@ -936,6 +1243,11 @@ bool sound_isStreamPlaying(AUDIO_STREAM *stream)
 		{
 			return true;
 		}
+		// Waiting for the decoder thread, to start or after running out.
+		if (state != AL_PAUSED && !stream->stopped && !stream->paused && !stream->finished)
+		{
+			return true;
+		}
 	}
 	return false;
 }
@@ -951,6 +1263,8 @@ void sound_StopStream(AUDIO_STREAM *stream)
 {
 	assert(stream != NULL);
 
+	stream->stopped = true;
+
 	alGetError();	// clear error codes
 	// Tell OpenAL to stop playing on the given source
 	alSourceStop(stream->source);
@@ -965,6 +1279,9 @@ void sound_PauseStream(AUDIO_STREAM *stream)
 {
 	ALint state;
 
+	// Also keeps the stream from starting, if still waiting for data.
+	stream->paused = true;
+
 	// To be sure we won't go mutilating this OpenAL source, check wether
 	// it's playing first.
 	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
@@ -987,6 +1304,8 @@ void sound_ResumeStream(AUDIO_STREAM *stream)
 {
 	ALint state;
 
+	stream->paused = false;
+
 	// To be sure we won't go mutilating this OpenAL source, check wether
 	// it's paused first.
 	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
@@ -1031,66 +1350,97 @@ void sound_SetStreamVolume(AUDIO_STREAM *stream, float volume)
 	sound_GetError();
 }
 
-/** Update the given stream by making sure its buffers remain full
+/** Update the given stream by making sure its buffers remain full, with the data decoded by the decoder thread
  *  \param stream the stream to update
  *  \return true when the stream is still playing, false when it has stopped
  */
 static bool sound_UpdateStream(AUDIO_STREAM *stream)
 {
-	ALint state, buffer_count;
-
-	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
-	sound_GetError();
+	ALint state, processed, queued;
+	soundDataBuffer *soundBuffer;
+	bool consumed = false;
 
-	if (state != AL_PLAYING && state != AL_PAUSED)
+	if (stream->stopped)
 	{
 		return false;
 	}
 
-	// Retrieve the amount of buffers which were processed and need refilling
-	alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &buffer_count);
+	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
 	sound_GetError();
 
-	// Refill and reattach all buffers
-	for (; buffer_count != 0; --buffer_count)
+	// Retrieve the buffers which were processed and need refilling
+	alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &processed);
+	sound_GetError();
+	for (ALint i = 0; i < processed; ++i)
 	{
-		soundDataBuffer *soundBuffer;
 		ALuint buffer;
-
-		// Retrieve the buffer to work on
 		alSourceUnqueueBuffers(stream->source, 1, &buffer);
 		sound_GetError();
+		stream->freeBuffers.push_back(buffer);
+	}
 
-		// Decode some data to stuff in our buffer
-		soundBuffer = sound_DecodeOggVorbis(stream->decoder, stream->bufferSize);
-
-		// If we actually decoded some data
-		if (soundBuffer && soundBuffer->size > 0)
+	// Refill and reattach as many buffers as have been decoded
+	while (!stream->freeBuffers.empty() && !stream->finished && sound_PopStreamRing(stream, &soundBuffer))
+	{
+		consumed = true;
+		if (soundBuffer == NULL)
 		{
-			// Determine PCM data format
-			ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+			// The decoder has reached the end of the stream.
+			stream->finished = true;
+			break;
+		}
 
-			// Insert the data into the buffer
-			alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
-			sound_GetError();
+		ALuint buffer = stream->freeBuffers.back();
+		stream->freeBuffers.pop_back();
 
-			// Reattach the buffer to the source
-			alSourceQueueBuffers(stream->source, 1, &buffer);
-			sound_GetError();
-		}
-		else
-		{
-			// If no data has been decoded we're probably at the end of our
-			// stream. So cleanup this buffer.
+		// Determine PCM data format
+		ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
 
-			// Then remove OpenAL's buffer
-			alDeleteBuffers(1, &buffer);
-			sound_GetError();
-		}
+		// Insert the data into the buffer
+		alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
+		sound_GetError();
+
+		// Reattach the buffer to the source
+		alSourceQueueBuffers(stream->source, 1, &buffer);
+		sound_GetError();
 
 		// Now remove the data buffer itself
 		free(soundBuffer);
 	}
+	if (consumed)
+	{
+		wzSemaphorePost(streamThreadSemaphore);  // There is room in the ring again.
+	}
+	else if (processed > 0 && !stream->finished)
+	{
+		++streamUnderruns;
+		metricStreamUnderruns.add();
+	}
+
+	if (state == AL_PLAYING || state == AL_PAUSED)
+	{
+		return true;
+	}
+
+	// Not started yet, or ran out of buffers.
+	alGetSourcei(stream->source, AL_BUFFERS_QUEUED, &queued);
+	sound_GetError();
+	if (queued == 0)
+	{
+		return !stream->finished;
+	}
+	if (stream->paused)
+	{
+		return true;
+	}
+	if (stream->started)
+	{
+		++streamsStarved;
+		metricStreamsStarved.add();
+	}
+	stream->started = true;
+	alSourcePlay(stream->source);
+	sound_GetError();
 
 	return true;
 }
@@ -1102,46 +1452,32 @@ static bool sound_UpdateStream(AUDIO_STREAM *stream)
  */
 static void sound_DestroyStream(AUDIO_STREAM *stream)
 {
-	ALint buffer_count;
-	ALuint *buffers;
-	ALint error;
+	soundDataBuffer *soundBuffer;
 
-	// Stop the OpenAL source from playing
-	alSourceStop(stream->source);
-	error = sound_GetError();
+	// Stop decoding it, the decoder thread isn't using it once we have the lock
+	wzMutexLock(streamThreadMutex);
+	streamThreadStreams.erase(std::find(streamThreadStreams.begin(), streamThreadStreams.end(), stream));
+	wzMutexUnlock(streamThreadMutex);
 
-	if (error != AL_NO_ERROR)
-	{
-		// FIXME: We should really handle these errors.
-	}
-
-	// Retrieve the amount of buffers which were processed
-	alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &buffer_count);
-	error = sound_GetError();
-	if (error != AL_NO_ERROR)
-	{
-		/* FIXME: We're leaking memory and resources here when bailing
-		 * out. But not doing so could cause stack overflows as a
-		 * result of the below alloca() call (due to buffer_count not
-		 * being properly initialised.
-		 */
-		debug(LOG_SOUND, "alGetSourcei(AL_BUFFERS_PROCESSED) failed; bailing out...");
-		return;
-	}
-
-	// Detach all buffers and retrieve their ID numbers
-	buffers = (ALuint *)alloca(buffer_count * sizeof(ALuint));
-	alSourceUnqueueBuffers(stream->source, buffer_count, buffers);
+	// Stop the OpenAL source from playing, and detach all buffers
+	alSourceStop(stream->source);
+	alSourcei(stream->source, AL_BUFFER, 0);
 	sound_GetError();
 
-	// Destroy all of these buffers
-	alDeleteBuffers(buffer_count, buffers);
+	// Destroy all of the buffers
+	alDeleteBuffers(stream->buffers.size(), &stream->buffers[0]);
 	sound_GetError();
 
 	// Destroy the OpenAL source
 	alDeleteSources(1, &stream->source);
 	sound_GetError();
 
+	// Free what was decoded, but not played
+	while (sound_PopStreamRing(stream, &soundBuffer))
+	{
+		free(soundBuffer);
+	}
+
 	// Destroy the sound decoder
 	sound_DestroyOggVorbisDecoder(stream->decoder);
 
@@ -1155,7 +1491,7 @@ static void sound_DestroyStream(AUDIO_STREAM *stream)
 	}
 
 	// Free the memory used by this stream
-	free(stream);
+	delete stream;
 }
 
 /** Update all currently running streams and destroy them when they're finished.
@@ -1207,15 +1543,10 @@ static void sound_UpdateStreams()
 //
 void sound_StopSample(AUDIO_SAMPLE *psSample)
 {
-	if (psSample->iSample == (ALuint)SAMPLE_NOT_ALLOCATED)
-	{
-		debug(LOG_SOUND, "sound_StopSample: sample number (%u) out of range, we probably have run out of available OpenAL sources", psSample->iSample);
-		return;
-	}
 	alGetError();	// clear error codes
-	// Tell OpenAL to stop playing the given sample
-	alSourceStop(psSample->iSample);
-	sound_GetError();
+	// Free the voice, and sound_Update() will finish the sample, even if virtual
+	sound_ReleaseVoice(psSample);
+	psSample->iEndTime = 0;
 }
 
 void sound_SetPlayerPos(Vector3f pos)
@@ -1299,6 +1630,13 @@ void sound_SetObjectPosition(AUDIO_SAMPLE *psSample)
 		// this sample can't be heard right now
 		gain = 0.0f;
 	}
+	psSample->fGain = gain;
+
+	// virtual samples only keep the gain, to compete for a voice
+	if (psSample->iSample == (ALuint)AL_INVALID)
+	{
+		return;
+	}
 	alSourcef(psSample->iSample, AL_GAIN, gain);
 
 	// the alSource3i variant would be better, if it wouldn't provide linker errors however
@@ -1314,6 +1652,10 @@ void sound_SetObjectPosition(AUDIO_SAMPLE *psSample)
 //
 void sound_PauseSample(AUDIO_SAMPLE *psSample)
 {
+	if (psSample->iSample == (ALuint)AL_INVALID)
+	{
+		return;
+	}
 	alSourcePause(psSample->iSample);
 	sound_GetError();
 }
@@ -1324,6 +1666,10 @@ void sound_PauseSample(AUDIO_SAMPLE *psSample)
 //
 void sound_ResumeSample(AUDIO_SAMPLE *psSample)
 {
+	if (psSample->iSample == (ALuint)AL_INVALID)
+	{
+		return;
+	}
 	alSourcePlay(psSample->iSample);
 	sound_GetError();
 }
@@ -1358,8 +1704,12 @@ void sound_StopAll(void)
 //
 bool sound_SampleIsFinished(AUDIO_SAMPLE *psSample)
 {
-	ALenum	state;
+	ALenum	state = AL_STOPPED;
 
+	if (psSample->iSample == (ALuint)AL_INVALID)
+	{
+		return wzGetTicks() >= psSample->iEndTime;
+	}
 	alGetSourcei(psSample->iSample, AL_SOURCE_STATE, &state);
 	sound_GetError(); // check for an error and clear the error state for later on in this function
 	if (state == AL_PLAYING || state == AL_PAUSED)
@@ -1367,12 +1717,7 @@ bool sound_SampleIsFinished(AUDIO_SAMPLE *psSample)
 		return false;
 	}
 
-	if (psSample->iSample != (ALuint)AL_INVALID)
-	{
-		alDeleteSources(1, &(psSample->iSample));
-		sound_GetError();
-		psSample->iSample = AL_INVALID;
-	}
+	sound_ReleaseVoice(psSample);
 
 	return true;
 }
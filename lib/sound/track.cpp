@@ -226,6 +226,13 @@ bool sound_CheckTrack(SDWORD iTrack)
 	return true;
 }
 
+/** \return the track, or NULL if it isn't loaded
+ */
+TRACK *sound_GetTrack(SDWORD iTrack)
+{
+	return sound_CheckTrack(iTrack) ? g_apTrack[iTrack] : NULL;
+}
+
 //*
 // =======================================================================================================================
 // =======================================================================================================================
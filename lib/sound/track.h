@@ -59,6 +59,10 @@ struct AUDIO_SAMPLE
 #endif
 	SDWORD                  x, y, z;
 	float                   fVol;           // computed volume of sample
+	float                   fGain;          // gain after attenuation, which decides which samples get a voice
+	UDWORD                  iStartTime;     // wzGetTicks() when started
+	UDWORD                  iEndTime;       // wzGetTicks() when finished, UDWORD_MAX if looping
+	SDWORD                  iSameCell;      // bucket counting the samples of this track nearby, or -1
 	bool                    bFinishedPlaying;
 	AUDIO_CALLBACK          pCallback;
 	SIMPLE_OBJECT          *psObj;
@@ -74,8 +78,11 @@ struct TRACK
 	SDWORD          iTime;                  // duration in milliseconds
 	UDWORD          iTimeLastFinished;      // time last finished in ms
 	UDWORD          iNumPlaying;
-	ALuint          iBufferName;            // OpenAL name of the buffer
+	ALuint          iBufferName;            // OpenAL name of the buffer, or 0 until first played
+	size_t          iBufferSize;            // bytes of decoded PCM data in the buffer
+	UDWORD          iLastPlayed;            // when last played, in sounds played, to drop the least recently played buffers first
 	const char     *fileName;
+	const char     *filePath;               // file to decode when first played, or NULL if decoding failed
 };
 
 /* functions
@@ -94,6 +101,7 @@ void	sound_UpdateSample(AUDIO_SAMPLE *psSample);
 void	sound_CheckAllUnloaded(void);
 void sound_RemoveActiveSample(AUDIO_SAMPLE *psSample);
 bool	sound_CheckTrack(SDWORD iTrack);
+TRACK	*sound_GetTrack(SDWORD iTrack);
 
 SDWORD	sound_GetTrackTime(SDWORD iTrack);
 SDWORD	sound_GetTrackAudibleRadius(SDWORD iTrack);
@@ -25,6 +25,7 @@
 #define __INCLUDED_BASEDEF_H__
 
 #include "lib/framework/vector.h"
+#include "lib/framework/slaballoc.h"
 #include "displaydef.h"
 #include "statsdef.h"
 
@@ -93,24 +94,26 @@ struct BASE_OBJECT : public SIMPLE_OBJECT
 	BASE_OBJECT(OBJECT_TYPE type, uint32_t id, unsigned player);
 	~BASE_OBJECT();
 
-	SCREEN_DISP_DATA    sDisplay;                   ///< screen coordinate details
-	UBYTE               group;                      ///< Which group selection is the droid currently in?
-	UBYTE               selected;                   ///< Whether the object is selected (might want this elsewhere)
-	UBYTE               cluster;                    ///< Which cluster the object is a member of
+	// The fields used by the visibility, grid and update loops every tick come first, to share cache lines with pos.
 	UBYTE               visible[MAX_PLAYERS];       ///< Whether object is visible to specific player
 	UBYTE               seenThisTick[MAX_PLAYERS];  ///< Whether object has been seen this tick by the specific player.
-	UWORD               numWatchedTiles;            ///< Number of watched tiles, zero for features
-	UDWORD              lastEmission;               ///< When did it last puff out smoke?
-	WEAPON_SUBCLASS     lastHitWeapon;              ///< The weapon that last hit it
-	UDWORD              timeLastHit;                ///< The time the structure was last attacked
-	UDWORD              body;                       ///< Hit points with lame name
-	UDWORD              periodicalDamageStart;                  ///< When the object entered the fire
-	UDWORD              periodicalDamage;                 ///< How much damage has been done since the object entered the fire
 	uint16_t            flags;                      ///< Various flags
-	TILEPOS             *watchedTiles;              ///< Variable size array of watched tiles, NULL for features
+	UDWORD              body;                       ///< Hit points with lame name
+	UDWORD              timeLastHit;                ///< The time the structure was last attacked
 
 	NEXTOBJ             psNext;                     ///< Pointer to the next object in the object list
 	NEXTOBJ             psNextFunc;                 ///< Pointer to the next object in the function list
+
+	SCREEN_DISP_DATA    sDisplay;                   ///< screen coordinate details
+	TILEPOS             *watchedTiles;              ///< Variable size array of watched tiles, NULL for features
+	UDWORD              lastEmission;               ///< When did it last puff out smoke?
+	WEAPON_SUBCLASS     lastHitWeapon;              ///< The weapon that last hit it
+	UDWORD              periodicalDamageStart;                  ///< When the object entered the fire
+	UDWORD              periodicalDamage;                 ///< How much damage has been done since the object entered the fire
+	UWORD               numWatchedTiles;            ///< Number of watched tiles, zero for features
+	UBYTE               group;                      ///< Which group selection is the droid currently in?
+	UBYTE               selected;                   ///< Whether the object is selected (might want this elsewhere)
+	UBYTE               cluster;                    ///< Which cluster the object is a member of
 };
 
 /// Space-time coordinate, including orientation.
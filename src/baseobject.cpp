@@ -93,17 +93,17 @@ SIMPLE_OBJECT::~SIMPLE_OBJECT()
 
 BASE_OBJECT::BASE_OBJECT(OBJECT_TYPE type, uint32_t id, unsigned player)
 	: SIMPLE_OBJECT(type, id, player)
-	, selected(false)
-	, cluster(0)
-	, numWatchedTiles(0)
+	, flags(0)
+	, body(0)
+	, timeLastHit(UDWORD_MAX)
+	, watchedTiles(NULL)
 	, lastEmission(0)
 	, lastHitWeapon(WSC_NUM_WEAPON_SUBCLASSES)  // No such weapon.
-	, timeLastHit(UDWORD_MAX)
-	, body(0)
 	, periodicalDamageStart(0)
 	, periodicalDamage(0)
-	, flags(0)
-	, watchedTiles(NULL)
+	, numWatchedTiles(0)
+	, selected(false)
+	, cluster(0)
 {
 	memset(visible, 0, sizeof(visible));
 	sDisplay.imd = NULL;
@@ -24,6 +24,7 @@
  */
 
 #include "lib/framework/frame.h"
+#include "lib/framework/radixsort.h"
 #include "lib/ivis_opengl/piematrix.h"
 
 #include "atmos.h"
@@ -34,8 +35,6 @@
 #include "map.h"
 #include "miscimd.h"
 
-#include <algorithm>
-
 #define CLIP_LEFT	((SDWORD)0)
 #define CLIP_RIGHT	((SDWORD)pie_GetVideoBufferWidth())
 #define CLIP_TOP	((SDWORD)0)
@@ -47,14 +46,25 @@
 
 struct BUCKET_TAG
 {
-	bool operator <(BUCKET_TAG const &b) const { return actualZ > b.actualZ; }  // Sort in reverse z order.
-
 	RENDER_TYPE     objectType; //type of object held
 	void *          pObject;    //pointer to the object
-	int32_t         actualZ;
+	uint32_t        sortKey;    //texture page or inverted depth, see bucketAddTypeToList
+};
+
+struct BucketTagKey
+{
+	uint32_t operator ()(BUCKET_TAG const &tag) const { return tag.sortKey; }
 };
 
-static std::vector<BUCKET_TAG> bucketArray;
+/*
+ * The render list is split into three buckets, drawn in this order:
+ * objects which aren't depth sorted, grouped by texture page to save state changes,
+ * then depth sorted objects from back to front, then atmospheric particles.
+ */
+static std::vector<BUCKET_TAG> bucketTexpageArray;
+static std::vector<BUCKET_TAG> bucketDepthArray;
+static std::vector<BUCKET_TAG> bucketParticleArray;
+static std::vector<BUCKET_TAG> bucketScratch;  ///< Radix sort buffer, kept to avoid reallocating every frame.
 
 static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
 {
@@ -339,7 +349,7 @@ static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
 /* add an object to the current render list */
 void bucketAddTypeToList(RENDER_TYPE objectType, void* pObject)
 {
-	const iIMDShape* pie;
+	const iIMDShape* pie = NULL;
 	BUCKET_TAG	newTag;
 	int32_t		z = bucketCalculateZ(objectType, pObject);
 
@@ -355,6 +365,10 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void* pObject)
 		return;
 	}
 
+	//put the object data into the tag
+	newTag.objectType = objectType;
+	newTag.pObject = pObject;
+
 	switch(objectType)
 	{
 		case RENDER_EFFECT:
@@ -369,59 +383,56 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void* pObject)
 
 				case EFFECT_WAYPOINT:
 					pie = ((EFFECT*)pObject)->imd;
-					z = INT32_MAX - pie->texpage;
 					break;
 
 				default:
-					z = INT32_MAX - 42;
-					break;
+					newTag.sortKey = 42;
+					bucketTexpageArray.push_back(newTag);
+					return;
 			}
 			break;
 		case RENDER_DROID:
 			pie = BODY_IMD(((DROID*)pObject),0);
-			z = INT32_MAX - pie->texpage;
 			break;
 		case RENDER_STRUCTURE:
 			pie = ((STRUCTURE*)pObject)->sDisplay.imd;
-			z = INT32_MAX - pie->texpage;
 			break;
 		case RENDER_FEATURE:
 			pie = ((FEATURE*)pObject)->sDisplay.imd;
-			z = INT32_MAX - pie->texpage;
 			break;
 		case RENDER_ANIMATION:
 			pie = ((COMPONENT_OBJECT*)pObject)->psShape;
-			z = INT32_MAX - pie->texpage;
 			break;
 		case RENDER_DELIVPOINT:
 			pie = pAssemblyPointIMDs[((FLAG_POSITION*)pObject)->
 			factoryType][((FLAG_POSITION*)pObject)->factoryInc];
-			z = INT32_MAX - pie->texpage;
 			break;
 		case RENDER_PARTICLE:
-			z = 0;
-			break;
+			newTag.sortKey = 0;
+			bucketParticleArray.push_back(newTag);
+			return;
 		default:
 			// Use calculated Z
 			break;
 	}
 
-	//put the object data into the tag
-	newTag.objectType = objectType;
-	newTag.pObject = pObject;
-	newTag.actualZ = z;
-
-	//add tag to bucketArray
-	bucketArray.push_back(newTag);
+	if (pie != NULL)
+	{
+		// Not depth sorted, only grouped by texture page.
+		newTag.sortKey = radixSortClampKey(pie->texpage);
+		bucketTexpageArray.push_back(newTag);
+	}
+	else
+	{
+		// Sort in reverse z order.
+		newTag.sortKey = RADIXSORT_KEY_MAX - radixSortClampKey(z);
+		bucketDepthArray.push_back(newTag);
+	}
 }
 
-/* render Objects in list */
-void bucketRenderCurrentList(void)
+static void bucketRenderTags(std::vector<BUCKET_TAG> const &tags)
 {
-	std::sort(bucketArray.begin(), bucketArray.end());
-
-	pie_MatBegin(true);
-	for (std::vector<BUCKET_TAG>::const_iterator thisTag = bucketArray.begin(); thisTag != bucketArray.end(); ++thisTag)
+	for (std::vector<BUCKET_TAG>::const_iterator thisTag = tags.begin(); thisTag != tags.end(); ++thisTag)
 	{
 		switch(thisTag->objectType)
 		{
@@ -457,8 +468,22 @@ void bucketRenderCurrentList(void)
 				break;
 		}
 	}
+}
+
+/* render Objects in list */
+void bucketRenderCurrentList(void)
+{
+	radixSort(bucketTexpageArray, bucketScratch, BucketTagKey());
+	radixSort(bucketDepthArray, bucketScratch, BucketTagKey());
+
+	pie_MatBegin(true);
+	bucketRenderTags(bucketTexpageArray);
+	bucketRenderTags(bucketDepthArray);
+	bucketRenderTags(bucketParticleArray);
 	pie_MatEnd();
 
-	//reset the bucket array as we go
-	bucketArray.resize(0);
+	//reset the bucket arrays as we go
+	bucketTexpageArray.resize(0);
+	bucketDepthArray.resize(0);
+	bucketParticleArray.resize(0);
 }
@@ -25,6 +25,7 @@
  */
 
 #include "lib/framework/frame.h"
+#include "lib/framework/metrics.h"
 #include "lib/framework/opengl.h"
 #include "lib/ivis_opengl/screen.h"
 #include "lib/netplay/netplay.h"
@@ -35,7 +36,9 @@
 #include "keybind.h"
 #include "loadsave.h"
 #include "main.h"
+#include "move.h"
 #include "multiplay.h"
+#include "replay.h"
 #include "version.h"
 #include "warzoneconfig.h"
 #include "wrappers.h"
@@ -232,6 +235,12 @@ typedef enum
 	CLI_CRASH,
 	CLI_TEXTURECOMPRESSION,
 	CLI_NOTEXTURECOMPRESSION,
+	CLI_NOSHAREDNEIGHBOURS,
+	CLI_METRICS,
+	CLI_REPLAY,
+	CLI_REPLAYSEEK,
+	CLI_REPLAYFAST,
+	CLI_NOREPLAY,
 } CLI_OPTIONS;
 
 static const struct poptOption* getOptionsTable(void)
@@ -263,6 +272,12 @@ static const struct poptOption* getOptionsTable(void)
 		{ "host",       '\0', POPT_ARG_NONE,   NULL, CLI_HOSTLAUNCH, N_("go directly to host screen"),        NULL },
 		{ "texturecompression", '\0', POPT_ARG_NONE, NULL, CLI_TEXTURECOMPRESSION, N_("Enable texture compression"), NULL },
 		{ "notexturecompression", '\0', POPT_ARG_NONE, NULL, CLI_NOTEXTURECOMPRESSION, N_("Disable texture compression"), NULL },
+		{ "nosharedneighbours", '\0', POPT_ARG_NONE, NULL, CLI_NOSHAREDNEIGHBOURS, N_("Query the map grid separately for each movement check (for determinism testing)"), NULL },
+		{ "metrics",    '\0', POPT_ARG_STRING, NULL, CLI_METRICS,    N_("Write game tick metrics to metrics.csv every so many ticks"), N_("ticks") },
+		{ "replay",     '\0', POPT_ARG_STRING, NULL, CLI_REPLAY,     N_("Play a replay from the replay directory"), N_("replay") },
+		{ "replay-seek", '\0', POPT_ARG_STRING, NULL, CLI_REPLAYSEEK, N_("Fast-forward the replay to the given game time"), N_("seconds") },
+		{ "replay-fast", '\0', POPT_ARG_NONE, NULL, CLI_REPLAYFAST, N_("Play the replay as fast as possible, and quit at the end"), NULL },
+		{ "noreplay",   '\0', POPT_ARG_NONE,   NULL, CLI_NOREPLAY,   N_("Don't record games to the replay directory"), NULL },
 		// Terminating entry
 		{ NULL,         '\0', 0,               NULL, 0,              NULL,                                    NULL },
 	};
@@ -595,6 +610,51 @@ bool ParseCommandLine(int argc, const char** argv)
 			case CLI_NOTEXTURECOMPRESSION:
 				wz_texture_compression = GL_RGBA;
 				break;
+
+			case CLI_NOSHAREDNEIGHBOURS:
+				moveSetSharedNeighbours(false);
+				break;
+
+			case CLI_METRICS:
+			{
+				unsigned ticks;
+				token = poptGetOptArg(poptCon);
+				if (token == NULL || sscanf(token, "%u", &ticks) != 1 || ticks == 0)
+				{
+					qFatal("Bad metrics interval, should be a number of ticks");
+				}
+				metricsSetCsvInterval(ticks);
+				break;
+			}
+
+			case CLI_REPLAY:
+				token = poptGetOptArg(poptCon);
+				if (token == NULL)
+				{
+					qFatal("No replay given");
+				}
+				replaySetPlayback(token);
+				break;
+
+			case CLI_REPLAYSEEK:
+			{
+				unsigned seconds;
+				token = poptGetOptArg(poptCon);
+				if (token == NULL || sscanf(token, "%u", &seconds) != 1)
+				{
+					qFatal("Bad replay seek time, should be a number of seconds");
+				}
+				replaySetSeek(seconds);
+				break;
+			}
+
+			case CLI_REPLAYFAST:
+				replaySetFast(true);
+				break;
+
+			case CLI_NOREPLAY:
+				replaySetRecord(false);
+				break;
 		};
 	}
 
@@ -81,7 +81,9 @@ bool loadConfig()
 	setMiddleClickRotate(ini.value("MiddleClickRotate", false).toBool());
 	rotateRadar = ini.value("rotateRadar", true).toBool();
 	war_SetPauseOnFocusLoss(ini.value("PauseOnFocusLoss", false).toBool());
+	if (ini.contains("replayFiles")) war_SetReplayFiles(ini.value("replayFiles").toInt());
 	NETsetMasterserverName(ini.value("masterserver_name", "lobby.wz2100.net").toString().toUtf8().constData());
+	NETsetRelayAddresses(ini.value("relay_addresses", "").toString().toUtf8().constData());
 	iV_font(ini.value("fontname", "DejaVu Sans").toString().toUtf8().constData(),
 		ini.value("fontface", "Book").toString().toUtf8().constData(),
 		ini.value("fontfacebold", "Bold").toString().toUtf8().constData());
@@ -188,7 +190,9 @@ bool saveConfig()
 	ini.setValue("UPnP", (SDWORD)NetPlay.isUPNP);
 	ini.setValue("rotateRadar", rotateRadar);
 	ini.setValue("PauseOnFocusLoss", war_GetPauseOnFocusLoss());
+	ini.setValue("replayFiles", war_GetReplayFiles());
 	ini.setValue("masterserver_name", NETgetMasterserverName());
+	ini.setValue("relay_addresses", NETgetRelayAddresses());
 	ini.setValue("masterserver_port", NETgetMasterserverPort());
 	ini.setValue("gameserver_port", NETgetGameserverPort());
 	if (!bMultiPlayer)
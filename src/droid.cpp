@@ -344,13 +344,13 @@ bool droidCheckReferences(DROID *psVictimDroid)
 DROID::DROID(uint32_t id, unsigned player)
 	: BASE_OBJECT(OBJ_DROID, id, player)
 	, droidType(DROID_ANY)
-	, psGroup(NULL)
-	, psGrpNext(NULL)
 	, secondaryOrder(DSS_REPLEV_NEVER | DSS_ALEV_ALWAYS)
 	, secondaryOrderPending(DSS_REPLEV_NEVER | DSS_ALEV_ALWAYS)
 	, secondaryOrderPendingCount(0)
 	, action(DACTION_NONE)
 	, actionPos(0, 0)
+	, psGroup(NULL)
+	, psGrpNext(NULL)
 	, psCurAnim(NULL)
 {
 	memset(aName, 0, sizeof(aName));
@@ -428,6 +428,8 @@ DROID::~DROID()
 	// remove the droid from the cluster system
 	clustRemoveObject((BASE_OBJECT *)psDroid);
 
+	gateClearOccupancy(psDroid);
+
 	free(sMove.asPath);
 }
 
@@ -693,6 +695,9 @@ bool droidRemove(DROID *psDroid, DROID *pList[MAX_PLAYERS])
 	// remove the droid from the cluster systerm
 	clustRemoveObject((BASE_OBJECT *)psDroid);
 
+	// stop holding any gate open
+	gateClearOccupancy(psDroid);
+
 	removeDroid(psDroid, pList);
 
 	if (psDroid->player == selectedPlayer)
@@ -1799,7 +1804,7 @@ DROID *reallyBuildDroid(DROID_TEMPLATE *pTemplate, Position pos, UDWORD player,
 	// Don't use this assertion in single player, since droids can finish building while on an away mission
 	ASSERT(!bMultiPlayer || worldOnMap(pos.x, pos.y), "the build locations are not on the map");
 
-	psDroid = new DROID(generateSynchronisedObjectId(), player);
+	psDroid = new (player) DROID(generateSynchronisedObjectId(), player);
 	droidSetName(psDroid, getName(pTemplate));
 
 	// Set the droids type
@@ -1881,6 +1886,7 @@ DROID *reallyBuildDroid(DROID_TEMPLATE *pTemplate, Position pos, UDWORD player,
 		}
 		visTilesUpdate((BASE_OBJECT *)psDroid);
  		clustNewDroid(psDroid);
+		gateUpdateOccupancy(psDroid);
 	}
 
 	/* transporter-specific stuff */
@@ -3441,6 +3447,7 @@ void droidSetPosition(DROID *psDroid, int x, int y)
 	psDroid->pos.z = map_Height(psDroid->pos.x, psDroid->pos.y);
 	initDroidMovement(psDroid);
 	visTilesUpdate((BASE_OBJECT *)psDroid);
+	gateUpdateOccupancy(psDroid);
 }
 
 /** Check validity of a droid. Crash hard if it fails. */
@@ -85,15 +85,12 @@ struct DROID_TEMPLATE : public BASE_STATS
 class DROID_GROUP;
 struct STRUCTURE;
 
-struct DROID : public BASE_OBJECT
+struct DROID : public BASE_OBJECT, public SlabAllocated<DROID>
 {
 	DROID(uint32_t id, unsigned player);
 	~DROID();
 
-	/// UTF-8 name of the droid. This is generated from the droid template
-	///  WARNING: This *can* be changed by the game player after creation & can be translated, do NOT rely on this being the same for everyone!
-	char            aName[MAX_STR_LENGTH];
-
+	// The fields used every tick by movement, orders, actions and combat come first, the rest follows.
 	DROID_TYPE      droidType;                      ///< The type of droid
 
 	/** Holds the specifics for the component parts - allows damage
@@ -102,6 +99,29 @@ struct DROID : public BASE_OBJECT
 	 */
 	uint8_t         asBits[DROID_MAXCOMP];
 
+	/* Movement control data */
+	MOVE_CONTROL    sMove;
+	Spacetime       prevSpacetime;                  ///< Location of droid in previous tick.
+	uint8_t		blockedBits;			///< Bit set telling which tiles block this type of droid (TODO)
+
+	/* Order data */
+	DROID_ORDER_DATA order;
+
+	// secondary order data
+	UDWORD          secondaryOrder;
+	uint32_t        secondaryOrderPending;          ///< What the secondary order will be, after synchronisation.
+	int             secondaryOrderPendingCount;     ///< Number of pending secondary order changes.
+
+	/* Action data */
+	DROID_ACTION    action;
+	Vector2i        actionPos;
+	BASE_OBJECT*    psActionTarget[DROID_MAXWEAPS]; ///< Action target object
+	UDWORD          actionStarted;                  ///< Game time action started
+	UDWORD          actionPoints;                   ///< number of points done by action since start
+
+	UDWORD          numWeaps;                       ///< Watermelon:Re-enabled this,I need this one in droid.c
+	WEAPON          asWeaps[DROID_MAXWEAPS];
+
 	/* The other droid data.  These are all derived from the components
 	 * but stored here for easy access
 	 */
@@ -110,25 +130,29 @@ struct DROID : public BASE_OBJECT
 	UDWORD          originalBody;                   ///< the original body points
 	uint32_t        experience;
 
-	UDWORD          lastFrustratedTime;		///< Set when eg being stuck; used for eg firing indiscriminately at map features to clear the way
-
-	SWORD           resistance;                     ///< used in Electronic Warfare
-	UDWORD          armour[WC_NUM_WEAPON_CLASSES];
-
-	UDWORD          numWeaps;                       ///< Watermelon:Re-enabled this,I need this one in droid.c
-	WEAPON          asWeaps[DROID_MAXWEAPS];
+	UDWORD          expectedDamage;                 ///< Expected damage to be caused by all currently incoming projectiles. This info is shared between all players,
+	                                                ///< but shouldn't make a difference unless 3 mutual enemies happen to be fighting each other at the same time.
 
 	// The group the droid belongs to
 	DROID_GROUP *   psGroup;
 	DROID *         psGrpNext;
 	STRUCTURE *     psBaseStruct;                   ///< a structure that this droid might be associated with. For VTOLs this is the rearming pad
+	SlabHandle<STRUCTURE> onGate;                   ///< The gate whose tile the droid is on, which counts the droid in its gateOccupants.
 	// queued orders
 	SDWORD          listSize;                       ///< Gives the number of synchronised orders. Orders from listSize to the real end of the list may not affect game state.
 	OrderList       asOrderList;                    ///< The range [0; listSize - 1] corresponds to synchronised orders, and the range [listPendingBegin; listPendingEnd - 1] corresponds to the orders that will remain, once all orders are synchronised.
 	unsigned        listPendingBegin;               ///< Index of first order which will not be erased by a pending order. After all messages are processed, the orders in the range [listPendingBegin; listPendingEnd - 1] will remain.
 
-	/* Order data */
-	DROID_ORDER_DATA order;
+	UDWORD          lastFrustratedTime;		///< Set when eg being stuck; used for eg firing indiscriminately at map features to clear the way
+
+	SWORD           resistance;                     ///< used in Electronic Warfare
+	UDWORD          armour[WC_NUM_WEAPON_CLASSES];
+
+	UBYTE           illumination;
+
+	/// UTF-8 name of the droid. This is generated from the droid template
+	///  WARNING: This *can* be changed by the game player after creation & can be translated, do NOT rely on this being the same for everyone!
+	char            aName[MAX_STR_LENGTH];
 
 #ifdef DEBUG
 	// these are to help tracking down dangling pointers
@@ -140,28 +164,6 @@ struct DROID : public BASE_OBJECT
 	int             baseLine;
 #endif
 
-	// secondary order data
-	UDWORD          secondaryOrder;
-	uint32_t        secondaryOrderPending;          ///< What the secondary order will be, after synchronisation.
-	int             secondaryOrderPendingCount;     ///< Number of pending secondary order changes.
-
-	/* Action data */
-	DROID_ACTION    action;
-	Vector2i        actionPos;
-	BASE_OBJECT*    psActionTarget[DROID_MAXWEAPS]; ///< Action target object
-	UDWORD          actionStarted;                  ///< Game time action started
-	UDWORD          actionPoints;                   ///< number of points done by action since start
-
-	UDWORD          expectedDamage;                 ///< Expected damage to be caused by all currently incoming projectiles. This info is shared between all players,
-	                                                ///< but shouldn't make a difference unless 3 mutual enemies happen to be fighting each other at the same time.
-
-	UBYTE           illumination;
-
-	/* Movement control data */
-	MOVE_CONTROL    sMove;
-	Spacetime       prevSpacetime;                  ///< Location of droid in previous tick.
-	uint8_t		blockedBits;			///< Bit set telling which tiles block this type of droid (TODO)
-
 	/* anim data */
 	ANIM_OBJECT     *psCurAnim;
 	SDWORD          iAudioID;
@@ -40,6 +40,7 @@
 #include "lib/framework/frameresource.h"
 #include "lib/framework/input.h"
 #include "lib/framework/math_ext.h"
+#include "lib/framework/metrics.h"
 
 #include "lib/ivis_opengl/ivisdef.h" //ivis matrix code
 #include "lib/ivis_opengl/piedef.h" //ivis matrix code
@@ -184,6 +185,9 @@ struct activeList_t {
 	0, NULL, NULL
 };
 
+static Metric metricAdded("effects.added", METRIC_COUNTER);
+static Metric metricActive("effects.active", METRIC_GAUGE);
+
 
 /* Tick counts for updates on a particular interval */
 static	UDWORD	lastUpdateDroids[EFFECT_DROID_DIVISION];
@@ -293,6 +297,7 @@ static EFFECT *Effect_malloc(void)
 	/* Adjust counts */
 	activeList.num++;
 	inactiveList.num--;
+	metricAdded.add();
 
 	/* Ensure the next search will have something to feed its hunger with */
 	if (inactiveList.first == NULL)
@@ -639,6 +644,8 @@ void processEffects(void)
 
 	/* Add any structure effects */
 	effectStructureUpdates();
+
+	metricActive.set(activeList.num);
 }
 
 
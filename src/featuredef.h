@@ -61,7 +61,7 @@ struct FEATURE_STATS : public BASE_STATS
 	UDWORD          armourValue;            ///< Feature armour
 };
 
-struct FEATURE : public BASE_OBJECT
+struct FEATURE : public BASE_OBJECT, public SlabAllocated<FEATURE>
 {
 	FEATURE(uint32_t id, FEATURE_STATS const *psStats);
 	~FEATURE();
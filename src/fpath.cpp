@@ -26,6 +26,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/crc.h"
+#include "lib/framework/metrics.h"
 #include "lib/netplay/netplay.h"
 
 #include "lib/framework/wzapp.h"
@@ -68,6 +69,10 @@ static bool             waitingForResult = false;
 static uint32_t         waitingForResultId;
 static WZ_SEMAPHORE     *waitingForResultSemaphore = NULL;
 
+// Only touched from the main thread.
+static Metric metricQueued("paths.queued", METRIC_COUNTER);
+static Metric metricWaits("paths.waits", METRIC_COUNTER);  ///< Times the game had to stop and wait for the pathfinding thread.
+
 static void fpathExecute(PATHJOB *psJob, PATHRESULT *psResult);
 
 
@@ -421,6 +426,7 @@ static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, int id, int startX, int sta
 		waitingForResult = true;
 		waitingForResultId = id;
 		wzMutexUnlock(fpathMutex);
+		metricWaits.add();
 		wzSemaphoreWait(waitingForResultSemaphore);  // keep waiting
 	}
 queuePathfinding:
@@ -456,6 +462,7 @@ queuePathfinding:
 	}
 
 	wzMutexUnlock(fpathMutex);
+	metricQueued.add();
 
 	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
@@ -4386,10 +4386,19 @@ static bool loadSaveDroid(const char *pFileName, DROID **ppsCurrentDroidLists)
 			scriptSetStartPos(psDroid->player, psDroid->pos.x, psDroid->pos.y);	// set map start position, FIXME - save properly elsewhere!
 		}
 
-		if (psDroid->psGroup == NULL || psDroid->psGroup->type != GT_TRANSPORTER || psDroid->droidType == DROID_TRANSPORTER || psDroid->droidType == DROID_SUPERTRANSPORTER)  // do not add to list if on a transport, then the group list is used instead
+		bool onTransporter = psDroid->psGroup != NULL && psDroid->psGroup->type == GT_TRANSPORTER && psDroid->droidType != DROID_TRANSPORTER && psDroid->droidType != DROID_SUPERTRANSPORTER;
+		if (!onTransporter)  // do not add to list if on a transport, then the group list is used instead
 		{
 			addDroid(psDroid, ppsCurrentDroidLists);
 		}
+		if (!onTransporter && ppsCurrentDroidLists == apsDroidLists)
+		{
+			gateUpdateOccupancy(psDroid);  // Gates loaded before the droid didn't count it.
+		}
+		else
+		{
+			gateClearOccupancy(psDroid);  // Not on this map, or inside a transporter.
+		}
 
 		ini.endGroup();
 	}
@@ -5867,6 +5876,7 @@ bool loadSaveResearch(const char *pFileName)
 		}
 		ini.endGroup();
 	}
+	resetResearchFrontier();
 	return true;
 }
 
@@ -30,6 +30,7 @@
 #include "lib/framework/frameresource.h"
 #include "lib/framework/input.h"
 #include "lib/framework/file.h"
+#include "lib/framework/metrics.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/strres.h"
 #include "lib/framework/wzapp.h"
@@ -81,6 +82,7 @@
 #include "multiplay.h"
 #include "projectile.h"
 #include "radar.h"
+#include "replay.h"
 #include "research.h"
 #include "lib/framework/cursors.h"
 #include "scriptextern.h"
@@ -711,6 +713,7 @@ void systemShutdown(void)
 
 	shutdownEffectsSystem();
 	keyClearMappings();
+	metricsShutdown();
 
 	// free up all the load functions (all the data should already have been freed)
 	resReleaseAll();
@@ -1227,6 +1230,8 @@ bool stageThreeInitialise(void)
 
 	loopMissionState = LMS_NORMAL;
 
+	replayRecordStart();
+
 	if(!InitRadar()) 	// After resLoad cause it needs the game palette initialised.
 	{
 		return false;
@@ -1350,6 +1355,7 @@ bool stageThreeShutDown(void)
 	{
 		multiGameShutdown();
 	}
+	replayStop();
 
 	cmdDroidMultiExpBoost(false);
 
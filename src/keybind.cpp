@@ -20,6 +20,7 @@
 #include <string.h>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/metrics.h"
 #include "lib/framework/strres.h"
 #include "lib/framework/stdio_ext.h"
 #include "lib/framework/utf.h"
@@ -187,6 +188,12 @@ void kf_PerformanceSample()
 	wzPerfStart();
 }
 
+void kf_DumpMetrics()
+{
+	metricsDump();
+	addConsoleMessage("Metrics written to the log.", DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+}
+
 // --------------------------------------------------------------------------
 void	kf_ToggleRadarJump( void )
 {
@@ -605,6 +612,14 @@ void	kf_FrameRate( void )
 		                          NETgetStatistic(NetStatisticUncompressedBytes, false),
 		                          NETgetStatistic(NetStatisticPackets, true),
 		                          NETgetStatistic(NetStatisticPackets, false)));
+		CONPRINTF(ConsoleString, (ConsoleString, "NETWORK:  File bytes: s-%d r-%d",
+		                          NETgetStatistic(NetStatisticFileBytes, true),
+		                          NETgetStatistic(NetStatisticFileBytes, false)));
+		CONPRINTF(ConsoleString, (ConsoleString, "NETWORK:  Compressed to: s-%d%% r-%d%%  Compression time: s-%dus r-%dus",
+		                          NETgetStatistic(NetStatisticCompressionRatio, true),
+		                          NETgetStatistic(NetStatisticCompressionRatio, false),
+		                          NETgetStatistic(NetStatisticCompressionTime, true),
+		                          NETgetStatistic(NetStatisticCompressionTime, false)));
 	}
 	gameStats = !gameStats;
 	CONPRINTF(ConsoleString, (ConsoleString,"Built at %s on %s",__TIME__,__DATE__));
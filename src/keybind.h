@@ -260,5 +260,6 @@ extern void kf_DamageMe(void);
 extern void kf_AutoGame(void);
 
 void kf_PerformanceSample();
+void kf_DumpMetrics();
 
 #endif // __INCLUDED_SRC_KEYBIND_H__
@@ -267,6 +267,7 @@ _keymapsave keyMapSaveTable[] =
 	kf_SelectAllTrucks,
 	kf_SetDroidOrderStop,
 	kf_SelectAllArmedVTOLs,
+	kf_DumpMetrics,
 	NULL		// last function!
 };
 
@@ -468,6 +469,7 @@ void	keyInitMappings( bool bForceDefaults )
 	keyAddMapping(KEYMAP__DEBUG, KEY_LCTRL,  KEY_Q,         KEYMAP_PRESSED, kf_ToggleWeather,       N_("Trigger some weather"));
 	keyAddMapping(KEYMAP__DEBUG, KEY_IGNORE, KEY_K,         KEYMAP_PRESSED, kf_TriFlip,             N_("Flip terrain triangle"));
 	keyAddMapping(KEYMAP__DEBUG, KEY_LCTRL,  KEY_K,         KEYMAP_PRESSED, kf_PerformanceSample,   N_("Make a performance measurement sample"));
+	keyAddMapping(KEYMAP__DEBUG, KEY_LSHIFT, KEY_K,         KEYMAP_PRESSED, kf_DumpMetrics,         N_("Write game tick metrics to the log"));
 
 	//These ones are necessary for debugging
 	keyAddMapping(KEYMAP__DEBUG, KEY_LALT,   KEY_A, KEYMAP_PRESSED, kf_AllAvailable,      N_("Make all items available"));
@@ -25,6 +25,7 @@
  */
 #include "lib/framework/frame.h"
 #include "lib/framework/input.h"
+#include "lib/framework/metrics.h"
 #include "lib/framework/strres.h"
 #include "lib/framework/wzapp.h"
 #include "lib/framework/rational.h"
@@ -86,6 +87,7 @@
 #include "keybind.h"
 #include "wrappers.h"
 #include "random.h"
+#include "replay.h"
 #include "qtscript.h"
 
 #include "warzoneconfig.h"
@@ -656,6 +658,8 @@ static void gameStateUpdate()
 
 	objmemUpdate();
 
+	metricsTick();
+
 	// Must end update, since we may or may not have ticked, and some message queue processing code may vary depending on whether it's in an update.
 	gameTimeUpdateEnd();
 }
@@ -672,14 +676,22 @@ GAMECODE gameLoop(void)
 
 	countUpdate(); // kick off with correct counts
 
+	unsigned loopStart = wzGetTicks();
 	while (true)
 	{
+		// Put the recorded GAME_BLAH messages into the game queues, if playing a replay.
+		if (!replayUpdate())
+		{
+			wzQuit();
+			return GAMECODE_QUITGAME;
+		}
+
 		// Receive NET_BLAH messages.
 		// Receive GAME_BLAH messages, and if it's time, process exactly as many GAME_BLAH messages as required to be able to tick the gameTime.
 		recvMessage();
 
 		// Update gameTime and graphicsTime, and corresponding deltas. Note that gameTime and graphicsTime pause, if we aren't getting our GAME_GAME_TIME messages.
-		gameTimeUpdate(renderBudget > 0 || previousUpdateWasRender);
+		gameTimeUpdate(renderBudget > 0 || previousUpdateWasRender || replayFastForward());
 
 		if (deltaGameTime == 0)
 		{
@@ -699,6 +711,11 @@ GAMECODE gameLoop(void)
 		previousUpdateWasRender = false;
 
 		ASSERT(deltaGraphicsTime == 0, "Shouldn't update graphics and game state at once.");
+
+		if (replayFastForward() && wzGetTicks() - loopStart >= 100)
+		{
+			break;  // Fast-forwarding never runs out of ticks, so let the events through now and then.
+		}
 	}
 
 	if (realTime - lastFlushTime >= 400u)
@@ -707,6 +724,11 @@ GAMECODE gameLoop(void)
 		NETflush();  // Make sure that we aren't waiting too long to send data.
 	}
 
+	if (replaySkipRender())
+	{
+		return GAMECODE_CONTINUE;
+	}
+
 	unsigned before = wzGetTicks();
 	GAMECODE renderReturn = renderLoop();
 	unsigned after = wzGetTicks();
@@ -68,6 +68,7 @@
 #include "modding.h"
 #include "multiplay.h"
 #include "qtscript.h"
+#include "replay.h"
 #include "research.h"
 #include "scripttabs.h"
 #include "seqdisp.h"
@@ -1117,6 +1118,7 @@ int realmain(int argc, char *argv[])
 	PHYSFS_mkdir("music");
 	PHYSFS_mkdir("logs");		// a place to hold our netplay, mingw crash reports & WZ logs
 	PHYSFS_mkdir("userdata");	// a place to store per-mod data user generated data
+	PHYSFS_mkdir("replay");		// recorded skirmish and multiplayer games
 	memset(rulesettag, 0, sizeof(rulesettag)); // tag to add to userdata to find user generated stuff
 	make_dir(MultiPlayersPath, "multiplay", NULL);
 	make_dir(MultiPlayersPath, "multiplay", "players");
@@ -1282,6 +1284,12 @@ int realmain(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	// Sets the game mode to GS_NORMAL, if asked to play a replay.
+	if (!replayPlaybackStart())
+	{
+		return EXIT_FAILURE;
+	}
+
 	//set all the pause states to false
 	setAllPauseStates(false);
 
@@ -25,6 +25,7 @@
  *
  */
 #include "lib/framework/types.h"
+#include "lib/framework/metrics.h"
 #include "objects.h"
 #include "map.h"
 
@@ -35,6 +36,8 @@
 static PointTree *gridPointTree = NULL;  // A quad-tree-like object.
 static PointTree::Filter *gridFiltersUnseen;
 static PointTree::Filter *gridFiltersDroidsByPlayer;
+static unsigned gridResetCount = 0;
+static Metric metricQueryResults("grid.query.results", METRIC_HISTOGRAM);  ///< Number of objects found by each query.
 
 // initialise the grid system
 bool gridInitialise(void)
@@ -51,6 +54,7 @@ bool gridInitialise(void)
 void gridReset(void)
 {
 	gridPointTree->clear();
+	++gridResetCount;
 
 	// Put all existing objects into the point tree.
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
@@ -92,6 +96,11 @@ void gridShutDown(void)
 	gridFiltersDroidsByPlayer = NULL;
 }
 
+unsigned gridGeneration(void)
+{
+	return gridResetCount;
+}
+
 static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 {
 	return (uint32_t)(x*x + y*y) <= radius*radius;
@@ -129,6 +138,7 @@ static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t r
 	// In case you are curious.
 	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
 	*/
+	metricQueryResults.sample(gridPointTree->lastQueryResults.size());
 	static GridList gridList;
 	gridList.resize(gridPointTree->lastQueryResults.size());
 	for (unsigned n = 0; n < gridList.size(); ++n)
@@ -143,6 +153,7 @@ static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_
 {
 	gridPointTree->query(x, y, x2, y2);
 
+	metricQueryResults.sample(gridPointTree->lastQueryResults.size());
 	static GridList gridList;
 	gridList.resize(gridPointTree->lastQueryResults.size());
 	for (unsigned n = 0; n < gridList.size(); ++n)
@@ -165,6 +176,27 @@ GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
 	return gridStartIterateFiltered(x, y, radius, NULL, ConditionTrue());
 }
 
+GridList const &gridStartIterateSquare(int32_t x, int32_t y, uint32_t radius, std::vector<Vector2i> &gridPositions)
+{
+	gridPointTree->queryWithPositions(x, y, radius);
+
+	metricQueryResults.sample(gridPointTree->lastQueryResults.size());
+	static GridList gridList;
+	gridList.resize(gridPointTree->lastQueryResults.size());
+	gridPositions.resize(gridList.size());
+	for (unsigned n = 0; n < gridList.size(); ++n)
+	{
+		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		gridPositions[n] = Vector2i(gridPointTree->lastQueryPositions[n].first, gridPointTree->lastQueryPositions[n].second);
+	}
+	return gridList;
+}
+
+bool gridInSquare(Vector2i gridPosition, int32_t x, int32_t y, uint32_t radius)
+{
+	return PointTree::inQuerySquare(gridPosition.x, gridPosition.y, x, y, radius);
+}
+
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
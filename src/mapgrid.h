@@ -35,6 +35,9 @@ extern bool gridInitialise(void);
 // shutdown the grid system
 extern void gridShutDown(void);
 
+/// Changes every time the grid is reset, so query results can be cached until then.
+unsigned gridGeneration(void);
+
 // Reset the grid system. Called once per update.
 // Resets seenThisTick[] to false.
 extern void gridReset(void);
@@ -42,6 +45,14 @@ extern void gridReset(void);
 /// Find all objects within radius.
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
+/// Find all objects in the square of edge length 2*radius around (x, y), by where they were when the grid was reset,
+/// without checking their distance now. gridPositions gets those positions, which gridInSquare() checks, so that the
+/// objects gridStartIterate() would find with a smaller radius can be picked out, in the same order.
+GridList const &gridStartIterateSquare(int32_t x, int32_t y, uint32_t radius, std::vector<Vector2i> &gridPositions);
+
+/// Whether an object found at gridPosition by gridStartIterateSquare() is in the square searched around (x, y).
+bool gridInSquare(Vector2i gridPosition, int32_t x, int32_t y, uint32_t radius);
+
 /// Find all objects within radius.
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
 
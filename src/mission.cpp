@@ -989,6 +989,7 @@ void placeLimboDroids(void)
 			initDroidMovement(psDroid);
 			//make sure the died flag is not set
 			psDroid->died = false;
+			gateUpdateOccupancy(psDroid);
 		}
 		else
 		{
@@ -103,6 +103,34 @@
 #define EXTRA_BITS                              8
 #define EXTRA_PRECISION                         (1 << EXTRA_BITS)
 
+// distance to look for features to pick up
+#define DROIDDIST		((TILE_UNITS*5)/2)
+
+// distance to gather neighbours for the movement checks, the largest check radius
+// plus how far a droid may move before they have to be gathered again
+#define NEIGHBOUR_DIST		(OBJ_MAXRADIUS + TILE_UNITS)
+
+enum NEIGHBOUR_TYPE
+{
+	NEIGHBOUR_DROID,
+	NEIGHBOUR_FEATURE,
+	NEIGHBOUR_TYPES
+};
+
+/// Objects around a droid, gathered from the grid once for all the movement checks.
+struct NEIGHBOURHOOD
+{
+	DROID *                 psDroid;                        ///< Droid the neighbours were gathered for
+	unsigned                generation;                     ///< Grid generation they were gathered in
+	Vector2i                pos;                            ///< Where they were gathered
+	GridList                list[NEIGHBOUR_TYPES];          ///< Droids and features in the grid square of NEIGHBOUR_DIST, in grid order
+	std::vector<Vector2i>   gridPos[NEIGHBOUR_TYPES];       ///< Where the grid has each of them
+};
+
+// Two neighbourhoods, so that a droid can shuffle another droid while looking through its own neighbours.
+static NEIGHBOURHOOD neighbourhoods[2];
+static unsigned lastNeighbourhood = 0;
+static bool sharedNeighbours = true;
 
 static uint32_t oilTimer = 0;
 static unsigned drumCount = 0;
@@ -128,6 +156,96 @@ const char *moveDescription(MOVE_STATUS status)
 	return "Error";	// satisfy compiler
 }
 
+void moveSetSharedNeighbours(bool shared)
+{
+	sharedNeighbours = shared;
+	for (unsigned i = 0; i < ARRAY_SIZE(neighbourhoods); ++i)
+	{
+		neighbourhoods[i].psDroid = NULL;
+	}
+}
+
+/// Checks whether an object is within radius of a droid now, in the same way as the grid does.
+static bool moveNeighbourInRange(DROID *psDroid, BASE_OBJECT *psObj, uint32_t radius)
+{
+	int32_t dx = psObj->pos.x - psDroid->pos.x;
+	int32_t dy = psObj->pos.y - psDroid->pos.y;
+	return (uint32_t)(dx*dx + dy*dy) <= radius*radius;
+}
+
+/// Finds or gathers the neighbourhood of a droid, holding everything a grid query of radius around it would find.
+static NEIGHBOURHOOD &moveGetNeighbourhood(DROID *psDroid, uint32_t radius)
+{
+	for (unsigned i = 0; i < ARRAY_SIZE(neighbourhoods); ++i)
+	{
+		NEIGHBOURHOOD &hood = neighbourhoods[i];
+		if (hood.psDroid == psDroid && hood.generation == gridGeneration()
+		    && abs(psDroid->pos.x - hood.pos.x) + radius <= NEIGHBOUR_DIST && abs(psDroid->pos.y - hood.pos.y) + radius <= NEIGHBOUR_DIST)
+		{
+			lastNeighbourhood = i;
+			return hood;
+		}
+	}
+
+	// Not gathered yet this tick, or moved too far since. Replace the least recently used one.
+	lastNeighbourhood = 1 - lastNeighbourhood;
+	NEIGHBOURHOOD &hood = neighbourhoods[lastNeighbourhood];
+	hood.psDroid = psDroid;
+	hood.generation = gridGeneration();
+	hood.pos = removeZ(psDroid->pos);
+	for (unsigned type = 0; type < NEIGHBOUR_TYPES; ++type)
+	{
+		hood.list[type].clear();
+		hood.gridPos[type].clear();
+	}
+	static std::vector<Vector2i> gridPos;  // static to avoid allocations.
+	GridList const &gridList = gridStartIterateSquare(hood.pos.x, hood.pos.y, NEIGHBOUR_DIST, gridPos);
+	for (unsigned n = 0; n < gridList.size(); ++n)
+	{
+		NEIGHBOUR_TYPE type = gridList[n]->type == OBJ_DROID ? NEIGHBOUR_DROID : NEIGHBOUR_FEATURE;
+		if (gridList[n]->type == OBJ_DROID || gridList[n]->type == OBJ_FEATURE)
+		{
+			hood.list[type].push_back(gridList[n]);
+			hood.gridPos[type].push_back(gridPos[n]);
+		}
+	}
+	return hood;
+}
+
+/** Get the droids or features that gridStartIterate() would find within radius of a droid, in grid order.
+ *  With shared neighbours, they are picked out of the droid's neighbourhood by the same tests the grid does,
+ *  where the grid has them for the square, and where they are now for the radius. Otherwise the grid is queried.
+ *  \param list Holds the neighbours.
+ */
+static GridList const &moveGetNeighbours(DROID *psDroid, NEIGHBOUR_TYPE type, uint32_t radius, GridList &list)
+{
+	list.clear();
+	if (!sharedNeighbours)
+	{
+		OBJECT_TYPE objType = type == NEIGHBOUR_DROID ? OBJ_DROID : OBJ_FEATURE;
+		GridList const &gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, radius);
+		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+		{
+			if ((*gi)->type == objType)
+			{
+				list.push_back(*gi);
+			}
+		}
+		return list;
+	}
+
+	NEIGHBOURHOOD const &hood = moveGetNeighbourhood(psDroid, radius);
+	for (unsigned n = 0; n < hood.list[type].size(); ++n)
+	{
+		if (gridInSquare(hood.gridPos[type][n], psDroid->pos.x, psDroid->pos.y, radius)
+		    && moveNeighbourInRange(psDroid, hood.list[type][n], radius))
+		{
+			list.push_back(hood.list[type][n]);
+		}
+	}
+	return list;
+}
+
 /** Initialise the movement system
  */
 bool moveInitialise(void)
@@ -297,7 +415,7 @@ static void moveShuffleDroid(DROID *psDroid, Vector2i s)
 
 	// find any droids that could block the shuffle
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, SHUFFLE_DIST);
+	moveGetNeighbours(psDroid, NEIGHBOUR_DROID, SHUFFLE_DIST, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		DROID *psCurr = castDroid(*gi);
@@ -617,7 +735,7 @@ static void moveCheckSquished(DROID *psDroid, int32_t emx, int32_t emy)
 	const int32_t   my = gameTimeAdjustedAverage(emy, EXTRA_PRECISION);
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);
+	moveGetNeighbours(psDroid, NEIGHBOUR_DROID, OBJ_MAXRADIUS, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -999,6 +1117,7 @@ static void moveCalcBlockingSlide(DROID *psDroid, int32_t *pmx, int32_t *pmy, ui
 			psDroid->pos.y = MAX(0, jumpy);
 			*pmx = 0;
 			*pmy = 0;
+			gateUpdateOccupancy(psDroid);  // May have jumped off or onto a gate.
 		}
 		else
 		{
@@ -1061,7 +1180,7 @@ static void moveCalcDroidSlide(DROID *psDroid, int *pmx, int *pmy)
 	droidR = moveObjRadius((BASE_OBJECT *)psDroid);
 	BASE_OBJECT *psObst = NULL;
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);
+	moveGetNeighbours(psDroid, NEIGHBOUR_DROID, OBJ_MAXRADIUS, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -1178,7 +1297,7 @@ static Vector2i moveGetObstacleVector(DROID *psDroid, Vector2i dest)
 
 	// scan the neighbours for obstacles
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, AVOID_DIST);
+	moveGetNeighbours(psDroid, NEIGHBOUR_DROID, AVOID_DIST, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		if (*gi == psDroid)
@@ -1539,6 +1658,8 @@ static void moveUpdateDroidPos(DROID *psDroid, int32_t dx, int32_t dy)
 		return;
 	}
 
+	Vector2i oldTile = map_coord(removeZ(psDroid->pos));
+
 	psDroid->pos.x += gameTimeAdjustedAverage(dx, EXTRA_PRECISION);
 	psDroid->pos.y += gameTimeAdjustedAverage(dy, EXTRA_PRECISION);
 
@@ -1568,6 +1689,11 @@ static void moveUpdateDroidPos(DROID *psDroid, int32_t dx, int32_t dy)
 			psDroid->pos.y = 1;
 		}
 	}
+
+	if (map_coord(removeZ(psDroid->pos)) != oldTile)
+	{
+		gateUpdateOccupancy(psDroid);  // Gates close once nothing is on them.
+	}
 	CHECK_DROID(psDroid);
 }
 
@@ -2106,9 +2232,8 @@ static void checkLocalFeatures(DROID *psDroid)
 	}
 
 	// scan the neighbours
-#define DROIDDIST ((TILE_UNITS*5)/2)
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, DROIDDIST);
+	moveGetNeighbours(psDroid, NEIGHBOUR_FEATURE, DROIDDIST, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
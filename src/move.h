@@ -68,4 +68,7 @@ void moveMakeVtolHover( DROID *psDroid );
 
 const char *moveDescription(MOVE_STATUS status);
 
+/// Whether the movement checks share one neighbour list per droid and tick, instead of each querying the grid.
+void moveSetSharedNeighbours(bool shared);
+
 #endif // __INCLUDED_SRC_MOVE_H__
@@ -63,7 +63,7 @@ struct QueuedDroidInfo
 		if (orComp != 0) return orComp < 0;
 		return droidId < z.droidId;
 	}
-	/// Returns 0 if order is the same, non-zero otherwise.
+	/// Returns 0 if order is the same, except maybe for the position of a LocOrder, non-zero otherwise.
 	int orderCompare(QueuedDroidInfo const &z) const
 	{
 		if (player != z.player)       return player < z.player ? -1 : 1;
@@ -78,11 +78,6 @@ struct QueuedDroidInfo
 					if (destId != z.destId)       return destId < z.destId ? -1 : 1;
 					if (destType != z.destType)   return destType < z.destType ? -1 : 1;
 				}
-				else
-				{
-					if (pos.x != z.pos.x)                 return pos.x < z.pos.x ? -1 : 1;
-					if (pos.y != z.pos.y)                 return pos.y < z.pos.y ? -1 : 1;
-				}
 				if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
 				{
 					if (structRef != z.structRef) return structRef < z.structRef ? -1 : 1;
@@ -126,6 +121,8 @@ struct QueuedDroidInfo
 		SECONDARY_STATE secState;
 };
 
+#define DROIDINFO_ID_BITS 8         ///< Number of droid IDs after each ID in a GAME_DROIDINFO range, sent as a bitset.
+
 static std::vector<QueuedDroidInfo> queuedOrders;
 
 
@@ -448,34 +445,69 @@ static void NETQueuedDroidInfo(QueuedDroidInfo *info)
 }
 
 // Actually send the droid info.
+//
+// Each GAME_DROIDINFO message is one order, followed by the droids it is for, in increasing ID order. The droids are
+// encoded in ranges, each an ID, as the difference from the end of the previous range, and a bitset of which of the next
+// DROIDINFO_ID_BITS IDs are also in the range. The low bit of the difference says whether the bitset is there, it isn't
+// for a range of one droid. If the droids were given different positions, such as a formation or a script ordering each
+// droid separately, the order has the centroid, and each droid its offset from the centroid. An order for a single
+// droid is usually as big as before ranges and offsets.
 void sendQueuedDroidInfo()
 {
-	// Sort queued orders, to group the same order to multiple droids.
-	std::sort(queuedOrders.begin(), queuedOrders.end());
+	// Sort queued orders, to group the same order to multiple droids. Keep the order the orders were given in, if the same droid gets more than one.
+	std::stable_sort(queuedOrders.begin(), queuedOrders.end());
 
 	std::vector<QueuedDroidInfo>::iterator eqBegin, eqEnd;
 	for (eqBegin = queuedOrders.begin(); eqBegin != queuedOrders.end(); eqBegin = eqEnd)
 	{
-		// Find end of range of orders which differ only by the droid ID.
-		for (eqEnd = eqBegin + 1; eqEnd != queuedOrders.end() && eqEnd->orderCompare(*eqBegin) == 0; ++eqEnd)
-		{}
+		// Find end of range of orders which differ only by the droid ID and position, with each droid only once.
+		Vector2i minPos = eqBegin->pos, maxPos = eqBegin->pos;
+		int64_t sumX = 0, sumY = 0;
+		for (eqEnd = eqBegin; eqEnd != queuedOrders.end() && eqEnd->orderCompare(*eqBegin) == 0 && (eqEnd == eqBegin || eqEnd->droidId != (eqEnd - 1)->droidId); ++eqEnd)
+		{
+			minPos = Vector2i(std::min(minPos.x, eqEnd->pos.x), std::min(minPos.y, eqEnd->pos.y));
+			maxPos = Vector2i(std::max(maxPos.x, eqEnd->pos.x), std::max(maxPos.y, eqEnd->pos.y));
+			sumX += eqEnd->pos.x;
+			sumY += eqEnd->pos.y;
+		}
+		uint32_t num = eqEnd - eqBegin;
+		bool spread = eqBegin->subType == LocOrder && minPos != maxPos;
 
-		NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
-			NETQueuedDroidInfo(&*eqBegin);
+		QueuedDroidInfo info = *eqBegin;
+		info.pos = Vector2i((int)(sumX / num), (int)(sumY / num));
 
-			uint32_t num = eqEnd - eqBegin;
+		NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
+			NETQueuedDroidInfo(&info);
 			NETuint32_t(&num);
-
-			uint32_t prevDroidId = 0;
-			for (unsigned n = 0; n < num; ++n)
+			if (info.subType == LocOrder && num > 1)
 			{
-				uint32_t droidId = (eqBegin + n)->droidId;
+				NETbool(&spread);
+			}
 
-				// Encode deltas between droid IDs, since the deltas are smaller than the actual droid IDs, and will encode to less bytes on average.
-				uint32_t deltaDroidId = droidId - prevDroidId;
+			uint32_t rangeEnd = 0;
+			for (std::vector<QueuedDroidInfo>::iterator i = eqBegin; i != eqEnd; )
+			{
+				uint32_t rangeBegin = i->droidId;
+				uint8_t bits = 0;
+				std::vector<QueuedDroidInfo>::iterator j = i + 1;
+				for (; j != eqEnd && j->droidId - rangeBegin <= DROIDINFO_ID_BITS; ++j)
+				{
+					bits |= 1 << (j->droidId - rangeBegin - 1);
+				}
+				ASSERT(rangeBegin - rangeEnd < 0x80000000, "Droid ID %u too big to send", rangeBegin);
+				uint32_t deltaDroidId = (rangeBegin - rangeEnd) << 1 | (bits != 0);
 				NETuint32_t(&deltaDroidId);
-
-				prevDroidId = droidId;
+				if (bits != 0)
+				{
+					NETuint8_t(&bits);
+				}
+				for (; i != j && spread; ++i)
+				{
+					Vector2i offset = i->pos - info.pos;
+					NETauto(&offset);
+				}
+				i = j;
+				rangeEnd = rangeBegin + 1 + DROIDINFO_ID_BITS;
 			}
 		NETend();
 	}
@@ -557,6 +589,66 @@ void sendDroidInfo(DROID *psDroid, DroidOrder const &order, bool add)
 
 // ////////////////////////////////////////////////////////////////////////////
 // receive droid information form other players.
+static void recvDroidInfoDroid(NETQUEUE queue, QueuedDroidInfo const &info, DROID_ORDER_DATA *sOrder)
+{
+	DROID *psDroid = IdToDroid(info.droidId, info.player);
+	if (!psDroid)
+	{
+		debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
+		      queue.index, info.droidId, isHumanPlayer(info.player) ? "Human" : "AI", info.player);
+		syncDebug("Droid %d missing", info.droidId);
+		return;  // Can't find the droid, so skip this droid.
+	}
+	if (!canGiveOrdersFor(queue.index, psDroid->player))
+	{
+		debug(LOG_WARNING, "Droid order for wrong player.");
+		syncDebug("Wrong player.");
+		return;
+	}
+
+	CHECK_DROID(psDroid);
+
+	syncDebugDroid(psDroid, '<');
+
+	switch (info.subType)
+	{
+		case ObjOrder:
+		case LocOrder:
+			/*
+			* If the current order not is a command order and we are not a
+			* commander yet are in the commander group remove us from it.
+			*/
+			if (hasCommander(psDroid))
+			{
+				psDroid->psGroup->remove(psDroid);
+			}
+
+			if (sOrder->psObj != TargetMissing)  // Only do order if the target didn't die.
+			{
+				if (!info.add)
+				{
+					orderDroidListEraseRange(psDroid, 0, psDroid->listSize + 1);  // Clear all non-pending orders, plus the first pending order (which is probably the order we just received).
+					orderDroidBase(psDroid, sOrder);  // Execute the order immediately (even if in the middle of another order.
+				}
+				else
+				{
+					orderDroidAdd(psDroid, sOrder);   // Add the order to the (non-pending) list. Will probably overwrite the corresponding pending order, assuming all pending orders were written to the list.
+				}
+			}
+			break;
+		case SecondaryOrder:
+			// Set the droids secondary order
+			turnOffMultiMsg(true);
+			secondarySetState(psDroid, info.secOrder, info.secState);
+			turnOffMultiMsg(false);
+			break;
+	}
+
+	syncDebugDroid(psDroid, '>');
+
+	CHECK_DROID(psDroid);
+}
+
 bool recvDroidInfo(NETQUEUE queue)
 {
 	NETbeginDecode(queue, GAME_DROIDINFO);
@@ -590,70 +682,43 @@ bool recvDroidInfo(NETQUEUE queue)
 
 		uint32_t num = 0;
 		NETuint32_t(&num);
+		bool spread = false;
+		if (info.subType == LocOrder && num > 1)
+		{
+			NETbool(&spread);
+		}
 
-		for (unsigned n = 0; n < num; ++n)
+		uint32_t rangeEnd = 0;
+		for (unsigned n = 0; n < num; )
 		{
-			// Get the next droid ID which is being given this order.
+			// Get the next range of droid IDs which are being given this order.
 			uint32_t deltaDroidId = 0;
+			uint8_t bits = 0;
 			NETuint32_t(&deltaDroidId);
-			info.droidId += deltaDroidId;
-
-			DROID *psDroid = IdToDroid(info.droidId, info.player);
-			if (!psDroid)
-			{
-				debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
-				      queue.index, info.droidId, isHumanPlayer(info.player) ? "Human" : "AI", info.player);
-				syncDebug("Droid %d missing", info.droidId);
-				continue;  // Can't find the droid, so skip this droid.
-			}
-			if (!canGiveOrdersFor(queue.index, psDroid->player))
+			if (deltaDroidId & 1)
 			{
-				debug(LOG_WARNING, "Droid order for wrong player.");
-				syncDebug("Wrong player.");
-				continue;
+				NETuint8_t(&bits);
 			}
+			uint32_t rangeBegin = rangeEnd + (deltaDroidId >> 1);
+			rangeEnd = rangeBegin + 1 + DROIDINFO_ID_BITS;
 
-			CHECK_DROID(psDroid);
-
-			syncDebugDroid(psDroid, '<');
-
-			switch (info.subType)
+			for (unsigned bit = 0; bit <= DROIDINFO_ID_BITS && n < num; ++bit)
 			{
-				case ObjOrder:
-				case LocOrder:
-					/*
-					* If the current order not is a command order and we are not a
-					* commander yet are in the commander group remove us from it.
-					*/
-					if (hasCommander(psDroid))
-					{
-						psDroid->psGroup->remove(psDroid);
-					}
-
-					if (sOrder.psObj != TargetMissing)  // Only do order if the target didn't die.
-					{
-						if (!info.add)
-						{
-							orderDroidListEraseRange(psDroid, 0, psDroid->listSize + 1);  // Clear all non-pending orders, plus the first pending order (which is probably the order we just received).
-							orderDroidBase(psDroid, &sOrder);  // Execute the order immediately (even if in the middle of another order.
-						}
-						else
-						{
-							orderDroidAdd(psDroid, &sOrder);   // Add the order to the (non-pending) list. Will probably overwrite the corresponding pending order, assuming all pending orders were written to the list.
-						}
-					}
-					break;
-				case SecondaryOrder:
-					// Set the droids secondary order
-					turnOffMultiMsg(true);
-					secondarySetState(psDroid, info.secOrder, info.secState);
-					turnOffMultiMsg(false);
-					break;
-			}
-
-			syncDebugDroid(psDroid, '>');
+				if (bit != 0 && (bits & 1 << (bit - 1)) == 0)
+				{
+					continue;
+				}
+				info.droidId = rangeBegin + bit;
+				if (spread)
+				{
+					Vector2i offset(0, 0);
+					NETauto(&offset);
+					sOrder.pos = info.pos + offset;
+				}
+				++n;
 
-			CHECK_DROID(psDroid);
+				recvDroidInfoDroid(queue, info, &sOrder);
+			}
 		}
 	}
 	NETend();
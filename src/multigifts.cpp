@@ -724,6 +724,7 @@ bool pickupArtefact(int toPlayer, int fromPlayer)
 				if (asResearch[topic].researchPower && asResearch[topic].researchPoints)
 				{
 					MakeResearchPossible(&asPlayerResList[toPlayer][topic]);
+					researchFrontierAdd(toPlayer, topic);
 					if (toPlayer == selectedPlayer)
 					{
 						CONPRINTF(ConsoleString,(ConsoleString,_("You Discover Blueprints For %s"), getName(&asResearch[topic])));
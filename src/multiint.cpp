@@ -2692,7 +2692,7 @@ static void stopJoining(void)
 			// if we were in a midle of transfering a file, then close the file handle
 			if (NetPlay.pMapFileHandle)
 			{
-				debug(LOG_NET, "closing aborted file");		// no need to delete it, we do size check on (map) file
+				debug(LOG_NET, "closing aborted file");		// keep it, so we can resume the download
 				PHYSFS_close(NetPlay.pMapFileHandle);
 				NetPlay.pMapFileHandle = NULL;
 			}
@@ -3295,6 +3295,10 @@ void frontendMultiMessages(void)
 			recvMapFileRequested(queue);
 			break;
 
+		case NET_FILE_ACK:
+			NETrecvFileAck(queue);
+			break;
+
 		case NET_FILE_PAYLOAD:
 		{
 			bool done = recvMapFileData(queue);
@@ -4129,6 +4133,9 @@ void displayPlayer(WIDGET *psWidget, UDWORD xOffset, UDWORD yOffset)
 		int progress = (NetPlay.players[j].wzFile.currPos * 100) / NetPlay.players[j].wzFile.fileSize_32;
 
 		snprintf(mapProgressString, MAX_STR_LENGTH, _("Sending Map: %d%% "), progress);
+		char rateString[32];
+		ssprintf(rateString, "%u KiB/s", NETgetStatistic(NetStatisticFileBytes, true) / 1024);
+		sstrcat(mapProgressString, rateString);
 		iV_SetFont(font_regular); // font
 		iV_SetTextColour(WZCOL_FORM_TEXT);
 		iV_DrawText(mapProgressString, x + 15, y + 22);
@@ -4137,6 +4144,9 @@ void displayPlayer(WIDGET *psWidget, UDWORD xOffset, UDWORD yOffset)
 	{
 		static char mapProgressString[MAX_STR_LENGTH] = {'\0'};
 		snprintf(mapProgressString, MAX_STR_LENGTH, _("Map: %d%% downloaded"), mapDownloadProgress);
+		char rateString[32];
+		ssprintf(rateString, " %u KiB/s", NETgetStatistic(NetStatisticFileBytes, false) / 1024);
+		sstrcat(mapProgressString, rateString);
 		iV_SetFont(font_regular); // font
 		iV_SetTextColour(WZCOL_FORM_TEXT);
 		iV_DrawText(mapProgressString, x + 5, y + 22);
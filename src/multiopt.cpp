@@ -206,13 +206,9 @@ void recvOptions(NETQUEUE queue)
 	// See if we have the map or not
 	if (mapData == NULL)
 	{
-		uint32_t player = selectedPlayer;
-
 		debug(LOG_INFO, "Map was not found, requesting map %s from host, type %d", game.map, game.isMapMod);
 		// Request the map from the host
-		NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_FILE_REQUESTED);
-		NETuint32_t(&player);
-		NETend();
+		NETrequestFile(game.map, game.hash);
 
 		addConsoleMessage("MAP REQUESTED!", DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
 	}
@@ -62,6 +62,7 @@
 #include "scriptfuncs.h"
 #include "template.h"
 #include "lib/netplay/netplay.h"								// the netplay library.
+#include "lib/netplay/netreplay.h"
 #include "multiplay.h"								// warzone net stuff.
 #include "multijoin.h"								// player management stuff.
 #include "multirecv.h"								// incoming messages stuff
@@ -503,6 +504,10 @@ int whosResponsible(int player)
 //returns true if selected player is responsible for 'player'
 bool myResponsibility(int player)
 {
+	if (NETisReplay())
+	{
+		return false;  // Only watching, every message comes from the replay.
+	}
 	return (whosResponsible(player) == selectedPlayer || whosResponsible(player) == realSelectedPlayer);
 }
 
@@ -1674,8 +1679,8 @@ bool recvMapFileRequested(NETQUEUE queue)
 {
 	//char mapStr[256],mapName[256],fixedname[256];
 	uint32_t player;
+	int32_t offset = 0;
 
-	PHYSFS_sint64 fileSize_64;
 	PHYSFS_file	*pFileHandle;
 
 	if(!NetPlay.isHost)				// only host should act
@@ -1687,45 +1692,51 @@ bool recvMapFileRequested(NETQUEUE queue)
 	//	Check to see who wants the file
 	NETbeginDecode(queue, NET_FILE_REQUESTED);
 	NETuint32_t(&player);
+	NETint32_t(&offset);           // bytes the player already has
 	NETend();
 
-	if (!NetPlay.players[player].wzFile.isSending)
+	if (whosResponsible(player) != queue.index)
 	{
-		NetPlay.players[player].needFile = true;
-		NetPlay.players[player].wzFile.isCancelled = false;
-		NetPlay.players[player].wzFile.isSending = true;
+		HandleBadParam("NET_FILE_REQUESTED given incorrect params.", player, queue.index);
+		return false;
+	}
 
-		LEVEL_DATASET *mapData = levFindDataSet(game.map, &game.hash);
+	WZFile const &file = NetPlay.players[player].wzFile;
+	if (file.isSending && offset >= file.startPos && offset <= file.currPos)
+	{
+		// Asked again for what we are sending, such as after another options broadcast. Go on from where we are.
+		debug(LOG_NET, "Player %u asked again for the map from byte %d, already sent up to byte %d", player, offset, file.currPos);
+		return true;
+	}
 
-		addConsoleMessage("Map was requested: SENDING MAP!",DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+	LEVEL_DATASET *mapData = levFindDataSet(game.map, &game.hash);
 
-		char *mapStr = mapData->realFileName;
-		debug(LOG_INFO, "Map was requested. Looking for %s", mapStr);
+	addConsoleMessage("Map was requested: SENDING MAP!",DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
 
-		// Checking to see if file is available...
-		pFileHandle = PHYSFS_openRead(mapStr);
-		if (pFileHandle == NULL)
-		{
-			debug(LOG_ERROR, "Failed to open %s for reading: %s", mapStr, PHYSFS_getLastError());
-			debug(LOG_FATAL, "You have a map (%s) that can't be located.\n\nMake sure it is in the correct directory and or format! (No map packs!)", mapStr);
-			// NOTE: if we get here, then the game is basically over, The host can't send the file for whatever reason...
-			// Which also means, that we can't continue.
-			debug(LOG_NET, "***Host has a file issue, and is being forced to quit!***");
-			NETbeginEncode(NETbroadcastQueue(), NET_HOST_DROPPED);
-			NETend();
-			abort();
-		}
+	char *mapStr = mapData->realFileName;
+	debug(LOG_INFO, "Map was requested. Looking for %s", mapStr);
 
-		// get the file's size.
-		fileSize_64 = PHYSFS_fileLength(pFileHandle);
-		debug(LOG_INFO, "File is valid, sending [directory: %s] %s to client %u", PHYSFS_getRealDir(mapStr), mapStr, player);
-
-		NetPlay.players[player].wzFile.pFileHandle = pFileHandle;
-		NetPlay.players[player].wzFile.fileSize_32 = (int32_t) fileSize_64;		//we don't support 64bit int nettypes.
-		NetPlay.players[player].wzFile.currPos = 0;
+	// Checking to see if file is available...
+	pFileHandle = PHYSFS_openRead(mapStr);
+	if (pFileHandle == NULL)
+	{
+		debug(LOG_ERROR, "Failed to open %s for reading: %s", mapStr, PHYSFS_getLastError());
+		debug(LOG_FATAL, "You have a map (%s) that can't be located.\n\nMake sure it is in the correct directory and or format! (No map packs!)", mapStr);
+		// NOTE: if we get here, then the game is basically over, The host can't send the file for whatever reason...
+		// Which also means, that we can't continue.
+		debug(LOG_NET, "***Host has a file issue, and is being forced to quit!***");
+		NETbeginEncode(NETbroadcastQueue(), NET_HOST_DROPPED);
+		NETend();
+		abort();
+	}
 
-		NETsendFile(game.map, game.hash, player);
+	debug(LOG_INFO, "File is valid, sending [directory: %s] %s to client %u from byte %d", PHYSFS_getRealDir(mapStr), mapStr, player, offset);
+	if (!NETstartSendFile(pFileHandle, offset, player))
+	{
+		debug(LOG_ERROR, "Could not seek to byte %d of %s: %s", offset, mapStr, PHYSFS_getLastError());
 	}
+
+	NETsendFile(game.map, game.hash, player);
 	return true;
 }
 
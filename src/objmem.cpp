@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/metrics.h"
 #include "objects.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
@@ -69,6 +70,11 @@ FLAG_POSITION	*apsFlagPosLists[MAX_PLAYERS];
 /* The list of destroyed objects */
 BASE_OBJECT		*psDestroyedObj=NULL;
 
+static Metric metricDroids("objects.droids", METRIC_GAUGE);
+static Metric metricStructures("objects.structures", METRIC_GAUGE);
+static Metric metricFeatures("objects.features", METRIC_GAUGE);
+static Metric metricFreed("objects.freed", METRIC_COUNTER);
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck(void);
@@ -121,6 +127,7 @@ static bool objmemDestroy(BASE_OBJECT *psObj)
 	}
 	debug(LOG_MEMORY, "BASE_OBJECT* 0x%p is freed.", psObj);
 	delete psObj;
+	metricFreed.add();
 	return true;
 }
 
@@ -134,6 +141,11 @@ void objmemUpdate(void)
 	objListIntegCheck();
 #endif
 
+	// Includes objects in the destroyed list, which are still allocated.
+	metricDroids.set(DROID::slabAllocator().liveCount());
+	metricStructures.set(STRUCTURE::slabAllocator().liveCount());
+	metricFeatures.set(FEATURE::slabAllocator().liveCount());
+
 	// tell the script system about any destroyed objects
 	if (psDestroyedObj != NULL)
 	{
@@ -50,6 +50,18 @@ static uint64_t expand(uint32_t x)
 	return r;
 }
 
+// Compacts bit pattern 0a0b 0c0d 0e0f 0g0h to abcd efgh, the opposite of expand()
+static uint32_t compact(uint64_t r)
+{
+	r &= 0x5555555555555555ULL;
+	r = (r | r>>1)  & 0x3333333333333333ULL;
+	r = (r | r>>2)  & 0x0F0F0F0F0F0F0F0FULL;
+	r = (r | r>>4)  & 0x00FF00FF00FF00FFULL;
+	r = (r | r>>8)  & 0x0000FFFF0000FFFFULL;
+	r = (r | r>>16) & 0x00000000FFFFFFFFULL;
+	return r;
+}
+
 // Returns v with highest set bit and all higher bits set, and all following bits 0. Example: 0000 0110 1001 1100 -> 1111 1100 0000 0000.
 static uint32_t findSplit(uint32_t v)
 {
@@ -128,7 +140,7 @@ static unsigned current(std::vector<unsigned> &filterData, unsigned i)
 	return ret;
 }
 
-template<bool IsFiltered>
+template<bool IsFiltered, bool WithPositions>
 PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
 {
 	uint64_t minX = expandX(minXo);
@@ -230,6 +242,10 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 	{
 		lastFilteredQueryIndices.clear();
 	}
+	if (WithPositions)
+	{
+		lastQueryPositions.clear();
+	}
 	for (int r = 0; r != numRanges; ++r)
 	{
 		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
@@ -247,6 +263,10 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 				{
 					lastFilteredQueryIndices.push_back(i);
 				}
+				if (WithPositions)
+				{
+					lastQueryPositions.push_back(std::make_pair(int32_t(compact(px >> 1) - 0x80000000u), int32_t(compact(py) - 0x80000000u)));
+				}
 #ifdef DUMP_IMAGE
 				if (doDump)
 				{
@@ -273,7 +293,7 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	return queryMaybeFilter<false, false>(unused, x, y, x2, y2);
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
@@ -283,7 +303,7 @@ PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	return queryMaybeFilter<false, false>(unused, minXo, minYo, maxXo, maxYo);
 }
 
 PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
@@ -292,5 +312,25 @@ PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y,
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	return queryMaybeFilter<true, false>(filter, minXo, minYo, maxXo, maxYo);
+}
+
+PointTree::ResultVector &PointTree::queryWithPositions(int32_t x, int32_t y, uint32_t radius)
+{
+	Filter unused;
+	int32_t minXo = x - radius;
+	int32_t maxXo = x + radius;
+	int32_t minYo = y - radius;
+	int32_t maxYo = y + radius;
+	return queryMaybeFilter<false, true>(unused, minXo, minYo, maxXo, maxYo);
+}
+
+bool PointTree::inQuerySquare(int32_t px, int32_t py, int32_t x, int32_t y, uint32_t radius)
+{
+	// The same bounds as query(x, y, radius), which compares expanded coordinates, in the same order as these.
+	int32_t minXo = x - radius;
+	int32_t maxXo = x + radius;
+	int32_t minYo = y - radius;
+	int32_t maxYo = y + radius;
+	return px >= minXo && px <= maxXo && py >= minYo && py <= maxYo;
 }
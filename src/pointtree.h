@@ -29,6 +29,7 @@ class PointTree
 public:
 	typedef std::vector<void *> ResultVector;
 	typedef std::vector<unsigned> IndexVector;
+	typedef std::vector<std::pair<int32_t, int32_t> > PositionVector;
 	class Filter  ///< Filters are invalidated when modifying the PointTree.
 	{
 	public:
@@ -58,15 +59,21 @@ public:
 	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
 	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
 	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
+	/// The same as query(x, y, radius), also giving the position each point was inserted at in lastQueryPositions.
+	ResultVector &queryWithPositions(int32_t x, int32_t y, uint32_t radius);
+	/// Whether a point inserted at (px, py) is in the square searched by query(x, y, radius). Results of a query
+	/// that pass this for a smaller square are the results of querying that square, in the same order.
+	static bool inQuerySquare(int32_t px, int32_t py, int32_t x, int32_t y, uint32_t radius);
 
 	ResultVector lastQueryResults;
 	IndexVector lastFilteredQueryIndices;
+	PositionVector lastQueryPositions;
 
 private:
 	typedef std::pair<uint64_t, void *> Point;
 	typedef std::vector<Point> Vector;
 
-	template<bool IsFiltered>
+	template<bool IsFiltered, bool WithPositions>
 	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
 
 	Vector points;
@@ -24,6 +24,7 @@
  *
  */
 #include <string.h>
+#include <map>
 #include "objectdef.h"
 #include "power.h"
 #include "hci.h"
@@ -60,17 +61,155 @@ static int64_t updateExtractedPower(STRUCTURE *psBuilding);
 //returns the relevant list based on OffWorld or OnWorld
 static STRUCTURE *powerStructList(int player);
 
+#define NO_REQUEST          0xFFFFFFFFu
+
 struct PowerRequest
 {
 	int64_t  amount;              ///< Amount of power being requested.
-	unsigned id;                  ///< Structure which is requesting power.
+	unsigned id;                  ///< Structure which is requesting power, or NO_REQUEST if the request was removed.
+};
+
+/// Power requests, in the order they were first made. Removed requests leave an empty slot behind, until
+/// there are more empty slots than requests, and a Fenwick tree over the slots gives the power requested
+/// by all requests up to any slot, so each operation is O(log n) rather than a scan of the queue.
+class PowerQueue
+{
+	static unsigned lowBit(unsigned n) { return n & (~n + 1); }
+
+public:
+	PowerQueue() : totalAmount(0) {}
+
+	void clear()
+	{
+		requests.clear();
+		tree.clear();
+		requestSlots.clear();
+		totalAmount = 0;
+	}
+
+	/// Sets the request of id, adding it at the end of the queue if it has none.
+	/// Returns the power requested by all requests up to and including this one.
+	int64_t set(unsigned id, int64_t amount)
+	{
+		std::map<unsigned, unsigned>::const_iterator i = requestSlots.find(id);
+		unsigned slot;
+		if (i == requestSlots.end())
+		{
+			slot = requests.size();
+			PowerRequest request = {0, id};
+			requests.push_back(request);
+			treeAppend();
+			requestSlots[id] = slot;
+		}
+		else
+		{
+			slot = i->second;
+		}
+		treeAdd(slot, amount - requests[slot].amount);
+		requests[slot].amount = amount;
+		return prefix(slot);
+	}
+
+	void remove(unsigned id)
+	{
+		std::map<unsigned, unsigned>::iterator i = requestSlots.find(id);
+		if (i == requestSlots.end())
+		{
+			return;
+		}
+		unsigned slot = i->second;
+		requestSlots.erase(i);
+		treeAdd(slot, -requests[slot].amount);
+		requests[slot].amount = 0;
+		requests[slot].id = NO_REQUEST;
+		if (requests.size() > 2*requestSlots.size() + 16)
+		{
+			compact();
+		}
+	}
+
+	/// Returns true if id has a request, setting required to the power requested up to and including it.
+	bool find(unsigned id, int64_t &required) const
+	{
+		std::map<unsigned, unsigned>::const_iterator i = requestSlots.find(id);
+		if (i == requestSlots.end())
+		{
+			return false;
+		}
+		required = prefix(i->second);
+		return true;
+	}
+
+	int64_t total() const
+	{
+		return totalAmount;
+	}
+
+private:
+	/// Sum of the amounts in slots 0 to slot, inclusive.
+	int64_t prefix(unsigned slot) const
+	{
+		int64_t sum = 0;
+		for (unsigned n = slot + 1; n > 0; n &= n - 1)
+		{
+			sum += tree[n - 1];
+		}
+		return sum;
+	}
+
+	void treeAdd(unsigned slot, int64_t delta)
+	{
+		for (unsigned n = slot + 1; n <= tree.size(); n += lowBit(n))
+		{
+			tree[n - 1] += delta;
+		}
+		totalAmount += delta;
+	}
+
+	/// Extends the tree to cover the last slot, which must be empty.
+	void treeAppend()
+	{
+		unsigned n = requests.size();
+		unsigned first = n - lowBit(n);  // Tree node n covers slots first to n - 1.
+		tree.push_back((n > 1 ? prefix(n - 2) : 0) - (first > 0 ? prefix(first - 1) : 0));
+	}
+
+	/// Removes the empty slots, keeping the order of the requests.
+	void compact()
+	{
+		std::vector<PowerRequest> old;
+		old.swap(requests);
+		tree.clear();
+		for (unsigned i = 0; i < old.size(); ++i)
+		{
+			if (old[i].id != NO_REQUEST)
+			{
+				requestSlots[old[i].id] = requests.size();
+				requests.push_back(old[i]);
+				tree.push_back(old[i].amount);
+			}
+		}
+		for (unsigned n = 1; n <= tree.size(); ++n)
+		{
+			unsigned parent = n + lowBit(n);
+			if (parent <= tree.size())
+			{
+				tree[parent - 1] += tree[n - 1];
+			}
+		}
+	}
+
+	std::vector<PowerRequest> requests;     ///< Requests, by slot.
+	std::vector<int64_t> tree;              ///< Fenwick tree over the amounts in requests.
+	std::map<unsigned, unsigned> requestSlots;  ///< Slot of each structure's request.
+	int64_t totalAmount;                    ///< Power requested by all requests.
 };
 
 struct PlayerPower
 {
 	// All fields are 32.32 fixed point.
 	int64_t currentPower;                  ///< The current amount of power available to the player.
-	std::vector<PowerRequest> powerQueue;  ///< Requested power.
+	PowerQueue powerQueue;                 ///< Requested power.
 	int powerModifier;                 ///< Percentage modifier on power from each derrick.
 };
 
@@ -105,33 +244,13 @@ static bool addPowerRequest(unsigned player, unsigned id, int64_t amount)
 {
 	PlayerPower *p = &asPower[player];
 
-	int64_t requiredPower = amount;
-	size_t n;
-	for (n = 0; n < p->powerQueue.size() && p->powerQueue[n].id != id; ++n)
-	{
-		requiredPower += p->powerQueue[n].amount;
-	}
-	if (n == p->powerQueue.size())
-	{
-		p->powerQueue.resize(n + 1);
-		p->powerQueue[n].id = id;
-	}
-	p->powerQueue[n].amount = amount;
+	int64_t requiredPower = p->powerQueue.set(id, amount);
 	return requiredPower <= p->currentPower;
 }
 
 void delPowerRequest(STRUCTURE *psStruct)
 {
-	PlayerPower *p = &asPower[psStruct->player];
-
-	for (size_t n = 0; n < p->powerQueue.size(); ++n)
-	{
-		if (p->powerQueue[n].id == psStruct->id)
-		{
-			p->powerQueue.erase(p->powerQueue.begin() + n);
-			return;
-		}
-	}
+	asPower[psStruct->player].powerQueue.remove(psStruct->id);
 }
 
 static int64_t checkPrecisePowerRequest(STRUCTURE *psStruct)
@@ -139,20 +258,11 @@ static int64_t checkPrecisePowerRequest(STRUCTURE *psStruct)
 	PlayerPower const *p = &asPower[psStruct->player];
 
 	int64_t requiredPower = 0;
-	for (size_t n = 0; n < p->powerQueue.size(); ++n)
+	if (!p->powerQueue.find(psStruct->id, requiredPower) || requiredPower <= p->currentPower)
 	{
-		requiredPower += p->powerQueue[n].amount;
-		if (p->powerQueue[n].id == psStruct->id)
-		{
-			if (requiredPower <= p->currentPower)
-			{
-				return -1;  // Have enough power.
-			}
-			return requiredPower - p->currentPower;
-		}
+		return -1;  // Have enough power, or not waiting for any.
 	}
-
-	return -1;
+	return requiredPower - p->currentPower;
 }
 
 int32_t checkPowerRequest(STRUCTURE *psStruct)
@@ -163,26 +273,12 @@ int32_t checkPowerRequest(STRUCTURE *psStruct)
 
 static int64_t getPreciseQueuedPower(unsigned player)
 {
-	PlayerPower const *p = &asPower[player];
-
-	int64_t requiredPower = 0;
-	for (size_t n = 0; n < p->powerQueue.size(); ++n)
-	{
-		requiredPower += p->powerQueue[n].amount;
-	}
-	return requiredPower;
+	return asPower[player].powerQueue.total();
 }
 
 int getQueuedPower(int player)
 {
-	PlayerPower const *p = &asPower[player];
-
-	int64_t requiredPower = 0;
-	for (size_t n = 0; n < p->powerQueue.size(); ++n)
-	{
-		requiredPower += p->powerQueue[n].amount;
-	}
-	return requiredPower / FP_ONE;
+	return asPower[player].powerQueue.total() / FP_ONE;
 }
 
 static void syncDebugEconomy(unsigned player, char ch)
@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/metrics.h"
 #include "lib/framework/trig.h"
 
 #include "lib/gamelib/gtime.h"
@@ -84,6 +85,9 @@ static const UDWORD ProjectileTrackerID =	0xdead0000;
 /* The list of projectiles in play */
 static std::vector<PROJECTILE *> psProjectileList;
 
+static Metric metricFired("projectiles.fired", METRIC_COUNTER);
+static Metric metricLive("projectiles.live", METRIC_GAUGE);
+
 /* The next projectile to give out in the proj_First / proj_Next methods */
 static ProjectileIterator psProjectileNext;
 
@@ -535,6 +539,7 @@ bool proj_SendProjectileAngled(WEAPON *psWeap, SIMPLE_OBJECT *psAttacker, int pl
 
 	/* put the projectile object in the global list */
 	psProjectileList.push_back(psProj);
+	metricFired.add();
 
 	/* play firing audio */
 	// only play if either object is visible, i know it's a bit of a hack, but it avoids the problem
@@ -1327,6 +1332,7 @@ void proj_UpdateAll()
 
 	// Remove and free dead projectiles.
 	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), std::mem_fun(&PROJECTILE::deleteIfDead)), psProjectileList.end());
+	metricLive.set(psProjectileList.size());
 }
 
 /***************************************************************************/
@@ -37,9 +37,12 @@
 #include <QtGui/QStandardItemModel>
 #include <QtGui/QFileDialog>
 
+#include <algorithm>
+
 #include "lib/framework/wzapp.h"
 #include "lib/framework/wzconfig.h"
 #include "lib/framework/file.h"
+#include "lib/framework/metrics.h"
 #include "lib/gamelib/gtime.h"
 #include "multiplay.h"
 #include "map.h"
@@ -48,6 +51,7 @@
 #include "lib/netplay/netplay.h"
 
 #include "qtscriptdebug.h"
+#include "qtscriptevents.h"
 #include "qtscriptfuncs.h"
 
 #define ATTACK_THROTTLE 1000
@@ -76,20 +80,213 @@ struct timerNode
 	int player;
 	int calls;
 	timerType type;
-	timerNode() {}
+	unsigned seq;          ///< Creation order, timers due on the same game update run in this order
+	timerNode **slot;      ///< Timer wheel slot holding this timer
+	timerNode *prev, *next;        ///< Siblings in the timer wheel slot
+	timerNode *allPrev, *allNext;  ///< Siblings in the list of all timers
+	timerNode() : baseobj(-1), calls(0), type(TIMER_REPEAT), seq(0), slot(NULL), prev(NULL), next(NULL), allPrev(NULL), allNext(NULL) {}
 	timerNode(QScriptEngine *caller, QString val, int plr, int frame)
-		: function(val), engine(caller), baseobj(-1), frameTime(frame + gameTime), ms(frame), player(plr), calls(0), type(TIMER_REPEAT) {}
+		: function(val), engine(caller), baseobj(-1), frameTime(frame + gameTime), ms(frame), player(plr), calls(0), type(TIMER_REPEAT)
+		, seq(0), slot(NULL), prev(NULL), next(NULL), allPrev(NULL), allNext(NULL) {}
 	bool operator== (const timerNode &t) { return function == t.function && player == t.player; }
-	// implement operator less TODO
 };
 
 #define MAX_MS 20
 #define HALF_MAX_MS 10
 
-/// List of timer events for scripts. Before running them, we sort the list then run as many as we have time for.
-/// In this way, we implement load balancing of events and keep frame rates tidy for users. Since scripts run on the
-/// host, we do not need to worry about each peer simulating the world differently.
-static QList<timerNode> timers;
+static Metric metricCalls("scripts.calls", METRIC_COUNTER);
+static Metric metricCallTime("scripts.call.ms", METRIC_HISTOGRAM);
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS 3
+
+/// Timer events for scripts are kept in a hierarchical timer wheel, keyed on the game update they are due.
+/// Level 0 has a slot for each of the next TIMER_WHEEL_SIZE game updates, each further level has slots
+/// TIMER_WHEEL_SIZE times wider, and the few timers even further ahead wait in timerOverflow. The slots of
+/// higher levels are cascaded down as the wheel turns, so adding, removing and finding due timers is O(1).
+static timerNode *timerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+static timerNode *timerOverflow;
+static int timerWheelTick;  ///< Next game update to process, all earlier ones have run.
+
+/// All timers in order of creation, for saving, debugging and removal by name or object.
+static timerNode *timerFirst, *timerLast;
+static unsigned timerSeq;
+
+/// Per script timer load balancing. Scripts may limit how many of their timers run per game update,
+/// due timers above the limit are deferred to the next update in order of due time. Since the limit
+/// counts calls rather than measuring time, every peer defers the same timers.
+struct TIMER_STATS
+{
+	int budget;             ///< Maximum timer calls per game update, 0 for no limit
+	int deferredCalls;      ///< Timer calls pushed to a later game update because of the budget
+	int ticksOverBudget;    ///< Game updates which had more due timers than the budget
+	int ticksOverMaxTime;   ///< Game updates in which the timers of the script took over MAX_MS
+	TIMER_STATS() : budget(0), deferredCalls(0), ticksOverBudget(0), ticksOverMaxTime(0) {}
+};
+static QHash<QScriptEngine *, TIMER_STATS> timerStats;
+
+static int timerDueTick(int frameTime)
+{
+	// Game time advances a whole game update at a time, so this is the first update with gameTime >= frameTime.
+	return (frameTime + GAME_TICKS_PER_UPDATE - 1) / GAME_TICKS_PER_UPDATE;
+}
+
+static void timerSlotInsert(timerNode *node, int dueTick)
+{
+	int delta = dueTick - timerWheelTick;
+	if (delta < 0)
+	{
+		dueTick = timerWheelTick;
+		delta = 0;
+	}
+	timerNode **slot = &timerOverflow;
+	for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level)
+	{
+		if (delta < 1 << (TIMER_WHEEL_BITS * (level + 1)))
+		{
+			slot = &timerWheel[level][(dueTick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+			break;
+		}
+	}
+	node->slot = slot;
+	node->prev = NULL;
+	node->next = *slot;
+	if (node->next)
+	{
+		node->next->prev = node;
+	}
+	*slot = node;
+}
+
+static void timerSlotRemove(timerNode *node)
+{
+	if (!node->slot)
+	{
+		return;  // due, and already taken off the wheel
+	}
+	if (node->prev)
+	{
+		node->prev->next = node->next;
+	}
+	else
+	{
+		*node->slot = node->next;
+	}
+	if (node->next)
+	{
+		node->next->prev = node->prev;
+	}
+	node->slot = NULL;
+	node->prev = node->next = NULL;
+}
+
+/// Takes ownership of a heap allocated timer.
+static void timerAdd(timerNode *node)
+{
+	const int nowTick = gameTime / GAME_TICKS_PER_UPDATE;
+	if (!timerFirst && timerWheelTick < nowTick)
+	{
+		timerWheelTick = nowTick;  // the wheel stood still while empty, or we just loaded a savegame
+	}
+	node->seq = timerSeq++;
+	node->allPrev = timerLast;
+	node->allNext = NULL;
+	if (timerLast)
+	{
+		timerLast->allNext = node;
+	}
+	else
+	{
+		timerFirst = node;
+	}
+	timerLast = node;
+	timerSlotInsert(node, timerDueTick(node->frameTime));
+}
+
+static void timerRemove(timerNode *node)
+{
+	timerSlotRemove(node);
+	if (node->allPrev)
+	{
+		node->allPrev->allNext = node->allNext;
+	}
+	else
+	{
+		timerFirst = node->allNext;
+	}
+	if (node->allNext)
+	{
+		node->allNext->allPrev = node->allPrev;
+	}
+	else
+	{
+		timerLast = node->allPrev;
+	}
+	delete node;
+}
+
+static void timerClear()
+{
+	while (timerFirst)
+	{
+		timerRemove(timerFirst);
+	}
+	timerWheelTick = 0;
+	timerSeq = 0;
+}
+
+static void timerCascade(timerNode **slot)
+{
+	timerNode *node = *slot;
+	*slot = NULL;
+	while (node)
+	{
+		timerNode *next = node->next;
+		timerSlotInsert(node, timerDueTick(node->frameTime));
+		node = next;
+	}
+}
+
+/// Moves the timers due on game update timerWheelTick to the due list, and turns the wheel.
+static void timerWheelAdvance(QList<timerNode *> &due)
+{
+	const int tick = timerWheelTick;
+	// Cascade from the highest level down, so timers can fall through several levels at once.
+	if ((tick & ((1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)) == 0)
+	{
+		timerCascade(&timerOverflow);
+	}
+	for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; --level)
+	{
+		if ((tick & ((1 << (TIMER_WHEEL_BITS * level)) - 1)) == 0)
+		{
+			timerCascade(&timerWheel[level][(tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK]);
+		}
+	}
+	timerNode *node = timerWheel[0][tick & TIMER_WHEEL_MASK];
+	timerWheel[0][tick & TIMER_WHEEL_MASK] = NULL;
+	while (node)
+	{
+		timerNode *next = node->next;
+		node->slot = NULL;
+		node->prev = node->next = NULL;
+		due.append(node);
+		node = next;
+	}
+	timerWheelTick++;
+}
+
+static bool timerLessSeq(const timerNode *a, const timerNode *b)
+{
+	return a->seq < b->seq;
+}
+
+static bool timerLessDue(const timerNode *a, const timerNode *b)
+{
+	return a->frameTime < b->frameTime || (a->frameTime == b->frameTime && a->seq < b->seq);
+}
 
 /// Scripting engine (what others call the scripting context, but QtScript's nomenclature is different).
 static QList<QScriptEngine *> scripts;
@@ -108,7 +305,28 @@ typedef struct monitor_bin
 	monitor_bin() : worst(0),  worstGameTime(0), calls(0), overMaxTimeCalls(0), overHalfMaxTimeCalls(0), time(0) {}
 } MONITOR_BIN;
 typedef QHash<QString, MONITOR_BIN> MONITOR;
-static QHash<QScriptEngine *, MONITOR *> monitors;
+
+/// Event handlers and performance data of a script. The handlers are refreshed after every call into the
+/// script, after evaluating new code, and when hackChangeMe() or receiveAllEvents() change the player filter.
+struct SCRIPT_HANDLERS : public SCRIPT_EVENT_HANDLERS
+{
+	MONITOR *monitor;
+	SCRIPT_HANDLERS() : monitor(NULL) {}
+};
+static QHash<QScriptEngine *, SCRIPT_HANDLERS *> handlers;
+static QList<SCRIPT_HANDLERS *> handlerList;  ///< In the same order as scripts
+static int handlerCount[EVENT_COUNT];         ///< Number of scripts handling each event
+
+/// Dispatch statistics of each event, over all scripts.
+struct EVENT_STATS
+{
+	int triggered;    ///< Times the event happened
+	int skipped;      ///< Times no script handled the event, so no arguments were converted
+	int calls;        ///< Handler calls
+	int worst;        ///< Slowest handler call, in milliseconds
+	uint64_t time;    ///< Total handler time, in milliseconds
+};
+static EVENT_STATS eventStats[EVENT_COUNT];
 
 static MODELMAP models;
 static QStandardItemModel *triggerModel;
@@ -118,27 +336,18 @@ static void updateGlobalModels();
 
 // ----------------------------------------------------------
 
-// Call a function by name
-static bool callFunction(QScriptEngine *engine, const QString &function, const QScriptValueList &args, bool required = false)
+static void refreshHandlers(QScriptEngine *engine);
+
+// Call a function handle, keeping performance data under the given name
+static bool callValue(QScriptEngine *engine, MONITOR *monitor, const QString &function, QScriptValue value, const QScriptValueList &args, int &ticks)
 {
-	code_part level = required ? LOG_ERROR : LOG_SCRIPT;
-	QScriptValue value = engine->globalObject().property(function);
-	if (!value.isValid() || !value.isFunction())
-	{
-		// not necessarily an error, may just be a trigger that is not defined (ie not needed)
-		// or it could be a typo in the function name or ...
-		debug(level, "called function (%s) not defined", function.toUtf8().constData());
-		return false;
-	}
-	int ticks = wzGetTicks();
+	ticks = wzGetTicks();
 	QScriptValue result = value.call(QScriptValue(), args);
 	ticks = wzGetTicks() - ticks;
-	MONITOR *monitor = monitors.value(engine); // pick right one for this engine
-	MONITOR_BIN m;
-	if (monitor->contains(function))
-	{
-		m = monitor->value(function);
-	}
+	refreshHandlers(engine);  // the script may have changed its handlers or 'me', and later events this tick must see it
+	metricCalls.add();
+	metricCallTime.sample(ticks);
+	MONITOR_BIN &m = (*monitor)[function];
 	if (ticks > MAX_MS)
 	{
 		debug(LOG_SCRIPT, "%s took %d ms at time %d", function.toUtf8().constData(), ticks, wzGetTicks());
@@ -155,7 +364,6 @@ static bool callFunction(QScriptEngine *engine, const QString &function, const Q
 		m.worstGameTime = gameTime;
 	}
 	m.time += ticks;
-	monitor->insert(function, m);
 	if (engine->hasUncaughtException())
 	{
 		int line = engine->uncaughtExceptionLineNumber();
@@ -172,6 +380,73 @@ static bool callFunction(QScriptEngine *engine, const QString &function, const Q
 	return true;
 }
 
+// Call a function by name
+static bool callFunction(QScriptEngine *engine, const QString &function, const QScriptValueList &args, bool required = false)
+{
+	code_part level = required ? LOG_ERROR : LOG_SCRIPT;
+	QScriptValue value = engine->globalObject().property(function);
+	if (!value.isValid() || !value.isFunction())
+	{
+		// not necessarily an error, may just be a trigger that is not defined (ie not needed)
+		// or it could be a typo in the function name or ...
+		debug(level, "called function (%s) not defined", function.toUtf8().constData());
+		return false;
+	}
+	int ticks;
+	return callValue(engine, handlers.value(engine)->monitor, function, value, args, ticks);
+}
+
+/// Re-read the event handlers and player filter of the given script.
+static void refreshHandlers(QScriptEngine *engine)
+{
+	SCRIPT_HANDLERS *h = handlers.value(engine);
+	if (!h)
+	{
+		return;  // still loading, resolved once registered
+	}
+	h->refresh(engine, handlerCount);
+}
+
+void jsRefreshHandlers(QScriptEngine *engine)
+{
+	refreshHandlers(engine);
+}
+
+/// Whether any script handles the event. If not, the trigger is counted as skipped.
+static bool eventHandled(SCRIPT_EVENT event)
+{
+	eventStats[event].triggered++;
+	if (handlerCount[event] == 0)
+	{
+		eventStats[event].skipped++;
+		return false;
+	}
+	return true;
+}
+
+/// Whether the script at the given index has a handler for the event.
+static inline bool hasHandler(int index, SCRIPT_EVENT event)
+{
+	return handlerList.at(index)->handler[event].isValid();
+}
+
+// Call the pre-resolved handler of an event
+static bool callEvent(int index, SCRIPT_EVENT event, const QScriptValueList &args)
+{
+	SCRIPT_HANDLERS *h = handlerList.at(index);
+	if (!h->handler[event].isValid())
+	{
+		return false;
+	}
+	int ticks;
+	bool result = callValue(scripts.at(index), h->monitor, scriptEventNames[event], h->handler[event], args, ticks);
+	EVENT_STATS &stats = eventStats[event];
+	stats.calls++;
+	stats.time += ticks;
+	stats.worst = MAX(stats.worst, ticks);
+	return result;
+}
+
 //-- \subsection{setTimer(function, milliseconds[, object])}
 //-- Set a function to run repeated at some given time interval. The function to run 
 //-- is the first parameter, and it \underline{must be quoted}, otherwise the function will
@@ -194,25 +469,25 @@ static QScriptValue js_setTimer(QScriptContext *context, QScriptEngine *engine)
 	QString funcName = context->argument(0).toString();
 	QScriptValue ms = context->argument(1);
 	int player = engine->globalObject().property("me").toInt32();
-	timerNode node(engine, funcName, player, ms.toInt32());
 	QScriptValue value = engine->globalObject().property(funcName); // check existence
 	SCRIPT_ASSERT(context, value.isValid() && value.isFunction(), "No such function: %s",
 	              funcName.toUtf8().constData());
+	timerNode *node = new timerNode(engine, funcName, player, ms.toInt32());
 	if (context->argumentCount() == 3)
 	{
 		QScriptValue obj = context->argument(2);
 		if (obj.isString())
 		{
-			node.stringarg = obj.toString();
+			node->stringarg = obj.toString();
 		}
 		else // is game object
 		{
-			node.baseobj = obj.property("id").toInt32();
-			node.baseobjtype = (OBJECT_TYPE)obj.property("type").toInt32();
+			node->baseobj = obj.property("id").toInt32();
+			node->baseobjtype = (OBJECT_TYPE)obj.property("type").toInt32();
 		}
 	}
-	node.type = TIMER_REPEAT;
-	timers.push_back(node);
+	node->type = TIMER_REPEAT;
+	timerAdd(node);
 	return QScriptValue();
 }
 
@@ -223,17 +498,16 @@ static QScriptValue js_removeTimer(QScriptContext *context, QScriptEngine *engin
 {
 	SCRIPT_ASSERT(context, context->argument(0).isString(), "Timer functions must be quoted");
 	QString function = context->argument(0).toString();
-	int i, size = timers.size();
-	for (i = 0; i < size; ++i)
+	timerNode *node;
+	for (node = timerFirst; node; node = node->allNext)
 	{
-		timerNode node = timers.at(i);
-		if (node.function == function)
+		if (node->function == function)
 		{
-			timers.removeAt(i);
+			timerRemove(node);
 			break;
 		}
 	}
-	if (i == size)
+	if (!node)
 	{
 		// Friendly warning
 		QString warnName = function.left(15) + "...";
@@ -266,39 +540,50 @@ static QScriptValue js_queue(QScriptContext *context, QScriptEngine *engine)
 		ms = context->argument(1).toInt32();
 	}
 	int player = engine->globalObject().property("me").toInt32();
-	timerNode node(engine, funcName, player, ms);
+	timerNode *node = new timerNode(engine, funcName, player, ms);
 	if (context->argumentCount() == 3)
 	{
 		QScriptValue obj = context->argument(2);
 		if (obj.isString())
 		{
-			node.stringarg = obj.toString();
+			node->stringarg = obj.toString();
 		}
 		else // is game object
 		{
-			node.baseobj = obj.property("id").toInt32();
-			node.baseobjtype = (OBJECT_TYPE)obj.property("type").toInt32();
+			node->baseobj = obj.property("id").toInt32();
+			node->baseobjtype = (OBJECT_TYPE)obj.property("type").toInt32();
 		}
 	}
-	node.type = TIMER_ONESHOT_READY;
-	timers.push_back(node);
+	node->type = TIMER_ONESHOT_READY;
+	timerAdd(node);
+	return QScriptValue();
+}
+
+//-- \subsection{setTimerBudget(calls)}
+//-- Limit the number of timer and queued functions of this script that may run in the same
+//-- game tick. Functions that are due once the limit is reached are run in later game ticks, in the
+//-- order they became due. This spreads the load of scripts setting many short timers over
+//-- several ticks. A limit of 0, which is the default, means no limit. (3.2+ only)
+static QScriptValue js_setTimerBudget(QScriptContext *context, QScriptEngine *engine)
+{
+	int calls = context->argument(0).toInt32();
+	SCRIPT_ASSERT(context, calls >= 0, "Timer budget must not be negative");
+	timerStats[engine].budget = calls;
 	return QScriptValue();
 }
 
 void scriptRemoveObject(BASE_OBJECT *psObj)
 {
 	// Weed out timers with dead objects
-	for (int i = 0; i < timers.count(); )
+	timerNode *node = timerFirst;
+	while (node)
 	{
-		const timerNode node = timers.at(i);
-		if (node.baseobj == psObj->id)
+		timerNode *next = node->allNext;
+		if (node->baseobj == psObj->id)
 		{
-			timers.removeAt(i);
-		}
-		else
-		{
-			i++;
+			timerRemove(node);
 		}
+		node = next;
 	}
 	groupRemoveObject(psObj);
 }
@@ -347,6 +632,7 @@ static QScriptValue js_include(QScriptContext *context, QScriptEngine *engine)
 		      line, path.toUtf8().constData(), result.toString().toUtf8().constData());
 		return QScriptValue(false);
 	}
+	refreshHandlers(engine);
 	debug(LOG_SCRIPT, "Included new script file %s", path.toUtf8().constData());
 	return QScriptValue(true);
 }
@@ -373,7 +659,8 @@ bool shutdownScripts()
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		MONITOR *monitor = monitors.value(engine);
+		SCRIPT_HANDLERS *h = handlers.value(engine);
+		MONITOR *monitor = h->monitor;
 		QString scriptName = engine->globalObject().property("scriptName").toString();
 		int me = engine->globalObject().property("me").toInt32();
 		dumpScriptLog(scriptName, me, "=== PERFORMANCE DATA ===\n");
@@ -389,13 +676,34 @@ bool shutdownScripts()
 			info += QString::number(m.overHalfMaxTimeCalls) + " calls over half limit.\n";
 			dumpScriptLog(scriptName, me, info);
 		}
+		TIMER_STATS stats = timerStats.value(engine);
+		QString info = "Timers : " + QString::number(stats.budget) + " calls per tick budget; ";
+		info += QString::number(stats.deferredCalls) + " calls deferred; ";
+		info += QString::number(stats.ticksOverBudget) + " ticks over budget; ";
+		info += QString::number(stats.ticksOverMaxTime) + " ticks over time limit.\n";
+		dumpScriptLog(scriptName, me, info);
 		monitor->clear();
 		delete monitor;
+		delete h;
 		unregisterFunctions(engine);
 	}
-	timers.clear();
+	debug(LOG_SCRIPT, "=== EVENT DISPATCH DATA ===");
+	for (int event = 0; event < EVENT_COUNT; ++event)
+	{
+		const EVENT_STATS &stats = eventStats[event];
+		if (stats.triggered > 0)
+		{
+			debug(LOG_SCRIPT, "%s : %d triggered; %d skipped; %d calls; %d ms total; %d ms worst",
+			      scriptEventNames[event].toUtf8().constData(), stats.triggered, stats.skipped, stats.calls, (int)stats.time, stats.worst);
+		}
+	}
+	memset(eventStats, 0, sizeof(eventStats));
+	memset(handlerCount, 0, sizeof(handlerCount));
+	timerClear();
+	timerStats.clear();
 	internalNamespace.clear();
-	monitors.clear();
+	handlers.clear();
+	handlerList.clear();
 	while (!scripts.isEmpty())
 	{
 		delete scripts.takeFirst();
@@ -406,17 +714,20 @@ bool shutdownScripts()
 bool updateScripts()
 {
 	// Call delayed triggers here
-	if (selectionChanged)
+	if (selectionChanged && eventHandled(EVENT_SELECTION_CHANGED))
 	{
 		for (int i = 0; i < scripts.size(); ++i)
 		{
-			QScriptEngine *engine = scripts.at(i);
-			QScriptValueList args;
-			args += js_enumSelected(NULL, engine);
-			callFunction(engine, "eventSelectionChanged", args);
+			if (hasHandler(i, EVENT_SELECTION_CHANGED))
+			{
+				QScriptEngine *engine = scripts.at(i);
+				QScriptValueList args;
+				args += js_enumSelected(NULL, engine);
+				callEvent(i, EVENT_SELECTION_CHANGED, args);
+			}
 		}
-		selectionChanged = false;
 	}
+	selectionChanged = false;
 
 	// Update gameTime
 	for (int i = 0; i < scripts.size(); ++i)
@@ -425,37 +736,60 @@ bool updateScripts()
 
 		engine->globalObject().setProperty("gameTime", gameTime, QScriptValue::ReadOnly | QScriptValue::Undeletable);
 	}
-	// Weed out dead timers
-	for (int i = 0; i < timers.count(); )
+	// Collect the timers due up to now
+	QList<timerNode *> due;
+	const int nowTick = gameTime / GAME_TICKS_PER_UPDATE;
+	while (timerWheelTick <= nowTick)
 	{
-		const timerNode node = timers.at(i);
-		if (node.type == TIMER_ONESHOT_DONE)
-		{
-			timers.removeAt(i);
-		}
-		else
+		if (!timerFirst)
 		{
-			i++;
+			timerWheelTick = nowTick + 1;  // nothing to turn the wheel for
+			break;
 		}
+		timerWheelAdvance(due);
 	}
-	// Check for timers, and run them if applicable.
-	// TODO - load balancing
-	QList<timerNode> runlist; // make a new list here, since we might trample all over the timer list during execution
-	QList<timerNode>::iterator iter;
-	for (iter = timers.begin(); iter != timers.end(); iter++)
+	bool budgets = false;
+	for (QHash<QScriptEngine *, TIMER_STATS>::const_iterator i = timerStats.constBegin(); i != timerStats.constEnd(); ++i)
 	{
-		if (iter->frameTime <= gameTime)
+		budgets = budgets || i.value().budget > 0;
+	}
+	// Without budgets, run in creation order. With budgets, timers deferred from earlier ticks go first.
+	std::sort(due.begin(), due.end(), budgets ? timerLessDue : timerLessSeq);
+
+	// Make a run list of copies, since we might trample all over the timers during execution
+	QList<timerNode> runlist;
+	QHash<QScriptEngine *, int> dueCalls;
+	for (int i = 0; i < due.size(); ++i)
+	{
+		timerNode *node = due.at(i);
+		int &calls = dueCalls[node->engine];
+		TIMER_STATS &stats = timerStats[node->engine];
+		if (stats.budget > 0 && calls >= stats.budget)
 		{
-			iter->frameTime = iter->ms + gameTime;	// update for next invokation
-			if (iter->type == TIMER_ONESHOT_READY)
+			if (calls == stats.budget)
 			{
-				iter->type = TIMER_ONESHOT_DONE; // unless there is none
+				stats.ticksOverBudget++;
 			}
-			iter->calls++;
-			runlist.append(*iter);
+			calls++;
+			stats.deferredCalls++;
+			timerSlotInsert(node, timerWheelTick);  // try again next game update
+			continue;
+		}
+		calls++;
+		node->calls++;
+		runlist.append(*node);
+		if (node->type == TIMER_ONESHOT_READY)
+		{
+			timerRemove(node);
+		}
+		else
+		{
+			node->frameTime = node->ms + gameTime;	// update for next invokation
+			timerSlotInsert(node, timerDueTick(node->frameTime));
 		}
 	}
-	for (iter = runlist.begin(); iter != runlist.end(); iter++)
+	QHash<QScriptEngine *, int> runTicks;
+	for (QList<timerNode>::iterator iter = runlist.begin(); iter != runlist.end(); iter++)
 	{
 		QScriptValueList args;
 		if (iter->baseobj > 0)
@@ -466,7 +800,16 @@ bool updateScripts()
 		{
 			args += iter->stringarg;
 		}
+		int ticks = wzGetTicks();
 		callFunction(iter->engine, iter->function, args, true);
+		runTicks[iter->engine] += wzGetTicks() - ticks;
+	}
+	for (QHash<QScriptEngine *, int>::const_iterator i = runTicks.constBegin(); i != runTicks.constEnd(); ++i)
+	{
+		if (i.value() > MAX_MS)
+		{
+			timerStats[i.key()].ticksOverMaxTime++;
+		}
 	}
 
 	if (globalDialog && doUpdateModels)
@@ -498,6 +841,7 @@ QScriptEngine *loadPlayerScript(QString path, int player, int difficulty)
 	engine->globalObject().setProperty("setTimer", engine->newFunction(js_setTimer));
 	engine->globalObject().setProperty("queue", engine->newFunction(js_queue));
 	engine->globalObject().setProperty("removeTimer", engine->newFunction(js_removeTimer));
+	engine->globalObject().setProperty("setTimerBudget", engine->newFunction(js_setTimerBudget));
 	engine->globalObject().setProperty("include", engine->newFunction(js_include));
 
 	// Special global variables
@@ -586,8 +930,12 @@ QScriptEngine *loadPlayerScript(QString path, int player, int difficulty)
 	// Register script
 	scripts.push_back(engine);
 
-	MONITOR *monitor = new MONITOR;
-	monitors.insert(engine, monitor);
+	SCRIPT_HANDLERS *h = new SCRIPT_HANDLERS;
+	h->monitor = new MONITOR;
+	handlers.insert(engine, h);
+	handlerList.push_back(h);
+	refreshHandlers(engine);
+	timerStats.insert(engine, TIMER_STATS());
 
 	debug(LOG_SAVE, "Created script engine %d for player %d from %s", scripts.size() - 1, player, path.toUtf8().constData());
 	return engine;
@@ -623,9 +971,10 @@ bool saveScriptStates(const char *filename)
 		saveGroups(ini, engine);
 		ini.endGroup();
 	}
-	for (int i = 0; i < timers.size(); ++i)
+	int i = 0;
+	for (timerNode *psNode = timerFirst; psNode; psNode = psNode->allNext, ++i)
 	{
-		timerNode node = timers.at(i);
+		const timerNode &node = *psNode;
 		ini.beginGroup(QString("triggers_") + QString::number(i));
 		// we have to save 'scriptName' and 'me' explicitly
 		ini.setValue("me", node.player);
@@ -673,17 +1022,24 @@ bool loadScriptStates(const char *filename)
 		QScriptEngine *engine = findEngineForPlayer(player, scriptName);
 		if (engine && list[i].startsWith("triggers_"))
 		{
-			timerNode node;
-			node.player = player;
-			node.ms = ini.value("ms").toInt();
-			node.frameTime = ini.value("frame").toInt();
-			node.engine = engine;
+			timerNode *node = new timerNode;
+			node->player = player;
+			node->ms = ini.value("ms").toInt();
+			node->frameTime = ini.value("frame").toInt();
+			node->engine = engine;
 			debug(LOG_SAVE, "Registering trigger %d for player %d, script %s", 
-			      i, node.player, scriptName.toUtf8().constData());
-			node.function = ini.value("function").toString();
-			node.baseobj = ini.value("baseobj", -1).toInt();
-			node.type = (timerType)ini.value("type", TIMER_REPEAT).toInt();
-			timers.push_back(node);
+			      i, node->player, scriptName.toUtf8().constData());
+			node->function = ini.value("function").toString();
+			node->baseobj = ini.value("baseobj", -1).toInt();
+			node->type = (timerType)ini.value("type", TIMER_REPEAT).toInt();
+			if (node->type == TIMER_ONESHOT_DONE)
+			{
+				delete node;  // already run
+			}
+			else
+			{
+				timerAdd(node);
+			}
 		}
 		else if (engine && list[i].startsWith("globals_"))
 		{
@@ -694,6 +1050,7 @@ bool loadScriptStates(const char *filename)
 			{
 				engine->globalObject().setProperty(keys.at(j), engine->toScriptValue(ini.value(keys.at(j))));
 			}
+			refreshHandlers(engine);
 		}
 		else if (engine && list[i].startsWith("groups_"))
 		{
@@ -762,9 +1119,9 @@ static void updateGlobalModels()
 	}
 	QStandardItemModel *m = triggerModel;
 	m->setRowCount(0);
-	for (int i = 0; i < timers.size(); ++i)
+	for (timerNode *psNode = timerFirst; psNode; psNode = psNode->allNext)
 	{
-		timerNode node = timers.at(i);
+		const timerNode &node = *psNode;
 		int nextRow = m->rowCount();
 		m->setRowCount(nextRow);
 		m->setItem(nextRow, 0, new QStandardItem(node.function));
@@ -806,6 +1163,7 @@ bool jsEvaluate(QScriptEngine *engine, const QString &text)
 		return false;
 	}
 	QScriptValue result = engine->evaluate(text);
+	refreshHandlers(engine);
 	if (engine->hasUncaughtException())
 	{
 		debug(LOG_ERROR, "Uncaught exception in %s: %s",
@@ -896,66 +1254,59 @@ void jsShowDebug()
 //__ An event that is run when the mission transporter has landed with reinforcements.
 bool triggerEvent(SCRIPT_TRIGGER_TYPE trigger, BASE_OBJECT *psObj)
 {
+	SCRIPT_EVENT event = EVENT_COUNT, deprecated = EVENT_COUNT;
+	bool withObject = false;
+	switch (trigger)
+	{
+	case TRIGGER_GAME_INIT: event = EVENT_GAME_INIT; break;
+	case TRIGGER_START_LEVEL: event = EVENT_START_LEVEL; break;
+	case TRIGGER_TRANSPORTER_LAUNCH: event = EVENT_TRANSPORTER_LAUNCH; deprecated = EVENT_LAUNCH_TRANSPORTER; withObject = true; break;
+	case TRIGGER_TRANSPORTER_ARRIVED: event = EVENT_TRANSPORTER_ARRIVED; deprecated = EVENT_REINFORCEMENTS_ARRIVED; withObject = true; break;
+	case TRIGGER_OBJECT_RECYCLED: event = EVENT_OBJECT_RECYCLED; withObject = true; break;
+	case TRIGGER_TRANSPORTER_EXIT: event = EVENT_TRANSPORTER_EXIT; withObject = true; break;
+	case TRIGGER_TRANSPORTER_DONE: event = EVENT_TRANSPORTER_DONE; withObject = true; break;
+	case TRIGGER_TRANSPORTER_LANDED: event = EVENT_TRANSPORTER_LANDED; withObject = true; break;
+	case TRIGGER_MISSION_TIMEOUT: event = EVENT_MISSION_TIMEOUT; break;
+	case TRIGGER_VIDEO_QUIT: event = EVENT_VIDEO_DONE; break;
+	case TRIGGER_GAME_LOADED: event = EVENT_GAME_LOADED; break;
+	case TRIGGER_GAME_SAVING: event = EVENT_GAME_SAVING; break;
+	case TRIGGER_GAME_SAVED: event = EVENT_GAME_SAVED; break;
+	}
+	ASSERT_OR_RETURN(false, event != EVENT_COUNT, "Unknown trigger %d", (int)trigger);
+	bool handled = eventHandled(event);
+	if (deprecated != EVENT_COUNT)
+	{
+		handled = eventHandled(deprecated) || handled;
+	}
+	if (!handled && trigger != TRIGGER_START_LEVEL)  // starting the level also initializes visibility
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		QScriptValueList args;
+		SCRIPT_HANDLERS *h = handlerList.at(i);
 
-		if (psObj)
+		if (psObj && h->player != psObj->player && !h->receiveAll)
 		{
-			int player = engine->globalObject().property("me").toInt32();
-			bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-			if (player != psObj->player && !receiveAll)
-			{
-				continue;
-			}
-			args += convMax(psObj, engine);
+			continue;
 		}
-
-		switch (trigger)
+		if (trigger == TRIGGER_START_LEVEL)
 		{
-		case TRIGGER_GAME_INIT:
-			callFunction(engine, "eventGameInit", QScriptValueList());
-			break;
-		case TRIGGER_START_LEVEL:
 			processVisibility(); // make sure we initialize visibility first
-			callFunction(engine, "eventStartLevel", QScriptValueList());
-			break;
-		case TRIGGER_TRANSPORTER_LAUNCH:
-			callFunction(engine, "eventLaunchTransporter", QScriptValueList()); // deprecated!
-			callFunction(engine, "eventTransporterLaunch", args);
-			break;
-		case TRIGGER_TRANSPORTER_ARRIVED:
-			callFunction(engine, "eventReinforcementsArrived", QScriptValueList()); // deprecated!
-			callFunction(engine, "eventTransporterArrived", args);
-			break;
-		case TRIGGER_OBJECT_RECYCLED:
-			callFunction(engine, "eventObjectRecycled", args);
-			break;
-		case TRIGGER_TRANSPORTER_EXIT:
-			callFunction(engine, "eventTransporterExit", args);
-			break;
-		case TRIGGER_TRANSPORTER_DONE:
-			callFunction(engine, "eventTransporterDone", args);
-			break;
-		case TRIGGER_TRANSPORTER_LANDED:
-			callFunction(engine, "eventTransporterLanded", args);
-			break;
-		case TRIGGER_MISSION_TIMEOUT:
-			callFunction(engine, "eventMissionTimeout", QScriptValueList());
-			break;
-		case TRIGGER_VIDEO_QUIT:
-			callFunction(engine, "eventVideoDone", QScriptValueList());
-			break;
-		case TRIGGER_GAME_LOADED:
-			callFunction(engine, "eventGameLoaded", QScriptValueList());
-			break;
-		case TRIGGER_GAME_SAVING:
-			callFunction(engine, "eventGameSaving", QScriptValueList());
-			break;
-		case TRIGGER_GAME_SAVED:
-			callFunction(engine, "eventGameSaved", QScriptValueList());
-			break;
+		}
+		if (deprecated != EVENT_COUNT)
+		{
+			callEvent(i, deprecated, QScriptValueList());
+		}
+		if (hasHandler(i, event))
+		{
+			QScriptValueList args;
+			if (psObj && withObject)
+			{
+				args += convMax(psObj, engine);
+			}
+			callEvent(i, event, args);
 		}
 	}
 	return true;
@@ -965,12 +1316,15 @@ bool triggerEvent(SCRIPT_TRIGGER_TYPE trigger, BASE_OBJECT *psObj)
 //__ An event that is run after a player has left the game.
 bool triggerEventPlayerLeft(int id)
 {
+	if (!eventHandled(EVENT_PLAYER_LEFT))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
 		QScriptValueList args;
 		args += id;
-		callFunction(engine, "eventPlayerLeft", args);
+		callEvent(i, EVENT_PLAYER_LEFT, args);
 	}
 	return true;
 }
@@ -979,12 +1333,15 @@ bool triggerEventPlayerLeft(int id)
 //__ The entered parameter is true if cheat mode entered, false otherwise.
 bool triggerEventCheatMode(bool entered)
 {
+	if (!eventHandled(EVENT_CHEAT_MODE))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
 		QScriptValueList args;
 		args += entered;
-		callFunction(engine, "eventCheatMode", args);
+		callEvent(i, EVENT_CHEAT_MODE, args);
 	}
 	return true;
 }
@@ -992,15 +1349,19 @@ bool triggerEventCheatMode(bool entered)
 //__ \subsection{eventDroidIdle(droid)} A droid should be given new orders.
 bool triggerEventDroidIdle(DROID *psDroid)
 {
+	if (!eventHandled(EVENT_DROID_IDLE))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int player = engine->globalObject().property("me").toInt32();
-		if (player == psDroid->player)
+		int player = handlerList.at(i)->player;
+		if (player == psDroid->player && hasHandler(i, EVENT_DROID_IDLE))
 		{
 			QScriptValueList args;
 			args += convDroid(psDroid, engine);
-			callFunction(engine, "eventDroidIdle", args);
+			callEvent(i, EVENT_DROID_IDLE, args);
 		}
 	}
 	return true;
@@ -1012,12 +1373,16 @@ bool triggerEventDroidIdle(DROID *psDroid)
 //__ gift (check \emph{eventObjectTransfer} for that).
 bool triggerEventDroidBuilt(DROID *psDroid, STRUCTURE *psFactory)
 {
+	if (!eventHandled(EVENT_DROID_BUILT))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (player == psDroid->player || receiveAll)
+		int player = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((player == psDroid->player || receiveAll) && hasHandler(i, EVENT_DROID_BUILT))
 		{
 			QScriptValueList args;
 			args += convDroid(psDroid, engine);
@@ -1025,7 +1390,7 @@ bool triggerEventDroidBuilt(DROID *psDroid, STRUCTURE *psFactory)
 			{
 				args += convStructure(psFactory, engine);
 			}
-			callFunction(engine, "eventDroidBuilt", args);
+			callEvent(i, EVENT_DROID_BUILT, args);
 		}
 	}
 	return true;
@@ -1037,12 +1402,16 @@ bool triggerEventDroidBuilt(DROID *psDroid, STRUCTURE *psFactory)
 //__ (check \emph{eventObjectTransfer} for that).
 bool triggerEventStructBuilt(STRUCTURE *psStruct, DROID *psDroid)
 {
+	if (!eventHandled(EVENT_STRUCTURE_BUILT))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (player == psStruct->player || receiveAll)
+		int player = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((player == psStruct->player || receiveAll) && hasHandler(i, EVENT_STRUCTURE_BUILT))
 		{
 			QScriptValueList args;
 			args += convStructure(psStruct, engine);
@@ -1050,7 +1419,7 @@ bool triggerEventStructBuilt(STRUCTURE *psStruct, DROID *psDroid)
 			{
 				args += convDroid(psDroid, engine);
 			}
-			callFunction(engine, "eventStructureBuilt", args);
+			callEvent(i, EVENT_STRUCTURE_BUILT, args);
 		}
 	}
 	return true;
@@ -1062,16 +1431,20 @@ bool triggerEventStructBuilt(STRUCTURE *psStruct, DROID *psDroid)
 //__ register your own timer to keep checking.
 bool triggerEventStructureReady(STRUCTURE *psStruct)
 {
+	if (!eventHandled(EVENT_STRUCTURE_READY))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (player == psStruct->player || receiveAll)
+		int player = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((player == psStruct->player || receiveAll) && hasHandler(i, EVENT_STRUCTURE_READY))
 		{
 			QScriptValueList args;
 			args += convStructure(psStruct, engine);
-			callFunction(engine, "eventStructureReady", args);
+			callEvent(i, EVENT_STRUCTURE_READY, args);
 		}
 	}
 	return true;
@@ -1093,16 +1466,20 @@ bool triggerEventAttacked(BASE_OBJECT *psVictim, BASE_OBJECT *psAttacker, int la
 	{
 		return false;
 	}
+	if (!eventHandled(EVENT_ATTACKED))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int player = engine->globalObject().property("me").toInt32();
-		if (player == psVictim->player)
+		int player = handlerList.at(i)->player;
+		if (player == psVictim->player && hasHandler(i, EVENT_ATTACKED))
 		{
 			QScriptValueList args;
 			args += convMax(psVictim, engine);
 			args += convMax(psAttacker, engine);
-			callFunction(engine, "eventAttacked", args);
+			callEvent(i, EVENT_ATTACKED, args);
 		}
 	}
 	return true;
@@ -1115,12 +1492,16 @@ bool triggerEventAttacked(BASE_OBJECT *psVictim, BASE_OBJECT *psAttacker, int la
 //__ be set to null. The player parameter gives the player it is called for.
 bool triggerEventResearched(RESEARCH *psResearch, STRUCTURE *psStruct, int player)
 {
+	if (!eventHandled(EVENT_RESEARCHED))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (me == player || receiveAll)
+		int me = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((me == player || receiveAll) && hasHandler(i, EVENT_RESEARCHED))
 		{
 			QScriptValueList args;
 			args += convResearch(psResearch, engine, player);
@@ -1133,7 +1514,7 @@ bool triggerEventResearched(RESEARCH *psResearch, STRUCTURE *psStruct, int playe
 				args += QScriptValue::NullValue;
 			}
 			args += QScriptValue(player);
-			callFunction(engine, "eventResearched", args);
+			callEvent(i, EVENT_RESEARCHED, args);
 		}
 	}
 	return true;
@@ -1144,12 +1525,19 @@ bool triggerEventResearched(RESEARCH *psResearch, STRUCTURE *psStruct, int playe
 //__ the parameter object around, since it is about to vanish!
 bool triggerEventDestroyed(BASE_OBJECT *psVictim)
 {
+	if (!eventHandled(EVENT_DESTROYED))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size() && psVictim; ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
-		QScriptValueList args;
-		args += convMax(psVictim, engine);
-		callFunction(engine, "eventDestroyed", args);
+		if (hasHandler(i, EVENT_DESTROYED))
+		{
+			QScriptEngine *engine = scripts.at(i);
+			QScriptValueList args;
+			args += convMax(psVictim, engine);
+			callEvent(i, EVENT_DESTROYED, args);
+		}
 	}
 	return true;
 }
@@ -1160,13 +1548,20 @@ bool triggerEventDestroyed(BASE_OBJECT *psVictim)
 //__ Careful passing the parameter object around, since it is about to vanish! (3.2+ only)
 bool triggerEventPickup(FEATURE *psFeat, DROID *psDroid)
 {
+	if (!eventHandled(EVENT_PICKUP))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
-		QScriptValueList args;
-		args += convFeature(psFeat, engine);
-		args += convDroid(psDroid, engine);
-		callFunction(engine, "eventPickup", args);
+		if (hasHandler(i, EVENT_PICKUP))
+		{
+			QScriptEngine *engine = scripts.at(i);
+			QScriptValueList args;
+			args += convFeature(psFeat, engine);
+			args += convDroid(psDroid, engine);
+			callEvent(i, EVENT_PICKUP, args);
+		}
 	}
 	return true;
 }
@@ -1177,17 +1572,21 @@ bool triggerEventPickup(FEATURE *psFeat, DROID *psDroid)
 //__ object being seen. This is event is throttled, and so is not called every time.
 bool triggerEventSeen(BASE_OBJECT *psViewer, BASE_OBJECT *psSeen)
 {
+	if (!eventHandled(EVENT_OBJECT_SEEN))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size() && psSeen && psViewer; ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (me == psViewer->player || receiveAll)
+		int me = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((me == psViewer->player || receiveAll) && hasHandler(i, EVENT_OBJECT_SEEN))
 		{
 			QScriptValueList args;
 			args += convMax(psViewer, engine);
 			args += convMax(psSeen, engine);
-			callFunction(engine, "eventObjectSeen", args);
+			callEvent(i, EVENT_OBJECT_SEEN, args);
 		}
 	}
 	return true;
@@ -1200,17 +1599,21 @@ bool triggerEventSeen(BASE_OBJECT *psViewer, BASE_OBJECT *psSeen)
 //__ The event is called for both players.
 bool triggerEventObjectTransfer(BASE_OBJECT *psObj, int from)
 {
+	if (!eventHandled(EVENT_OBJECT_TRANSFER))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size() && psObj; ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (me == psObj->player || me == from || receiveAll)
+		int me = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((me == psObj->player || me == from || receiveAll) && hasHandler(i, EVENT_OBJECT_TRANSFER))
 		{
 			QScriptValueList args;
 			args += convMax(psObj, engine);
 			args += QScriptValue(from);
-			callFunction(engine, "eventObjectTransfer", args);
+			callEvent(i, EVENT_OBJECT_TRANSFER, args);
 		}
 	}
 	return true;
@@ -1222,18 +1625,21 @@ bool triggerEventObjectTransfer(BASE_OBJECT *psObj, int from)
 //__ player.
 bool triggerEventChat(int from, int to, const char *message)
 {
+	if (!eventHandled(EVENT_CHAT))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size() && message; ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int me = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
 		if (me == to || (receiveAll && to == from))
 		{
 			QScriptValueList args;
 			args += QScriptValue(from);
 			args += QScriptValue(to);
 			args += QScriptValue(message);
-			callFunction(engine, "eventChat", args);
+			callEvent(i, EVENT_CHAT, args);
 			break; // only call once
 		}
 	}
@@ -1246,12 +1652,15 @@ bool triggerEventChat(int from, int to, const char *message)
 //__ Message may be undefined.
 bool triggerEventBeacon(int from, int to, const char *message, int x, int y)
 {
+	if (!eventHandled(EVENT_BEACON))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (me == to || receiveAll)
+		int me = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((me == to || receiveAll) && hasHandler(i, EVENT_BEACON))
 		{
 			QScriptValueList args;
 			args += QScriptValue(map_coord(x));
@@ -1262,7 +1671,7 @@ bool triggerEventBeacon(int from, int to, const char *message, int x, int y)
 			{
 				args += QScriptValue(message);
 			}
-			callFunction(engine, "eventBeacon", args);
+			callEvent(i, EVENT_BEACON, args);
 		}
 	}
 	return true;
@@ -1273,17 +1682,20 @@ bool triggerEventBeacon(int from, int to, const char *message, int x, int y)
 //__ player sending the beacon. For the moment, the \emph{to} parameter is always the script player.
 bool triggerEventBeaconRemoved(int from, int to)
 {
+	if (!eventHandled(EVENT_BEACON_REMOVED))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
-		if (me == to || receiveAll)
+		int me = handlerList.at(i)->player;
+		bool receiveAll = handlerList.at(i)->receiveAll;
+		if ((me == to || receiveAll) && hasHandler(i, EVENT_BEACON_REMOVED))
 		{
 			QScriptValueList args;
 			args += QScriptValue(from);
 			args += QScriptValue(to);
-			callFunction(engine, "eventBeaconRemoved", args);
+			callEvent(i, EVENT_BEACON_REMOVED, args);
 		}
 	}
 	return true;
@@ -1309,11 +1721,16 @@ bool triggerEventSelected()
 // Since groups are entities local to one context, we do not iterate over them here.
 bool triggerEventGroupLoss(BASE_OBJECT *psObj, int group, int size, QScriptEngine *engine)
 {
+	int i = scripts.indexOf(engine);
+	if (!eventHandled(EVENT_GROUP_LOSS) || i < 0 || !hasHandler(i, EVENT_GROUP_LOSS))
+	{
+		return true;
+	}
 	QScriptValueList args;
 	args += convMax(psObj, engine);
 	args += QScriptValue(group);
 	args += QScriptValue(size);
-	callFunction(engine, "eventGroupLoss", args);
+	callEvent(i, EVENT_GROUP_LOSS, args);
 	return true;
 }
 
@@ -1348,12 +1765,19 @@ bool triggerEventArea(QString label, DROID *psDroid)
 //__ run on the client of the player designing the template.
 bool triggerEventDesignCreated(DROID_TEMPLATE *psTemplate)
 {
+	if (!eventHandled(EVENT_DESIGN_CREATED))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
-		QScriptEngine *engine = scripts.at(i);
-		QScriptValueList args;
-		args += convTemplate(psTemplate, engine);
-		callFunction(engine, "eventDesignCreated", args);
+		if (hasHandler(i, EVENT_DESIGN_CREATED))
+		{
+			QScriptEngine *engine = scripts.at(i);
+			QScriptValueList args;
+			args += convTemplate(psTemplate, engine);
+			callEvent(i, EVENT_DESIGN_CREATED, args);
+		}
 	}
 	return true;
 }
@@ -1364,8 +1788,16 @@ bool triggerEventDesignCreated(DROID_TEMPLATE *psTemplate)
 //__ cheating!
 bool triggerEventSyncRequest(int from, int req_id, int x, int y, BASE_OBJECT *psObj, BASE_OBJECT *psObj2)
 {
+	if (!eventHandled(EVENT_SYNC_REQUEST))
+	{
+		return true;
+	}
 	for (int i = 0; i < scripts.size(); ++i)
 	{
+		if (!hasHandler(i, EVENT_SYNC_REQUEST))
+		{
+			continue;
+		}
 		QScriptEngine *engine = scripts.at(i);
 		QScriptValueList args;
 		args += QScriptValue(from);
@@ -1380,7 +1812,7 @@ bool triggerEventSyncRequest(int from, int req_id, int x, int y, BASE_OBJECT *ps
 		{
 			args += convMax(psObj2, engine);
 		}
-		callFunction(engine, "eventSyncRequest", args);
+		callEvent(i, EVENT_SYNC_REQUEST, args);
 	}
 	return true;
 }
@@ -88,6 +88,9 @@ void jsAutogame();
 /// Run-time code from user
 bool jsEvaluate(QScriptEngine *engine, const QString &text);
 
+/// Re-read the event handlers and player filter of a script, after changing 'me' or 'isReceivingAllEvents' for it
+void jsRefreshHandlers(QScriptEngine *engine);
+
 // ----------------------------------------------
 // Event functions
 
@@ -0,0 +1,80 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+/**
+ * @file qtscriptevents.cpp
+ *
+ * Event handlers of a script, resolved ahead of time.
+ */
+
+#include "qtscriptevents.h"
+
+#include <QtScript/QScriptEngine>
+
+const QString scriptEventNames[EVENT_COUNT] =
+{
+	"eventGameInit",
+	"eventStartLevel",
+	"eventLaunchTransporter", // deprecated!
+	"eventTransporterLaunch",
+	"eventReinforcementsArrived", // deprecated!
+	"eventTransporterArrived",
+	"eventObjectRecycled",
+	"eventTransporterExit",
+	"eventTransporterDone",
+	"eventTransporterLanded",
+	"eventMissionTimeout",
+	"eventVideoDone",
+	"eventGameLoaded",
+	"eventGameSaving",
+	"eventGameSaved",
+	"eventPlayerLeft",
+	"eventCheatMode",
+	"eventDroidIdle",
+	"eventDroidBuilt",
+	"eventStructureBuilt",
+	"eventStructureReady",
+	"eventAttacked",
+	"eventResearched",
+	"eventDestroyed",
+	"eventPickup",
+	"eventObjectSeen",
+	"eventObjectTransfer",
+	"eventChat",
+	"eventBeacon",
+	"eventBeaconRemoved",
+	"eventSelectionChanged",
+	"eventGroupLoss",
+	"eventDesignCreated",
+	"eventSyncRequest"
+};
+
+void SCRIPT_EVENT_HANDLERS::refresh(QScriptEngine *engine, int handlerCount[EVENT_COUNT])
+{
+	QScriptValue global = engine->globalObject();
+	player = global.property("me").toInt32();
+	receiveAll = global.property("isReceivingAllEvents").toBool();
+	for (int event = 0; event < EVENT_COUNT; ++event)
+	{
+		const bool had = handler[event].isValid();
+		QScriptValue value = global.property(scriptEventNames[event]);
+		handler[event] = value.isFunction() ? value : QScriptValue();
+		handlerCount[event] += (int)handler[event].isValid() - (int)had;
+	}
+}
@@ -0,0 +1,90 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+/** @file qtscriptevents.h
+ *  Event handlers of a script, resolved ahead of time. Only depends on QtScript, so that it can be tested alone.
+ */
+
+#ifndef __INCLUDED_QTSCRIPTEVENTS_H__
+#define __INCLUDED_QTSCRIPTEVENTS_H__
+
+#include <QtCore/QString>
+#include <QtScript/QScriptValue>
+
+class QScriptEngine;
+
+/// Events with a fixed handler name, which are resolved ahead of time for each script.
+enum SCRIPT_EVENT
+{
+	EVENT_GAME_INIT,
+	EVENT_START_LEVEL,
+	EVENT_LAUNCH_TRANSPORTER,
+	EVENT_TRANSPORTER_LAUNCH,
+	EVENT_REINFORCEMENTS_ARRIVED,
+	EVENT_TRANSPORTER_ARRIVED,
+	EVENT_OBJECT_RECYCLED,
+	EVENT_TRANSPORTER_EXIT,
+	EVENT_TRANSPORTER_DONE,
+	EVENT_TRANSPORTER_LANDED,
+	EVENT_MISSION_TIMEOUT,
+	EVENT_VIDEO_DONE,
+	EVENT_GAME_LOADED,
+	EVENT_GAME_SAVING,
+	EVENT_GAME_SAVED,
+	EVENT_PLAYER_LEFT,
+	EVENT_CHEAT_MODE,
+	EVENT_DROID_IDLE,
+	EVENT_DROID_BUILT,
+	EVENT_STRUCTURE_BUILT,
+	EVENT_STRUCTURE_READY,
+	EVENT_ATTACKED,
+	EVENT_RESEARCHED,
+	EVENT_DESTROYED,
+	EVENT_PICKUP,
+	EVENT_OBJECT_SEEN,
+	EVENT_OBJECT_TRANSFER,
+	EVENT_CHAT,
+	EVENT_BEACON,
+	EVENT_BEACON_REMOVED,
+	EVENT_SELECTION_CHANGED,
+	EVENT_GROUP_LOSS,
+	EVENT_DESIGN_CREATED,
+	EVENT_SYNC_REQUEST,
+	EVENT_COUNT
+};
+
+/// Names of the handler functions, by event.
+extern const QString scriptEventNames[EVENT_COUNT];
+
+/// Event handlers and player filter of a script, resolved ahead of time so that events can be dispatched
+/// without looking anything up in the script. Must be refreshed whenever script code may have run, since
+/// the script can redefine its handlers, or change 'me' and 'isReceivingAllEvents', at any time.
+struct SCRIPT_EVENT_HANDLERS
+{
+	int player;                         ///< Value of 'me'
+	bool receiveAll;                    ///< Value of 'isReceivingAllEvents'
+	QScriptValue handler[EVENT_COUNT];  ///< Invalid if the script does not handle the event
+
+	SCRIPT_EVENT_HANDLERS() : player(0), receiveAll(false) {}
+
+	/// Re-reads everything from the global object of the engine. Adds the change in handled events to handlerCount.
+	void refresh(QScriptEngine *engine, int handlerCount[EVENT_COUNT]);
+};
+
+#endif // __INCLUDED_QTSCRIPTEVENTS_H__
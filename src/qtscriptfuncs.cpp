@@ -29,8 +29,11 @@
 #include "qtscriptfuncs.h"
 #include "lib/ivis_opengl/tex.h"
 
+#include <algorithm>
+
 #include <QtScript/QScriptValue>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 #include <QtGui/QStandardItemModel>
 
 #include "action.h"
@@ -85,6 +88,8 @@ extern bool structDoubleCheck(BASE_STATS *psStat,UDWORD xx,UDWORD yy, SDWORD max
 extern Vector2i positions[MAX_PLAYERS];
 extern std::vector<Vector2i> derricks;
 
+Q_DECLARE_METATYPE(SlabHandle<BASE_OBJECT>)
+
 // private qtscript bureaucracy
 typedef QMap<BASE_OBJECT *, int> GROUPMAP;
 typedef QMap<QScriptEngine *, GROUPMAP *> ENGINEMAP;
@@ -280,6 +285,218 @@ static bool groupAddObject(BASE_OBJECT *psObj, int groupId, QScriptEngine *engin
 	return true; // inserted
 }
 
+// ----------------------------------------------------------------------------------------
+// Lazy object conversion
+//
+// Droids and structures are handed to scripts in large numbers, and most scripts only look at a
+// few of their properties. So most properties are set when the object is converted, and only the
+// expensive ones are worked out when a script first reads them, after which they are kept in the object.
+
+/// Droid and structure properties that are computed on access.
+enum LAZY_PROPERTY
+{
+	LAZY_WEAPONS,
+	LAZY_STRUCTURE_COUNT,		///< Properties below are for droids only
+	LAZY_COST = LAZY_STRUCTURE_COUNT,
+	LAZY_DROID_COUNT,		///< Properties below are for transporters only
+	LAZY_CARGO_LEFT = LAZY_DROID_COUNT,
+	LAZY_CARGO_COUNT,
+	LAZY_COUNT
+};
+
+static const char *lazyPropertyNames[LAZY_COUNT] =
+{
+	"weapons", "cost", "cargoLeft", "cargoCount"
+};
+
+static void objWeaponInfo(BASE_OBJECT *psObj, bool &aa, bool &ga, bool &indirect, int &range)
+{
+	const WEAPON *asWeaps = psObj->type == OBJ_DROID ? ((DROID *)psObj)->asWeaps : ((STRUCTURE *)psObj)->asWeaps;
+	int numWeaps = psObj->type == OBJ_DROID ? ((DROID *)psObj)->numWeaps : ((STRUCTURE *)psObj)->numWeaps;
+
+	aa = ga = indirect = false;
+	range = -1;
+	for (int i = 0; i < numWeaps; i++)
+	{
+		if (asWeaps[i].nStat)
+		{
+			WEAPON_STATS *psWeap = &asWeaponStats[asWeaps[i].nStat];
+			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
+			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
+			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
+			range = MAX((int)psWeap->upgrade[psObj->player].maxRange, range);
+		}
+	}
+}
+
+static QScriptValue convWeapons(BASE_OBJECT *psObj, QScriptEngine *engine)
+{
+	WEAPON *asWeaps = psObj->type == OBJ_DROID ? ((DROID *)psObj)->asWeaps : ((STRUCTURE *)psObj)->asWeaps;
+	int numWeaps = psObj->type == OBJ_DROID ? ((DROID *)psObj)->numWeaps : ((STRUCTURE *)psObj)->numWeaps;
+	QScriptValue weaponlist = engine->newArray(numWeaps);
+
+	for (int j = 0; j < numWeaps; j++)
+	{
+		QScriptValue weapon = engine->newObject();
+		const WEAPON_STATS *psStats = asWeaponStats + asWeaps[j].nStat;
+		weapon.setProperty("fullname", psStats->name, QScriptValue::ReadOnly);
+		weapon.setProperty("id", psStats->id, QScriptValue::ReadOnly); // will be changed to full name
+		weapon.setProperty("name", psStats->id, QScriptValue::ReadOnly);
+		weapon.setProperty("lastFired", asWeaps[j].lastFired, QScriptValue::ReadOnly);
+		if (psObj->type == OBJ_DROID)
+		{
+			weapon.setProperty("armed", droidReloadBar(psObj, &asWeaps[j], j), QScriptValue::ReadOnly);
+		}
+		weaponlist.setProperty(j, weapon, QScriptValue::ReadOnly);
+	}
+	return weaponlist;
+}
+
+static QScriptValue lazyProperty(BASE_OBJECT *psObj, int property, QScriptEngine *engine)
+{
+	switch (property)
+	{
+	case LAZY_WEAPONS: return convWeapons(psObj, engine);
+	case LAZY_COST: return calcDroidPower((DROID *)psObj);
+	case LAZY_CARGO_LEFT: return calcRemainingCapacity((DROID *)psObj);
+	case LAZY_CARGO_COUNT: return ((DROID *)psObj)->psGroup->getNumMembers();
+	default: ASSERT(false, "Bad lazy property %d", property); return QScriptValue();
+	}
+}
+
+/// Script class for droids and structures. The object data is a variant holding a SlabHandle to the object,
+/// with the number of lazy properties it has, and the values of those that have been read so far. A lazy
+/// property reflects the object when it is first read, which is still the same object if it has since changed
+/// owner or been loaded into a transporter. It is undefined if the object has been freed by then.
+class ObjectClass : public QObject, public QScriptClass
+{
+public:
+	ObjectClass(QScriptEngine *engine);
+	QueryFlags queryProperty(const QScriptValue &object, const QScriptString &name, QueryFlags flags, uint *id);
+	QScriptValue property(const QScriptValue &object, const QScriptString &name, uint id);
+	QScriptValue::PropertyFlags propertyFlags(const QScriptValue &object, const QScriptString &name, uint id);
+	QScriptClassPropertyIterator *newIterator(const QScriptValue &object);
+	QString name() const { return "GameObject"; }
+
+	QScriptValue newObject(BASE_OBJECT *psObj, int numProperties);
+
+	QScriptString names[LAZY_COUNT];
+	QScriptString countName;
+};
+
+class ObjectClassIterator : public QScriptClassPropertyIterator
+{
+public:
+	ObjectClassIterator(const QScriptValue &object, ObjectClass *objectClass)
+		: QScriptClassPropertyIterator(object), objectClass(objectClass), index(0), last(-1)
+	{
+		count = object.data().property(objectClass->countName).toInt32();
+	}
+	bool hasNext() const { return index < count; }
+	void next() { last = index++; }
+	bool hasPrevious() const { return index > 0; }
+	void previous() { last = --index; }
+	void toFront() { index = 0; last = -1; }
+	void toBack() { index = count; last = -1; }
+	QScriptString name() const { return objectClass->names[last]; }
+	uint id() const { return last; }
+	QScriptValue::PropertyFlags flags() const { return QScriptValue::ReadOnly; }
+
+private:
+	ObjectClass *objectClass;
+	int index, last, count;
+};
+
+ObjectClass::ObjectClass(QScriptEngine *engine) : QObject(engine), QScriptClass(engine)
+{
+	for (int i = 0; i < LAZY_COUNT; i++)
+	{
+		names[i] = engine->toStringHandle(lazyPropertyNames[i]);
+	}
+	countName = engine->toStringHandle("count");
+}
+
+QScriptClass::QueryFlags ObjectClass::queryProperty(const QScriptValue &object, const QScriptString &name, QueryFlags flags, uint *id)
+{
+	int count = object.data().property(countName).toInt32();
+	for (int i = 0; i < count; i++)
+	{
+		if (names[i] == name)
+		{
+			*id = i;
+			return flags & HandlesReadAccess;
+		}
+	}
+	return 0;
+}
+
+QScriptValue ObjectClass::property(const QScriptValue &object, const QScriptString &name, uint id)
+{
+	QScriptValue data = object.data();
+	QScriptValue value = data.property(name);
+	if (!value.isValid())
+	{
+		BASE_OBJECT *psObj = data.toVariant().value<SlabHandle<BASE_OBJECT> >().get();
+		if (!psObj)
+		{
+			return engine()->undefinedValue();
+		}
+		value = lazyProperty(psObj, id, engine());
+		data.setProperty(name, value);
+	}
+	return value;
+}
+
+QScriptValue::PropertyFlags ObjectClass::propertyFlags(const QScriptValue &object, const QScriptString &name, uint id)
+{
+	return QScriptValue::ReadOnly;
+}
+
+QScriptClassPropertyIterator *ObjectClass::newIterator(const QScriptValue &object)
+{
+	return new ObjectClassIterator(object, this);
+}
+
+/// Creates a script object for a droid or structure with the first numProperties lazy properties.
+QScriptValue ObjectClass::newObject(BASE_OBJECT *psObj, int numProperties)
+{
+	QScriptValue data = engine()->newVariant(QVariant::fromValue(SlabHandle<BASE_OBJECT>(psObj)));
+	data.setProperty(countName, numProperties);
+	return engine()->newObject(this, data);
+}
+
+static QHash<QScriptEngine *, ObjectClass *> objectClasses;
+
+static void convObjBase(BASE_OBJECT *psObj, QScriptEngine *engine, QScriptValue &value);
+
+/// Sets the properties droids and structures have in common, other than the lazy ones.
+static void convWeaponObj(BASE_OBJECT *psObj, QScriptEngine *engine, QScriptValue &value)
+{
+	bool isDroid = psObj->type == OBJ_DROID;
+	bool aa, ga, indirect;
+	int range;
+
+	convObjBase(psObj, engine, value);
+	objWeaponInfo(psObj, aa, ga, indirect, range);
+	value.setProperty("armour", objArmour(psObj, WC_KINETIC), QScriptValue::ReadOnly);
+	value.setProperty("thermal", objArmour(psObj, WC_HEAT), QScriptValue::ReadOnly);
+	value.setProperty("name", objInfo(psObj), QScriptValue::ReadOnly);
+	value.setProperty("isCB", isDroid ? cbSensorDroid((DROID *)psObj) : structCBSensor((STRUCTURE *)psObj), QScriptValue::ReadOnly);
+	value.setProperty("isSensor", isDroid ? standardSensorDroid((DROID *)psObj) : structStandardSensor((STRUCTURE *)psObj), QScriptValue::ReadOnly);
+	value.setProperty("canHitAir", aa, QScriptValue::ReadOnly);
+	value.setProperty("canHitGround", ga, QScriptValue::ReadOnly);
+	value.setProperty("hasIndirect", indirect, QScriptValue::ReadOnly);
+	value.setProperty("isRadarDetector", objRadarDetector(psObj), QScriptValue::ReadOnly);
+	if (range >= 0 || !isDroid)
+	{
+		value.setProperty("range", range, QScriptValue::ReadOnly);
+	}
+	else
+	{
+		value.setProperty("range", QScriptValue::NullValue);
+	}
+}
+
 //;; \subsection{Research}
 //;; Describes a research item. The following properties are defined:
 //;; \begin{description}
@@ -342,29 +559,8 @@ QScriptValue convResearch(RESEARCH *psResearch, QScriptEngine *engine, int playe
 //;; \end{description}
 QScriptValue convStructure(STRUCTURE *psStruct, QScriptEngine *engine)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	for (int i = 0; i < psStruct->numWeaps; i++)
-	{
-		if (psStruct->asWeaps[i].nStat)
-		{
-			WEAPON_STATS *psWeap = &asWeaponStats[psStruct->asWeaps[i].nStat];
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX((int)psWeap->upgrade[psStruct->player].maxRange, range);
-		}
-	}
-	QScriptValue value = convObj(psStruct, engine);
-	value.setProperty("isCB", structCBSensor(psStruct), QScriptValue::ReadOnly);
-	value.setProperty("isSensor", structStandardSensor(psStruct), QScriptValue::ReadOnly);
-	value.setProperty("canHitAir", aa, QScriptValue::ReadOnly);
-	value.setProperty("canHitGround", ga, QScriptValue::ReadOnly);
-	value.setProperty("hasIndirect", indirect, QScriptValue::ReadOnly);
-	value.setProperty("isRadarDetector", objRadarDetector(psStruct), QScriptValue::ReadOnly);
-	value.setProperty("range", range, QScriptValue::ReadOnly);
+	QScriptValue value = objectClasses.value(engine)->newObject(psStruct, LAZY_STRUCTURE_COUNT);
+	convWeaponObj(psStruct, engine, value);
 	value.setProperty("status", (int)psStruct->status, QScriptValue::ReadOnly);
 	value.setProperty("health", 100 * psStruct->body / MAX(1, structureBody(psStruct)), QScriptValue::ReadOnly);
 	value.setProperty("cost", psStruct->pStructureType->powerToBuild, QScriptValue::ReadOnly);
@@ -399,18 +595,6 @@ QScriptValue convStructure(STRUCTURE *psStruct, QScriptEngine *engine)
 	{
 		value.setProperty("modules", QScriptValue::NullValue);
 	}
-	QScriptValue weaponlist = engine->newArray(psStruct->numWeaps);
-	for (int j = 0; j < psStruct->numWeaps; j++)
-	{
-		QScriptValue weapon = engine->newObject();
-		const WEAPON_STATS *psStats = asWeaponStats + psStruct->asWeaps[j].nStat;
-		weapon.setProperty("fullname", psStats->name, QScriptValue::ReadOnly);
-		weapon.setProperty("name", psStats->id, QScriptValue::ReadOnly); // will be changed to contain full name
-		weapon.setProperty("id", psStats->id, QScriptValue::ReadOnly);
-		weapon.setProperty("lastFired", psStruct->asWeaps[j].lastFired, QScriptValue::ReadOnly);
-		weaponlist.setProperty(j, weapon, QScriptValue::ReadOnly);
-	}
-	value.setProperty("weapons", weaponlist, QScriptValue::ReadOnly);
 	return value;
 }
 
@@ -431,6 +615,19 @@ QScriptValue convFeature(FEATURE *psFeature, QScriptEngine *engine)
 	return value;
 }
 
+/// Returns the droid type as scripts see it.
+static DROID_TYPE scriptDroidType(DROID_TYPE type)
+{
+	switch (type) // hide some engine craziness
+	{
+	case DROID_CYBORG_CONSTRUCT: return DROID_CONSTRUCT;
+	case DROID_CYBORG_SUPER: return DROID_CYBORG;
+	case DROID_DEFAULT: return DROID_WEAPON;
+	case DROID_CYBORG_REPAIR: return DROID_REPAIR;
+	default: return type;
+	}
+}
+
 //;; \subsection{Droid}
 //;; Describes a droid. It inherits all the properties of the base object (see below).
 //;; In addition, the following properties are defined:
@@ -498,84 +695,24 @@ QScriptValue convFeature(FEATURE *psFeature, QScriptEngine *engine)
 //;; \end{description}
 QScriptValue convDroid(DROID *psDroid, QScriptEngine *engine)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	const BODY_STATS *psBodyStats = &asBodyStats[psDroid->asBits[COMP_BODY]];
-
-	for (int i = 0; i < psDroid->numWeaps; i++)
-	{
-		if (psDroid->asWeaps[i].nStat)
-		{
-			WEAPON_STATS *psWeap = &asWeaponStats[psDroid->asWeaps[i].nStat];
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX((int)psWeap->upgrade[psDroid->player].maxRange, range);
-		}
-	}
-	DROID_TYPE type = psDroid->droidType;
-	QScriptValue value = convObj(psDroid, engine);
+	bool transporter = psDroid->droidType == DROID_TRANSPORTER || psDroid->droidType == DROID_SUPERTRANSPORTER;
+	QScriptValue value = objectClasses.value(engine)->newObject(psDroid, transporter ? LAZY_COUNT : LAZY_DROID_COUNT);
+	convWeaponObj(psDroid, engine, value);
 	value.setProperty("action", (int)psDroid->action, QScriptValue::ReadOnly);
-	if (range >= 0)
-	{
-		value.setProperty("range", range, QScriptValue::ReadOnly);
-	}
-	else
-	{
-		value.setProperty("range", QScriptValue::NullValue);
-	}
 	value.setProperty("order", (int)psDroid->order.type, QScriptValue::ReadOnly);
-	value.setProperty("cost", calcDroidPower(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("hasIndirect", indirect, QScriptValue::ReadOnly);
-	switch (psDroid->droidType) // hide some engine craziness
-	{
-	case DROID_CYBORG_CONSTRUCT:
-		type = DROID_CONSTRUCT; break;
-	case DROID_CYBORG_SUPER:
-		type = DROID_CYBORG; break;
-	case DROID_DEFAULT:
-		type = DROID_WEAPON; break;
-	case DROID_CYBORG_REPAIR:
-		type = DROID_REPAIR; break;
-	default:
-		break;
-	}
-	value.setProperty("bodySize", psBodyStats->size, QScriptValue::ReadOnly);
-	if (psDroid->droidType == DROID_TRANSPORTER || psDroid->droidType == DROID_SUPERTRANSPORTER)
-	{
-		value.setProperty("cargoCapacity", TRANSPORTER_CAPACITY, QScriptValue::ReadOnly);
-		value.setProperty("cargoLeft", calcRemainingCapacity(psDroid), QScriptValue::ReadOnly);
-		value.setProperty("cargoCount", psDroid->psGroup->getNumMembers(), QScriptValue::ReadOnly);
-	}
-	value.setProperty("isRadarDetector", objRadarDetector(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("isCB", cbSensorDroid(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("isSensor", standardSensorDroid(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("canHitAir", aa, QScriptValue::ReadOnly);
-	value.setProperty("canHitGround", ga, QScriptValue::ReadOnly);
+	value.setProperty("bodySize", asBodyStats[psDroid->asBits[COMP_BODY]].size, QScriptValue::ReadOnly);
 	value.setProperty("isVTOL", isVtolDroid(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("droidType", (int)type, QScriptValue::ReadOnly);
+	value.setProperty("droidType", (int)scriptDroidType(psDroid->droidType), QScriptValue::ReadOnly);
 	value.setProperty("experience", (double)psDroid->experience / 65536.0, QScriptValue::ReadOnly);
 	value.setProperty("health", 100.0 / (double)psDroid->originalBody * (double)psDroid->body, QScriptValue::ReadOnly);
 	value.setProperty("body", asBodyStats[psDroid->asBits[COMP_BODY]].id, QScriptValue::ReadOnly);
 	value.setProperty("propulsion", asPropulsionStats[psDroid->asBits[COMP_PROPULSION]].id, QScriptValue::ReadOnly);
 	value.setProperty("armed", 0.0, QScriptValue::ReadOnly); // deprecated!
-	QScriptValue weaponlist = engine->newArray(psDroid->numWeaps);
-	for (int j = 0; j < psDroid->numWeaps; j++)
+	value.setProperty("cargoSize", transporterSpaceRequired(psDroid), QScriptValue::ReadOnly);
+	if (transporter)
 	{
-		int armed = droidReloadBar(psDroid, &psDroid->asWeaps[j], j);
-		QScriptValue weapon = engine->newObject();
-		const WEAPON_STATS *psStats = asWeaponStats + psDroid->asWeaps[j].nStat;
-		weapon.setProperty("fullname", psStats->name, QScriptValue::ReadOnly);
-		weapon.setProperty("id", psStats->id, QScriptValue::ReadOnly); // will be changed to full name
-		weapon.setProperty("name", psStats->id, QScriptValue::ReadOnly);
-		weapon.setProperty("lastFired", psDroid->asWeaps[j].lastFired, QScriptValue::ReadOnly);
-		weapon.setProperty("armed", armed, QScriptValue::ReadOnly);
-		weaponlist.setProperty(j, weapon, QScriptValue::ReadOnly);
+		value.setProperty("cargoCapacity", TRANSPORTER_CAPACITY, QScriptValue::ReadOnly);
 	}
-	value.setProperty("weapons", weaponlist, QScriptValue::ReadOnly);
-	value.setProperty("cargoSize", transporterSpaceRequired(psDroid), QScriptValue::ReadOnly);
 	return value;
 }
 
@@ -597,20 +734,16 @@ QScriptValue convDroid(DROID *psDroid, QScriptEngine *engine)
 //;; \item[thermal] Amount of thermal protection that protect against heat based weapons.
 //;; \item[born] The game time at which this object was produced or came into the world. (3.2+ only)
 //;; \end{description}
-QScriptValue convObj(BASE_OBJECT *psObj, QScriptEngine *engine)
+/// Sets the base object properties that are cheap to work out.
+static void convObjBase(BASE_OBJECT *psObj, QScriptEngine *engine, QScriptValue &value)
 {
-	QScriptValue value = engine->newObject();
-	ASSERT_OR_RETURN(value, psObj, "No object for conversion");
 	value.setProperty("id", psObj->id, QScriptValue::ReadOnly);
 	value.setProperty("x", map_coord(psObj->pos.x), QScriptValue::ReadOnly);
 	value.setProperty("y", map_coord(psObj->pos.y), QScriptValue::ReadOnly);
 	value.setProperty("z", map_coord(psObj->pos.z), QScriptValue::ReadOnly);
 	value.setProperty("player", psObj->player, QScriptValue::ReadOnly);
-	value.setProperty("armour", objArmour(psObj, WC_KINETIC), QScriptValue::ReadOnly);
-	value.setProperty("thermal", objArmour(psObj, WC_HEAT), QScriptValue::ReadOnly);
 	value.setProperty("type", psObj->type, QScriptValue::ReadOnly);
 	value.setProperty("selected", psObj->selected, QScriptValue::ReadOnly);
-	value.setProperty("name", objInfo(psObj), QScriptValue::ReadOnly);
 	value.setProperty("born", psObj->born, QScriptValue::ReadOnly);
 	GROUPMAP *psMap = groups.value(engine);
 	if (psMap->contains(psObj))
@@ -622,6 +755,16 @@ QScriptValue convObj(BASE_OBJECT *psObj, QScriptEngine *engine)
 	{
 		value.setProperty("group", QScriptValue::NullValue);
 	}
+}
+
+QScriptValue convObj(BASE_OBJECT *psObj, QScriptEngine *engine)
+{
+	QScriptValue value = engine->newObject();
+	ASSERT_OR_RETURN(value, psObj, "No object for conversion");
+	convObjBase(psObj, engine, value);
+	value.setProperty("armour", objArmour(psObj, WC_KINETIC), QScriptValue::ReadOnly);
+	value.setProperty("thermal", objArmour(psObj, WC_HEAT), QScriptValue::ReadOnly);
+	value.setProperty("name", objInfo(psObj), QScriptValue::ReadOnly);
 	return value;
 }
 
@@ -1211,30 +1354,17 @@ static QScriptValue js_findResearch(QScriptContext *context, QScriptEngine *engi
 		return engine->newArray(0); // return empty array
 	}
 	debug(LOG_SCRIPT, "Find reqs for %s for player %d", resName.toUtf8().constData(), player);
-	// Go down the requirements list for the desired tech
-	QList<RESEARCH *> reslist;
-	RESEARCH *cur = psTarget;
-	while (cur)
+	if (!(plrRes->ResearchStatus & RESEARCHED))
 	{
-		if (!(asPlayerResList[player][cur->index].ResearchStatus & RESEARCHED))
-		{
-			debug(LOG_SCRIPT, "Added research in %d's %s for %s", player, getID(cur), getID(psTarget));
-			list.append(cur);
-		}
-		RESEARCH *prev = cur;
-		cur = NULL;
-		if (prev->pPRList.size())
-		{
-			cur = &asResearch[prev->pPRList[0]]; // get first pre-req
-		}
-		for (int i = 1; i < prev->pPRList.size(); i++)
-		{
-			// push any other pre-reqs on the stack
-			reslist += &asResearch[prev->pPRList[i]];
-		}
-		if (!cur && reslist.size())
+		list.append(psTarget);
+	}
+	std::vector<int> const &prereqs = researchPrerequisites(psTarget->index);
+	for (int i = 0; i < prereqs.size(); i++)
+	{
+		if (!(asPlayerResList[player][prereqs[i]].ResearchStatus & RESEARCHED))
 		{
-			cur = reslist.takeFirst(); // retrieve options from the stack
+			debug(LOG_SCRIPT, "Added research in %d's %s for %s", player, getID(&asResearch[prereqs[i]]), getID(psTarget));
+			list.append(&asResearch[prereqs[i]]);
 		}
 	}
 	QScriptValue retval = engine->newArray(list.size());
@@ -1245,6 +1375,27 @@ static QScriptValue js_findResearch(QScriptContext *context, QScriptEngine *engi
 	return retval;
 }	
 
+/// Whether pursueResearch may start the topic, that is if nobody sharing research with the player has it yet.
+static bool pursueResearchStep(int topic, int player)
+{
+	if (!researchAvailable(topic, player, ModeQueue))
+	{
+		return false;
+	}
+	for (int i = 0; i < game.maxPlayers; i++)
+	{
+		if (i == player || (aiCheckAlliances(player, i) && alliancesSharedResearch(game.alliance)))
+		{
+			int bits = asPlayerResList[i][topic].ResearchStatus;
+			if ((bits & STARTED_RESEARCH) || (bits & STARTED_RESEARCH_PENDING) || (bits & RESBITS_PENDING_ONLY) || (bits & RESEARCHED))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 //-- \subsection{pursueResearch(lab, research)}
 //-- Start researching the first available technology on the way to the given technology.
 //-- First parameter is the structure to research in, which must be a research lab. The
@@ -1296,53 +1447,20 @@ static QScriptValue js_pursueResearch(QScriptContext *context, QScriptEngine *en
 	SCRIPT_ASSERT(context, psStruct->pStructureType->type == REF_RESEARCH, "Not a research lab: %s", objInfo(psStruct));
 	RESEARCH_FACILITY *psResLab = (RESEARCH_FACILITY *)psStruct->pFunctionality;
 	SCRIPT_ASSERT(context, psResLab->psSubject == NULL, "Research lab not ready");
-	// Go down the requirements list for the desired tech
-	QList<RESEARCH *> reslist;
-	RESEARCH *cur = psResearch;
-	int iterations = 0;  // Only used to assert we're not stuck in the loop.
-	while (cur)
+	// Find the first topic on the way to the desired tech that we can start
+	int topic = researchNextStep(psResearch->index, player, pursueResearchStep);
+	if (topic >= 0)
 	{
-		if (researchAvailable(cur->index, player, ModeQueue))
-		{
-			bool started = false;
-			for (int i = 0; i < game.maxPlayers; i++)
-			{
-				if (i == player || (aiCheckAlliances(player, i) && alliancesSharedResearch(game.alliance)))
-				{
-					int bits = asPlayerResList[i][cur->index].ResearchStatus;
-					started = started || (bits & STARTED_RESEARCH) || (bits & STARTED_RESEARCH_PENDING)
-							|| (bits & RESBITS_PENDING_ONLY) || (bits & RESEARCHED);
-				}
-			}
-			if (!started) // found relevant item on the path?
-			{
-				sendResearchStatus(psStruct, cur->index, player, true);
+		RESEARCH *cur = &asResearch[topic];
+		sendResearchStatus(psStruct, cur->index, player, true);
 #if defined (DEBUG)
-				char sTemp[128];
-				sprintf(sTemp, "player:%d starts topic from script: %s", player, getID(cur));
-				NETlogEntry(sTemp, SYNC_FLAG, 0);
+		char sTemp[128];
+		sprintf(sTemp, "player:%d starts topic from script: %s", player, getID(cur));
+		NETlogEntry(sTemp, SYNC_FLAG, 0);
 #endif
-				debug(LOG_SCRIPT, "Started research in %d's %s(%d) of %s", player, 
-				      objInfo(psStruct), psStruct->id, getName(cur));
-				return QScriptValue(true);
-			}
-		}
-		RESEARCH *prev = cur;
-		cur = NULL;
-		if (!prev->pPRList.empty())
-		{
-			cur = &asResearch[prev->pPRList[0]]; // get first pre-req
-		}
-		for (int i = 1; i < prev->pPRList.size(); i++)
-		{
-			// push any other pre-reqs on the stack
-			reslist += &asResearch[prev->pPRList[i]];
-		}
-		if (!cur && !reslist.empty())
-		{
-			cur = reslist.takeFirst(); // retrieve options from the stack
-		}
-		ASSERT_OR_RETURN(QScriptValue(false), ++iterations < asResearch.size()*100 || !cur, "Possible cyclic dependencies in prerequisites, possibly of research \"%s\".", getName(cur));
+		debug(LOG_SCRIPT, "Started research in %d's %s(%d) of %s", player,
+		      objInfo(psStruct), psStruct->id, getName(cur));
+		return QScriptValue(true);
 	}
 	debug(LOG_SCRIPT, "No research topic found for %s(%d)", objInfo(psStruct), psStruct->id);
 	return QScriptValue(false); // none found
@@ -1377,10 +1495,11 @@ static QScriptValue js_enumResearch(QScriptContext *context, QScriptEngine *engi
 {
 	QList<RESEARCH *> reslist;
 	int player = engine->globalObject().property("me").toInt32();
-	for (int i = 0; i < asResearch.size(); i++)
+	std::set<int> const &candidates = researchFrontier(player);
+	for (std::set<int>::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
 	{
-		RESEARCH *psResearch = &asResearch[i];
-		if (!IsResearchCompleted(&asPlayerResList[player][i]) && researchAvailable(i, player, ModeQueue))
+		RESEARCH *psResearch = &asResearch[*i];
+		if (!IsResearchCompleted(&asPlayerResList[player][*i]) && researchAvailable(*i, player, ModeQueue))
 		{
 			reslist += psResearch;
 		}
@@ -2892,6 +3011,7 @@ static QScriptValue js_hackChangeMe(QScriptContext *context, QScriptEngine *engi
 	int me = context->argument(0).toInt32();
 	SCRIPT_ASSERT_PLAYER(context, me);
 	engine->globalObject().setProperty("me", me);
+	jsRefreshHandlers(engine);  // so that events triggered before this call returns go to the new player
 	return QScriptValue();
 }
 
@@ -2903,6 +3023,7 @@ static QScriptValue js_receiveAllEvents(QScriptContext *context, QScriptEngine *
 	{
 		bool value = context->argument(0).toBool();
 		engine->globalObject().setProperty("isReceivingAllEvents", value, QScriptValue::ReadOnly | QScriptValue::Undeletable);
+		jsRefreshHandlers(engine);
 	}
 	return engine->globalObject().property("isReceivingAllEvents");
 }
@@ -3224,52 +3345,157 @@ static QScriptValue js_loadLevel(QScriptContext *context, QScriptEngine *)
 	return QScriptValue();
 }
 
-//-- \subsection{enumRange(x, y, range[, filter[, seen]])}
-//-- Returns an array of game objects seen within range of given position that passes the optional filter
-//-- which can be one of a player index, ALL_PLAYERS, ALLIES or ENEMIES. By default, filter is 
-//-- ALL_PLAYERS. Finally an optional parameter can specify whether only visible objects should be 
-//-- returned; by default only visible objects are returned. Calling this function is much faster than 
-//-- iterating over all game objects using other enum functions. (3.2+ only)
-static QScriptValue js_enumRange(QScriptContext *context, QScriptEngine *engine)
+/// Filter for enumRange and enumArea, applied to the grid query before any objects are converted.
+struct ENUM_FILTER
 {
-	int player = engine->globalObject().property("me").toInt32();
-	int x = world_coord(context->argument(0).toInt32());
-	int y = world_coord(context->argument(1).toInt32());
-	int range = world_coord(context->argument(2).toInt32());
-	int filter = ALL_PLAYERS;
-	bool seen = true;
-	if (context->argumentCount() > 3)
+	int player;             ///< Player index, ALL_PLAYERS, ALLIES or ENEMIES.
+	bool seen;              ///< Only return objects visible to the script's player.
+	unsigned types;         ///< Bit mask of accepted object types.
+	unsigned droidTypes;    ///< Bit mask of accepted droid types, as returned by scriptDroidType().
+	bool sort;              ///< Sort results by distance, nearest first.
+};
+
+/// Turns a single value or an array of values below max into a bit mask. Returns 0 if any value is out of range.
+static unsigned enumFilterMask(const QScriptValue &value, int max)
+{
+	unsigned mask = 0;
+	int length = value.isArray() ? value.property("length").toInt32() : 1;
+	for (int i = 0; i < length; i++)
 	{
-		filter = context->argument(3).toInt32();
+		int bit = value.isArray() ? value.property(i).toInt32() : value.toInt32();
+		if (bit < 0 || bit >= max)
+		{
+			return 0;
+		}
+		mask |= 1 << bit;
 	}
-	if (context->argumentCount() > 4)
+	return mask;
+}
+
+/// Reads the optional filter arguments starting at argument \a param, either as a player filter followed
+/// by a seen flag, or as a single filter object. Only fails for filter objects with bad types or droid
+/// types. A player which isn't a player index, ALL_PLAYERS, ALLIES or ENEMIES is not an error, it just
+/// matches nothing, as it always did.
+static bool enumFilterParse(QScriptContext *context, int param, ENUM_FILTER &filter)
+{
+	filter.player = ALL_PLAYERS;
+	filter.seen = true;
+	filter.types = (1 << OBJ_DROID) | (1 << OBJ_STRUCTURE) | (1 << OBJ_FEATURE);
+	filter.droidTypes = (1 << DROID_ANY) - 1;
+	filter.sort = false;
+	if (context->argumentCount() <= param)
 	{
-		seen = context->argument(4).toBool();
+		return true;
 	}
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(x, y, range);
-	QList<BASE_OBJECT *> list;
+	QScriptValue arg = context->argument(param);
+	if (!arg.isObject())
+	{
+		filter.player = arg.toInt32();
+		if (context->argumentCount() > param + 1)
+		{
+			filter.seen = context->argument(param + 1).toBool();
+		}
+		return true;
+	}
+	if (arg.property("player").isValid())
+	{
+		filter.player = arg.property("player").toInt32();
+	}
+	if (arg.property("seen").isValid())
+	{
+		filter.seen = arg.property("seen").toBool();
+	}
+	if (arg.property("droidType").isValid())
+	{
+		filter.types = 1 << OBJ_DROID;
+		if (arg.property("droidType").toInt32() != DROID_ANY)
+		{
+			filter.droidTypes = enumFilterMask(arg.property("droidType"), DROID_ANY);
+		}
+	}
+	if (arg.property("type").isValid())
+	{
+		filter.types = enumFilterMask(arg.property("type"), OBJ_FEATURE + 1);
+	}
+	filter.sort = arg.property("sort").toBool();
+	return filter.types != 0 && filter.droidTypes != 0;
+}
+
+struct EnumDistanceLess
+{
+	EnumDistanceLess(int x, int y) : x(x), y(y) {}
+	bool operator()(BASE_OBJECT const *a, BASE_OBJECT const *b) const
+	{
+		return distance(a) < distance(b);
+	}
+	int64_t distance(BASE_OBJECT const *psObj) const
+	{
+		int64_t dx = psObj->pos.x - x, dy = psObj->pos.y - y;
+		return dx * dx + dy * dy;
+	}
+	int x, y;
+};
+
+/// Converts the objects in the grid list that pass the filter, optionally sorted by distance to (x, y).
+static QScriptValue enumFiltered(GridList const &gridList, ENUM_FILTER const &filter, int x, int y, QScriptEngine *engine)
+{
+	int player = engine->globalObject().property("me").toInt32();
+	static std::vector<BASE_OBJECT *> list;  // static to avoid allocations.
+	list.clear();
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
-		if ((psObj->visible[player] || !seen) && !psObj->died)
+		if ((psObj->visible[player] || !filter.seen) && !psObj->died && (filter.types & (1 << psObj->type))
+		    && (psObj->type != OBJ_DROID || (filter.droidTypes & (1 << scriptDroidType(((DROID *)psObj)->droidType)))))
 		{
-			if ((filter >= 0 && psObj->player == filter) || filter == ALL_PLAYERS
-			    || (filter == ALLIES && psObj->type != OBJ_FEATURE && aiCheckAlliances(psObj->player, player))
-			    || (filter == ENEMIES && psObj->type != OBJ_FEATURE && !aiCheckAlliances(psObj->player, player)))
+			if ((filter.player >= 0 && psObj->player == filter.player) || filter.player == ALL_PLAYERS
+			    || (filter.player == ALLIES && psObj->type != OBJ_FEATURE && aiCheckAlliances(psObj->player, player))
+			    || (filter.player == ENEMIES && psObj->type != OBJ_FEATURE && !aiCheckAlliances(psObj->player, player)))
 			{
-				list.append(psObj);
+				list.push_back(psObj);
 			}
 		}
 	}
+	if (filter.sort)
+	{
+		std::stable_sort(list.begin(), list.end(), EnumDistanceLess(x, y));
+	}
 	QScriptValue value = engine->newArray(list.size());
-	for (int i = 0; i < list.size(); i++)
+	for (unsigned i = 0; i < list.size(); i++)
 	{
 		value.setProperty(i, convMax(list[i], engine), QScriptValue::ReadOnly);
 	}
 	return value;
 }
 
+//-- \subsection{enumRange(x, y, range[, filter[, seen]])}
+//-- Returns an array of game objects seen within range of given position that passes the optional filter
+//-- which can be one of a player index, ALL_PLAYERS, ALLIES or ENEMIES. By default, filter is 
+//-- ALL_PLAYERS. Finally an optional parameter can specify whether only visible objects should be 
+//-- returned; by default only visible objects are returned. Calling this function is much faster than 
+//-- iterating over all game objects using other enum functions. (3.2+ only)
+//-- The filter may instead be an object with any of the following properties, which are applied before
+//-- the objects are converted, so it is faster than filtering the results in the script. (3.2+ only)
+//-- \begin{description}
+//-- \item[player] A player index, ALL_PLAYERS, ALLIES or ENEMIES. The default is ALL_PLAYERS.
+//-- \item[type] An object type, such as DROID, or an array of object types.
+//-- \item[droidType] A droid type, such as DROID_CONSTRUCT, or an array of droid types. If set, and
+//-- type is not, only droids are returned.
+//-- \item[seen] Whether only visible objects should be returned. The default is true.
+//-- \item[sort] If true, the objects are sorted by distance to the given position, nearest first.
+//-- \end{description}
+static QScriptValue js_enumRange(QScriptContext *context, QScriptEngine *engine)
+{
+	int x = world_coord(context->argument(0).toInt32());
+	int y = world_coord(context->argument(1).toInt32());
+	int range = world_coord(context->argument(2).toInt32());
+	ENUM_FILTER filter;
+	SCRIPT_ASSERT(context, enumFilterParse(context, 3, filter), "Bad filter");
+	static GridList gridList;  // static to avoid allocations.
+	gridList = gridStartIterate(x, y, range);
+	return enumFiltered(gridList, filter, x, y, engine);
+}
+
 //-- \subsection{enumArea(<x1, y1, x2, y2 | label>[, filter[, seen]])}
 //-- Returns an array of game objects seen within the given area that passes the optional filter
 //-- which can be one of a player index, ALL_PLAYERS, ALLIES or ENEMIES. By default, filter is 
@@ -3277,12 +3503,11 @@ static QScriptValue js_enumRange(QScriptContext *context, QScriptEngine *engine)
 //-- returned; by default only visible objects are returned. The label can either be actual 
 //-- positions or a label to an AREA. Calling this function is much faster than iterating over all
 //-- game objects using other enum functions. (3.2+ only)
+//-- The filter may instead be a filter object, as for enumRange(). If sorted, the objects are sorted
+//-- by distance to the middle of the area. (3.2+ only)
 static QScriptValue js_enumArea(QScriptContext *context, QScriptEngine *engine)
 {
-	int player = engine->globalObject().property("me").toInt32();
 	int x1, y1, x2, y2, nextparam;
-	int filter = ALL_PLAYERS;
-	bool seen = true;
 	if (context->argument(0).isString())
 	{
 		QString label = context->argument(0).toString();
@@ -3303,36 +3528,11 @@ static QScriptValue js_enumArea(QScriptContext *context, QScriptEngine *engine)
 		y2 = world_coord(context->argument(3).toInt32());
 		nextparam = 4;
 	}
-	if (context->argumentCount() > nextparam++)
-	{
-		filter = context->argument(nextparam - 1).toInt32();
-	}
-	if (context->argumentCount() > nextparam++)
-	{
-		seen = context->argument(nextparam - 1).toBool();
-	}
+	ENUM_FILTER filter;
+	SCRIPT_ASSERT(context, enumFilterParse(context, nextparam, filter), "Bad filter");
 	static GridList gridList;  // static to avoid allocations.
 	gridList = gridStartIterateArea(x1, y1, x2, y2);
-	QList<BASE_OBJECT *> list;
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
-	{
-		BASE_OBJECT *psObj = *gi;
-		if ((psObj->visible[player] || !seen) && !psObj->died)
-		{
-			if ((filter >= 0 && psObj->player == filter) || filter == ALL_PLAYERS
-			    || (filter == ALLIES && psObj->type != OBJ_FEATURE && aiCheckAlliances(psObj->player, player))
-			    || (filter == ENEMIES && psObj->type != OBJ_FEATURE && !aiCheckAlliances(psObj->player, player)))
-			{
-				list.append(psObj);
-			}
-		}
-	}
-	QScriptValue value = engine->newArray(list.size());
-	for (int i = 0; i < list.size(); i++)
-	{
-		value.setProperty(i, convMax(list[i], engine), QScriptValue::ReadOnly);
-	}
-	return value;
+	return enumFiltered(gridList, filter, (x1 + x2) / 2, (y1 + y2) / 2, engine);
 }
 
 //-- \subsection{addBeacon(x, y, target player[, message])}
@@ -3876,6 +4076,7 @@ bool unregisterFunctions(QScriptEngine *engine)
 	GROUPMAP *psMap = groups.value(engine);
 	int num = groups.remove(engine);
 	delete psMap;
+	objectClasses.remove(engine);  // Deleted along with the engine, which may still hold objects using it.
 	ASSERT(num == 1, "Number of engines removed from group map is %d!", num);
 	labels.clear();
 	labelModel = NULL;
@@ -4167,6 +4368,9 @@ bool registerFunctions(QScriptEngine *engine, QString scriptName)
 	GROUPMAP *psMap = new GROUPMAP;
 	groups.insert(engine, psMap);
 
+	// Create class for lazily converted droids and structures
+	objectClasses.insert(engine, new ObjectClass(engine));
+
 	/// Register 'Stats' object. It is a read-only representation of basic game component states.
 	//== \item[Stats] A sparse, read-only array containing rules information for game entity types.
 	//== (For now only the highest level member attributes are documented here. Use the 'jsdebug' cheat
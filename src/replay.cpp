@@ -0,0 +1,394 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * replay.cpp
+ *
+ * The settings at the start of a game, which the replay file keeps next to the game queues.
+ * Seeking replays the game from the start as fast as possible, since there is no way to
+ * save the whole game state, including the synchronised random numbers.
+ */
+#include "lib/framework/frame.h"
+#include "lib/framework/rational.h"
+#include "lib/framework/wzapp.h"
+#include "lib/gamelib/gtime.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
+
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include "replay.h"
+#include "ai.h"
+#include "console.h"
+#include "frontend.h"
+#include "levels.h"
+#include "main.h"
+#include "multiplay.h"
+#include "random.h"
+#include "warzoneconfig.h"
+
+#define REPLAY_FAST_SPEED 1000     ///< Game time modifier when fast-forwarding, more than the game can keep up with.
+#define REPLAY_FRAME_TIME 1000     ///< Real time between frames rendered, while fast-forwarding.
+
+static char replayFileName[PATH_MAX] = "";
+static uint32_t replaySeekTime = 0;
+static bool replayFast = false;
+static bool replayRecord = true;
+static bool replayFinished = false;
+static bool replayModified = false;        ///< Whether the game time modifier is set for fast-forwarding.
+static uint32_t replayStartTime = 0;       ///< Real time when the replay started.
+static uint32_t replayFrameTime = 0;       ///< Real time of the last frame rendered, while fast-forwarding.
+
+static void putUint32(std::vector<uint8_t> &settings, uint32_t v)
+{
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		settings.push_back(v >> shift);
+	}
+}
+
+static void putBytes(std::vector<uint8_t> &settings, void const *bytes, uint32_t length)
+{
+	putUint32(settings, length);
+	settings.insert(settings.end(), (uint8_t const *)bytes, (uint8_t const *)bytes + length);
+}
+
+static void putString(std::vector<uint8_t> &settings, char const *str)
+{
+	putBytes(settings, str, strlen(str));
+}
+
+// Reading past the end gives zeros, the caller checks pos <= settings.size() at the end.
+static uint32_t getUint32(std::vector<uint8_t> const &settings, size_t &pos)
+{
+	uint32_t v = 0;
+	for (unsigned n = 0; n < 4; ++n, ++pos)
+	{
+		v = v<<8 | (pos < settings.size() ? settings[pos] : 0);
+	}
+	return v;
+}
+
+// Truncates to size bytes, or to size - 1 characters, if a string.
+static void getBytes(std::vector<uint8_t> const &settings, size_t &pos, void *bytes, uint32_t size, bool string)
+{
+	uint32_t length = getUint32(settings, pos);
+	uint32_t copy = std::min(length, string ? size - 1 : size);
+	memset(bytes, 0, size);
+	if (pos <= settings.size() && copy <= settings.size() - pos)
+	{
+		memcpy(bytes, &settings[0] + pos, copy);
+	}
+	pos += length;
+}
+
+static std::vector<uint8_t> replayEncodeSettings(void)
+{
+	std::vector<uint8_t> settings;
+
+	putUint32(settings, gameSRandSeed());
+	putUint32(settings, selectedPlayer);
+	putString(settings, aLevelName);
+
+	putUint32(settings, game.type);
+	putString(settings, game.map);
+	putBytes(settings, game.hash.bytes, game.hash.Bytes);
+	putUint32(settings, game.maxPlayers);
+	putString(settings, game.name);
+	putUint32(settings, game.power);
+	putUint32(settings, game.base);
+	putUint32(settings, game.alliance);
+	putUint32(settings, game.scavengers);
+	putUint32(settings, game.mapHasScavengers);
+	putUint32(settings, game.isMapMod);
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		putUint32(settings, game.skDiff[i]);
+	}
+
+	for (unsigned i = 0; i < MAX_PLAYER_SLOTS; ++i)
+	{
+		putBytes(settings, alliances[i], MAX_PLAYER_SLOTS);
+	}
+
+	putUint32(settings, ingame.numStructureLimits);
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		putUint32(settings, ingame.pStructureLimits[i].id);
+		putUint32(settings, ingame.pStructureLimits[i].limit);
+	}
+	putUint32(settings, ingame.flags);
+
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		PLAYER const &p = NetPlay.players[i];
+		putString(settings, p.name);
+		putUint32(settings, p.position);
+		putUint32(settings, p.colour);
+		putUint32(settings, p.team);
+		putUint32(settings, p.allocated);
+		putUint32(settings, p.ai);
+		putUint32(settings, p.difficulty);
+	}
+
+	return settings;
+}
+
+static bool replayDecodeSettings(std::vector<uint8_t> const &settings)
+{
+	size_t pos = 0;
+
+	gameSRand(getUint32(settings, pos));
+	selectedPlayer = getUint32(settings, pos);
+	realSelectedPlayer = selectedPlayer;
+	getBytes(settings, pos, aLevelName, sizeof(aLevelName), true);
+
+	game.type = getUint32(settings, pos);
+	getBytes(settings, pos, game.map, sizeof(game.map), true);
+	getBytes(settings, pos, game.hash.bytes, game.hash.Bytes, false);
+	game.maxPlayers = getUint32(settings, pos);
+	getBytes(settings, pos, game.name, sizeof(game.name), true);
+	game.power = getUint32(settings, pos);
+	game.base = getUint32(settings, pos);
+	game.alliance = getUint32(settings, pos);
+	game.scavengers = getUint32(settings, pos);
+	game.mapHasScavengers = getUint32(settings, pos);
+	game.isMapMod = getUint32(settings, pos);
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		game.skDiff[i] = getUint32(settings, pos);
+	}
+
+	for (unsigned i = 0; i < MAX_PLAYER_SLOTS; ++i)
+	{
+		getBytes(settings, pos, alliances[i], MAX_PLAYER_SLOTS, false);
+	}
+
+	free(ingame.pStructureLimits);
+	ingame.pStructureLimits = NULL;
+	ingame.numStructureLimits = getUint32(settings, pos);
+	if (ingame.numStructureLimits > settings.size())
+	{
+		ingame.numStructureLimits = 0;  // Broken, and don't try to allocate it.
+		pos = settings.size() + 1;
+	}
+	if (ingame.numStructureLimits)
+	{
+		ingame.pStructureLimits = (MULTISTRUCTLIMITS *)malloc(ingame.numStructureLimits * sizeof(MULTISTRUCTLIMITS));
+	}
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		ingame.pStructureLimits[i].id = getUint32(settings, pos);
+		ingame.pStructureLimits[i].limit = getUint32(settings, pos);
+	}
+	ingame.flags = getUint32(settings, pos);
+
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		PLAYER &p = NetPlay.players[i];
+		getBytes(settings, pos, p.name, sizeof(p.name), true);
+		p.position = getUint32(settings, pos);
+		p.colour = getUint32(settings, pos);
+		p.team = getUint32(settings, pos);
+		p.allocated = getUint32(settings, pos);
+		p.ai = getUint32(settings, pos);
+		p.difficulty = getUint32(settings, pos);
+	}
+
+	if (pos > settings.size() || selectedPlayer >= MAX_PLAYERS || game.maxPlayers > MAX_PLAYERS)
+	{
+		debug(LOG_ERROR, "The settings in the replay are broken.");
+		selectedPlayer = realSelectedPlayer = 0;
+		return false;
+	}
+	return true;
+}
+
+void replaySetPlayback(char const *fileName)
+{
+	ssprintf(replayFileName, "replay/%s", fileName);
+}
+
+void replaySetSeek(unsigned seconds)
+{
+	replaySeekTime = seconds * GAME_TICKS_PER_SEC;
+}
+
+void replaySetFast(bool fast)
+{
+	replayFast = fast;
+}
+
+void replaySetRecord(bool record)
+{
+	replayRecord = record;
+}
+
+/// Deletes the oldest recordings in the replay directory, until only keep are left. Their names start with the
+/// date and time they were recorded, so the oldest sort first.
+static void replayDeleteOldest(int keep)
+{
+	std::vector<std::string> replays;
+	char **files = PHYSFS_enumerateFiles("replay");
+	for (char **i = files; *i != NULL; ++i)
+	{
+		size_t length = strlen(*i);
+		if (length > strlen(".wzrp") && strcmp(*i + length - strlen(".wzrp"), ".wzrp") == 0)
+		{
+			replays.push_back(*i);
+		}
+	}
+	PHYSFS_freeList(files);
+
+	std::sort(replays.begin(), replays.end());
+	for (int i = 0; i + keep < (int)replays.size(); ++i)
+	{
+		std::string fileName = "replay/" + replays[i];
+		if (!PHYSFS_delete(fileName.c_str()))
+		{
+			debug(LOG_WARNING, "Could not delete old replay \"%s\": %s", fileName.c_str(), PHYSFS_getLastError());
+		}
+	}
+}
+
+bool replayPlaybackStart(void)
+{
+	if (replayFileName[0] == '\0')
+	{
+		return true;  // Not playing a replay.
+	}
+
+	std::vector<uint8_t> settings;
+	if (!NETreplayLoadStart(replayFileName, &settings))
+	{
+		return false;
+	}
+	if (!replayDecodeSettings(settings))
+	{
+		NETreplayLoadStop();
+		return false;
+	}
+	replayFileName[0] = '\0';
+
+	// Like a skirmish, but all the players are remote.
+	NetPlay.bComms = false;
+	NetPlay.isHost = true;
+	bMultiPlayer = true;
+	bMultiMessages = true;
+	ingame.localOptionsReceived = true;
+	ingame.localJoiningInProgress = false;
+
+	replayFinished = false;
+	replayStartTime = wzGetTicks();
+	SetGameMode(GS_NORMAL);
+	return true;
+}
+
+void replayRecordStart(void)
+{
+	if (!bMultiPlayer || NETisReplay() || getLevelLoadType() != GTYPE_SCENARIO_START)
+	{
+		return;  // Can't replay a campaign or a loaded game, without the state they started from.
+	}
+	if (!replayRecord || war_GetReplayFiles() == 0)
+	{
+		return;
+	}
+	replayDeleteOldest(war_GetReplayFiles() - 1);
+
+	time_t aclock;
+	time(&aclock);
+	struct tm *t = localtime(&aclock);
+	char fileName[PATH_MAX];
+	ssprintf(fileName, "replay/%04d%02d%02d_%02d%02d%02d-%s.wzrp", t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec, game.map);
+	NETreplaySaveStart(fileName, replayEncodeSettings());
+}
+
+void replayStop(void)
+{
+	NETreplaySaveStop();
+
+	if (NETisReplay())
+	{
+		NETreplayLoadStop();
+		gameTimeResetMod();
+		replayModified = false;
+	}
+}
+
+bool replayUpdate(void)
+{
+	if (!NETisReplay())
+	{
+		return true;
+	}
+
+	// The game queues only let the messages through when it's their time.
+	NETreplayLoadNetMessages(gameTime + GAME_TICKS_PER_SEC);
+
+	if (!replayFinished && NETreplayLoadFinished() && gameTime >= NETreplayLoadEndTime())
+	{
+		replayFinished = true;
+		debug(LOG_INFO, "Replay finished, %u ticks in %u ms.", gameTime / GAME_TICKS_PER_UPDATE, wzGetTicks() - replayStartTime);
+		if (replayFast)
+		{
+			return false;
+		}
+		addConsoleMessage(_("The replay has finished."), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+	}
+
+	bool fast = replayFastForward();
+	if (fast != replayModified)
+	{
+		if (fast)
+		{
+			gameTimeSetMod(Rational(REPLAY_FAST_SPEED));
+		}
+		else
+		{
+			gameTimeResetMod();
+			gameTimeCatchUpGraphics();
+		}
+		replayModified = fast;
+	}
+	return true;
+}
+
+bool replayFastForward(void)
+{
+	return NETisReplay() && !replayFinished && (replayFast || gameTime < replaySeekTime);
+}
+
+bool replaySkipRender(void)
+{
+	if (!replayFastForward())
+	{
+		return false;
+	}
+	if (realTime - replayFrameTime < REPLAY_FRAME_TIME)
+	{
+		return true;
+	}
+	replayFrameTime = realTime;
+	gameTimeCatchUpGraphics();  // Show where the game is now.
+	return false;
+}
@@ -0,0 +1,48 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording skirmish and multiplayer games to the replay directory, and playing them back.
+ *
+ *  A replay is watched as an observer: no player is our responsibility, so nothing we do
+ *  reaches the game queues, which only get the recorded messages.
+ */
+
+#ifndef __INCLUDED_SRC_REPLAY_H__
+#define __INCLUDED_SRC_REPLAY_H__
+
+void replaySetPlayback(char const *fileName);   ///< Plays the given replay, instead of showing the title screen.
+void replaySetSeek(unsigned seconds);           ///< Fast-forwards the replay to the given game time, before playing it at normal speed.
+void replaySetFast(bool fast);                  ///< Plays the whole replay as fast as possible, mostly without rendering, and quits at the end.
+void replaySetRecord(bool record);              ///< Whether to record games at all, whatever the replayFiles setting.
+
+/// Sets up the game from the replay given on the command line, if any. Returns false if the replay can't be played.
+bool replayPlaybackStart(void);
+
+/// Starts recording, if starting a skirmish or multiplayer game, after deleting the oldest recordings so that
+/// no more than war_GetReplayFiles() are kept.
+void replayRecordStart(void);
+void replayStop(void);                          ///< Stops recording or playing back, when the game ends.
+
+/// Feeds the replay into the game queues. Returns false if the replay has finished, and the game should quit.
+bool replayUpdate(void);
+
+bool replayFastForward(void);                   ///< True while the game should tick as fast as it can.
+bool replaySkipRender(void);                    ///< True if this frame needn't be rendered, since fast-forwarding.
+
+#endif // __INCLUDED_SRC_REPLAY_H__
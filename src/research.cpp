@@ -25,6 +25,8 @@
  */
 #include <string.h>
 #include <map>
+#include <set>
+#include <algorithm>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/strres.h"
@@ -53,6 +55,21 @@
 // The stores for the research stats
 std::vector<RESEARCH> asResearch;
 
+// Research frontier. For each player, the topics that are not researched yet, and are possible, have
+// all their prerequisites researched, or have been cancelled. Every topic which researchAvailable()
+// accepts is in the frontier, so only these need to be checked, rather than the whole research list.
+static std::vector<std::vector<int> > researchDependents;   ///< Topics which have each topic as a prerequisite.
+static std::vector<int> prereqsLeft[MAX_PLAYERS];           ///< Prerequisites of each topic not yet researched.
+static std::vector<bool> frontierResearched[MAX_PLAYERS];   ///< Topics already accounted for in prereqsLeft.
+static std::set<int> frontier[MAX_PLAYERS];
+static bool frontierValid = false;
+
+// Research paths. For each topic, all the topics it depends on directly or indirectly, as a bitset and
+// in the order pursueResearch searches them. Built once the prerequisites are loaded.
+static std::vector<std::vector<int> > pathOrder;                     ///< Prerequisites, in search order.
+static std::vector<std::vector<std::pair<int, int> > > pathRank;     ///< (topic, position in pathOrder), sorted by topic.
+static std::vector<std::vector<uint32_t> > pathBits;                 ///< Set bits are prerequisites.
+
 //used for Callbacks to say which topic was last researched
 RESEARCH                *psCBLastResearch;
 STRUCTURE				*psCBLastResStructure;
@@ -78,6 +95,7 @@ static void replaceDroidComponent(DROID *pList, UDWORD oldType, UDWORD oldCompIn
                       UDWORD newCompInc);
 static void replaceStructureComponent(STRUCTURE *pList, UDWORD oldType, UDWORD oldCompInc,
                       UDWORD newCompInc, UBYTE player);
+static void buildResearchPaths();
 static void switchComponent(DROID *psDroid,UDWORD oldType, UDWORD oldCompInc,
                      UDWORD newCompInc);
 static void replaceTransDroidComponents(DROID *psTransporter, UDWORD oldType,
@@ -90,6 +108,10 @@ bool researchInitVars(void)
 	psCBLastResStructure = NULL;
 	CBResFacilityOwner = -1;
 	asResearch.clear();
+	resetResearchFrontier();
+	pathOrder.clear();
+	pathRank.clear();
+	pathBits.clear();
 
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
@@ -347,9 +369,238 @@ bool loadResearch(QString filename)
 		}
 	}
 
+	resetResearchFrontier();
+	buildResearchPaths();
+
 	return true;
 }
 
+void resetResearchFrontier()
+{
+	frontierValid = false;
+}
+
+static void buildResearchFrontier()
+{
+	researchDependents.assign(asResearch.size(), std::vector<int>());
+	for (int inc = 0; inc < asResearch.size(); inc++)
+	{
+		for (int incPR = 0; incPR < asResearch[inc].pPRList.size(); incPR++)
+		{
+			researchDependents[asResearch[inc].pPRList[incPR]].push_back(inc);
+		}
+	}
+	for (int player = 0; player < MAX_PLAYERS; player++)
+	{
+		prereqsLeft[player].assign(asResearch.size(), 0);
+		frontierResearched[player].assign(asResearch.size(), false);
+		frontier[player].clear();
+		for (int inc = 0; inc < asResearch.size(); inc++)
+		{
+			frontierResearched[player][inc] = IsResearchCompleted(&asPlayerResList[player][inc]);
+			for (int incPR = 0; incPR < asResearch[inc].pPRList.size(); incPR++)
+			{
+				prereqsLeft[player][inc] += !IsResearchCompleted(&asPlayerResList[player][asResearch[inc].pPRList[incPR]]);
+			}
+		}
+		for (int inc = 0; inc < asResearch.size(); inc++)
+		{
+			PLAYER_RESEARCH const *psPlRes = &asPlayerResList[player][inc];
+			if (!frontierResearched[player][inc]
+			    && (IsResearchPossible(psPlRes) || (psPlRes->ResearchStatus & (CANCELLED_RESEARCH | CANCELLED_RESEARCH_PENDING))
+			        || (!asResearch[inc].pPRList.empty() && prereqsLeft[player][inc] == 0)))
+			{
+				frontier[player].insert(inc);
+			}
+		}
+	}
+	frontierValid = true;
+}
+
+void researchFrontierAdd(UDWORD player, UDWORD topic)
+{
+	if (frontierValid && !frontierResearched[player][topic])
+	{
+		frontier[player].insert(topic);
+	}
+}
+
+/// Moves the topics which needed only this one onto the frontier.
+static void researchFrontierCompleted(UDWORD player, UDWORD topic)
+{
+	if (!frontierValid || frontierResearched[player][topic])
+	{
+		return;
+	}
+	frontierResearched[player][topic] = true;
+	frontier[player].erase(topic);
+	for (int i = 0; i < researchDependents[topic].size(); i++)
+	{
+		int inc = researchDependents[topic][i];
+		if (--prereqsLeft[player][inc] == 0 && !frontierResearched[player][inc])
+		{
+			frontier[player].insert(inc);
+		}
+	}
+}
+
+std::set<int> const &researchFrontier(UDWORD player)
+{
+	if (!frontierValid)
+	{
+		buildResearchFrontier();
+	}
+	return frontier[player];
+}
+
+/// Builds the prerequisite bitsets in topological order, so that each topic can take the union of the
+/// bitsets of its direct prerequisites, then lists the prerequisites of each topic in search order.
+static void buildResearchPaths()
+{
+	int numTopics = asResearch.size();
+	int numWords = (numTopics + 31)/32;
+	std::vector<int> topoOrder;
+	std::vector<int> unsorted(numTopics, 0);
+	std::vector<std::vector<int> > dependents(numTopics);
+	for (int inc = 0; inc < numTopics; inc++)
+	{
+		unsorted[inc] = asResearch[inc].pPRList.size();
+		for (int incPR = 0; incPR < asResearch[inc].pPRList.size(); incPR++)
+		{
+			dependents[asResearch[inc].pPRList[incPR]].push_back(inc);
+		}
+		if (unsorted[inc] == 0)
+		{
+			topoOrder.push_back(inc);
+		}
+	}
+	for (int i = 0; i < topoOrder.size(); i++)
+	{
+		for (int j = 0; j < dependents[topoOrder[i]].size(); j++)
+		{
+			int inc = dependents[topoOrder[i]][j];
+			if (--unsorted[inc] == 0)
+			{
+				topoOrder.push_back(inc);
+			}
+		}
+	}
+	for (int inc = 0; inc < numTopics; inc++)
+	{
+		if (unsorted[inc] != 0)
+		{
+			debug(LOG_ERROR, "Cyclic dependencies in prerequisites of research \"%s\".", getName(&asResearch[inc]));
+		}
+	}
+
+	pathBits.assign(numTopics, std::vector<uint32_t>(numWords, 0));
+	for (int i = 0; i < topoOrder.size(); i++)
+	{
+		std::vector<uint32_t> &bits = pathBits[topoOrder[i]];
+		std::vector<UWORD> const &prereqs = asResearch[topoOrder[i]].pPRList;
+		for (int incPR = 0; incPR < prereqs.size(); incPR++)
+		{
+			bits[prereqs[incPR]/32] |= 1u << prereqs[incPR]%32;
+			for (int w = 0; w < numWords; w++)
+			{
+				bits[w] |= pathBits[prereqs[incPR]][w];
+			}
+		}
+	}
+
+	// Follow the first prerequisite of each topic straight away, and queue the others. Going through a
+	// topic again would only queue topics behind their earlier copies, so it can be skipped.
+	pathOrder.assign(numTopics, std::vector<int>());
+	pathRank.assign(numTopics, std::vector<std::pair<int, int> >());
+	std::vector<bool> seen;
+	for (int target = 0; target < numTopics; target++)
+	{
+		std::vector<int> &order = pathOrder[target];
+		std::vector<int> queue;
+		int next = 0;
+		int cur = target;
+		seen.assign(numTopics, false);
+		seen[target] = true;
+		while (cur >= 0)
+		{
+			std::vector<UWORD> const &prereqs = asResearch[cur].pPRList;
+			cur = -1;
+			if (!prereqs.empty() && !seen[prereqs[0]])
+			{
+				cur = prereqs[0];
+			}
+			queue.insert(queue.end(), prereqs.begin() + std::min<int>(1, prereqs.size()), prereqs.end());
+			while (cur < 0 && next < queue.size())
+			{
+				cur = seen[queue[next]] ? -1 : queue[next];
+				++next;
+			}
+			if (cur >= 0)
+			{
+				seen[cur] = true;
+				order.push_back(cur);
+			}
+		}
+		for (int i = 0; i < order.size(); i++)
+		{
+			pathRank[target].push_back(std::make_pair(order[i], i));
+		}
+		std::sort(pathRank[target].begin(), pathRank[target].end());
+	}
+}
+
+std::vector<int> const &researchPrerequisites(int topic)
+{
+	static std::vector<int> none;
+	ASSERT_OR_RETURN(none, topic >= 0 && topic < pathOrder.size(), "Invalid research topic %d", topic);
+	return pathOrder[topic];
+}
+
+bool researchIsPrerequisite(int topic, int prereq)
+{
+	ASSERT_OR_RETURN(false, topic >= 0 && topic < pathBits.size() && prereq >= 0 && prereq < pathBits.size(), "Invalid research topic %d or %d", topic, prereq);
+	return (pathBits[topic][prereq/32] & 1u << prereq%32) != 0;
+}
+
+int researchNextStep(int target, int player, bool (*acceptable)(int topic, int player))
+{
+	ASSERT_OR_RETURN(-1, target >= 0 && target < pathOrder.size(), "Invalid research topic %d", target);
+	if (acceptable(target, player))
+	{
+		return target;
+	}
+	std::vector<int> const &order = pathOrder[target];
+	std::set<int> const &candidates = researchFrontier(player);
+	if (order.size() <= candidates.size())
+	{
+		for (int i = 0; i < order.size(); i++)
+		{
+			if (candidates.count(order[i]) && acceptable(order[i], player))
+			{
+				return order[i];
+			}
+		}
+		return -1;
+	}
+	// Fewer candidates than prerequisites, so check the candidates on the path, and keep the earliest.
+	int best = -1;
+	int bestRank = order.size();
+	for (std::set<int>::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
+	{
+		if (!researchIsPrerequisite(target, *i))
+		{
+			continue;
+		}
+		int rank = std::lower_bound(pathRank[target].begin(), pathRank[target].end(), std::make_pair(*i, 0))->second;
+		if (rank < bestRank && acceptable(*i, player))
+		{
+			best = *i;
+			bestRank = rank;
+		}
+	}
+	return best;
+}
+
 bool researchAvailable(int inc, int playerID, QUEUE_MODE mode)
 {
 	// Decide whether to use IsResearchCancelledPending/IsResearchStartedPending or IsResearchCancelled/IsResearchStarted.
@@ -462,20 +713,33 @@ There can only be 'limit' number of entries
 // NOTE by AJL may 99 - skirmish now has it's own version of this, skTopicAvail.
 UWORD fillResearchList(UWORD *plist, UDWORD playerID, UWORD topic, UWORD limit)
 {
-	UWORD				inc, count=0;
+	UWORD				count=0;
+	std::set<int> const &candidates = researchFrontier(playerID);
+	bool topicAdded = topic >= asResearch.size();
 
-	for (inc=0; inc < asResearch.size(); inc++)
+	for (std::set<int>::const_iterator i = candidates.begin(); i != candidates.end() && count < limit; ++i)
 	{
 		// if the inc matches the 'topic' - automatically add to the list
-		if (inc == topic || researchAvailable(inc, playerID, ModeQueue))
+		if (!topicAdded && topic <= *i)
 		{
-			*plist++ = inc;
+			*plist++ = topic;
 			count++;
-			if (count == limit)
+			topicAdded = true;
+			if (topic == *i || count == limit)
 			{
-				return count;
+				continue;
 			}
 		}
+		if (researchAvailable(*i, playerID, ModeQueue))
+		{
+			*plist++ = *i;
+			count++;
+		}
+	}
+	if (!topicAdded && count < limit)
+	{
+		*plist++ = topic;
+		count++;
 	}
 	return count;
 }
@@ -491,6 +755,7 @@ void researchResult(UDWORD researchIndex, UBYTE player, bool bDisplay, STRUCTURE
 	ASSERT_OR_RETURN( , researchIndex < asResearch.size(), "Invalid research index %u", researchIndex);
 
 	MakeResearchCompleted(&asPlayerResList[player][researchIndex]);
+	researchFrontierCompleted(player, researchIndex);
 
 	//check for structures to be made available
 	for (int inc = 0; inc < pResearch->pStructureResults.size(); inc++)
@@ -624,6 +889,10 @@ void ResearchRelease(void)
 	{
 		asPlayerResList[i].clear();
 	}
+	resetResearchFrontier();
+	pathOrder.clear();
+	pathRank.clear();
+	pathBits.clear();
 }
 
 /*puts research facility on hold*/
@@ -729,6 +998,7 @@ void cancelResearch(STRUCTURE *psBuilding, QUEUE_MODE mode)
 			sendResearchStatus(psBuilding, topicInc, psBuilding->player, false);
 			// Immediately tell the UI that we can research this now. (But don't change the game state.)
 			MakeResearchCancelledPending(pPlayerRes);
+			researchFrontierAdd(psBuilding->player, topicInc);
 			setStatusPendingCancel(*psResFac);
 			return;  // Wait for our message before doing anything. (Whatever this function does...)
 		}
@@ -743,6 +1013,7 @@ void cancelResearch(STRUCTURE *psBuilding, QUEUE_MODE mode)
 		{
 			// Set the researched flag
 			MakeResearchCancelled(pPlayerRes);
+			researchFrontierAdd(psBuilding->player, topicInc);
 		}
 
 		// Initialise the research facility's subject
@@ -1117,6 +1388,7 @@ bool enableResearch(RESEARCH *psResearch, UDWORD player)
 
 	//found, so set the flag
 	MakeResearchPossible(&asPlayerResList[player][inc]);
+	researchFrontierAdd(player, inc);
 
 	if (player == selectedPlayer)
 	{
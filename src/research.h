@@ -26,6 +26,8 @@
 
 #include "objectdef.h"
 
+#include <set>
+
 #define NO_RESEARCH_ICON 0
 //max 'research complete' console message length
 #define MAX_RESEARCH_MSG_SIZE 200
@@ -142,6 +144,22 @@ extern bool researchInitVars(void);
 
 bool researchAvailable(int inc, int playerID, QUEUE_MODE mode);
 
+/// Returns the topics the player may be able to research, in index order. These are all the topics
+/// researchAvailable() can accept, so only these need checking.
+std::set<int> const &researchFrontier(UDWORD player);
+/// Adds a topic to the frontier, after setting its possible flag directly instead of with enableResearch().
+void researchFrontierAdd(UDWORD player, UDWORD topic);
+/// Rebuilds the frontier on next use, after the research status has been changed wholesale, such as by loading a game.
+void resetResearchFrontier(void);
+
+/// Returns all the direct and indirect prerequisites of a topic, in the order the JS pursueResearch searches them.
+std::vector<int> const &researchPrerequisites(int topic);
+/// Returns whether prereq must be researched, directly or indirectly, before topic.
+bool researchIsPrerequisite(int topic, int prereq);
+/** Returns the first topic for which acceptable() holds, out of the target and then its prerequisites in
+ *  search order, or -1 if there is none. acceptable() must only hold for topics in the researchFrontier(). */
+int researchNextStep(int target, int player, bool (*acceptable)(int topic, int player));
+
 struct AllyResearch
 {
 	unsigned player;
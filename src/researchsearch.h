@@ -0,0 +1,68 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+/** @file researchsearch.h
+ *  Depth first search through research prerequisites, as the legacy pursueResearch does it. Only depends on
+ *  the pPRList of each topic, so that it can be tested alone.
+ */
+
+#ifndef __INCLUDED_SRC_RESEARCHSEARCH_H__
+#define __INCLUDED_SRC_RESEARCHSEARCH_H__
+
+#include <utility>
+#include <vector>
+
+/** Goes through the prerequisites of the target, and all the prerequisites of each before the next, and returns
+ *  the first topic for which acceptable() holds, or -1 if there is none. The prerequisites of a topic are only
+ *  gone through if expand() holds for it. Each topic is gone through once, since acceptable() and expand()
+ *  don't depend on how the topic was reached, so going through it again would find nothing new. */
+template <typename Topics>
+int researchSearchDepthFirst(Topics const &topics, int target, int player, bool (*acceptable)(int topic, int player), bool (*expand)(int topic, int player))
+{
+	std::vector<bool> seen(topics.size(), false);
+	std::vector<std::pair<int, unsigned> > stack;  // (topic, next prerequisite to go through)
+	seen[target] = true;
+	stack.push_back(std::make_pair(target, 0u));
+	while (!stack.empty())
+	{
+		std::pair<int, unsigned> &top = stack.back();
+		if (top.second >= topics[top.first].pPRList.size())
+		{
+			stack.pop_back();
+			continue;
+		}
+		int cur = topics[top.first].pPRList[top.second++];
+		if (seen[cur])
+		{
+			continue;
+		}
+		seen[cur] = true;
+		if (acceptable(cur, player))
+		{
+			return cur;
+		}
+		if (expand(cur, player))
+		{
+			stack.push_back(std::make_pair(cur, 0u));
+		}
+	}
+	return -1;
+}
+
+#endif // __INCLUDED_SRC_RESEARCHSEARCH_H__
@@ -1592,13 +1592,20 @@ bool scrSkDoResearch(void)
 	}
 
 	// choose a topic to complete.
-	for (i = 0; i < asResearch.size(); i++)
+	std::set<int> const &candidates = researchFrontier(player);
+	std::set<int>::const_iterator candidate;
+	for (candidate = candidates.begin(); candidate != candidates.end(); ++candidate)
 	{
+		i = *candidate;
 		if (skTopicAvail(i, player) && (!bMultiPlayer || !beingResearchedByAlly(i, player)))
 		{
 			break;
 		}
 	}
+	if (candidate == candidates.end())
+	{
+		i = asResearch.size();
+	}
 
 	if (i != asResearch.size())
 	{
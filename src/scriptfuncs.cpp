@@ -46,6 +46,7 @@
 #include "structure.h"
 #include "display3d.h"
 #include "research.h"
+#include "researchsearch.h"
 #include "lib/sound/audio.h"
 #include "lib/sound/audio_id.h"
 #include "power.h"
@@ -9418,13 +9419,30 @@ bool objectInRangeVis(BASE_OBJECT *psList, SDWORD x, SDWORD y, SDWORD range, SDW
 	return false;
 }
 
+/// Whether pursueResearch looks for a way to the topic through its prerequisites.
+static bool scrPursueResearchThrough(int topic, int player)
+{
+	return !IsResearchCompleted(&asPlayerResList[player][topic]) && !IsResearchStartedPending(&asPlayerResList[player][topic]);
+}
+
+/// Whether pursueResearch may start the topic, when on the way to another. A topic without prerequisites that
+/// hasn't been started is chosen even if it isn't available.
+static bool scrPursueResearchStep(int topic, int player)
+{
+	if (beingResearchedByAlly(topic, player))
+	{
+		return false;
+	}
+	return skTopicAvail(topic, player)
+	       || (asResearch[topic].pPRList.empty() && scrPursueResearchThrough(topic, player));
+}
+
 /* Go after a certain research */
 bool scrPursueResearch(void)
 {
 	RESEARCH			*psResearch;
-	SDWORD				foundIndex = 0, player, cur, tempIndex, Stack[400];
+	SDWORD				foundIndex = 0, player;
 	UDWORD				index;
-	SWORD				top;
 	bool				found;
 	STRUCTURE			*psBuilding;
 	RESEARCH_FACILITY	*psResFacilty;
@@ -9486,63 +9504,8 @@ bool scrPursueResearch(void)
 	}
 	else
 	{
-		top = -1;
-
-		cur = 0;				//start with first index's PR
-		while (true)	//do
-		{
-			if (cur >= asResearch[index].pPRList.size())		//node has nodes?
-			{
-				top = top - 2;
-				if (top < (-1))
-				{
-					break;		//end of stack
-				}
-				index = Stack[top + 2];	//if index = -1, then exit
-				cur = Stack[top + 1];		//go to next PR of the last node, since this one didn't work
-
-			}
-			else		//end of nodes not reached
-			{
-				tempIndex = asResearch[index].pPRList[cur];		//get cur node's index
-
-				if (skTopicAvail(tempIndex, player) && (!beingResearchedByAlly(tempIndex, player)))	//<NEW> - ally check added
-				{
-					found = true;
-					foundIndex = tempIndex;		//done
-					break;
-				}
-				else if (!IsResearchCompleted(&asPlayerResList[player][tempIndex])
-				        && !IsResearchStartedPending(&asPlayerResList[player][tempIndex]))  //not avail and not busy with it, can check this PR's PR
-				{
-					if (!asResearch[tempIndex].pPRList.empty())	//node has any nodes itself
-					{
-						Stack[top + 1] = cur;								//so can go back to it further
-						Stack[top + 2] = index;
-						top = top + 2;
-
-						index = tempIndex;		//go 1 level further
-						cur = -1;									//start with first PR of this PR next time
-					}
-					else		//has no PRs, choose it (?)
-					{
-						if (!beingResearchedByAlly(tempIndex, player))	//<NEW> ally check added
-						{
-							found = true;
-							foundIndex = tempIndex;	//done
-							break;
-						}
-					}
-				}
-			}
-
-			cur++;				//try next node of the main node
-			if ((cur >= asResearch[index].pPRList.size()) && (top <= (-1)))	//nothing left
-			{
-				break;
-			}
-
-		} // while(true)
+		foundIndex = researchSearchDepthFirst(asResearch, index, player, scrPursueResearchStep, scrPursueResearchThrough);
+		found = foundIndex >= 0;
 	}
 
 	if (found && foundIndex < asResearch.size())
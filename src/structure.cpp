@@ -1365,7 +1365,7 @@ STRUCTURE* buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 		}
 
 		// allocate memory for and initialize a structure object
-		psBuilding = new STRUCTURE(generateSynchronisedObjectId(), player);
+		psBuilding = new (player) STRUCTURE(generateSynchronisedObjectId(), player);
 		if (psBuilding == NULL)
 		{
 			return NULL;
@@ -3527,6 +3527,61 @@ int gateCurrentOpenHeight(STRUCTURE const *psStructure, uint32_t time, int minim
 	return 0;
 }
 
+static void gateSetOccupancy(DROID *psDroid, STRUCTURE *psGate)
+{
+	STRUCTURE *psOldGate = psDroid->onGate.get();  // NULL if the old gate has been freed.
+	if (psOldGate == psGate)
+	{
+		return;
+	}
+	if (psOldGate != NULL)
+	{
+		ASSERT(psOldGate->gateOccupants > 0, "Gate occupancy out of sync");
+		--psOldGate->gateOccupants;
+	}
+	if (psGate != NULL)
+	{
+		++psGate->gateOccupants;
+	}
+	psDroid->onGate = SlabHandle<STRUCTURE>(psGate);
+}
+
+void gateUpdateOccupancy(DROID *psDroid)
+{
+	STRUCTURE *psGate = NULL;
+	if (!isDead(psDroid) && worldOnMap(psDroid->pos.x, psDroid->pos.y))
+	{
+		BASE_OBJECT *psObj = mapTile(map_coord(removeZ(psDroid->pos)))->psObject;
+		if (psObj != NULL && psObj->type == OBJ_STRUCTURE && ((STRUCTURE *)psObj)->pStructureType->type == REF_GATE)
+		{
+			psGate = (STRUCTURE *)psObj;
+		}
+	}
+	gateSetOccupancy(psDroid, psGate);
+}
+
+void gateClearOccupancy(DROID *psDroid)
+{
+	gateSetOccupancy(psDroid, NULL);
+}
+
+/// Counts the droids already on the tile of a gate, when the gate is finished or loaded. Goes through the droid
+/// lists rather than the grid, since the grid isn't up to date while loading.
+static void gateCountOccupants(STRUCTURE *psGate)
+{
+	Vector2i tile = map_coord(removeZ(psGate->pos));
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			if (map_coord(removeZ(psDroid->pos)) == tile)
+			{
+				gateUpdateOccupancy(psDroid);
+			}
+		}
+	}
+}
+
 /* The main update routine for all Structures */
 void structureUpdate(STRUCTURE *psBuilding, bool mission)
 {
@@ -3547,16 +3602,7 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 	{
 		if (psBuilding->state == SAS_OPEN && psBuilding->lastStateTime + SAS_STAY_OPEN_TIME < gameTime)
 		{
-			bool		found = false;
-
-			static GridList gridList;  // static to avoid allocations.
-			gridList = gridStartIterate(psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
-			for (GridIterator gi = gridList.begin(); !found && gi != gridList.end(); ++gi)
-			{
-				found = isDroid(*gi);
-			}
-
-			if (!found)	// no droids on our tile, safe to close
+			if (psBuilding->gateOccupants == 0)	// no droids on our tile, safe to close
 			{
 				psBuilding->state = SAS_CLOSING;
 				auxStructureClosedGate(psBuilding);     // closed
@@ -3742,6 +3788,7 @@ STRUCTURE::STRUCTURE(uint32_t id, unsigned player)
 	, buildRate(1)  // Initialise to 1 instead of 0, to make sure we don't get destroyed first tick due to inactivity.
 	, lastBuildRate(0)
 	, psCurAnim(NULL)
+	, gateOccupants(0)
 	, prebuiltImd(NULL)
 {
 	pos = Vector3i(0, 0, 0);
@@ -5413,6 +5460,7 @@ void buildingComplete(STRUCTURE *psBuilding)
 		case REF_GATE:
 			auxStructureNonblocking(psBuilding);  // Clear outdated flags.
 			auxStructureClosedGate(psBuilding);  // Don't block for the sake of allied pathfinding.
+			gateCountOccupants(psBuilding);  // Don't close on droids which were already there.
 			break;
 		default:
 			//do nothing
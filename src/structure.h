@@ -89,6 +89,8 @@ extern bool	structureStatsShutDown(void);
 
 int requestOpenGate(STRUCTURE *psStructure);
 int gateCurrentOpenHeight(STRUCTURE const *psStructure, uint32_t time, int minimumStub);  ///< Returns how far open the gate is, or 0 if the structure is not a gate.
+void gateUpdateOccupancy(DROID *psDroid);  ///< Counts the droid on the gate of the tile it is on, if any. Call when the droid is placed or changes tile.
+void gateClearOccupancy(DROID *psDroid);   ///< Stops counting the droid on any gate, when it leaves the map.
 
 int32_t structureDamage(STRUCTURE *psStructure, unsigned damage, WEAPON_CLASS weaponClass, WEAPON_SUBCLASS weaponSubClass, unsigned impactTime, bool isDamagePerSecond, int minDamage);
 extern void structureBuild(STRUCTURE *psStructure, DROID *psDroid, int buildPoints, int buildRate = 1);
@@ -238,7 +238,7 @@ union FUNCTIONALITY
 };
 
 //this structure is used whenever an instance of a building is required in game
-struct STRUCTURE : public BASE_OBJECT
+struct STRUCTURE : public BASE_OBJECT, public SlabAllocated<STRUCTURE>
 {
 	STRUCTURE(uint32_t id, unsigned player);
 	~STRUCTURE();
@@ -277,6 +277,7 @@ struct STRUCTURE : public BASE_OBJECT
 
 	STRUCT_ANIM_STATES	state;
 	UDWORD			lastStateTime;
+	uint16_t		gateOccupants;		///< Number of droids on the tile of a gate, which keeps the gate open.
 
 	iIMDShape *         prebuiltImd;
 };
@@ -57,6 +57,7 @@ struct WARZONE_GLOBALS
 	bool		trapCursor;
 	bool		vsync;
 	bool		pauseOnFocusLoss;
+	int		replayFiles;		///< How many recorded games to keep in the replay directory, 0 to record none.
 	bool		ColouredCursor;
 	bool		MusicEnabled;
 };
@@ -87,6 +88,7 @@ void war_SetDefaultStates(void)//Sets all states
 	war_SetVsync(true);
 	war_setSoundEnabled( true );
 	war_SetPauseOnFocusLoss(false);
+	war_SetReplayFiles(10);
 	war_SetMusicEnabled(true);
 	war_SetSPcolor(0);		//default color is green
 	war_setMPcolour(-1);            // Default color is random.
@@ -211,6 +213,16 @@ bool war_GetPauseOnFocusLoss()
 	return warGlobs.pauseOnFocusLoss;
 }
 
+void war_SetReplayFiles(int files)
+{
+	warGlobs.replayFiles = MAX(files, 0);
+}
+
+int war_GetReplayFiles(void)
+{
+	return warGlobs.replayFiles;
+}
+
 void war_setSoundEnabled( bool soundEnabled )
 {
 	warGlobs.soundEnabled = soundEnabled;
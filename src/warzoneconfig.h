@@ -73,6 +73,8 @@ extern void war_SetHeight(UDWORD height);
 extern UDWORD war_GetHeight(void);
 extern void war_SetPauseOnFocusLoss(bool enabled);
 extern bool war_GetPauseOnFocusLoss(void);
+extern void war_SetReplayFiles(int files);
+extern int war_GetReplayFiles(void);
 extern bool war_GetMusicEnabled(void);
 extern void war_SetMusicEnabled(bool enabled);
 extern int8_t war_GetSPcolor(void);
@@ -789,6 +789,13 @@ static QScriptValue js_setTimer(QScriptContext *context, QScriptEngine *engine)
 	return QScriptValue();
 }
 
+static QScriptValue js_setTimerBudget(QScriptContext *context, QScriptEngine *)
+{
+	ARG_COUNT_EXACT(1);
+	ARG_NUMBER(0);
+	return QScriptValue();
+}
+
 static QScriptValue js_bind(QScriptContext *context, QScriptEngine *engine)
 {
 	ARG_COUNT_VAR(2, 3);
@@ -911,6 +918,7 @@ bool testPlayerScript(QString path, int player, int difficulty)
 	engine->globalObject().setProperty("setTimer", engine->newFunction(js_setTimer));
 	engine->globalObject().setProperty("queue", engine->newFunction(js_queue));
 	engine->globalObject().setProperty("removeTimer", engine->newFunction(js_removeTimer));
+	engine->globalObject().setProperty("setTimerBudget", engine->newFunction(js_setTimerBudget));
 	engine->globalObject().setProperty("include", engine->newFunction(js_include));
 	engine->globalObject().setProperty("bind", engine->newFunction(js_bind));
 
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "src/pointtree.h"
+
+// Checks that picking the neighbours of a droid out of one larger grid query, as moveGetNeighbours in
+// src/move.cpp does with shared neighbours, gives the same objects in the same order as querying the
+// grid for each radius, as it does with --nosharedneighbours. Objects move after the grid is built,
+// as droids do during a game tick.
+
+#define TILE_UNITS 128
+#define NEIGHBOUR_DIST (TILE_UNITS * 4 + TILE_UNITS)
+
+struct Object
+{
+	int32_t gridX, gridY;  ///< Where the point tree has it.
+	int32_t x, y;          ///< Where it is now.
+};
+
+// The same as isInRadius in src/mapgrid.cpp.
+static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
+{
+	return (uint32_t)(x*x + y*y) <= radius*radius;
+}
+
+// As gridStartIterate.
+static void queryGrid(PointTree &tree, int32_t x, int32_t y, uint32_t radius, std::vector<Object *> &result)
+{
+	PointTree::ResultVector &found = tree.query(x, y, radius);
+	result.clear();
+	for (unsigned i = 0; i < found.size(); ++i)
+	{
+		Object *obj = (Object *)found[i];
+		if (isInRadius(obj->x - x, obj->y - y, radius))
+		{
+			result.push_back(obj);
+		}
+	}
+}
+
+// As moveGetNeighbours, picking the objects out of those found around (hoodX, hoodY).
+static bool queryNeighbours(std::vector<Object *> const &hood, PointTree::PositionVector const &gridPos, int32_t x, int32_t y, uint32_t radius, std::vector<Object *> &result)
+{
+	result.clear();
+	for (unsigned i = 0; i < hood.size(); ++i)
+	{
+		if (gridPos[i].first != hood[i]->gridX || gridPos[i].second != hood[i]->gridY)
+		{
+			fprintf(stderr, "neighbourtest: Position (%d, %d) from the point tree should be (%d, %d)\n", gridPos[i].first, gridPos[i].second, hood[i]->gridX, hood[i]->gridY);
+			return false;
+		}
+		if (PointTree::inQuerySquare(gridPos[i].first, gridPos[i].second, x, y, radius) && isInRadius(hood[i]->x - x, hood[i]->y - y, radius))
+		{
+			result.push_back(hood[i]);
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	const unsigned radii[] = {3*TILE_UNITS/2, TILE_UNITS*2, (TILE_UNITS*5)/2, TILE_UNITS*4};  // SHUFFLE_DIST, AVOID_DIST, DROIDDIST, OBJ_MAXRADIUS
+	const int32_t mapSize = 64 * TILE_UNITS;
+	unsigned checked = 0, found = 0;
+
+	srand(42);
+	for (unsigned tick = 0; tick < 20; ++tick)
+	{
+		// Crowded, with some objects in exactly the same place, to check the order of equal points.
+		std::vector<Object> objects(3000);
+		PointTree tree;
+		for (unsigned i = 0; i < objects.size(); ++i)
+		{
+			Object &obj = objects[i];
+			if (i > 0 && rand() % 10 == 0)
+			{
+				obj = objects[rand() % i];
+			}
+			else
+			{
+				obj.gridX = rand() % mapSize;
+				obj.gridY = rand() % mapSize;
+			}
+			tree.insert(&obj, obj.gridX, obj.gridY);
+		}
+		tree.sort();
+		for (unsigned i = 0; i < objects.size(); ++i)
+		{
+			objects[i].x = objects[i].gridX + rand() % (2*TILE_UNITS + 1) - TILE_UNITS;
+			objects[i].y = objects[i].gridY + rand() % (2*TILE_UNITS + 1) - TILE_UNITS;
+		}
+
+		for (unsigned droid = 0; droid < 500; ++droid)
+		{
+			int32_t hoodX = rand() % mapSize, hoodY = rand() % mapSize;
+			tree.queryWithPositions(hoodX, hoodY, NEIGHBOUR_DIST);
+			std::vector<Object *> hood;
+			for (unsigned i = 0; i < tree.lastQueryResults.size(); ++i)
+			{
+				hood.push_back((Object *)tree.lastQueryResults[i]);
+			}
+			PointTree::PositionVector gridPos = tree.lastQueryPositions;
+
+			for (unsigned r = 0; r < sizeof(radii)/sizeof(*radii); ++r)
+			{
+				// Anywhere the droid may have moved to while the neighbourhood still covers the radius.
+				const int32_t slack = NEIGHBOUR_DIST - radii[r];
+				int32_t x = hoodX + rand() % (2*slack + 1) - slack;
+				int32_t y = hoodY + rand() % (2*slack + 1) - slack;
+				std::vector<Object *> expected, result;
+				queryGrid(tree, x, y, radii[r], expected);
+				if (!queryNeighbours(hood, gridPos, x, y, radii[r], result))
+				{
+					return 1;
+				}
+				if (result != expected)
+				{
+					fprintf(stderr, "neighbourtest: Tick %u, droid %u, radius %u: %u shared neighbours, %u from the grid\n",
+					        tick, droid, radii[r], (unsigned)result.size(), (unsigned)expected.size());
+					return 1;
+				}
+				++checked;
+				found += expected.size();
+			}
+		}
+	}
+
+	printf("neighbourtest: %u queries, %u neighbours, all the same\n", checked, found);
+	return 0;
+}
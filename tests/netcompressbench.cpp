@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTime>
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netqueue.h"
+#include "lib/netplay/netsocket.h"
+
+// --- dummy implementations of what the game would provide ---
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+void inputInitialise()
+{
+}
+
+// Real, since the sockets adapt their compression level to the time.
+int wzGetTicks()
+{
+	static QTime time;
+	if (time.isNull())
+	{
+		time.start();
+	}
+	return time.elapsed();
+}
+
+// The same as in lib/qtgame, which we don't want to link.
+struct WZ_THREAD : public QThread
+{
+	WZ_THREAD(int (*threadFunc_)(void *), void *data_) : threadFunc(threadFunc_), data(data_) {}
+	void run()
+	{
+		ret = (*threadFunc)(data);
+	}
+	int (*threadFunc)(void *);
+	void *data;
+	int ret;
+};
+
+struct WZ_MUTEX : public QMutex
+{
+};
+
+struct WZ_SEMAPHORE : public QSemaphore
+{
+	WZ_SEMAPHORE(int startValue = 0) : QSemaphore(startValue) {}
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data) { return new WZ_THREAD(threadFunc, data); }
+int wzThreadJoin(WZ_THREAD *thread) { thread->wait(); int ret = thread->ret; delete thread; return ret; }
+void wzThreadStart(WZ_THREAD *thread) { thread->start(); }
+WZ_MUTEX *wzMutexCreate() { return new WZ_MUTEX; }
+void wzMutexDestroy(WZ_MUTEX *mutex) { delete mutex; }
+void wzMutexLock(WZ_MUTEX *mutex) { mutex->lock(); }
+void wzMutexUnlock(WZ_MUTEX *mutex) { mutex->unlock(); }
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue) { return new WZ_SEMAPHORE(startValue); }
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore) { delete semaphore; }
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore) { semaphore->acquire(); }
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore) { semaphore->release(); }
+
+// --- end linking hacks ---
+
+// Replays the game queues recorded in a replay file through a compressed loopback connection, as the host would
+// send them, one NET_SHARE_GAME_QUEUE per player per tick, flushing every tick. Prints the compression ratio and
+// time for some fixed zlib levels, and for the adaptive level the game uses.
+
+enum { TIMEOUT = 5000 };
+static const uint8_t REPLAY_END = 0xFF;
+
+typedef std::vector<uint8_t> Tick;   ///< The bytes sent in one flush.
+
+static Socket *listenSocket;
+static unsigned port;
+
+// Reads a replay file, as written by netreplay.cpp. Returns false if it isn't one.
+static bool loadReplay(char const *fileName, std::vector<Tick> &ticks)
+{
+	FILE *file = fopen(fileName, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "netcompressbench: Could not open %s\n", fileName);
+		return false;
+	}
+	std::vector<uint8_t> data;
+	uint8_t buf[4096];
+	size_t size;
+	while ((size = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		data.insert(data.end(), buf, buf + size);
+	}
+	fclose(file);
+
+	if (data.size() < 12 || memcmp(&data[0], "WZRP", 4) != 0)
+	{
+		fprintf(stderr, "netcompressbench: %s is not a replay\n", fileName);
+		return false;
+	}
+	uint32_t settingsSize = data[8]<<24 | data[9]<<16 | data[10]<<8 | data[11];
+	size_t pos = 12 + settingsSize;
+
+	std::vector<Tick> playerMessages(MAX_PLAYERS);
+	std::vector<uint32_t> playerCounts(MAX_PLAYERS);
+	while (pos < data.size())
+	{
+		uint32_t deltaTime = 0;
+		for (unsigned n = 0; pos < data.size() && decode_uint32_t(data[pos++], deltaTime, n); ++n)
+		{}
+		uint8_t player = pos < data.size() ? data[pos++] : REPLAY_END;
+
+		if (deltaTime != 0 || player == REPLAY_END)
+		{
+			// The tick is over, send what each player did.
+			Tick tick;
+			for (unsigned p = 0; p < MAX_PLAYERS; ++p)
+			{
+				if (playerCounts[p] == 0)
+				{
+					continue;
+				}
+				NetMessage message(NET_SHARE_GAME_QUEUE);
+				message.data.push_back(p);
+				for (unsigned n = 0, more = true; more; ++n)
+				{
+					uint8_t b;
+					more = encode_uint32_t(b, playerCounts[p], n);
+					message.data.push_back(b);
+				}
+				message.data.insert(message.data.end(), playerMessages[p].begin(), playerMessages[p].end());
+				uint8_t *raw = message.rawDataDup();
+				tick.insert(tick.end(), raw, raw + message.rawLen());
+				delete[] raw;
+				playerMessages[p].clear();
+				playerCounts[p] = 0;
+			}
+			if (!tick.empty())
+			{
+				ticks.push_back(tick);
+			}
+		}
+		if (player == REPLAY_END)
+		{
+			break;
+		}
+		if (player >= MAX_PLAYERS || pos >= data.size())
+		{
+			fprintf(stderr, "netcompressbench: Broken replay record at byte %u\n", (unsigned)pos);
+			return false;
+		}
+
+		// Copy the message as it is, type, length and data.
+		size_t start = pos++;
+		uint32_t length = 0;
+		for (unsigned n = 0; pos < data.size() && decode_uint32_t(data[pos++], length, n); ++n)
+		{}
+		if (length > data.size() - std::min(pos, data.size()))
+		{
+			fprintf(stderr, "netcompressbench: Broken replay record at byte %u\n", (unsigned)start);
+			return false;
+		}
+		pos += length;
+		playerMessages[player].insert(playerMessages[player].end(), data.begin() + start, data.begin() + pos);
+		++playerCounts[player];
+	}
+	return true;
+}
+
+static bool connectPair(Socket **client, Socket **server)
+{
+	SocketAddress *addr = resolveHost("127.0.0.1", port);
+	*client = socketOpen(addr, TIMEOUT);
+	*server = NULL;
+	deleteSocketAddress(addr);
+	QTime timer;
+	timer.start();
+	while (*client != NULL && *server == NULL && timer.elapsed() < TIMEOUT)
+	{
+		*server = socketAccept(listenSocket);  // Doesn't block, the connection should be there almost at once.
+	}
+	if (*client == NULL || *server == NULL)
+	{
+		fprintf(stderr, "netcompressbench: Could not connect over loopback\n");
+		return false;
+	}
+	return true;
+}
+
+// Sends all the ticks with the given compression level, or -1 to adapt. Returns false if the data arrives wrong.
+static bool sendTicks(std::vector<Tick> const &ticks, int level)
+{
+	Socket *client, *server;
+	if (!connectPair(&client, &server))
+	{
+		return false;
+	}
+	SocketSet *serverSet = allocSocketSet();
+	SocketSet_AddSocket(serverSet, server);
+	socketSetCompressionLevel(client, level);
+	socketBeginCompression(client);
+	socketBeginCompression(server);
+
+	uint64_t uncompressed = 0, compressed = 0;
+	unsigned compressStart = socketCompressionTime(true);
+	unsigned decompressStart = socketCompressionTime(false);
+	std::vector<uint8_t> buf(16384);
+	bool ok = true;
+	QTime timer;
+	timer.start();
+	for (unsigned t = 0; t < ticks.size() && ok; ++t)
+	{
+		Tick const &tick = ticks[t];
+		size_t rawBytes;
+		writeAll(client, &tick[0], tick.size(), &rawBytes);
+		compressed += rawBytes;
+		socketFlush(client, &rawBytes);
+		compressed += rawBytes;
+		uncompressed += tick.size();
+
+		for (size_t received = 0; received < tick.size() && ok; )
+		{
+			if (checkSockets(serverSet, TIMEOUT) <= 0)
+			{
+				fprintf(stderr, "netcompressbench: Timed out\n");
+				ok = false;
+				break;
+			}
+			ssize_t size = readNoInt(server, &buf[0], std::min(buf.size(), tick.size() - received));
+			if (size < 0 || memcmp(&buf[0], &tick[received], size) != 0)
+			{
+				fprintf(stderr, "netcompressbench: Received wrong data\n");
+				ok = false;
+			}
+			received += std::max<ssize_t>(size, 0);
+		}
+	}
+	int time = timer.elapsed();
+
+	if (ok)
+	{
+		char name[20];
+		if (level < 0)
+		{
+			snprintf(name, sizeof(name), "adaptive, at %d", socketGetCompressionLevel(client));
+		}
+		else
+		{
+			snprintf(name, sizeof(name), "level %d", level);
+		}
+		printf("%-16s %9u -> %8u bytes (%4.1f%%), compress %7u us, decompress %7u us, %5d ms\n", name,
+		       (unsigned)uncompressed, (unsigned)compressed, uncompressed != 0 ? compressed*100.0/uncompressed : 100.0,
+		       socketCompressionTime(true) - compressStart, socketCompressionTime(false) - decompressStart, time);
+	}
+
+	SocketSet_DelSocket(serverSet, server);
+	deleteSocketSet(serverSet);
+	socketClose(client);
+	socketClose(server);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: netcompressbench <replay file>\n");
+		return 1;
+	}
+
+	std::vector<Tick> ticks;
+	if (!loadReplay(argv[1], ticks))
+	{
+		return 1;
+	}
+	printf("%s: %u ticks\n", argv[1], (unsigned)ticks.size());
+
+	SOCKETinit();
+	for (port = 21000; port < 21100 && listenSocket == NULL; ++port)
+	{
+		listenSocket = socketListen(port);
+	}
+	--port;
+	if (listenSocket == NULL)
+	{
+		fprintf(stderr, "netcompressbench: Could not listen on loopback\n");
+		return 1;
+	}
+
+	const int levels[] = {1, 3, 6, 9, -1};
+	for (unsigned i = 0; i < ARRAY_SIZE(levels); ++i)
+	{
+		if (!sendTicks(ticks, levels[i]))
+		{
+			return 1;
+		}
+	}
+
+	socketClose(listenSocket);
+	SOCKETshutdown();
+	return 0;
+}
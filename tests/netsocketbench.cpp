@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTime>
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/netplay/netsocket.h"
+
+// --- dummy implementations of what the game would provide ---
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// The same as in lib/qtgame, which we don't want to link.
+struct WZ_THREAD : public QThread
+{
+	WZ_THREAD(int (*threadFunc_)(void *), void *data_) : threadFunc(threadFunc_), data(data_) {}
+	void run()
+	{
+		ret = (*threadFunc)(data);
+	}
+	int (*threadFunc)(void *);
+	void *data;
+	int ret;
+};
+
+struct WZ_MUTEX : public QMutex
+{
+};
+
+struct WZ_SEMAPHORE : public QSemaphore
+{
+	WZ_SEMAPHORE(int startValue = 0) : QSemaphore(startValue) {}
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data) { return new WZ_THREAD(threadFunc, data); }
+int wzThreadJoin(WZ_THREAD *thread) { thread->wait(); int ret = thread->ret; delete thread; return ret; }
+void wzThreadStart(WZ_THREAD *thread) { thread->start(); }
+WZ_MUTEX *wzMutexCreate() { return new WZ_MUTEX; }
+void wzMutexDestroy(WZ_MUTEX *mutex) { delete mutex; }
+void wzMutexLock(WZ_MUTEX *mutex) { mutex->lock(); }
+void wzMutexUnlock(WZ_MUTEX *mutex) { mutex->unlock(); }
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue) { return new WZ_SEMAPHORE(startValue); }
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore) { delete semaphore; }
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore) { semaphore->acquire(); }
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore) { semaphore->release(); }
+
+// --- end linking hacks ---
+
+enum { CLIENTS = 10, CHUNK = 1400, TIMEOUT = 5000 };
+
+struct Connection
+{
+	Socket *client;
+	Socket *server;
+	unsigned sent, received;
+};
+
+static Socket *listenSocket;
+static unsigned port;
+
+static bool connectClients(Connection *connections, SocketSet *serverSet)
+{
+	SocketAddress *addr = resolveHost("127.0.0.1", port);
+	for (unsigned i = 0; i < CLIENTS; ++i)
+	{
+		connections[i].client = socketOpen(addr, TIMEOUT);
+		connections[i].server = NULL;
+		QTime timer;
+		timer.start();
+		while (connections[i].client != NULL && connections[i].server == NULL && timer.elapsed() < TIMEOUT)
+		{
+			connections[i].server = socketAccept(listenSocket);  // Doesn't block, the connection should be there almost at once.
+		}
+		if (connections[i].client == NULL || connections[i].server == NULL)
+		{
+			fprintf(stderr, "netsocketbench: Could not connect over loopback\n");
+			return false;
+		}
+		SocketSet_AddSocket(serverSet, connections[i].server);
+	}
+	deleteSocketAddress(addr);
+	return true;
+}
+
+// Every client sends bytes bytes, while the server reads from all of them. Returns false if the data arrives wrong.
+static bool throughput(Connection *connections, SocketSet *serverSet, unsigned bytes)
+{
+	std::vector<uint8_t> buf(CHUNK*4);
+	unsigned done = 0;
+
+	for (unsigned i = 0; i < CLIENTS; ++i)
+	{
+		connections[i].sent = 0;
+		connections[i].received = 0;
+	}
+
+	while (done < CLIENTS)
+	{
+		for (unsigned i = 0; i < CLIENTS; ++i)
+		{
+			Connection &c = connections[i];
+			// Stay a bit ahead of the reader, like a host sending game messages.
+			if (c.sent < bytes && c.sent - c.received < CHUNK*32)
+			{
+				uint8_t chunk[CHUNK];
+				for (unsigned n = 0; n < CHUNK; ++n)
+				{
+					chunk[n] = (uint8_t)(c.sent + n + i);
+				}
+				writeAll(c.client, chunk, CHUNK);
+				c.sent += CHUNK;
+			}
+		}
+
+		if (checkSockets(serverSet, TIMEOUT) <= 0)
+		{
+			fprintf(stderr, "netsocketbench: Timed out\n");
+			return false;
+		}
+		for (unsigned i = 0; i < CLIENTS; ++i)
+		{
+			Connection &c = connections[i];
+			if (!socketReadReady(c.server))
+			{
+				continue;
+			}
+			ssize_t size = readNoInt(c.server, &buf[0], buf.size());
+			for (ssize_t n = 0; n < size; ++n)
+			{
+				if (buf[n] != (uint8_t)(c.received + n + i))
+				{
+					fprintf(stderr, "netsocketbench: Received wrong data\n");
+					return false;
+				}
+			}
+			c.received += std::max<ssize_t>(size, 0);
+			done += size > 0 && c.received == bytes;
+		}
+	}
+	return true;
+}
+
+// Sends a small message there and back again, through the socket thread both ways. Returns false on timeout.
+static bool pingPong(Connection &c)
+{
+	uint8_t message[16] = {0};
+	if (writeAll(c.client, message, sizeof(message)) != sizeof(message)
+	 || readAll(c.server, message, sizeof(message), TIMEOUT) != sizeof(message)
+	 || writeAll(c.server, message, sizeof(message)) != sizeof(message)
+	 || readAll(c.client, message, sizeof(message), TIMEOUT) != sizeof(message))
+	{
+		fprintf(stderr, "netsocketbench: Ping failed\n");
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned megabytes = argc > 1 ? atoi(argv[1]) : 20;
+	const unsigned pings = 2000;
+	const unsigned bytes = megabytes*1000000/CLIENTS/CHUNK*CHUNK;
+	Connection connections[CLIENTS];
+
+	SOCKETinit();
+	for (port = 21000; port < 21100 && listenSocket == NULL; ++port)
+	{
+		listenSocket = socketListen(port);
+	}
+	--port;
+	if (listenSocket == NULL)
+	{
+		fprintf(stderr, "netsocketbench: Could not listen on loopback\n");
+		return 1;
+	}
+
+	SocketSet *serverSet = allocSocketSet();
+	if (!connectClients(connections, serverSet))
+	{
+		return 1;
+	}
+
+	QTime timer;
+	timer.start();
+	if (!throughput(connections, serverSet, bytes))
+	{
+		return 1;
+	}
+	int throughputTime = std::max(timer.elapsed(), 1);
+
+	timer.start();
+	for (unsigned i = 0; i < pings; ++i)
+	{
+		if (!pingPong(connections[i % CLIENTS]))
+		{
+			return 1;
+		}
+	}
+	int pingTime = timer.elapsed();
+
+	printf("Loopback, %u connections: %.1f MB/s, round trip %.1f us\n", (unsigned)CLIENTS,
+	       bytes*(double)CLIENTS/1000.0/throughputTime, pingTime*1000.0/pings);
+
+	for (unsigned i = 0; i < CLIENTS; ++i)
+	{
+		SocketSet_DelSocket(serverSet, connections[i].server);
+		socketClose(connections[i].client);
+		socketClose(connections[i].server);
+	}
+	deleteSocketSet(serverSet);
+	socketClose(listenSocket);
+	SOCKETshutdown();
+	return 0;
+}
@@ -3,11 +3,55 @@
 #include <string.h>
 #include <limits.h>
 #include <QtCore/QCoreApplication>
+#include <QtScript/QScriptEngine>
 #include "lint.h"
+#include "src/qtscriptevents.h"
+
+// A handler which changes 'me', and sets up another handler, must have both seen by the next event, in the same
+// game tick. The game refreshes the handlers after every call into a script, as done here.
+static bool testEventHandlers()
+{
+	QScriptEngine engine;
+	engine.evaluate("var me = 0; var isReceivingAllEvents = false; var built = -1;\n"
+	                "function eventGameInit() { me = 3; isReceivingAllEvents = true; eventDroidBuilt = function(droid) { built = droid; }; }");
+	SCRIPT_EVENT_HANDLERS h;
+	int handlerCount[EVENT_COUNT] = {0};
+	h.refresh(&engine, handlerCount);
+	if (h.player != 0 || h.receiveAll || !h.handler[EVENT_GAME_INIT].isValid() || h.handler[EVENT_DROID_BUILT].isValid()
+	    || handlerCount[EVENT_GAME_INIT] != 1 || handlerCount[EVENT_DROID_BUILT] != 0)
+	{
+		fprintf(stderr, "qtscripttest: Wrong handlers before eventGameInit\n");
+		return false;
+	}
+	h.handler[EVENT_GAME_INIT].call();
+	h.refresh(&engine, handlerCount);
+	if (h.player != 3 || !h.receiveAll || !h.handler[EVENT_DROID_BUILT].isValid() || handlerCount[EVENT_DROID_BUILT] != 1)
+	{
+		fprintf(stderr, "qtscripttest: Changes made in eventGameInit not seen\n");
+		return false;
+	}
+	h.handler[EVENT_DROID_BUILT].call(QScriptValue(), QScriptValueList() << QScriptValue(7));
+	if (engine.globalObject().property("built").toInt32() != 7)
+	{
+		fprintf(stderr, "qtscripttest: eventDroidBuilt set in eventGameInit not called\n");
+		return false;
+	}
+	h.refresh(&engine, handlerCount);
+	if (handlerCount[EVENT_GAME_INIT] != 1 || handlerCount[EVENT_DROID_BUILT] != 1)
+	{
+		fprintf(stderr, "qtscripttest: Handlers counted twice\n");
+		return false;
+	}
+	return true;
+}
 
 int main(int argc, char **argv)
 {
 	QCoreApplication app(argc, argv);
+	if (!testEventHandlers())
+	{
+		return 1;
+	}
 	char datapath[PATH_MAX], fullpath[PATH_MAX], filename[PATH_MAX];
 	FILE *fp = fopen("jslist.txt", "r");
 	if (!fp)
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include "lib/framework/radixsort.h"
+
+// Mirrors BUCKET_TAG in src/bucket3d.cpp.
+struct Tag
+{
+	int type;
+	void *object;
+	uint32_t sortKey;
+};
+
+struct TagKey
+{
+	uint32_t operator ()(Tag const &tag) const { return tag.sortKey; }
+};
+
+static bool tagLess(Tag const &a, Tag const &b)
+{
+	return a.sortKey < b.sortKey;
+}
+
+static void makeTags(std::vector<Tag> &tags, unsigned count)
+{
+	tags.resize(count);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		tags[i].type = rand() % 10;
+		tags[i].object = &tags[i];
+		// Depth like keys, with plenty of duplicates to check stability.
+		tags[i].sortKey = radixSortClampKey(RADIXSORT_KEY_MAX - rand() % 20000);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned count = argc > 1 ? atoi(argv[1]) : 10000;
+	const unsigned frames = 500;
+	std::vector<Tag> source, radix, reference, scratch;
+
+	srand(42);
+	makeTags(source, count);
+
+	reference = source;
+	std::stable_sort(reference.begin(), reference.end(), tagLess);
+	radix = source;
+	radixSort(radix, scratch, TagKey());
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (radix[i].object != reference[i].object)
+		{
+			fprintf(stderr, "radixsorttest: Mismatch at %u\n", i);
+			return 1;
+		}
+	}
+
+	clock_t start = clock();
+	for (unsigned frame = 0; frame < frames; ++frame)
+	{
+		reference = source;
+		std::sort(reference.begin(), reference.end(), tagLess);
+	}
+	clock_t stdTime = clock() - start;
+
+	start = clock();
+	for (unsigned frame = 0; frame < frames; ++frame)
+	{
+		radix = source;
+		radixSort(radix, scratch, TagKey());
+	}
+	clock_t radixTime = clock() - start;
+
+	printf("Sorting %u tags, %u times: std::sort %.2f ms, radixSort %.2f ms\n", count, frames,
+	       stdTime * 1000.0 / CLOCKS_PER_SEC, radixTime * 1000.0 / CLOCKS_PER_SEC);
+	return 0;
+}
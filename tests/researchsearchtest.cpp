@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "src/researchsearch.h"
+
+// Checks that researchSearchDepthFirst, as the legacy pursueResearch in src/scriptfuncs.cpp uses it, chooses the
+// same topic as the loop pursueResearch had before, on the real research trees, for many research states.
+
+struct Topic
+{
+	std::string id;
+	std::vector<std::string> required;
+	std::vector<unsigned short> pPRList;
+};
+
+enum Status
+{
+	NOT_STARTED,
+	STARTED,
+	COMPLETED
+};
+
+static std::vector<Topic> topics;
+static std::vector<Status> status;
+static std::vector<bool> avail;
+static std::vector<bool> ally;
+
+static bool skTopicAvail(int topic, int)
+{
+	return avail[topic];
+}
+
+static bool beingResearchedByAlly(int topic, int)
+{
+	return ally[topic];
+}
+
+static bool isCompleted(int topic)
+{
+	return status[topic] == COMPLETED;
+}
+
+static bool isStartedPending(int topic)
+{
+	return status[topic] == STARTED;
+}
+
+// The same as scrPursueResearchStep and scrPursueResearchThrough.
+static bool researchThrough(int topic, int player)
+{
+	return !isCompleted(topic) && !isStartedPending(topic);
+}
+
+static bool researchStep(int topic, int player)
+{
+	if (beingResearchedByAlly(topic, player))
+	{
+		return false;
+	}
+	return skTopicAvail(topic, player) || (topics[topic].pPRList.empty() && researchThrough(topic, player));
+}
+
+// The loop of pursueResearch before researchSearchDepthFirst, when the target itself can't be chosen. Returns
+// OVERFLOWED where the loop would have overrun its stack, by going round a cycle of prerequisites.
+#define OVERFLOWED -2
+#define STACK_SIZE 4000
+
+static int oldPursueResearch(unsigned index, int player)
+{
+	int foundIndex = -1, cur, tempIndex, Stack[STACK_SIZE];
+	int top = -1;
+
+	cur = 0;				//start with first index's PR
+	while (true)	//do
+	{
+		if (cur >= (int)topics[index].pPRList.size())		//node has nodes?
+		{
+			top = top - 2;
+			if (top < (-1))
+			{
+				break;		//end of stack
+			}
+			index = Stack[top + 2];	//if index = -1, then exit
+			cur = Stack[top + 1];		//go to next PR of the last node, since this one didn't work
+
+		}
+		else		//end of nodes not reached
+		{
+			tempIndex = topics[index].pPRList[cur];		//get cur node's index
+
+			if (skTopicAvail(tempIndex, player) && (!beingResearchedByAlly(tempIndex, player)))	//<NEW> - ally check added
+			{
+				foundIndex = tempIndex;		//done
+				break;
+			}
+			else if (!isCompleted(tempIndex) && !isStartedPending(tempIndex))  //not avail and not busy with it, can check this PR's PR
+			{
+				if (!topics[tempIndex].pPRList.empty())	//node has any nodes itself
+				{
+					if (top + 2 >= STACK_SIZE)
+					{
+						return OVERFLOWED;
+					}
+					Stack[top + 1] = cur;								//so can go back to it further
+					Stack[top + 2] = index;
+					top = top + 2;
+
+					index = tempIndex;		//go 1 level further
+					cur = -1;									//start with first PR of this PR next time
+				}
+				else		//has no PRs, choose it (?)
+				{
+					if (!beingResearchedByAlly(tempIndex, player))	//<NEW> ally check added
+					{
+						foundIndex = tempIndex;	//done
+						break;
+					}
+				}
+			}
+		}
+
+		cur++;				//try next node of the main node
+		if ((cur >= (int)topics[index].pPRList.size()) && (top <= (-1)))	//nothing left
+		{
+			break;
+		}
+	}
+	return foundIndex;
+}
+
+static std::string trim(std::string const &str)
+{
+	size_t begin = str.find_first_not_of(" \t\r\n");
+	size_t end = str.find_last_not_of(" \t\r\n");
+	return begin == std::string::npos ? std::string() : str.substr(begin, end + 1 - begin);
+}
+
+static bool loadResearch(char const *filename)
+{
+	FILE *fp = fopen(filename, "r");
+	char line[4096];
+
+	if (!fp)
+	{
+		fprintf(stderr, "researchsearchtest: Failed to open \"%s\"\n", filename);
+		return false;
+	}
+	topics.clear();
+	while (fgets(line, sizeof(line), fp))
+	{
+		std::string str = trim(line);
+		if (!str.empty() && str[0] == '[')
+		{
+			topics.push_back(Topic());
+			topics.back().id = str.substr(1, str.find(']') - 1);
+		}
+		else if (!topics.empty() && str.compare(0, strlen("requiredResearch"), "requiredResearch") == 0)
+		{
+			str = str.substr(str.find('=') + 1);
+			for (size_t comma; !str.empty(); str = comma == std::string::npos ? std::string() : str.substr(comma + 1))
+			{
+				comma = str.find(',');
+				topics.back().required.push_back(trim(str.substr(0, comma)));
+			}
+		}
+	}
+	fclose(fp);
+
+	std::map<std::string, int> index;
+	for (unsigned i = 0; i < topics.size(); ++i)
+	{
+		index[topics[i].id] = i;
+	}
+	for (unsigned i = 0; i < topics.size(); ++i)
+	{
+		for (unsigned j = 0; j < topics[i].required.size(); ++j)
+		{
+			if (!index.count(topics[i].required[j]))
+			{
+				fprintf(stderr, "researchsearchtest: %s: Unknown research \"%s\"\n", filename, topics[i].required[j].c_str());
+				return false;
+			}
+			topics[i].pPRList.push_back(index[topics[i].required[j]]);
+		}
+	}
+	return true;
+}
+
+// Completes random topics whose prerequisites are complete, and starts or makes available some of the rest.
+static void randomState()
+{
+	status.assign(topics.size(), NOT_STARTED);
+	avail.assign(topics.size(), false);
+	ally.assign(topics.size(), false);
+	int completeChance = rand() % 100;
+	for (bool changed = true; changed; )
+	{
+		changed = false;
+		for (unsigned i = 0; i < topics.size(); ++i)
+		{
+			bool ready = status[i] == NOT_STARTED;
+			for (unsigned j = 0; j < topics[i].pPRList.size(); ++j)
+			{
+				ready = ready && (topics[i].pPRList[j] == i || status[topics[i].pPRList[j]] == COMPLETED);  // R-Vehicle-Body01 needs itself.
+			}
+			if (ready && rand() % 100 < completeChance)
+			{
+				status[i] = COMPLETED;
+				changed = true;
+			}
+		}
+	}
+	for (unsigned i = 0; i < topics.size(); ++i)
+	{
+		if (status[i] != COMPLETED)
+		{
+			status[i] = rand() % 10 == 0 ? STARTED : NOT_STARTED;
+			avail[i] = status[i] == NOT_STARTED && rand() % 4 == 0;
+		}
+		ally[i] = rand() % 10 == 0;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *files[] = {"mp/stats/research.ini", "base/stats/research_cam1.ini", "base/stats/research_cam2.ini", "base/stats/research_cam3.ini"};
+	const char *srcdir = getenv("srcdir");
+	unsigned searches = 0, found = 0, overflowed = 0;
+
+	srand(42);
+	for (unsigned f = 0; f < sizeof(files)/sizeof(*files); ++f)
+	{
+		char filename[PATH_MAX];
+		snprintf(filename, sizeof(filename), "%s/../data/%s", srcdir ? srcdir : ".", files[f]);
+		if (!loadResearch(filename))
+		{
+			return 1;
+		}
+		for (unsigned state = 0; state < 200; ++state)
+		{
+			randomState();
+			for (unsigned target = 0; target < topics.size(); ++target)
+			{
+				// pursueResearch only searches the prerequisites of a target it can't choose, and needn't research.
+				if (ally[target] || status[target] != NOT_STARTED || avail[target])
+				{
+					continue;
+				}
+				int expected = oldPursueResearch(target, 0);
+				if (expected == OVERFLOWED)
+				{
+					++overflowed;
+					continue;
+				}
+				int result = researchSearchDepthFirst(topics, target, 0, researchStep, researchThrough);
+				if (result != expected)
+				{
+					fprintf(stderr, "researchsearchtest: %s: For \"%s\", chose \"%s\" instead of \"%s\"\n", files[f], topics[target].id.c_str(),
+					        result >= 0 ? topics[result].id.c_str() : "nothing", expected >= 0 ? topics[expected].id.c_str() : "nothing");
+					return 1;
+				}
+				++searches;
+				found += result >= 0;
+			}
+		}
+	}
+
+	printf("researchsearchtest: %u searches, %u found a topic, all the same as before, %u overran the old stack\n", searches, found, overflowed);
+	return 0;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "lib/framework/frame.h"
+#include "lib/script/script.h"
+
+// --- dummy implementations of what the game would provide ---
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// Defined in src/scriptfuncs.cpp, only needed for comparing objects.
+bool scriptOperatorEquals(INTERP_VAL const &v1, INTERP_VAL const &v2)
+{
+	return v1.v.ival == v2.v.ival;
+}
+
+// --- end linking hacks ---
+
+enum { VAR_I, VAR_SUM, VAR_CALLS, NUM_GLOBALS };
+
+static void emit(std::vector<INTERP_VAL> &code, OPCODE opcode, unsigned data = 0)
+{
+	INTERP_VAL val;
+	val.type = VAL_PKOPCODE;
+	val.v.ival = opcode << OPCODE_SHIFT | (data & OPCODE_DATAMASK);
+	code.push_back(val);
+}
+
+static void emitValue(std::vector<INTERP_VAL> &code, INTERP_TYPE type, int value)
+{
+	INTERP_VAL val;
+	val.type = type;
+	val.v.ival = value;
+	code.push_back(val);
+}
+
+static void emitInt(std::vector<INTERP_VAL> &code, int value)
+{
+	emit(code, OP_PUSH, VAL_INT);
+	emitValue(code, VAL_INT, value);
+}
+
+static void emitJump(std::vector<INTERP_VAL> &code, OPCODE opcode, unsigned target)
+{
+	emit(code, opcode, (uint16_t)(target - code.size()));
+}
+
+/* Builds the equivalent of:
+ *
+ *   event main { i = 0; while (i < count) { sum = sum + i; count(); i = i + 1; } }
+ *   function count() { calls = calls + 1; }
+ */
+static SCRIPT_CODE *makeProgram(int count)
+{
+	std::vector<INTERP_VAL> code;
+	unsigned loop, exitJump, function;
+
+	emitInt(code, 0);
+	emit(code, OP_POPGLOBAL, VAR_I);
+	loop = code.size();
+	emit(code, OP_PUSHGLOBAL, VAR_I);
+	emitInt(code, count);
+	emit(code, OP_BINARYOP, OP_LESS);
+	exitJump = code.size();
+	emit(code, OP_JUMPFALSE);
+	emit(code, OP_PUSHGLOBAL, VAR_SUM);
+	emit(code, OP_PUSHGLOBAL, VAR_I);
+	emit(code, OP_BINARYOP, OP_ADD);
+	emit(code, OP_POPGLOBAL, VAR_SUM);
+	emit(code, OP_FUNC);
+	emitValue(code, VAL_EVENT, 1);
+	emit(code, OP_PUSHGLOBAL, VAR_I);
+	emitInt(code, 1);
+	emit(code, OP_BINARYOP, OP_ADD);
+	emit(code, OP_POPGLOBAL, VAR_I);
+	emitJump(code, OP_JUMP, loop);
+	code[exitJump].v.ival |= (uint16_t)(code.size() - exitJump);
+
+	function = code.size();
+	emit(code, OP_PUSHGLOBAL, VAR_CALLS);
+	emitInt(code, 1);
+	emit(code, OP_BINARYOP, OP_ADD);
+	emit(code, OP_POPGLOBAL, VAR_CALLS);
+
+	SCRIPT_CODE *psProg = (SCRIPT_CODE *)calloc(1, sizeof(SCRIPT_CODE));
+	psProg->size = code.size() * sizeof(INTERP_VAL);
+	psProg->pCode = (INTERP_VAL *)malloc(psProg->size);
+	memcpy(psProg->pCode, &code[0], psProg->size);
+	psProg->numEvents = 2;
+	psProg->pEventTab = (UWORD *)malloc(3 * sizeof(UWORD));
+	psProg->pEventTab[0] = 0;
+	psProg->pEventTab[1] = function;
+	psProg->pEventTab[2] = code.size();
+	psProg->pEventLinks = (SWORD *)calloc(2, sizeof(SWORD));
+	psProg->numGlobals = NUM_GLOBALS;
+	psProg->pGlobals = (INTERP_TYPE *)malloc(NUM_GLOBALS * sizeof(INTERP_TYPE));
+	for (int i = 0; i < NUM_GLOBALS; ++i)
+	{
+		psProg->pGlobals[i] = VAL_INT;
+	}
+	psProg->ppsLocalVars = (INTERP_TYPE **)calloc(2, sizeof(INTERP_TYPE *));
+	psProg->numLocalVars = (UDWORD *)calloc(2, sizeof(UDWORD));
+	psProg->numParams = (UDWORD *)calloc(2, sizeof(UDWORD));
+	return psProg;
+}
+
+static int global(SCRIPT_CONTEXT *psContext, unsigned index)
+{
+	INTERP_VAL *psVal = NULL;
+	eventGetContextVal(psContext, index, &psVal);
+	return psVal->v.ival;
+}
+
+int main(int argc, char **argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 10000;
+	const unsigned runs = 500;
+	SCRIPT_CONTEXT *psContext = NULL;
+
+	scriptInitialise();
+	SCRIPT_CODE *psProg = makeProgram(count);
+	if (!eventNewContext(psProg, CR_RELEASE, &psContext))
+	{
+		fprintf(stderr, "scriptinterptest: Could not create context\n");
+		return 1;
+	}
+
+	clock_t start = clock();
+	for (unsigned run = 0; run < runs; ++run)
+	{
+		INTERP_VAL zero;
+		zero.type = VAL_INT;
+		zero.v.ival = 0;
+		eventSetContextVar(psContext, VAR_SUM, &zero);
+		eventSetContextVar(psContext, VAR_CALLS, &zero);
+		if (!interpRunScript(psContext, IRT_EVENT, 0, 0))
+		{
+			fprintf(stderr, "scriptinterptest: Script failed\n");
+			return 1;
+		}
+	}
+	clock_t time = clock() - start;
+
+	if (global(psContext, VAR_SUM) != count*(count - 1)/2 || global(psContext, VAR_CALLS) != count)
+	{
+		fprintf(stderr, "scriptinterptest: Wrong result, sum %d, calls %d\n", global(psContext, VAR_SUM), global(psContext, VAR_CALLS));
+		return 1;
+	}
+
+	// 14 instructions in the loop, and 4 in the function.
+	double instructions = 18.0 * count * runs;
+	printf("Ran %u loops of %d iterations: %.2f ms, %.2f ns per instruction\n", runs, count,
+	       time * 1000.0 / CLOCKS_PER_SEC, time * 1e9 / CLOCKS_PER_SEC / instructions);
+
+	eventRemoveContext(psContext);
+	scriptFreeCode(psProg);
+	scriptShutDown();
+	return 0;
+}
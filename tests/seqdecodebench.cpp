@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <theora/theora.h>
+#include "lib/sequence/yuv.h"
+
+// Decodes the Theora stream of a sequence, without showing it, and converts every frame to RGBA
+// both with the scalar conversion and with the one the game uses, checking they are the same.
+// Prints the time taken by each, as the decoder thread in lib/sequence/sequence.cpp spends it.
+
+static bool readPage(FILE *file, ogg_sync_state *oy, ogg_page *og)
+{
+	while (ogg_sync_pageout(oy, og) <= 0)
+	{
+		char *buffer = ogg_sync_buffer(oy, 4096);
+		size_t bytes = fread(buffer, 1, 4096, file);
+		if (bytes == 0)
+		{
+			return false;
+		}
+		ogg_sync_wrote(oy, bytes);
+	}
+	return true;
+}
+
+static double elapsed(clock_t start)
+{
+	return (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: seqdecodebench <sequence.ogg>\n");
+		return 1;
+	}
+	FILE *file = fopen(argv[1], "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "seqdecodebench: Could not open %s\n", argv[1]);
+		return 1;
+	}
+
+	ogg_sync_state oy;
+	ogg_page og;
+	ogg_packet op;
+	ogg_stream_state to;
+	theora_info ti;
+	theora_comment tc;
+	theora_state td;
+	int headers = 0;
+	bool found = false;
+
+	ogg_sync_init(&oy);
+	theora_info_init(&ti);
+	theora_comment_init(&tc);
+
+	// Find the Theora stream among the initial pages, and read its three headers.
+	while (headers < 3)
+	{
+		if (!readPage(file, &oy, &og))
+		{
+			fprintf(stderr, "seqdecodebench: No Theora stream in %s\n", argv[1]);
+			return 1;
+		}
+		if (!found && ogg_page_bos(&og))
+		{
+			ogg_stream_state test;
+			ogg_stream_init(&test, ogg_page_serialno(&og));
+			ogg_stream_pagein(&test, &og);
+			if (ogg_stream_packetout(&test, &op) > 0 && theora_decode_header(&ti, &tc, &op) >= 0)
+			{
+				memcpy(&to, &test, sizeof(test));
+				found = true;
+				headers = 1;
+			}
+			else
+			{
+				ogg_stream_clear(&test);
+			}
+			continue;
+		}
+		if (!found)
+		{
+			continue;
+		}
+		ogg_stream_pagein(&to, &og);
+		while (headers < 3 && ogg_stream_packetout(&to, &op) > 0)
+		{
+			if (theora_decode_header(&ti, &tc, &op) != 0)
+			{
+				fprintf(stderr, "seqdecodebench: Broken Theora headers\n");
+				return 1;
+			}
+			++headers;
+		}
+	}
+	if (ti.pixelformat != OC_PF_420)
+	{
+		fprintf(stderr, "seqdecodebench: Video not in YUV420 format\n");
+		return 1;
+	}
+	theora_decode_init(&td, &ti);
+
+	const unsigned width = ti.frame_width, height = ti.frame_height;
+	printf("%s: %ux%u, %.02f fps, converting with %s\n", argv[1], width, height, (double)ti.fps_numerator / ti.fps_denominator, yuv420ToRgbaImplementation());
+
+	std::vector<uint8_t> scalar(width * height * 4), converted(width * height * 4);
+	double decodeTime = 0, scalarTime = 0, convertTime = 0;
+	unsigned frames = 0;
+	bool more = true;
+	while (more)
+	{
+		int ret;
+		while ((ret = ogg_stream_packetout(&to, &op)) != 0)
+		{
+			if (ret < 0)
+			{
+				continue;  // A hole in the data.
+			}
+			clock_t start = clock();
+			theora_decode_packetin(&td, &op);
+			yuv_buffer yuv;
+			theora_decode_YUVout(&td, &yuv);
+			decodeTime += elapsed(start);
+
+			start = clock();
+			for (unsigned y = 0; y < height; ++y)
+			{
+				const int uvOffset = (y >> 1) * yuv.uv_stride;
+				yuv420ToRgbaRowScalar(&scalar[y * width * 4], yuv.y + y * yuv.y_stride, yuv.u + uvOffset, yuv.v + uvOffset, width);
+			}
+			scalarTime += elapsed(start);
+
+			start = clock();
+			for (unsigned y = 0; y < height; ++y)
+			{
+				const int uvOffset = (y >> 1) * yuv.uv_stride;
+				yuv420ToRgbaRow(&converted[y * width * 4], yuv.y + y * yuv.y_stride, yuv.u + uvOffset, yuv.v + uvOffset, width);
+			}
+			convertTime += elapsed(start);
+
+			if (scalar != converted)
+			{
+				fprintf(stderr, "seqdecodebench: Frame %u differs from the scalar conversion\n", frames);
+				return 1;
+			}
+			++frames;
+		}
+		more = readPage(file, &oy, &og);
+		if (more)
+		{
+			ogg_stream_pagein(&to, &og);
+		}
+	}
+
+	if (frames == 0)
+	{
+		fprintf(stderr, "seqdecodebench: No frames decoded\n");
+		return 1;
+	}
+	printf("%u frames: decode %.3f ms/frame, convert scalar %.3f ms/frame, convert %s %.3f ms/frame\n", frames,
+	       decodeTime / frames, scalarTime / frames, yuv420ToRgbaImplementation(), convertTime / frames);
+
+	theora_clear(&td);
+	theora_comment_clear(&tc);
+	theora_info_clear(&ti);
+	ogg_stream_clear(&to);
+	ogg_sync_clear(&oy);
+	fclose(file);
+	return 0;
+}
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "lib/framework/frame.h"
+#include "lib/framework/slaballoc.h"
+
+// --- dummy implementations of what the game would provide ---
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// --- end linking hacks ---
+
+enum { PLAYERS = 8 };
+
+// Roughly the size and layout of a DROID, with the fields gameStateUpdate touches spread out.
+struct DroidData
+{
+	int x, y, z;
+	int speed, body;
+	char middle[600];
+	int order, action;
+	char rest[500];
+};
+
+struct HeapDroid : public DroidData
+{
+	HeapDroid *psNext;
+};
+
+struct SlabDroid : public DroidData, public SlabAllocated<SlabDroid>
+{
+	SlabDroid *psNext;
+};
+
+// Some other garbage, so that heap droids end up spread out like in the game.
+static std::vector<std::vector<char> *> clutter;
+
+static void makeClutter()
+{
+	clutter.push_back(new std::vector<char>(16 + rand() % 2000));
+	if (clutter.size() > 3000)
+	{
+		unsigned i = rand() % clutter.size();
+		delete clutter[i];
+		clutter[i] = clutter.back();
+		clutter.pop_back();
+	}
+}
+
+static void freeClutter()
+{
+	for (unsigned i = 0; i < clutter.size(); ++i)
+	{
+		delete clutter[i];
+	}
+	clutter.clear();
+}
+
+template <typename Droid>
+static Droid *newDroid(unsigned player);
+
+template <>
+HeapDroid *newDroid<HeapDroid>(unsigned)
+{
+	return new HeapDroid;
+}
+
+template <>
+SlabDroid *newDroid<SlabDroid>(unsigned player)
+{
+	return new (player) SlabDroid;
+}
+
+template <typename Droid>
+static void addDroid(Droid **apsLists, unsigned player)
+{
+	Droid *psDroid = newDroid<Droid>(player);
+	psDroid->x = rand() % 10000;
+	psDroid->y = rand() % 10000;
+	psDroid->z = 0;
+	psDroid->speed = 1 + rand() % 10;
+	psDroid->body = 1000;
+	psDroid->order = rand() % 4;
+	psDroid->action = 0;
+	psDroid->psNext = apsLists[player];
+	apsLists[player] = psDroid;
+	makeClutter();
+}
+
+// Deletes the n-th droid of a player, and replaces it.
+template <typename Droid>
+static void replaceDroid(Droid **apsLists, unsigned player, unsigned n)
+{
+	Droid **ppsDroid = &apsLists[player];
+	for (unsigned i = 0; i < n && (*ppsDroid)->psNext != NULL; ++i)
+	{
+		ppsDroid = &(*ppsDroid)->psNext;
+	}
+	Droid *psDead = *ppsDroid;
+	*ppsDroid = psDead->psNext;
+	delete psDead;
+	addDroid(apsLists, player);
+}
+
+// The part of gameStateUpdate which walks every droid list.
+template <typename Droid>
+static unsigned update(Droid **apsLists)
+{
+	unsigned sum = 0;
+	for (unsigned player = 0; player < PLAYERS; ++player)
+	{
+		for (Droid *psDroid = apsLists[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			psDroid->x += psDroid->speed;
+			psDroid->y -= psDroid->speed;
+			if (psDroid->order == 1)
+			{
+				psDroid->action = (psDroid->action + 1) & 7;
+			}
+			sum += psDroid->x + psDroid->body + psDroid->action;
+		}
+	}
+	return sum;
+}
+
+template <typename Droid>
+static clock_t run(unsigned count, unsigned frames, unsigned *pResult)
+{
+	Droid *apsLists[PLAYERS] = {NULL};
+
+	srand(42);
+	freeClutter();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		addDroid(apsLists, i % PLAYERS);
+	}
+	// Let the game run a while, so the lists are no longer in allocation order.
+	for (unsigned i = 0; i < count; ++i)
+	{
+		replaceDroid(apsLists, rand() % PLAYERS, rand() % (count / PLAYERS));
+	}
+
+	unsigned result = 0;
+	clock_t start = clock();
+	for (unsigned frame = 0; frame < frames; ++frame)
+	{
+		result += update(apsLists);
+	}
+	clock_t time = clock() - start;
+
+	for (unsigned player = 0; player < PLAYERS; ++player)
+	{
+		while (apsLists[player] != NULL)
+		{
+			Droid *psNext = apsLists[player]->psNext;
+			delete apsLists[player];
+			apsLists[player] = psNext;
+		}
+	}
+	freeClutter();
+	*pResult = result;
+	return time;
+}
+
+static bool checkHandles()
+{
+	SlabDroid *psA = new (3) SlabDroid;
+	SlabDroid *psB = new (3) SlabDroid;
+	SlabHandle<SlabDroid> a(psA), b(psB);
+
+	if (a.get() != psA || b.get() != psB || (size_t)((char *)psB - (char *)psA) >= sizeof(SlabDroid) + 32)
+	{
+		fprintf(stderr, "slaballoctest: Objects of a pool are not next to each other\n");
+		return false;
+	}
+	delete psA;
+	SlabDroid *psC = new (3) SlabDroid;
+	if (psC != psA || a.get() != NULL || SlabHandle<SlabDroid>(psC).get() != psC || b.get() != psB)
+	{
+		fprintf(stderr, "slaballoctest: Freed slot not reused, or stale handle still valid\n");
+		return false;
+	}
+	delete psB;
+	delete psC;
+	return SlabDroid::slabAllocator().liveCount() == 0;
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned count = argc > 1 ? atoi(argv[1]) : 5000;
+	const unsigned frames = 2000;
+	unsigned heapResult, slabResult;
+
+	if (!checkHandles())
+	{
+		return 1;
+	}
+
+	clock_t heapTime = run<HeapDroid>(count, frames, &heapResult);
+	clock_t slabTime = run<SlabDroid>(count, frames, &slabResult);
+	if (heapResult != slabResult)
+	{
+		fprintf(stderr, "slaballoctest: Results differ\n");
+		return 1;
+	}
+
+	printf("Updating %u droids, %u times: new %.2f ms, slabs %.2f ms\n", count, frames,
+	       heapTime * 1000.0 / CLOCKS_PER_SEC, slabTime * 1000.0 / CLOCKS_PER_SEC);
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "lib/sequence/yuv.h"
+
+// The conversion as video_write in lib/sequence/sequence.cpp did it, one pixel at a time.
+static void referencePixel(uint8_t *rgba, int y, int u, int v)
+{
+	const int Y = y - 16, U = u - 128, V = v - 128;
+	const int A = 298 * Y;
+	const int C = 409 * V;
+	const int rgb[3] = {(A + C + 128) >> 8, (A - 100 * U - (C >> 1) + 128) >> 8, (A + 516 * U + 128) >> 8};
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		rgba[i] = rgb[i] < 0 ? 0 : rgb[i] > 255 ? 255 : rgb[i];
+	}
+	rgba[3] = 0xFF;
+}
+
+static bool check(char const *what, std::vector<uint8_t> const &result, std::vector<uint8_t> const &expected, unsigned width)
+{
+	if (memcmp(&result[0], &expected[0], expected.size()) == 0)
+	{
+		return true;
+	}
+	for (unsigned i = 0; i < expected.size(); ++i)
+	{
+		if (result[i] != expected[i])
+		{
+			fprintf(stderr, "yuvtest: %s mismatch at pixel %u of %u, channel %u: %d, expected %d\n", what, i / 4, width, i % 4, result[i], expected[i]);
+			break;
+		}
+	}
+	return false;
+}
+
+int main()
+{
+	printf("yuvtest: Using %s\n", yuv420ToRgbaImplementation());
+
+	// Every Y for every U and V, as a row of 256 pixels with constant U and V.
+	std::vector<uint8_t> y(256), u(128), v(128), expected(256 * 4), scalar(256 * 4), row(256 * 4);
+	for (unsigned i = 0; i < 256; ++i)
+	{
+		y[i] = i;
+	}
+	for (unsigned cu = 0; cu < 256; ++cu)
+	{
+		for (unsigned cv = 0; cv < 256; ++cv)
+		{
+			memset(&u[0], cu, u.size());
+			memset(&v[0], cv, v.size());
+			for (unsigned i = 0; i < 256; ++i)
+			{
+				referencePixel(&expected[4*i], y[i], cu, cv);
+			}
+			yuv420ToRgbaRowScalar(&scalar[0], &y[0], &u[0], &v[0], 256);
+			yuv420ToRgbaRow(&row[0], &y[0], &u[0], &v[0], 256);
+			if (!check("scalar", scalar, expected, 256) || !check("row", row, expected, 256))
+			{
+				return 1;
+			}
+		}
+	}
+
+	// Random rows of all widths, at unaligned offsets, to check the ends of rows. An odd pixel at the end is left alone.
+	srand(42);
+	for (unsigned width = 0; width < 100; ++width)
+	{
+		const unsigned offset = rand() % 16;
+		// One more byte than needed, so that no vector is empty.
+		std::vector<uint8_t> ry(offset + width + 1), ru(offset + width/2 + 1), rv(offset + width/2 + 1);
+		std::vector<uint8_t> expect(offset + width * 4 + 1, 0xAB), result(offset + width * 4 + 1, 0xAB);
+		for (unsigned i = 0; i < ry.size(); ++i)
+		{
+			ry[i] = rand();
+		}
+		for (unsigned i = 0; i < ru.size(); ++i)
+		{
+			ru[i] = rand();
+			rv[i] = rand();
+		}
+		for (unsigned i = 0; i < width / 2 * 2; ++i)
+		{
+			referencePixel(&expect[offset + 4*i], ry[offset + i], ru[offset + i/2], rv[offset + i/2]);
+		}
+		yuv420ToRgbaRow(&result[offset], &ry[offset], &ru[offset], &rv[offset], width);
+		if (!check("random row", result, expect, width))
+		{
+			return 1;
+		}
+	}
+
+	printf("yuvtest: All conversions exact\n");
+	return 0;
+}
@@ -0,0 +1,501 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2013  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * wzrelay.cpp
+ *
+ * Relays the games of many hosts through one process, one listening port per game.
+ * Each client connection is relayed to its own connection to the host, so the host
+ * sees the players as usual. After the version check, both connections are
+ * compressed, and the relay reads the messages, to count them per game, and to time
+ * the NET_PING round trips between the relay and the client, and the relay and the host.
+ * Connecting to the host is done on a thread per connection, so it doesn't hold up the other games.
+ *
+ * The host sees every relayed player at the relay's address, since the protocol has no way to pass on
+ * the client's address. Hosts list the relay in relay_addresses in their config, so that kicking one
+ * player doesn't ban the relay, and so everyone else on it. A kicked player can then rejoin.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTime>
+#include "lib/framework/frame.h"
+#include "lib/framework/metrics.h"
+#include "lib/framework/wzapp.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netqueue.h"
+#include "lib/netplay/netsocket.h"
+
+// --- what the game would provide ---
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+void inputInitialise()
+{
+}
+
+int wzGetTicks()
+{
+	static QTime time;
+	if (time.isNull())
+	{
+		time.start();
+	}
+	return time.elapsed();
+}
+
+// The same as in lib/qtgame, which we don't want to link.
+struct WZ_THREAD : public QThread
+{
+	WZ_THREAD(int (*threadFunc_)(void *), void *data_) : threadFunc(threadFunc_), data(data_) {}
+	void run()
+	{
+		ret = (*threadFunc)(data);
+	}
+	static void delay(unsigned ms)
+	{
+		msleep(ms);
+	}
+	int (*threadFunc)(void *);
+	void *data;
+	int ret;
+};
+
+struct WZ_MUTEX : public QMutex
+{
+};
+
+struct WZ_SEMAPHORE : public QSemaphore
+{
+	WZ_SEMAPHORE(int startValue = 0) : QSemaphore(startValue) {}
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data) { return new WZ_THREAD(threadFunc, data); }
+int wzThreadJoin(WZ_THREAD *thread) { thread->wait(); int ret = thread->ret; delete thread; return ret; }
+void wzThreadStart(WZ_THREAD *thread) { thread->start(); }
+WZ_MUTEX *wzMutexCreate() { return new WZ_MUTEX; }
+void wzMutexDestroy(WZ_MUTEX *mutex) { delete mutex; }
+void wzMutexLock(WZ_MUTEX *mutex) { mutex->lock(); }
+void wzMutexUnlock(WZ_MUTEX *mutex) { mutex->unlock(); }
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue) { return new WZ_SEMAPHORE(startValue); }
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore) { delete semaphore; }
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore) { semaphore->acquire(); }
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore) { semaphore->release(); }
+void wzDelay(unsigned int delay) { WZ_THREAD::delay(delay); }
+
+// --- end linking hacks ---
+
+#define RELAY_CONNECT_TIMEOUT 1000   // Clients give up on the version check after 1500ms.
+#define RELAY_POLL_TIMEOUT 50
+#define RELAY_BUFFER_SIZE (16*1024)
+
+enum ConnectionState
+{
+	STATE_VERSION,      ///< Waiting for the version from the client.
+	STATE_CONNECTING,   ///< Waiting for connectThread to connect to the host.
+	STATE_RESULT,       ///< Waiting for the host to accept the version.
+	STATE_RELAY,        ///< Relaying compressed messages both ways.
+	STATE_CLOSED,
+};
+
+struct Game;
+
+struct Connection
+{
+	Connection(Game *game_, Socket *client_) : game(game_), client(client_), host(NULL), state(STATE_VERSION), connectThread(NULL), connectDone(false), handshakeLen(0), clientPingTime(0), hostPingTime(0)
+	{
+		up.setWillNeverGetMessagesForNet();
+		down.setWillNeverGetMessagesForNet();
+	}
+
+	Game *game;
+	Socket *client;
+	Socket *host;
+	ConnectionState state;
+	WZ_THREAD *connectThread;       ///< Sets host and connectDone, under connectMutex.
+	bool connectDone;
+	uint8_t handshake[8];           ///< Version from the client, or result from the host.
+	unsigned handshakeLen;
+	NetQueue up;                    ///< Messages from the client to the host, for counting.
+	NetQueue down;                  ///< Messages from the host to the client.
+	uint32_t clientPingTime;        ///< When the host pinged the client, or 0.
+	uint32_t hostPingTime;          ///< When the client pinged the host, or 0.
+};
+
+struct Game
+{
+	unsigned port;
+	char hostName[256];
+	unsigned hostPort;
+	Socket *listenSocket;
+	std::vector<Connection *> connections;
+
+	// Since the last time the statistics were printed.
+	unsigned joins;
+	uint64_t wireUp, wireDown;      ///< Compressed bytes from the clients, and from the host.
+	uint64_t bytesUp, bytesDown;    ///< The same, uncompressed.
+	unsigned messagesUp, messagesDown;
+	MetricStats clientPing;         ///< Round trips between the relay and the clients, in milliseconds.
+	MetricStats hostPing;           ///< Round trips between the relay and the host, including the host's frame time.
+};
+
+static std::vector<Game *> games;
+static SocketSet *socketSet;
+static WZ_MUTEX *connectMutex;
+
+static void closeConnection(Connection *c)
+{
+	if (c->client != NULL)
+	{
+		SocketSet_DelSocket(socketSet, c->client);
+		socketClose(c->client);
+		c->client = NULL;
+	}
+	if (c->host != NULL)
+	{
+		SocketSet_DelSocket(socketSet, c->host);
+		socketClose(c->host);
+		c->host = NULL;
+	}
+	c->state = STATE_CLOSED;
+}
+
+// Checks a message on its way through, for the statistics.
+static void countMessage(Connection *c, NetMessage const &message, bool fromHost)
+{
+	Game *g = c->game;
+	uint32_t now = wzGetTicks();
+	++(fromHost ? g->messagesDown : g->messagesUp);
+
+	// NET_PING is the sender, then whether it is a new ping or the answer. The client and host answer pings sent directly to them directly.
+	if (message.type != NET_PING || message.data.size() < 2)
+	{
+		return;
+	}
+	bool isNew = message.data[1] != 0;
+	uint32_t &pingTime = fromHost == isNew ? c->clientPingTime : c->hostPingTime;
+	if (isNew && pingTime == 0)
+	{
+		pingTime = std::max(now, 1u);
+	}
+	else if (!isNew && pingTime != 0)
+	{
+		(fromHost ? g->hostPing : g->clientPing).add(now - pingTime);
+		pingTime = 0;
+	}
+}
+
+// Reads whatever is ready from one side, and writes it to the other side.
+static void relayData(Connection *c, bool fromHost)
+{
+	Socket *from = fromHost ? c->host : c->client;
+	Socket *to   = fromHost ? c->client : c->host;
+	Game *g = c->game;
+	uint8_t buffer[RELAY_BUFFER_SIZE];
+	size_t wireSize = 0;
+
+	ssize_t size = readNoInt(from, buffer, sizeof(buffer), &wireSize);
+	if ((size == 0 && socketReadDisconnected(from)) || size == SOCKET_ERROR)
+	{
+		closeConnection(c);
+		return;
+	}
+	(fromHost ? g->wireDown : g->wireUp) += wireSize;
+	(fromHost ? g->bytesDown : g->bytesUp) += size;
+	if (size == 0)
+	{
+		return;  // Compressed data which hasn't made any bytes yet.
+	}
+	if (writeAll(to, buffer, size) == SOCKET_ERROR)
+	{
+		closeConnection(c);
+		return;
+	}
+
+	NetQueue &queue = fromHost ? c->down : c->up;
+	queue.writeRawData(buffer, size);
+	while (queue.haveMessage())
+	{
+		countMessage(c, queue.getMessage(), fromHost);
+		queue.popMessage();
+	}
+}
+
+// Resolves and connects to the host, which can block for a while, so it doesn't run in the main loop.
+static int connectThreadFunc(void *data)
+{
+	Connection *c = (Connection *)data;
+	Game *g = c->game;
+
+	SocketAddress *address = resolveHost(g->hostName, g->hostPort);
+	Socket *host = address != NULL ? socketOpen(address, RELAY_CONNECT_TIMEOUT) : NULL;
+	deleteSocketAddress(address);
+
+	wzMutexLock(connectMutex);
+	c->host = host;
+	c->connectDone = true;
+	wzMutexUnlock(connectMutex);
+	return 0;
+}
+
+// Collects the handshake, which isn't compressed, and must not be read past, since the compressed data follows.
+static void relayHandshake(Connection *c)
+{
+	Game *g = c->game;
+
+	if (c->state == STATE_VERSION && socketReadReady(c->client))
+	{
+		ssize_t size = readNoInt(c->client, c->handshake + c->handshakeLen, 8 - c->handshakeLen);
+		if (size <= 0)
+		{
+			closeConnection(c);
+			return;
+		}
+		c->handshakeLen += size;
+		if (c->handshakeLen < 8)
+		{
+			return;
+		}
+
+		c->state = STATE_CONNECTING;
+		c->connectThread = wzThreadCreate(connectThreadFunc, c);
+		wzThreadStart(c->connectThread);
+	}
+	else if (c->state == STATE_CONNECTING)
+	{
+		wzMutexLock(connectMutex);
+		bool done = c->connectDone;
+		wzMutexUnlock(connectMutex);
+		if (!done)
+		{
+			return;
+		}
+		wzThreadJoin(c->connectThread);
+		c->connectThread = NULL;
+		if (c->host == NULL)
+		{
+			fprintf(stderr, "wzrelay: Port %u: Could not connect to %s:%u\n", g->port, g->hostName, g->hostPort);
+			closeConnection(c);
+			return;
+		}
+		SocketSet_AddSocket(socketSet, c->host);
+		writeAll(c->host, c->handshake, 8);
+		c->handshakeLen = 0;
+		c->state = STATE_RESULT;
+	}
+	else if (c->state == STATE_RESULT && socketReadReady(c->host))
+	{
+		ssize_t size = readNoInt(c->host, c->handshake + c->handshakeLen, 4 - c->handshakeLen);
+		if (size <= 0)
+		{
+			closeConnection(c);
+			return;
+		}
+		c->handshakeLen += size;
+		if (c->handshakeLen < 4)
+		{
+			return;
+		}
+
+		writeAll(c->client, c->handshake, 4);
+		uint32_t result;
+		memcpy(&result, c->handshake, 4);
+		if (ntohl(result) != ERROR_NOERROR)
+		{
+			c->state = STATE_CLOSED;  // Let the client read the result, the host will close its side.
+			return;
+		}
+		socketBeginCompression(c->client);
+		socketBeginCompression(c->host);
+		c->state = STATE_RELAY;
+		++g->joins;
+	}
+}
+
+static void printStatistics(unsigned seconds)
+{
+	for (unsigned i = 0; i < games.size(); ++i)
+	{
+		Game *g = games[i];
+		unsigned players = 0;
+		for (unsigned n = 0; n < g->connections.size(); ++n)
+		{
+			players += g->connections[n]->state == STATE_RELAY;
+		}
+		printf("port %u: %u players, %u joins, up %.1f kB/s (%.1f kB/s uncompressed, %u messages), down %.1f kB/s (%.1f kB/s uncompressed, %u messages), "
+		       "client ping %lld ms (max %lld), host ping %lld ms (max %lld)\n",
+		       g->port, players, g->joins,
+		       g->wireUp/1000.0/seconds, g->bytesUp/1000.0/seconds, g->messagesUp,
+		       g->wireDown/1000.0/seconds, g->bytesDown/1000.0/seconds, g->messagesDown,
+		       (long long)(g->clientPing.count? g->clientPing.sum/g->clientPing.count : 0), (long long)g->clientPing.max,
+		       (long long)(g->hostPing.count? g->hostPing.sum/g->hostPing.count : 0), (long long)g->hostPing.max);
+		g->joins = 0;
+		g->wireUp = g->wireDown = g->bytesUp = g->bytesDown = 0;
+		g->messagesUp = g->messagesDown = 0;
+		g->clientPing = MetricStats();
+		g->hostPing = MetricStats();
+	}
+	fflush(stdout);
+}
+
+// Parses port=host[:hostport].
+static Game *parseGame(char const *arg)
+{
+	Game *g = new Game;
+	char *colon;
+	g->hostPort = 2100;
+	if (sscanf(arg, "%u=%255s", &g->port, g->hostName) != 2)
+	{
+		delete g;
+		return NULL;
+	}
+	if ((colon = strrchr(g->hostName, ':')) != NULL)
+	{
+		*colon = '\0';
+		g->hostPort = atoi(colon + 1);
+	}
+	g->listenSocket = NULL;
+	g->joins = 0;
+	g->wireUp = g->wireDown = g->bytesUp = g->bytesDown = 0;
+	g->messagesUp = g->messagesDown = 0;
+	return g;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned statsInterval = 10;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		Game *g;
+		if (strncmp(argv[i], "--stats=", 8) == 0)
+		{
+			statsInterval = std::max(atoi(argv[i] + 8), 1);
+		}
+		else if ((g = parseGame(argv[i])) != NULL)
+		{
+			games.push_back(g);
+		}
+		else
+		{
+			fprintf(stderr, "wzrelay: Bad argument \"%s\"\n", argv[i]);
+			games.clear();
+			break;
+		}
+	}
+	if (games.empty())
+	{
+		fprintf(stderr, "Usage: wzrelay [--stats=<seconds>] <port>=<host>[:<host port>]...\n"
+		                "Relays the game hosted at host to players connecting to port, for each game given.\n");
+		return 1;
+	}
+
+	SOCKETinit();
+	socketSet = allocSocketSet();
+	connectMutex = wzMutexCreate();
+	for (unsigned i = 0; i < games.size(); ++i)
+	{
+		games[i]->listenSocket = socketListen(games[i]->port);
+		if (games[i]->listenSocket == NULL)
+		{
+			fprintf(stderr, "wzrelay: Could not listen on port %u\n", games[i]->port);
+			return 1;
+		}
+		printf("port %u: relaying to %s:%u\n", games[i]->port, games[i]->hostName, games[i]->hostPort);
+	}
+
+	uint32_t statsTime = wzGetTicks();
+	while (true)
+	{
+		bool connected = false;
+		for (unsigned i = 0; i < games.size(); ++i)
+		{
+			Socket *client;
+			while ((client = socketAccept(games[i]->listenSocket)) != NULL)
+			{
+				SocketSet_AddSocket(socketSet, client);
+				games[i]->connections.push_back(new Connection(games[i], client));
+			}
+			connected = connected || !games[i]->connections.empty();
+		}
+
+		// The listening sockets aren't in the set, so this is also how often we accept connections.
+		if (!connected || checkSockets(socketSet, RELAY_POLL_TIMEOUT) == SOCKET_ERROR)
+		{
+			wzDelay(RELAY_POLL_TIMEOUT);
+		}
+
+		for (unsigned i = 0; i < games.size(); ++i)
+		{
+			std::vector<Connection *> &connections = games[i]->connections;
+			for (unsigned n = 0; n < connections.size(); ++n)
+			{
+				Connection *c = connections[n];
+				if (c->state == STATE_RELAY && socketReadReady(c->client))
+				{
+					relayData(c, false);
+				}
+				if (c->state == STATE_RELAY && socketReadReady(c->host))
+				{
+					relayData(c, true);
+				}
+				if (c->state == STATE_RELAY)
+				{
+					// Like NETflush, send what we have every time around, since players wait for each other.
+					socketFlush(c->client);
+					socketFlush(c->host);
+				}
+				if (c->state == STATE_VERSION || c->state == STATE_CONNECTING || c->state == STATE_RESULT)
+				{
+					relayHandshake(c);
+				}
+				if (c->state == STATE_CLOSED)
+				{
+					closeConnection(c);
+					delete c;
+					connections.erase(connections.begin() + n);
+					--n;
+				}
+			}
+		}
+
+		uint32_t now = wzGetTicks();
+		if (now - statsTime >= statsInterval*1000)
+		{
+			printStatistics((now - statsTime)/1000);
+			statsTime = now;
+		}
+	}
+
+	return 0;
+}